@@ -1,10 +1,16 @@
 #include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cstdio>
 #include <thread>
 #include <memory>
 #include <string>
 #include <cstring>
 
 #include "gambit/blockchain.hpp"
+#include "gambit/block_importer.hpp"
+#include "gambit/chain_file.hpp"
+#include "gambit/state_snapshot.hpp"
 #include "gambit/p2p_node.hpp"
 #include "gambit/keys.hpp"
 #include "gambit/transaction.hpp"
@@ -27,6 +33,19 @@ struct NodeConfig {
     uint16_t rpcPort = 8545;
     uint64_t chainId = 1337;
     uint64_t premineAmount = 1000000;  // Default premine amount
+    uint32_t execThreads = 0;  // 0 = one per hardware thread
+    uint32_t shards = 0;       // 0 = speculative executor instead of shards
+    std::string dataDir;       // empty = keep everything in memory
+    bool archive = false;      // keep historical state for eth_getBalance(addr, blockN)
+    uint64_t archiveInterval = 256;  // blocks between archive checkpoints
+    bool stateless = false;    // validate received blocks against their witness
+    uint64_t freezeDepth = 0;  // 0 = keep all block segments uncompressed
+    uint64_t pruneBlocks = 0;  // 0 = keep all block history
+    uint64_t pruneRate = 0;    // MiB/s of pruned blocks deleted, 0 = unlimited
+    std::string exportPath;    // write the chain to this file and exit
+    std::string importPath;    // import blocks from this file and exit
+    std::string genesisState;  // load genesis accounts from this state snapshot
+    std::string exportState;   // write the head state to this file and exit
 };
 
 void printHelp(const char* programName) {
@@ -40,6 +59,19 @@ void printHelp(const char* programName) {
     std::cout << "  --p2p-port=<port>   Set P2P port (default: 30303)\n";
     std::cout << "  --rpc-port=<port>   Set RPC port (default: 8545)\n";
     std::cout << "  --chain-id=<id>     Set chain ID (default: 1337)\n";
+    std::cout << "  --exec-threads=<n>  Block execution threads (default: all cores)\n";
+    std::cout << "  --shards=<n>        Execute on N address-prefix shards (one pinned thread each)\n";
+    std::cout << "  --datadir=<path>    Directory for on-disk node data (default: in memory)\n";
+    std::cout << "  --archive           Keep historical state (archive mode)\n";
+    std::cout << "  --archive-interval=<n>  Blocks between archive checkpoints (default: 256)\n";
+    std::cout << "  --stateless         Re-execute received blocks against their witness\n";
+    std::cout << "  --freeze-depth=<n>  Compress block segments older than N blocks (needs --datadir)\n";
+    std::cout << "  --prune=<n>         Keep only the last N blocks, deleting older history\n";
+    std::cout << "  --prune-rate=<n>    Delete at most N MiB of pruned blocks per second (default: unlimited)\n";
+    std::cout << "  --export=<file>     Write the chain to <file> as length-prefixed RLP blocks and exit\n";
+    std::cout << "  --import=<file>     Verify and import blocks from an exported <file> and exit\n";
+    std::cout << "  --genesis-state=<file>  Load genesis accounts from a state snapshot (plus the premine)\n";
+    std::cout << "  --export-state=<file>   Write the head state as a state snapshot and exit\n";
     std::cout << "\nExamples:\n";
     std::cout << "  " << programName << " --mine-blocks=10 --enable-rpc\n";
     std::cout << "  " << programName << " --auto-mining --rpc-port=8080\n";
@@ -113,6 +145,115 @@ bool parseArgs(int argc, char* argv[], NodeConfig& config) {
                 std::cerr << "Error: Invalid chain ID: " << idStr << "\n";
                 return false;
             }
+        }
+        else if (arg.rfind("--exec-threads=", 0) == 0) {
+            std::string numStr = arg.substr(15);
+            try {
+                int num = std::stoi(numStr);
+                if (num < 1) {
+                    std::cerr << "Error: --exec-threads must be at least 1\n";
+                    return false;
+                }
+                config.execThreads = static_cast<uint32_t>(num);
+            } catch (...) {
+                std::cerr << "Error: Invalid thread count: " << numStr << "\n";
+                return false;
+            }
+        }
+        else if (arg.rfind("--shards=", 0) == 0) {
+            std::string numStr = arg.substr(9);
+            try {
+                int num = std::stoi(numStr);
+                if (num < 1 || num > 256) {
+                    std::cerr << "Error: --shards must be between 1 and 256\n";
+                    return false;
+                }
+                config.shards = static_cast<uint32_t>(num);
+            } catch (...) {
+                std::cerr << "Error: Invalid shard count: " << numStr << "\n";
+                return false;
+            }
+        }
+        else if (arg.rfind("--datadir=", 0) == 0) {
+            config.dataDir = arg.substr(10);
+            if (config.dataDir.empty()) {
+                std::cerr << "Error: --datadir requires a path\n";
+                return false;
+            }
+        }
+        else if (arg == "--archive") {
+            config.archive = true;
+        }
+        else if (arg.rfind("--archive-interval=", 0) == 0) {
+            std::string numStr = arg.substr(19);
+            try {
+                config.archiveInterval = std::stoull(numStr);
+                if (config.archiveInterval < 1) {
+                    std::cerr << "Error: --archive-interval must be at least 1\n";
+                    return false;
+                }
+            } catch (...) {
+                std::cerr << "Error: Invalid archive interval: " << numStr << "\n";
+                return false;
+            }
+        }
+        else if (arg == "--stateless") {
+            config.stateless = true;
+        }
+        else if (arg.rfind("--freeze-depth=", 0) == 0) {
+            std::string numStr = arg.substr(15);
+            try {
+                config.freezeDepth = std::stoull(numStr);
+            } catch (...) {
+                std::cerr << "Error: Invalid freeze depth: " << numStr << "\n";
+                return false;
+            }
+        }
+        else if (arg.rfind("--prune=", 0) == 0) {
+            std::string numStr = arg.substr(8);
+            try {
+                config.pruneBlocks = std::stoull(numStr);
+            } catch (...) {
+                std::cerr << "Error: Invalid prune depth: " << numStr << "\n";
+                return false;
+            }
+        }
+        else if (arg.rfind("--prune-rate=", 0) == 0) {
+            std::string numStr = arg.substr(13);
+            try {
+                config.pruneRate = std::stoull(numStr);
+            } catch (...) {
+                std::cerr << "Error: Invalid prune rate: " << numStr << "\n";
+                return false;
+            }
+        }
+        else if (arg.rfind("--export=", 0) == 0) {
+            config.exportPath = arg.substr(9);
+            if (config.exportPath.empty()) {
+                std::cerr << "Error: --export requires a file\n";
+                return false;
+            }
+        }
+        else if (arg.rfind("--import=", 0) == 0) {
+            config.importPath = arg.substr(9);
+            if (config.importPath.empty()) {
+                std::cerr << "Error: --import requires a file\n";
+                return false;
+            }
+        }
+        else if (arg.rfind("--genesis-state=", 0) == 0) {
+            config.genesisState = arg.substr(16);
+            if (config.genesisState.empty()) {
+                std::cerr << "Error: --genesis-state requires a file\n";
+                return false;
+            }
+        }
+        else if (arg.rfind("--export-state=", 0) == 0) {
+            config.exportState = arg.substr(15);
+            if (config.exportState.empty()) {
+                std::cerr << "Error: --export-state requires a file\n";
+                return false;
+            }
         }// In parseArgs function, add:
         else if (arg == "--wallet") {
             config.enableWallet = true;
@@ -170,6 +311,81 @@ void walletCLI() {
     }
 }
 
+// Blocks 1..head; genesis comes from the node's own config
+int exportBlocks(const Blockchain& chain, const std::string& path) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Error: cannot create " << path << "\n";
+        return 1;
+    }
+    if (chain.firstBlock() > 1) {
+        std::cerr << "Error: blocks below #" << chain.firstBlock() << " were pruned\n";
+        return 1;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    std::uint64_t blocks = exportChain(chain, out, 1, chain.height());
+    out.close();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    char line[64];
+    std::snprintf(line, sizeof(line), " in %.2fs\n", secs);
+    std::cout << "Exported " << blocks << " blocks to " << path << line;
+    return out ? 0 : 1;
+}
+
+int exportState(const Blockchain& chain, const std::string& path) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Error: cannot create " << path << "\n";
+        return 1;
+    }
+    Bytes32 root = writeStateSnapshot(chain.state(), out);
+    out.close();
+    std::cout << "Exported state at #" << chain.height() << " (root 0x" << toHex(root) << ") to " << path << "\n";
+    return out ? 0 : 1;
+}
+
+int importBlocks(Blockchain& chain, const std::string& path, uint32_t threads) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cerr << "Error: cannot open " << path << "\n";
+        return 1;
+    }
+    ChainFileReader reader(in);
+    BlockImporter importer(chain, threads);
+
+    using Clock = std::chrono::steady_clock;
+    auto t0 = Clock::now();
+    auto lastReport = t0;
+    auto rates = [&](const BlockImporter::Result& r) {
+        double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+        char line[128];
+        std::snprintf(line, sizeof(line), "%llu blocks, %llu txs in %.1fs (%.1f blocks/s, %.1f tx/s)",
+                      static_cast<unsigned long long>(r.blocks), static_cast<unsigned long long>(r.txs), secs,
+                      secs > 0 ? r.blocks / secs : 0.0, secs > 0 ? r.txs / secs : 0.0);
+        return std::string(line);
+    };
+
+    BlockImporter::Result r;
+    try {
+        importChain(chain, reader, importer, [&](std::uint64_t) {
+            if (Clock::now() - lastReport >= std::chrono::seconds(5)) {
+                lastReport = Clock::now();
+                std::cout << "  imported " << rates(importer.progress()) << "\n";
+            }
+        });
+        r = importer.finish();
+    } catch (const std::exception& e) {
+        r = importer.finish();
+        std::cerr << "Error: " << path << ": " << e.what() << "\n";
+        r.ok = false;
+    }
+
+    std::cout << "Imported " << rates(r) << ", head #" << chain.height() << "\n";
+    if (!r.ok && !r.error.empty()) {
+        std::cerr << "Error: block #" << r.failedIndex << ": " << r.error << "\n";
+    }
+    return r.ok ? 0 : 1;
+}
 
 int main(int argc, char* argv[]) {
     // Parse command line arguments
@@ -221,13 +437,59 @@ int main(int argc, char* argv[]) {
     GenesisConfig genesis;
     genesis.chainId = config.chainId;
     genesis.premine.push_back({ coinbase, config.premineAmount });
+    genesis.stateFile = config.genesisState;
 
     // Initialize blockchain with genesis
+    auto t0 = std::chrono::steady_clock::now();
     Blockchain chain(genesis);
+    if (!config.genesisState.empty()) {
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        char line[64];
+        std::snprintf(line, sizeof(line), " in %.2fs\n", secs);
+        std::cout << "Genesis state: " << config.genesisState << line;
+    }
+    if (config.execThreads > 0) {
+        chain.setExecutionThreads(config.execThreads);
+    }
+    if (config.shards > 0) {
+        chain.setShardCount(config.shards);
+    }
+    if (!config.dataDir.empty()) {
+        chain.setDataDir(config.dataDir);
+    }
+    if (config.archive) {
+        ArchiveConfig archiveCfg;
+        archiveCfg.checkpointInterval = config.archiveInterval;
+        if (!config.dataDir.empty()) {
+            archiveCfg.checkpointDir = config.dataDir + "/archive";
+        }
+        chain.enableArchive(archiveCfg);
+    }
+    chain.setStatelessValidation(config.stateless);
+    chain.setFreezeDepth(config.freezeDepth);
+    if (config.pruneBlocks > 0) {
+        if (config.archive) {
+            std::cerr << "Error: --prune cannot be combined with --archive\n";
+            return 1;
+        }
+        PruneConfig pruneCfg;
+        pruneCfg.keepBlocks = config.pruneBlocks;
+        pruneCfg.bytesPerSecond = config.pruneRate << 20;
+        chain.setPruning(pruneCfg);
+    }
+
+    if (!config.exportPath.empty()) {
+        return exportBlocks(chain, config.exportPath);
+    }
+    if (!config.importPath.empty()) {
+        return importBlocks(chain, config.importPath, config.execThreads);
+    }
+    if (!config.exportState.empty()) {
+        return exportState(chain, config.exportState);
+    }
     
-    const Block& genesisBlock = chain.chain().front();
-    std::cout << "Genesis Hash:  " << genesisBlock.hash << "\n";
-    std::cout << "State Root:    " << genesisBlock.stateAfter << "\n";
+    std::cout << "Genesis Hash:  0x" << toHex(chain.genesisHash()) << "\n";
+    std::cout << "State Root:    0x" << toHex(chain.genesisRoot()) << "\n";
     std::cout << "==============================\n\n";
 
     // 4. P2P node (optional)
@@ -275,8 +537,8 @@ int main(int argc, char* argv[]) {
         for (uint32_t i = 0; i < config.mineBlocks; ++i) {
             Block block = chain.mineBlock();
             std::cout << "Mined block #" << block.index 
-                      << " hash=" << block.hash
-                      << " proof=" << block.proof.proof
+                      << " hash=0x" << toHex(block.hash)
+                      << " proof=0x" << toHex(block.proof.proof)
                       << " (nonce=" << block.nonce << ")\n";
             if (node) {
                 node->broadcastNewBlock(block);
@@ -295,7 +557,8 @@ int main(int argc, char* argv[]) {
     std::cout << "P2P:         " << (config.enableP2P ? "enabled (port " + std::to_string(config.p2pPort) + ")" : "disabled") << "\n";
     std::cout << "RPC:         " << (config.enableRPC ? "enabled (port " + std::to_string(config.rpcPort) + ")" : "disabled") << "\n";
     std::cout << "Auto-mining: " << (config.enableMining ? "enabled" : "disabled") << "\n";
-    std::cout << "Block height: " << chain.chain().size() - 1 << "\n";
+    std::cout << "Archive:     " << (config.archive ? "enabled" : "disabled") << "\n";
+    std::cout << "Block height: " << chain.height() << "\n";
     if (config.mineBlocks > 0) {
         std::cout << "Mine blocks: " << config.mineBlocks << " (completed)\n";
     }
@@ -305,6 +568,18 @@ int main(int argc, char* argv[]) {
     // Keep node alive
     while (true) {
         std::this_thread::sleep_for(std::chrono::seconds(5));
+        if (!miner) {
+            try {
+                chain.freezeColdBlocks();
+            } catch (const std::exception& e) {
+                std::cerr << "Freezer: " << e.what() << "\n";
+            }
+            try {
+                chain.pruneHistory();
+            } catch (const std::exception& e) {
+                std::cerr << "Pruning: " << e.what() << "\n";
+            }
+        }
     }
     
     // Cleanup (unreachable in current loop, but here for completeness)
@@ -0,0 +1,111 @@
+// Random historical account lookups against the archive store.
+//
+// Usage: bench_archive [blocks] [accounts] [txsPerBlock] [lookups]
+//
+// For each checkpoint interval the archive is rebuilt from the same random
+// transfer history, then `lookups` random (address, height) pairs are
+// resolved. Reports archive size and lookup latency.
+
+#include "gambit/archive.hpp"
+#include "gambit/state.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace gambit;
+using Clock = std::chrono::steady_clock;
+
+static Address benchAddr(std::uint32_t i) {
+    std::array<std::uint8_t, Address::kSize> raw{};
+    for (int b = 0; b < 4; ++b) raw[b] = static_cast<std::uint8_t>(i >> (8 * b));
+    raw[19] = 0xbe;
+    return Address(raw);
+}
+
+int main(int argc, char* argv[]) {
+    std::uint64_t blocks   = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2048;
+    std::uint32_t accounts = argc > 2 ? static_cast<std::uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 2000;
+    std::uint32_t txs      = argc > 3 ? static_cast<std::uint32_t>(std::strtoul(argv[3], nullptr, 10)) : 64;
+    std::uint32_t lookups  = argc > 4 ? static_cast<std::uint32_t>(std::strtoul(argv[4], nullptr, 10)) : 200000;
+
+    std::printf("blocks=%llu accounts=%u txs/block=%u lookups=%u\n",
+                static_cast<unsigned long long>(blocks), accounts, txs, lookups);
+    std::printf("%10s %12s %14s %12s %12s %12s\n",
+                "interval", "checkpoints", "diff bytes", "build ms", "avg ns", "p99 ns");
+
+    for (std::uint64_t interval : {16u, 64u, 256u, 1024u}) {
+        GenesisConfig g;
+        for (std::uint32_t i = 0; i < accounts; ++i) g.premine.push_back({benchAddr(i), 1000000});
+        State state(g);
+        SnapshotTree tree;
+        {
+            SnapshotBase::Entries entries;
+            state.forEach([&](const Address& a, const Account& acc) { entries.emplace_back(a, acc); });
+            tree.reset(Bytes32{}, entries);
+        }
+
+        ArchiveConfig cfg;
+        cfg.checkpointInterval = interval;
+
+        auto t0 = Clock::now();
+        ArchiveStore archive(cfg, 0, tree.version());
+        std::mt19937 rng(1);
+        for (std::uint64_t h = 1; h <= blocks; ++h) {
+            ReverseDiff::Entries priors;
+            for (std::uint32_t t = 0; t < txs; ++t) {
+                Address from = benchAddr(rng() % accounts);
+                Address to = benchAddr(rng() % accounts);
+                for (const Address& a : {from, to}) {
+                    auto seen = std::find_if(priors.begin(), priors.end(),
+                                             [&](const auto& p) { return p.first == a; });
+                    if (seen == priors.end()) {
+                        const Account* prev = state.get(a);
+                        priors.emplace_back(a, prev ? std::optional<Account>(*prev) : std::nullopt);
+                    }
+                }
+                Transaction tx;
+                tx.from = from;
+                tx.to = to;
+                tx.value = rng() % 10;
+                tx.nonce = state.get(from) ? state.get(from)->nonce : 0;
+                state.applyTransaction(from, tx);
+            }
+            SnapshotBase::Entries writes;
+            for (const auto& p : priors) writes.emplace_back(p.first, *state.get(p.first));
+            Bytes32 root{};
+            for (int b = 0; b < 8; ++b) root[b] = static_cast<std::uint8_t>(h >> (8 * b));
+            tree.update(root, writes);
+            archive.recordBlock(h, ReverseDiff::build(std::move(priors)), tree.version());
+        }
+        archive.waitForCheckpoints();
+        double buildMs = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+
+        std::vector<double> samples;
+        samples.reserve(lookups);
+        std::uint64_t sink = 0;
+        std::mt19937 qrng(2);
+        for (std::uint32_t q = 0; q < lookups; ++q) {
+            Address a = benchAddr(qrng() % accounts);
+            std::uint64_t h = qrng() % (blocks + 1);
+            auto s = Clock::now();
+            auto acc = archive.accountAt(a, h);
+            samples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - s).count());
+            sink += acc ? acc->balance.low64() : 0;
+        }
+        std::sort(samples.begin(), samples.end());
+        double avg = 0;
+        for (double s : samples) avg += s;
+        avg /= samples.empty() ? 1 : samples.size();
+        double p99 = samples.empty() ? 0 : samples[samples.size() * 99 / 100];
+
+        std::printf("%10llu %12zu %14zu %12.1f %12.0f %12.0f\n",
+                    static_cast<unsigned long long>(interval), archive.checkpoints(),
+                    archive.diffBytes(), buildMs, avg, p99);
+        if (sink == 42) std::printf("\n");   // keep the lookups alive
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+// Freezer compression ratio and cold-block read cost.
+//
+// Usage: bench_freezer [blocks] [txsPerBlock] [accounts] [dir]
+//
+// Stores `blocks` blocks of signed transfers between `accounts` accounts
+// in 4 MB segments under `dir` (default a temp directory), then:
+//   freeze  - compresses every closed segment; reports MB/s and the
+//             on-disk size before and after
+//   read    - random single-block reads before and after freezing
+// Reports reads per second.
+
+#include "gambit/block_store.hpp"
+#include "gambit/keys.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+using namespace gambit;
+using Clock = std::chrono::steady_clock;
+
+static double seconds(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+static std::uint64_t dirBytes(const std::string& dir) {
+    std::uint64_t n = 0;
+    for (const auto& e : std::filesystem::directory_iterator(dir)) {
+        if (e.is_regular_file()) n += e.file_size();
+    }
+    return n;
+}
+
+static double readRate(const BlockStore& store, std::uint64_t below, std::uint32_t reads) {
+    std::mt19937_64 rng(11);
+    std::uint64_t sink = 0;
+    auto t0 = Clock::now();
+    for (std::uint32_t i = 0; i < reads; ++i) {
+        sink += store.get(rng() % below).txCount();
+    }
+    double rate = reads / seconds(t0);
+    if (sink == 42) std::printf("\n");   // keep the reads alive
+    return rate;
+}
+
+int main(int argc, char** argv) {
+    std::uint64_t blocks = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000;
+    std::uint32_t txsPerBlock = argc > 2 ? static_cast<std::uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 40;
+    std::uint32_t accounts = argc > 3 ? static_cast<std::uint32_t>(std::strtoul(argv[3], nullptr, 10)) : 200;
+    std::string dir = argc > 4 ? argv[4] : (std::filesystem::temp_directory_path() / "gambit_bench_freezer").string();
+    std::filesystem::remove_all(dir);
+
+    std::vector<KeyPair> keys;
+    for (std::uint32_t i = 0; i < accounts; ++i) keys.push_back(KeyPair::random());
+    std::vector<std::uint64_t> nonces(accounts, 0);
+
+    std::mt19937 rng(3);
+    {
+        BlockStore store(dir, std::size_t(4) << 20);
+        for (std::uint64_t n = 0; n < blocks; ++n) {
+            Bytes32 before = keccak256_32("before"), after = keccak256_32("after"), txRoot = keccak256_32("txroot");
+            Block b(n, keccak256_32("prev"), before, after, txRoot, ZkProver::generate(before, after, txRoot));
+            for (std::uint32_t t = 0; t < txsPerBlock; ++t) {
+                std::uint32_t from = rng() % accounts;
+                Transaction tx;
+                tx.nonce = nonces[from]++;
+                tx.gasPrice = 1 + rng() % 20;
+                tx.gasLimit = 21000;
+                tx.to = keys[rng() % accounts].address();
+                tx.value = 1 + rng() % 100000;
+                tx.chainId = 1337;
+                tx.signWith(keys[from]);
+                b.transactions.push_back(tx);
+            }
+            store.append(b.rlpEncode());
+        }
+    }
+
+    BlockStore store(dir, std::size_t(4) << 20);
+    std::uint64_t before = dirBytes(dir);
+    double rawReads = readRate(store, blocks, 20000);
+
+    auto t0 = Clock::now();
+    std::size_t frozen = store.freeze(blocks);
+    double secs = seconds(t0);
+    std::uint64_t after = dirBytes(dir);
+    double frozenReads = readRate(store, blocks, 20000);
+
+    std::printf("blocks=%llu txs/block=%u segments=%zu frozen=%zu\n", static_cast<unsigned long long>(blocks),
+                txsPerBlock, store.segments(), frozen);
+    std::printf("freeze   %8.1f MB/s\n", before / 1e6 / secs);
+    std::printf("disk     %8.1f MB -> %.1f MB (%.2fx)\n", before / 1e6, after / 1e6,
+                static_cast<double>(before) / after);
+    std::printf("read     %10.0f/s raw, %10.0f/s frozen\n", rawReads, frozenReads);
+
+    std::filesystem::remove_all(dir);
+    return 0;
+}
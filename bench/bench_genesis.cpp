@@ -0,0 +1,74 @@
+// Genesis state snapshot export and load.
+//
+// Usage: bench_genesis [accounts] [threads]
+//
+// Builds a state of `accounts` premined accounts, then:
+//   root    - state root, the old way (State::trie()) and bottom-up from
+//             sorted accounts (State::root())
+//   export  - writes a state snapshot
+//   load    - reads it back on `threads` workers (0 = all cores), checking
+//             every chunk hash and the state root
+// Reports accounts per second.
+
+#include "gambit/state_snapshot.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+using namespace gambit;
+using Clock = std::chrono::steady_clock;
+
+static double seconds(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    std::uint32_t accounts = argc > 1 ? static_cast<std::uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 200000;
+    std::size_t threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 0;
+
+    State state;
+    std::uint64_t x = 88172645463325252ull;
+    for (std::uint32_t i = 0; i < accounts; ++i) {
+        std::array<std::uint8_t, Address::kSize> raw{};
+        for (auto& b : raw) {
+            x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+            b = static_cast<std::uint8_t>(x);
+        }
+        state.set(Address(raw), Account{uint256(1000000 + i), 0});
+    }
+
+    auto t0 = Clock::now();
+    bool viaTrie = accounts <= 200000;
+    Bytes32 trieRoot = viaTrie ? state.trie().rootHash() : Bytes32{};
+    double trieSecs = seconds(t0);
+    t0 = Clock::now();
+    Bytes32 root = state.root();
+    double rootSecs = seconds(t0);
+    if (viaTrie && trieRoot != root) {
+        std::fprintf(stderr, "root mismatch\n");
+        return 1;
+    }
+
+    std::stringstream buf;
+    t0 = Clock::now();
+    writeStateSnapshot(state, buf);
+    double exportSecs = seconds(t0);
+    std::size_t bytes = buf.str().size();
+
+    t0 = Clock::now();
+    State loaded = loadStateSnapshot(buf, threads);
+    double loadSecs = seconds(t0);
+    if (loaded.root() != root) {
+        std::fprintf(stderr, "loaded root mismatch\n");
+        return 1;
+    }
+
+    std::printf("accounts=%u snapshot=%.1f MB\n", accounts, bytes / 1e6);
+    if (viaTrie) std::printf("root     %10.0f acct/s trie\n", accounts / trieSecs);
+    std::printf("root     %10.0f acct/s sorted\n", accounts / rootSecs);
+    std::printf("export   %10.0f acct/s\n", accounts / exportSecs);
+    std::printf("load     %10.0f acct/s (%.2fs)\n", accounts / loadSecs, loadSecs);
+    return 0;
+}
@@ -0,0 +1,91 @@
+// Block import throughput: one-at-a-time addBlock vs the staged pipeline.
+//
+// Usage: bench_import [blocks] [txsPerBlock] [accounts]
+//
+// A source chain mines `blocks` blocks of signed transfers. Their
+// encodings are then imported into fresh chains, once by decoding and
+// calling addBlock for each block in turn and once through
+// BlockImporter. Reports blocks/s and tx/s for both.
+
+#include "gambit/block_importer.hpp"
+#include "gambit/keys.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace gambit;
+using Clock = std::chrono::steady_clock;
+
+int main(int argc, char* argv[]) {
+    std::uint64_t blocks   = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 64;
+    std::uint32_t txs      = argc > 2 ? static_cast<std::uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 200;
+    std::uint32_t accounts = argc > 3 ? static_cast<std::uint32_t>(std::strtoul(argv[3], nullptr, 10)) : 256;
+
+    std::printf("blocks=%llu txs/block=%u accounts=%u\n",
+                static_cast<unsigned long long>(blocks), txs, accounts);
+
+    std::vector<KeyPair> keys;
+    GenesisConfig g;
+    g.chainId = 1337;
+    for (std::uint32_t i = 0; i < accounts; ++i) {
+        keys.push_back(KeyPair::random());
+        g.premine.push_back({keys.back().address(), 1000000000});
+    }
+
+    Blockchain source(g);
+    std::vector<std::uint64_t> nonces(accounts, 0);
+    std::vector<Bytes> encoded;
+    std::mt19937 rng(1);
+    for (std::uint64_t b = 0; b < blocks; ++b) {
+        for (std::uint32_t t = 0; t < txs; ++t) {
+            std::uint32_t from = rng() % accounts;
+            Transaction tx;
+            tx.nonce = nonces[from]++;
+            tx.gasPrice = 1;
+            tx.gasLimit = 21000;
+            tx.to = keys[rng() % accounts].address();
+            tx.value = rng() % 100;
+            tx.chainId = 1337;
+            tx.signWith(keys[from]);
+            source.addTransaction(tx);
+        }
+        encoded.push_back(source.mineBlock().rlpEncode());
+    }
+
+    auto report = [&](const char* name, Clock::time_point t0, const Blockchain& chain) {
+        double s = std::chrono::duration<double>(Clock::now() - t0).count();
+        bool match = chain.state().root() == source.state().root();
+        std::printf("%-10s %10.1f blocks/s %12.0f tx/s %s\n", name, blocks / s, blocks * txs / s,
+                    match ? "" : "(ROOT MISMATCH)");
+    };
+
+    {
+        Blockchain chain(g);
+        auto t0 = Clock::now();
+        for (const auto& raw : encoded) {
+            if (!chain.addBlock(Block::rlpDecode(raw))) {
+                std::printf("addBlock rejected block %llu\n", static_cast<unsigned long long>(chain.height() + 1));
+                return 1;
+            }
+        }
+        report("serial", t0, chain);
+    }
+
+    {
+        Blockchain chain(g);
+        auto t0 = Clock::now();
+        BlockImporter importer(chain);
+        for (const auto& raw : encoded) importer.submit(raw);
+        BlockImporter::Result r = importer.finish();
+        if (!r.ok) {
+            std::printf("import failed at block %llu: %s\n",
+                        static_cast<unsigned long long>(r.failedIndex), r.error.c_str());
+            return 1;
+        }
+        report("pipelined", t0, chain);
+    }
+    return 0;
+}
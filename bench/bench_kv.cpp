@@ -0,0 +1,128 @@
+// Key-value engine throughput on the node's access patterns.
+//
+// Usage: bench_kv [keys] [lookups] [blocks] [dir]
+//
+// For the in-memory store and the LSM engine (under `dir`, default a
+// temp directory):
+//   load    - `keys` 32-byte hash keys with account-sized values, in
+//             batches of 1000
+//   hit     - random lookups of present keys
+//   miss    - random lookups of absent keys (bloom filters for the LSM)
+//   append  - `blocks` sequential block-number keys with 2 KB bodies,
+//             one write per block, with and without an fsync each
+// Reports operations per second.
+
+#include "gambit/hash.hpp"
+#include "gambit/kv_store.hpp"
+#include "gambit/lsm_store.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+using namespace gambit;
+using Clock = std::chrono::steady_clock;
+
+static Bytes hashKey(std::uint32_t i) {
+    return keccak256(Bytes{static_cast<std::uint8_t>(i), static_cast<std::uint8_t>(i >> 8),
+                           static_cast<std::uint8_t>(i >> 16), static_cast<std::uint8_t>(i >> 24)});
+}
+
+static Bytes blockKey(std::uint64_t n) {
+    Bytes k{'b'};
+    for (int i = 7; i >= 0; --i) k.push_back(static_cast<std::uint8_t>(n >> (8 * i)));
+    return k;
+}
+
+static double seconds(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+static void run(const char* name, KvStore& kv, std::uint32_t keys, std::uint32_t lookups) {
+    auto t0 = Clock::now();
+    WriteBatch batch;
+    for (std::uint32_t i = 0; i < keys; ++i) {
+        batch.put(hashKey(i), Bytes(80, static_cast<std::uint8_t>(i)));
+        if (batch.size() == 1000 || i + 1 == keys) {
+            kv.write(batch);
+            batch.clear();
+        }
+    }
+    double load = keys / seconds(t0);
+    if (auto* lsm = dynamic_cast<LsmKvStore*>(&kv)) {
+        lsm->flush();
+        lsm->waitForCompaction();
+    }
+
+    std::mt19937 rng(7);
+    std::vector<Bytes> probes;
+    for (std::uint32_t i = 0; i < lookups; ++i) probes.push_back(hashKey(rng() % keys));
+    t0 = Clock::now();
+    std::uint32_t found = 0;
+    for (const auto& k : probes) found += kv.get(k).has_value();
+    double hit = lookups / seconds(t0);
+
+    probes.clear();
+    for (std::uint32_t i = 0; i < lookups; ++i) probes.push_back(hashKey(keys + rng() % keys));
+    t0 = Clock::now();
+    for (const auto& k : probes) found += kv.get(k).has_value();
+    double miss = lookups / seconds(t0);
+
+    std::printf("%-8s %12.0f %12.0f %12.0f  (found %u)\n", name, load, hit, miss, found);
+}
+
+static double appendBlocks(KvStore& kv, std::uint64_t blocks) {
+    Bytes body(2048);
+    std::mt19937 rng(1);
+    for (auto& b : body) b = static_cast<std::uint8_t>(rng());
+    auto t0 = Clock::now();
+    for (std::uint64_t n = 0; n < blocks; ++n) {
+        body[0] = static_cast<std::uint8_t>(n);
+        kv.put(blockKey(n), body);
+    }
+    return blocks / seconds(t0);
+}
+
+int main(int argc, char* argv[]) {
+    std::uint32_t keys    = argc > 1 ? static_cast<std::uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 200000;
+    std::uint32_t lookups = argc > 2 ? static_cast<std::uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 200000;
+    std::uint64_t blocks  = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 2000;
+    std::string dir = argc > 4 ? argv[4] : (std::filesystem::temp_directory_path() / "gambit_bench_kv").string();
+
+    std::printf("keys=%u lookups=%u blocks=%llu dir=%s\n", keys, lookups,
+                static_cast<unsigned long long>(blocks), dir.c_str());
+    std::printf("%-8s %12s %12s %12s\n", "engine", "load/s", "hit/s", "miss/s");
+
+    {
+        MemoryKvStore mem;
+        run("memory", mem, keys, lookups);
+    }
+    std::filesystem::remove_all(dir);
+    {
+        LsmKvStore lsm(dir + "/hash", LsmOptions{std::size_t(4) << 20, 4, 10, false});
+        run("lsm", lsm, keys, lookups);
+        LsmKvStore::Stats s = lsm.stats();
+        std::printf("         tables=%zu flushes=%llu compactions=%llu bloomSkips=%llu\n", lsm.tables(),
+                    static_cast<unsigned long long>(s.flushes), static_cast<unsigned long long>(s.compactions),
+                    static_cast<unsigned long long>(s.bloomSkips));
+    }
+
+    std::printf("\n%-8s %14s\n", "append", "blocks/s");
+    {
+        MemoryKvStore mem;
+        std::printf("%-8s %14.0f\n", "memory", appendBlocks(mem, blocks));
+    }
+    {
+        LsmKvStore lsm(dir + "/blocks-nosync", LsmOptions{std::size_t(4) << 20, 4, 10, false});
+        std::printf("%-8s %14.0f\n", "lsm", appendBlocks(lsm, blocks));
+    }
+    {
+        LsmKvStore lsm(dir + "/blocks-sync", LsmOptions{std::size_t(4) << 20, 4, 10, true});
+        std::printf("%-8s %14.0f\n", "lsm+sync", appendBlocks(lsm, blocks));
+    }
+    std::filesystem::remove_all(dir);
+    return 0;
+}
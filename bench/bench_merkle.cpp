@@ -0,0 +1,73 @@
+// Transaction root: flat hash vs binary Merkle tree.
+//
+// Usage: bench_merkle [txs] [threads]
+//
+// For `txs` random 110-byte transaction encodings:
+//   flat    - keccak256 of all encodings concatenated (the old tx root)
+//   merkle  - Merkle root over the transaction hashes, on one thread and
+//             on `threads` workers (0 = all cores)
+//   proof   - inclusion proofs built and verified per transaction
+// Transaction hashing is done once up front, as blocks already carry it.
+
+#include "gambit/merkle.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace gambit;
+using Clock = std::chrono::steady_clock;
+
+static double seconds(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    std::size_t txs = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    std::size_t threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 0;
+
+    Bytes concat;
+    std::vector<Bytes32> hashes;
+    std::uint64_t x = 88172645463325252ull;
+    for (std::size_t i = 0; i < txs; ++i) {
+        Bytes enc(110);
+        for (auto& b : enc) {
+            x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+            b = static_cast<std::uint8_t>(x);
+        }
+        concat.insert(concat.end(), enc.begin(), enc.end());
+        hashes.push_back(keccak256_32(enc));
+    }
+
+    auto t0 = Clock::now();
+    Bytes32 flat = keccak256_32(concat);
+    double flatSecs = seconds(t0);
+
+    t0 = Clock::now();
+    Bytes32 serial = merkle::root(hashes, 1);
+    double serialSecs = seconds(t0);
+    t0 = Clock::now();
+    Bytes32 parallel = merkle::root(hashes, threads);
+    double parallelSecs = seconds(t0);
+    if (serial != parallel) {
+        std::fprintf(stderr, "root mismatch\n");
+        return 1;
+    }
+
+    std::size_t samples = std::min<std::size_t>(txs, 200);
+    t0 = Clock::now();
+    for (std::size_t i = 0; i < samples; ++i) {
+        std::size_t k = i * txs / samples;
+        if (!merkle::verify(serial, hashes[k], merkle::prove(hashes, k))) {
+            std::fprintf(stderr, "proof %zu failed\n", k);
+            return 1;
+        }
+    }
+    double proofSecs = seconds(t0) / samples;
+
+    std::printf("txs=%zu flat=%02x.. merkle=%02x..\n", txs, flat[0], serial[0]);
+    std::printf("flat     %8.2f ms\n", flatSecs * 1e3);
+    std::printf("merkle   %8.2f ms serial, %8.2f ms parallel\n", serialSecs * 1e3, parallelSecs * 1e3);
+    std::printf("proof    %8.2f ms build+verify\n", proofSecs * 1e3);
+    return 0;
+}
@@ -0,0 +1,85 @@
+// Read throughput of chain views while blocks are being produced.
+//
+// Usage: bench_reads [accounts] [millisPerRun]
+//
+// For 1, 2, 4 and 8 reader threads, each reader repeatedly takes
+// Blockchain::view() and looks up a random account in it, while one
+// writer thread keeps adding transfers and mining blocks. Reports total
+// reads/s and the number of blocks the writer produced meanwhile.
+
+#include "gambit/blockchain.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace gambit;
+using Clock = std::chrono::steady_clock;
+
+static Address benchAddr(std::uint32_t i) {
+    std::array<std::uint8_t, Address::kSize> raw{};
+    for (int b = 0; b < 4; ++b) raw[b] = static_cast<std::uint8_t>(i >> (8 * b));
+    raw[19] = 0xbe;
+    return Address(raw);
+}
+
+int main(int argc, char* argv[]) {
+    std::uint32_t accounts = argc > 1 ? static_cast<std::uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 1000;
+    std::uint32_t millis   = argc > 2 ? static_cast<std::uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 1000;
+
+    std::printf("accounts=%u run=%ums\n", accounts, millis);
+    std::printf("%8s %14s %10s\n", "readers", "reads/s", "blocks");
+
+    for (int readers : {1, 2, 4, 8}) {
+        GenesisConfig g;
+        for (std::uint32_t i = 0; i < accounts; ++i) g.premine.push_back({benchAddr(i), 1000000});
+        Blockchain chain(g);
+
+        std::atomic<bool> stop{false};
+        std::atomic<std::uint64_t> reads{0};
+        std::uint64_t blocks = 0;
+
+        std::vector<std::thread> pool;
+        for (int r = 0; r < readers; ++r) {
+            pool.emplace_back([&, r] {
+                std::mt19937 rng(r);
+                std::uint64_t n = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    auto view = chain.view();
+                    auto acc = view->state.get(benchAddr(rng() % accounts));
+                    if (acc) ++n;
+                }
+                reads += n;
+            });
+        }
+
+        std::mt19937 rng(99);
+        std::vector<std::uint64_t> nonces(accounts, 0);
+        auto t0 = Clock::now();
+        auto deadline = t0 + std::chrono::milliseconds(millis);
+        while (Clock::now() < deadline) {
+            for (int t = 0; t < 16; ++t) {
+                std::uint32_t from = rng() % accounts;
+                Transaction tx;
+                tx.nonce = nonces[from]++;
+                tx.from = benchAddr(from);
+                tx.to = benchAddr(rng() % accounts);
+                tx.value = 1;
+                tx.hash = tx.computeHash();
+                chain.addTransaction(tx);
+            }
+            chain.mineBlock();
+            ++blocks;
+        }
+        stop = true;
+        for (auto& t : pool) t.join();
+
+        double s = std::chrono::duration<double>(Clock::now() - t0).count();
+        std::printf("%8d %14.0f %10llu\n", readers, reads / s, static_cast<unsigned long long>(blocks));
+    }
+    return 0;
+}
@@ -0,0 +1,77 @@
+// uint256 arithmetic throughput against native 64-bit integers.
+//
+// Usage: bench_uint256 [iterations]
+//
+// Runs the balance-update pattern (compare, subtract, add) and the gas-cost
+// pattern (checked multiply, checked add) on uint256 and on uint64_t.
+// Reports nanoseconds per operation.
+
+#include "gambit/uint256.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace gambit;
+using Clock = std::chrono::steady_clock;
+
+template <typename T>
+static double transfers(std::vector<T>& balances, const std::vector<std::uint32_t>& idx,
+                        const std::vector<T>& values) {
+    auto t0 = Clock::now();
+    std::size_t n = balances.size();
+    for (std::size_t i = 0; i + 1 < idx.size(); i += 2) {
+        T& from = balances[idx[i] % n];
+        T& to = balances[idx[i + 1] % n];
+        const T& v = values[i % values.size()];
+        if (!(from < v)) {
+            from -= v;
+            to += v;
+        }
+    }
+    return std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / (idx.size() / 2);
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t iters = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+
+    std::mt19937_64 rng(1);
+    std::vector<std::uint32_t> idx(iters * 2);
+    for (auto& i : idx) i = static_cast<std::uint32_t>(rng());
+
+    std::vector<std::uint64_t> b64(4096, 1ull << 40), v64(1024);
+    std::vector<uint256> b256(4096, uint256(1) << 200), v256(1024);
+    for (std::size_t i = 0; i < v64.size(); ++i) {
+        v64[i] = rng() % 1000;
+        v256[i] = v64[i];
+    }
+
+    double t64 = transfers(b64, idx, v64);
+    double t256 = transfers(b256, idx, v256);
+    std::printf("%-22s %8.2f ns/op (uint64 %6.2f)\n", "transfer", t256, t64);
+
+    // Gas cost: gasPrice * gasLimit + value with overflow checks
+    std::uint64_t sink = 0;
+    auto t0 = Clock::now();
+    for (std::size_t i = 0; i < iters; ++i) {
+        uint256 cost, total;
+        bool bad = uint256::mulOverflow(v256[i % 1024] << 64, idx[i], cost) ||
+                   uint256::addOverflow(cost, v256[(i + 1) % 1024], total);
+        sink += bad ? 1 : total.low64();
+    }
+    double tGas = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / iters;
+    std::printf("%-22s %8.2f ns/op\n", "checked gas cost", tGas);
+
+    t0 = Clock::now();
+    uint256 acc = uint256::max();
+    for (std::size_t i = 0; i < iters / 10; ++i) {
+        acc = acc / (v256[i % 1024] + 1) + (uint256(idx[i]) << 190);
+    }
+    double tDiv = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / (iters / 10);
+    std::printf("%-22s %8.2f ns/op\n", "div (256 / 64-bit)", tDiv);
+
+    if ((sink ^ acc.low64() ^ b64[0] ^ b256[0].low64()) == 42) std::printf("\n");
+    return 0;
+}
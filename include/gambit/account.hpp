@@ -1,10 +1,12 @@
 #pragma once
 #include <cstdint>
 
+#include "gambit/uint256.hpp"
+
 namespace gambit {
 
 struct Account {
-    std::uint64_t balance{0};
+    uint256 balance;
     std::uint64_t nonce{0};
     // Future: codeHash, storageRoot
 };
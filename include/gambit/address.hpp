@@ -30,4 +30,16 @@ private:
     static std::string toChecksumHex(const std::array<std::uint8_t, kSize>& raw);
 };
 
+// Hash functor for unordered containers keyed by Address
+struct AddressHash {
+    std::size_t operator()(const Address& a) const noexcept {
+        // Addresses are already uniformly distributed (keccak output)
+        std::size_t h = 0;
+        for (std::size_t i = 0; i < sizeof(std::size_t); ++i) {
+            h = (h << 8) | a.bytes()[i];
+        }
+        return h;
+    }
+};
+
 } // namespace gambit
@@ -0,0 +1,93 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "gambit/address.hpp"
+#include "gambit/block.hpp"
+
+namespace gambit {
+
+// Address activity: for every address, the (block, position) of each
+// canonical transaction it sent or received, oldest first.
+//
+// A list is split into pages of kPagePostings postings. A page's skip
+// entry holds its first posting and the byte offset of the rest, each
+// delta-encoded against the one before it: [varint height delta]
+// [varint position] when the height changes, [0][varint position
+// delta - 1] within a block, so most postings take two or three bytes.
+// A query binary-searches the skips and decodes from one page on; it
+// costs that page plus the postings returned, however long the chain
+// or the list.
+//
+// Lists only grow at the tail: a reorg cuts them back to the rewound
+// height, pruning drops whole pages from the front.
+class AddressIndex {
+public:
+    static constexpr std::size_t kPagePostings = 128;
+
+    struct Posting {
+        std::uint64_t height{0};
+        std::uint32_t position{0};
+
+        bool operator<(const Posting& o) const {
+            return height < o.height || (height == o.height && position < o.position);
+        }
+        bool operator==(const Posting& o) const { return height == o.height && position == o.position; }
+    };
+
+    struct Page {
+        std::vector<Posting> postings;
+        // Where the following page starts, if there is one
+        std::optional<Posting> next;
+    };
+
+    // Index the sender and recipient of each transaction. Blocks must
+    // arrive in height order.
+    void add(const Block& block);
+
+    // Undo add() for the head block (reorgs)
+    void remove(const Block& block);
+
+    // Drop pages whose postings all lie below `height`; addresses left
+    // without any are forgotten
+    void prune(std::uint64_t height);
+
+    void clear();
+
+    // Up to `limit` postings of `addr` starting at `from` (inclusive):
+    // ascending, or descending towards the oldest with `newestFirst`.
+    // Pass page.next back as `from` to continue.
+    Page query(const Address& addr, Posting from, std::size_t limit, bool newestFirst = false) const;
+
+    // Postings held for `addr`
+    std::uint64_t count(const Address& addr) const;
+
+    std::size_t addresses() const;
+    // Encoded posting bytes over all addresses
+    std::size_t bytes() const;
+
+private:
+    struct Skip {
+        Posting first;
+        std::size_t offset;
+    };
+
+    struct List {
+        Bytes data;
+        std::vector<Skip> pages;
+        std::uint64_t count{0};
+        Posting last;
+    };
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<Address, List, AddressHash> lists_;
+
+    static void append(List& list, const Posting& p);
+    static void decodePage(const List& list, std::size_t page, std::vector<Posting>& out);
+    static void truncate(List& list, const Posting& from);
+};
+
+} // namespace gambit
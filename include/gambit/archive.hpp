@@ -0,0 +1,124 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gambit/address.hpp"
+#include "gambit/account.hpp"
+#include "gambit/hash.hpp"
+#include "gambit/snapshot.hpp"
+
+namespace gambit {
+
+struct ArchiveConfig {
+    // A full account table is kept every `checkpointInterval` blocks.
+    // Lookups scan at most this many reverse diffs: smaller = faster
+    // queries, larger = less space.
+    std::uint64_t checkpointInterval{256};
+
+    // If set, checkpoint tables are written here and read through mmap
+    // instead of being held in memory. They only mean something next to
+    // the in-memory diffs, so tables left by an earlier run are deleted.
+    std::string checkpointDir;
+};
+
+// Values the accounts written by one block had *before* that block,
+// packed as fixed-width records sorted by address.
+class ReverseDiff {
+public:
+    using Entries = std::vector<std::pair<Address, std::optional<Account>>>;
+
+    static ReverseDiff build(Entries entries);
+
+    // True if the block wrote `addr`; `prior` is then its previous value
+    // (nullopt if the account did not exist yet).
+    bool find(const Address& addr, std::optional<Account>& prior) const;
+
+    void forEach(const std::function<void(const Address&, const std::optional<Account>&)>& fn) const;
+
+    std::size_t size() const;
+    std::size_t bytes() const { return data_.size(); }
+
+private:
+    Bytes data_;
+};
+
+// Archive of historical account state.
+//
+// Every block contributes a ReverseDiff; every `checkpointInterval` blocks
+// a full checkpoint table is kept. The account at height N is the prior
+// value recorded by the first block after N that touched it, or else the
+// value in the nearest checkpoint at or above N, or else the value in the
+// archive's own pinned head version. Lookups take only the archive's lock.
+//
+// Checkpoint tables are built by a background thread from a pinned
+// snapshot version, so recordBlock() costs the caller no account walk.
+// Until a checkpoint is ready, lookups scan the diffs past it instead.
+class ArchiveStore {
+public:
+    // Start archiving at `height`, whose post-state is `state`
+    ArchiveStore(const ArchiveConfig& cfg, std::uint64_t height, SnapshotTree::Version state);
+    ~ArchiveStore();
+
+    ArchiveStore(const ArchiveStore&) = delete;
+    ArchiveStore& operator=(const ArchiveStore&) = delete;
+
+    // Record block `height` (must be the next height) and its post-state
+    void recordBlock(std::uint64_t height, ReverseDiff diff, SnapshotTree::Version after);
+
+    // Forget blocks above `height` (reorgs), whose post-state is `state`;
+    // throws std::out_of_range below the first archived height
+    void rewind(std::uint64_t height, SnapshotTree::Version state);
+
+    bool available(std::uint64_t height) const;
+
+    std::optional<Account> accountAt(const Address& addr, std::uint64_t height) const;
+
+    std::uint64_t firstHeight() const { return first_; }
+    std::size_t checkpoints() const;    // built so far
+    std::size_t diffBytes() const;
+
+    // Block until every queued checkpoint is built
+    void waitForCheckpoints();
+
+private:
+    struct PendingCheckpoint {
+        std::uint64_t height;
+        SnapshotTree::Version state;
+    };
+
+    ArchiveConfig cfg_;
+    std::uint64_t first_;
+    std::uint64_t head_;
+
+    mutable std::mutex mutex_;
+    SnapshotTree::Version headState_;  // post-state of block head_
+    std::vector<ReverseDiff> diffs_;   // diffs_[i] belongs to block first_ + 1 + i
+    std::map<std::uint64_t, std::shared_ptr<const SnapshotBase>> checkpoints_;
+    std::size_t diffBytes_{0};
+
+    // Checkpoint builder
+    std::deque<PendingCheckpoint> queue_;
+    std::optional<std::uint64_t> building_;     // height being built
+    bool discardBuilding_{false};               // rewound past it meanwhile
+    bool stopping_{false};
+    std::condition_variable work_;
+    std::condition_variable idle_;
+    std::thread builder_;
+
+    void queueCheckpointLocked(std::uint64_t height, SnapshotTree::Version state);
+    std::shared_ptr<const SnapshotBase> buildCheckpoint(std::uint64_t height,
+                                                        const SnapshotTree::Version& state) const;
+    void buildLoop();
+};
+
+} // namespace gambit
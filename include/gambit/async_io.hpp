@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+
+namespace gambit {
+
+// Batched asynchronous positional file I/O.
+//
+// read() and write() only queue an operation. submit() hands everything
+// queued to the kernel in one go, and poll() runs the callbacks of
+// finished operations on the calling thread, in completion order. One
+// thread can thus keep a deep queue of small random reads outstanding
+// instead of blocking in pread once per read.
+//
+// On Linux the io_uring backend keeps up to `depth` operations in flight
+// with one system call per batch. Elsewhere, or when the kernel refuses
+// io_uring, the pread backend performs the queued operations
+// synchronously inside submit().
+//
+// Not thread-safe: one thread queues, submits and polls. Buffers must
+// stay valid until their callback has run.
+class AsyncIo {
+public:
+    enum class Backend { IoUring, Pread };
+
+    // Bytes transferred (short only at end of file), or -errno
+    using Callback = std::function<void(std::int64_t result)>;
+
+    // Backend::Pread forces the fallback
+    static std::unique_ptr<AsyncIo> create(unsigned depth = 128, Backend preferred = Backend::IoUring);
+
+    virtual ~AsyncIo() = default;
+
+    virtual Backend backend() const = 0;
+
+    void read(int fd, void* buf, std::size_t len, std::uint64_t offset, Callback cb);
+    void write(int fd, const void* buf, std::size_t len, std::uint64_t offset, Callback cb);
+
+    // Hand queued operations to the kernel; returns how many
+    virtual std::size_t submit() = 0;
+
+    // Run callbacks of finished operations and return how many ran. With
+    // `wait`, block until at least one finishes if any is in flight.
+    virtual std::size_t poll(bool wait) = 0;
+
+    // Submit and poll until nothing is queued or in flight; callbacks may
+    // queue more work
+    void drain();
+
+    std::size_t queued() const { return queue_.size(); }
+    std::size_t inFlight() const { return inFlight_; }
+
+protected:
+    struct Op {
+        bool write;
+        int fd;
+        std::uint8_t* buf;
+        std::size_t len;
+        std::uint64_t offset;
+        Callback cb;
+    };
+
+    std::deque<Op> queue_;
+    std::size_t inFlight_{0};
+};
+
+} // namespace gambit
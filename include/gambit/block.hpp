@@ -1,54 +1,75 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <array>
 #include <cstdint>
 
+#include "gambit/block_header.hpp"
 #include "gambit/transaction.hpp"
-#include "gambit/zk.hpp"
 #include "gambit/hash.hpp"
 #include "gambit/receipt.hpp"
-#include "gambit/bloom.hpp"
+#include "gambit/witness.hpp"
 
 namespace gambit {
 
-class Block {
+// A header plus its body. Header fields are inherited, so block.index,
+// block.stateAfter etc. read the header; `hash` caches its hash.
+class Block : public BlockHeader {
 public:
-    std::uint64_t index{0};
-    std::string   prevHash;
-    std::string   stateBefore;
-    std::string   stateAfter;
-    std::string   txRoot;
-    std::string   receiptsRoot;
-    ZkProof       proof;
-    std::uint64_t timestamp{0};
-    std::string   hash;
+    // Top-level RLP parts, in encoding order
+    enum Part : std::size_t {
+        kHeader, kHash, kTransactions, kReceipts, kWitness, kPartCount
+    };
+
+    Bytes32       hash{};
     std::uint64_t nonce{0};
 
     std::vector<Transaction> transactions;
     std::vector<Receipt> receipts;
-    Bloom logsBloom;
+
+    // Pre-state proof for stateless validation (not covered by the hash)
+    BlockWitness witness;
+
+    // False while transaction senders are still to be recovered (see
+    // fromHex); recoverSenders() fills them in
+    bool sendersRecovered{true};
 
     Block() = default;
 
     Block(std::uint64_t idx,
-          const std::string& prev,
-          const std::string& before,
-          const std::string& after,
-          const std::string& txRoot_,
+          const Bytes32& prev,
+          const Bytes32& before,
+          const Bytes32& after,
+          const Bytes32& txRoot_,
           const ZkProof& proof_);
 
-    // Compute block hash
-    std::string computeHash() const;
+    const BlockHeader& header() const { return *this; }
+    BlockHeader& header() { return *this; }
 
-    // RLP
+    // Recover every transaction sender not yet known; throws
+    // std::runtime_error on a bad signature
+    void recoverSenders();
+
+    // RLP: [header, hash, transactions, receipts, witness?]
     Bytes rlpEncode() const;
-    static Block rlpDecode(const Bytes& raw);
+    // `withSenders` = false leaves transaction senders unrecovered
+    static Block rlpDecode(const Bytes& raw, bool withSenders = true);
+
+    using PartRefs = std::array<rlp::ItemRef, kPartCount>;
+
+    // Locate the top-level parts of an encoded block in place; returns
+    // how many are present (the witness is optional)
+    static std::size_t splitParts(const std::uint8_t* data, std::size_t size, PartRefs& out);
 
+    // Decode only the header of an encoded block; the body is not parsed
+    static BlockHeader decodeHeader(const std::uint8_t* data, std::size_t size);
 
     // Serialize block to bytes (for P2P)
     std::string toHex() const;
 
-    // Deserialize (optional)
+    // Deserialize a block received from a peer. Senders are left for
+    // recoverSenders(), so a block that fails its header checks never
+    // pays for signature recovery.
     static Block fromHex(const std::string& hex);
 };
 
@@ -0,0 +1,48 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+#include "gambit/bloom.hpp"
+#include "gambit/hash.hpp"
+#include "gambit/rlp.hpp"
+#include "gambit/zk.hpp"
+
+namespace gambit {
+
+// Everything a block commits to, without its body. Encoded and hashed on
+// its own, so header-chain checks, fork choice and light clients never
+// decode transactions or receipts.
+struct BlockHeader {
+    // RLP fields, in encoding order
+    enum Field : std::size_t {
+        kIndex, kPrevHash, kStateBefore, kStateAfter, kTxRoot, kReceiptsRoot,
+        kProof, kCommitment, kTimestamp, kLogsBloom, kFieldCount
+    };
+
+    std::uint64_t index{0};
+    Bytes32       prevHash{};
+    Bytes32       stateBefore{};
+    Bytes32       stateAfter{};
+    Bytes32       txRoot{};
+    Bytes32       receiptsRoot{};
+    ZkProof       proof;
+    std::uint64_t timestamp{0};
+    Bloom         logsBloom;
+
+    // The block hash: keccak256 of rlpEncode()
+    Bytes32 computeHash() const;
+
+    Bytes rlpEncode() const;
+
+    // Throws std::runtime_error on a malformed header
+    static BlockHeader rlpDecode(const std::uint8_t* data, std::size_t size);
+    static BlockHeader rlpDecode(const Bytes& raw) { return rlpDecode(raw.data(), raw.size()); }
+
+    using FieldRefs = std::array<rlp::ItemRef, kFieldCount>;
+
+    // Locate the fields of an encoded header in place; throws
+    // std::runtime_error unless all are present
+    static void splitFields(const std::uint8_t* data, std::size_t size, FieldRefs& out);
+};
+
+} // namespace gambit
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "gambit/blockchain.hpp"
+
+namespace gambit {
+
+// Staged import of encoded blocks (sync, chain import).
+//
+//   decode -> verify (proof, senders, tx root) -> execute -> state root -> commit
+//
+// Each stage runs on its own thread and passes blocks on through a
+// bounded queue. Block N+1 is decoded and verified while block N
+// executes, and N's root is computed while N+1 executes, so throughput
+// is bound by the slowest stage (execution) rather than by the sum of
+// all of them. Sender recovery is spread over a worker pool.
+//
+// Every block is re-executed, its post-state root compared with
+// stateAfter and its receipts rebuilt and checked against receiptsRoot
+// before Blockchain::commitVerified appends it. The first
+// block that fails stops the import; blocks queued behind it are dropped.
+// The importer expects to be the chain's only writer while it runs.
+class BlockImporter {
+public:
+    struct Result {
+        std::uint64_t blocks{0};        // committed
+        std::uint64_t txs{0};
+        bool ok{true};
+        std::uint64_t failedIndex{0};   // block index (valid when !ok)
+        std::string error;
+    };
+
+    // senderThreads == 0 => std::thread::hardware_concurrency()
+    explicit BlockImporter(Blockchain& chain, std::size_t senderThreads = 0, std::size_t queueDepth = 8);
+    ~BlockImporter();
+
+    BlockImporter(const BlockImporter&) = delete;
+    BlockImporter& operator=(const BlockImporter&) = delete;
+
+    // Queue one Block::rlpEncode()d block; waits while the first stage is
+    // full. Returns false once the import has failed.
+    bool submit(Bytes encoded);
+
+    // Counts so far, for progress reports while blocks are submitted
+    Result progress() const;
+
+    // Wait for every queued block to be committed or dropped
+    Result finish();
+
+private:
+    struct Pipeline;
+    std::unique_ptr<Pipeline> p_;
+};
+
+} // namespace gambit
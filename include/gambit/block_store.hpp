@@ -0,0 +1,202 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "gambit/async_io.hpp"
+#include "gambit/block.hpp"
+#include "gambit/freezer.hpp"
+#include "gambit/mapped_file.hpp"
+
+namespace gambit {
+
+// Read-only view of one stored block.
+//
+// Points straight into the store's bytes (an mmap'd segment or an
+// in-memory record) and keeps them alive. Header fields are located once
+// and decoded on access; the body is only walked when a transaction or
+// receipt is read, and those are decoded one at a time.
+class BlockView {
+public:
+    BlockView(std::shared_ptr<const void> owner, const std::uint8_t* data, std::size_t size);
+
+    // Encoded block (Block::rlpEncode)
+    const std::uint8_t* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+    std::uint64_t index() const;
+    std::uint64_t timestamp() const;
+    Bytes32 hash() const;
+    Bytes32 prevHash() const;
+    Bytes32 stateBefore() const;
+    Bytes32 stateAfter() const;
+    Bytes32 txRoot() const;
+    Bytes32 receiptsRoot() const;
+
+    // Decoded header; reads nothing past the header's own bytes
+    BlockHeader header() const;
+
+    std::size_t txCount() const;
+    // `withSender` as for Transaction::rlpDecode
+    Transaction transaction(std::size_t i, bool withSender = true) const;
+
+    // Hashes of all transactions, in order, without decoding them
+    std::vector<Bytes32> txHashes() const;
+    Bytes32 txHash(std::size_t i) const;
+
+    // Receipt i belongs to transaction i (blocks may carry none)
+    std::size_t receiptCount() const;
+    Receipt receipt(std::size_t i) const;
+
+    // Fully decoded copy
+    Block toBlock() const;
+
+private:
+    std::shared_ptr<const void> owner_;
+    const std::uint8_t* data_;
+    std::size_t size_;
+    rlp::ItemRef header_;
+    rlp::ItemRef hash_;
+    const std::uint8_t* end_;               // end of the block's parts
+    BlockHeader::FieldRefs fields_;
+
+    Bytes32 hash32(const rlp::ItemRef& f) const;
+    std::uint64_t uint(std::size_t field) const;
+    rlp::ItemRef part(std::size_t part) const;
+    std::size_t count(std::size_t part) const;
+    rlp::ItemRef item(std::size_t part, std::size_t i) const;
+};
+
+// Append-only block log.
+//
+// On disk, blocks are appended to fixed-size segment files
+// (seg-NNNNN.dat) and located through an offset index (index.dat, 16 bytes
+// per block: [u32 segment][u32 length][u64 offset], little-endian).
+// Segments are read through mmap, so resident memory is bounded by the
+// page cache rather than the chain length. On open the index is
+// reconciled with the segments and a torn tail write is discarded.
+// Truncating only shortens the index; the dropped blocks' bytes stay in
+// their segment as dead space.
+//
+// freeze() moves closed segments of old blocks into compressed frozen
+// files (frz-NNNNN.dat, see FrozenSegment) and deletes the originals.
+// Their index entries are kept; get() then decodes the block's frame.
+//
+// prune() deletes whole closed segments of old blocks. The index is
+// rewritten without their entries, led by a marker entry
+// ([u32 0xFFFFFFFF][u32 0][u64 first block]) so positions keep meaning
+// block heights; reading a pruned block throws std::out_of_range.
+//
+// Without a directory the store keeps the encoded blocks in memory.
+class BlockStore {
+public:
+    static constexpr std::size_t kDefaultSegmentSize = std::size_t(64) << 20;
+
+    BlockStore() = default;
+    explicit BlockStore(const std::string& dir, std::size_t segmentSize = kDefaultSegmentSize);
+    ~BlockStore();
+
+    BlockStore(const BlockStore&) = delete;
+    BlockStore& operator=(const BlockStore&) = delete;
+
+    // Returns the new block's position (== its height)
+    std::uint64_t append(const Bytes& encoded);
+
+    // Throws std::out_of_range if `n` is not stored
+    BlockView get(std::uint64_t n) const;
+
+    // Header of block `n` only. Frozen blocks serve it from their
+    // uncompressed header section, so no frame is decoded. Throws
+    // std::out_of_range if `n` is not stored.
+    BlockHeader header(std::uint64_t n) const;
+
+    // Queue a read of block `n` on `io` into a buffer of its own. Unlike
+    // get(), this never blocks on a page fault, so one thread can keep
+    // many historical reads in flight. `done` runs from io.poll() with
+    // the block, or nullopt on an I/O error; in-memory stores and frozen
+    // blocks call it right away. Throws std::out_of_range if `n` is not
+    // stored. The store must outlive the reads it queued.
+    void readAsync(AsyncIo& io, std::uint64_t n, std::function<void(std::optional<BlockView>)> done) const;
+
+    // Keep only the first `n` blocks (reorgs). Views of dropped blocks
+    // stay readable. Throws std::out_of_range below first().
+    void truncate(std::uint64_t n);
+
+    // Flush appended blocks and the index to stable storage
+    void sync();
+
+    // Freeze every closed segment whose blocks all lie below height
+    // `below`, oldest first; returns how many were frozen. Compression
+    // runs without blocking append() or get().
+    std::size_t freeze(std::uint64_t below, const FreezerOptions& opts = {});
+
+    // Delete every closed segment whose blocks all lie below height
+    // `below`; returns how many blocks went. The newest block is always
+    // kept. The index is rewritten without holding the store lock, so
+    // append() and get() carry on meanwhile; views of pruned blocks stay
+    // readable. In-memory stores drop blocks one by one.
+    std::size_t prune(std::uint64_t below);
+
+    // One past the last block that prune() can only drop together with
+    // block `n` (the end of its segment). Throws std::out_of_range if `n`
+    // is not stored.
+    std::uint64_t segmentEnd(std::uint64_t n) const;
+
+    // Lowest stored block; everything below it was pruned
+    std::uint64_t first() const;
+
+    std::size_t size() const;
+    bool empty() const { return size() == 0; }
+    bool persistent() const { return !dir_.empty(); }
+    std::size_t segments() const;
+    std::size_t frozenSegments() const;
+
+private:
+    struct Location {
+        std::uint32_t segment;
+        std::uint32_t length;
+        std::uint64_t offset;
+    };
+
+    struct Segment {
+        std::string path;
+        std::uint64_t size{0};
+        std::shared_ptr<const MappedFile> map;
+        int fd{-1};             // for readAsync, opened on first use
+        std::size_t reads{0};   // readAsync reads queued on fd
+        std::shared_ptr<const FrozenSegment> frozen;
+        bool pruned{false};
+    };
+
+    std::string dir_;
+    std::size_t segmentSize_{kDefaultSegmentSize};
+
+    mutable std::mutex mutex_;
+    std::uint64_t first_{0};            // blocks pruned off the front
+    std::deque<Location> index_;        // block first_ + i
+    mutable std::vector<Segment> segments_;
+    std::deque<std::shared_ptr<const Bytes>> memory_;
+    std::uint64_t truncations_{0};      // lets prune() spot index rewinds
+
+    std::FILE* segFile_{nullptr};
+    std::FILE* indexFile_{nullptr};
+
+    std::mutex freezeMutex_;    // one freeze() or prune() at a time
+
+    std::string segmentPath(std::uint32_t id) const;
+    std::string frozenPath(std::uint32_t id) const;
+    void recover();
+    Bytes encodeIndex(std::size_t from, std::size_t to) const;
+    void openSegment(std::uint32_t id);
+    // Close a frozen or pruned segment's fd once no read is queued on it,
+    // so the deleted file's space is released
+    void releaseFdLocked(Segment& seg) const;
+};
+
+} // namespace gambit
@@ -1,47 +1,359 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
 #include <vector>
 #include <mutex>
+#include <memory>
+#include <optional>
 
 #include "gambit/block.hpp"
+#include "gambit/block_store.hpp"
+#include "gambit/chain_index.hpp"
+#include "gambit/change_feed.hpp"
+#include "gambit/fork_tree.hpp"
+#include "gambit/mempool.hpp"
 #include "gambit/state.hpp"
 #include "gambit/transaction.hpp"
 #include "gambit/genesis.hpp"
+#include "gambit/merkle.hpp"
+#include "gambit/parallel_executor.hpp"
+#include "gambit/pre_execution.hpp"
+#include "gambit/rcu.hpp"
+#include "gambit/sharded_executor.hpp"
+#include "gambit/snapshot.hpp"
+#include "gambit/archive.hpp"
+#include "gambit/wal.hpp"
 
 namespace gambit {
 
+// Chain tip as of one point in time: head block and the matching state
+// version. Immutable once published. Pending transactions are not part
+// of it (a copy per insert would make every insert O(n)); readers ask
+// Blockchain::pool(), which only waits for an insert in progress.
+struct ChainView {
+    std::uint64_t height{0};
+    Bytes32 headHash{};
+    Bytes32 stateRoot{};
+    SnapshotTree::Version state;
+};
+
+// History pruning: keep the bodies, receipts and index entries of the
+// last `keepBlocks` blocks (never fewer than the deepest reorg) and
+// delete older ones; 0 keeps everything. Deletion is limited to
+// `bytesPerSecond` of block data, 0 = as fast as it goes.
+struct PruneConfig {
+    std::uint64_t keepBlocks{0};
+    std::uint64_t bytesPerSecond{0};
+};
+
 class Blockchain {
 public:
     explicit Blockchain(const GenesisConfig& genesis);
 
-    // Add a transaction to the mempool
+    // Add a transaction to the mempool. Throws std::runtime_error if the
+    // pool does not take it (known, nonce too low, underpriced
+    // replacement, pool full).
     void addTransaction(const Transaction& tx);
 
     // Mine a block from current mempool
     Block mineBlock();
 
-    // Validate and append a received block
+    // Validate and add a received block. A block on the head is
+    // re-executed and appended, and rejected unless its stateAfter
+    // matches. A block on a side branch is kept in the fork tree; once its
+    // branch is longer than the canonical chain (ties keep the block seen
+    // first) the chain reorgs onto it.
     bool addBlock(const Block& block);
 
-    const std::vector<Block>& chain() const { return chain_; }
+    // Deepest reorg addBlock will perform; undo journals are kept for
+    // this many blocks, and side branches forking below it are dropped
+    void setMaxReorgDepth(std::size_t depth);
+    std::size_t maxReorgDepth() const { return maxReorgDepth_; }
+
+    // Blocks held on side branches
+    std::size_t forkBlocks() const { return forks_.size(); }
+
+    // Append a block whose proof the caller already verified, whose
+    // transactions it executed and whose post-state root it checked (see
+    // BlockImporter), or a template built locally from preparePending();
+    // only the link to the head is re-checked
+    bool commitVerified(const Block& block, const SnapshotBase::Entries& writes);
+
+    // Head block number and stored blocks; views stay valid while held.
+    // Reading a pruned block throws std::out_of_range.
+    std::uint64_t height() const { return store_->size() - 1; }
+    std::uint64_t firstBlock() const { return store_->first(); }
+    BlockView head() const { return store_->get(height()); }
+    BlockView blockView(std::uint64_t n) const { return store_->get(n); }
+    Block blockAt(std::uint64_t n) const { return store_->get(n).toBlock(); }
+    BlockHeader headerAt(std::uint64_t n) const { return store_->header(n); }
+
+    // Queue a read of block `n` on `io` (see BlockStore::readAsync)
+    void readBlockAsync(AsyncIo& io, std::uint64_t n, std::function<void(std::optional<BlockView>)> done) const
+    {
+        store_->readAsync(io, n, std::move(done));
+    }
+
+    // Constant-time lookups by block / transaction hash. The index and the
+    // store are read separately, so what the store returns is checked
+    // against the hash; a block reorged or pruned away in between is
+    // reported as missing.
+    std::optional<BlockView> blockByHash(const Bytes32& hash) const;
+    std::optional<BlockHeader> headerByHash(const Bytes32& hash) const;
+
+    // Canonical block holding a transaction, and its position there
+    struct TxBlock {
+        BlockView block;
+        std::uint32_t position;
+    };
+    std::optional<TxBlock> transactionBlock(const Bytes32& hash) const;
+
+    // Inclusion proof of a canonical transaction against its block's
+    // txRoot; a light client holding the header checks it with
+    // merkle::verify(header.txRoot, txHash, proof)
+    struct TxProof {
+        Bytes32 blockHash;
+        BlockHeader header;
+        merkle::Proof proof;
+    };
+    std::optional<TxProof> transactionProof(const Bytes32& hash) const;
+    std::optional<ChainIndex::TxLocation> findTransaction(const Bytes32& hash) const
+    {
+        return index_.transaction(hash);
+    }
+
+    // Canonical transactions sent or received by `addr`, a page at a time
+    // (see AddressIndex::query); costs what the address did, not the
+    // chain length
+    AddressIndex::Page addressHistory(const Address& addr, AddressIndex::Posting from, std::size_t limit,
+                                      bool newestFirst = false) const
+    {
+        return index_.addresses().query(addr, from, limit, newestFirst);
+    }
+    std::uint64_t addressTransactionCount(const Address& addr) const { return index_.addresses().count(addr); }
+
+    // Consistent read-only view of the tip for RPC / P2P threads. Taking
+    // and releasing it never blocks, and never blocks block production.
+    Rcu<ChainView>::Guard view() const { return view_.read(); }
+
+    // Committed and reverted blocks, their transactions and the accounts
+    // they changed, as they happen. Events are published under the chain
+    // lock; a Backpressure::Block subscriber that falls a ring behind
+    // holds up block commits until it catches up.
+    ChangeFeed& changes() { return changes_; }
+
+    // Writer-side state; not safe to read while blocks are produced
     const State& state() const { return state_; }
 
+    // Flat account snapshot; safe to read concurrently with block production
+    const SnapshotTree& snapshot() const { return snapshot_; }
+
+    // Keep on-disk data (block segments, snapshot tables, write-ahead
+    // log) under `dir`, in block segments of `segmentSize` bytes. Blocks
+    // already stored there are re-executed on top of genesis (or of a
+    // state checkpoint once pruned), then the log tail is replayed:
+    // blocks the store lost are re-applied from their logged writes and
+    // logged transactions return to the mempool.
+    //
+    // With a data dir, every block, rollback and mempool insert is logged
+    // and synced before the call that made it returns; concurrent callers
+    // share fsyncs.
+    void setDataDir(const std::string& dir, std::size_t segmentSize = BlockStore::kDefaultSegmentSize);
+
+    // Once the log outgrows this, the block store is synced and the log
+    // restarted
+    void setWalCheckpointBytes(std::uint64_t bytes) { walCheckpointBytes_ = bytes; }
+    const WriteAheadLog* wal() const { return wal_.get(); }
+
+    // Record types in the chain's log
+    enum class WalRecord : std::uint8_t {
+        Block = 1,         // block + the account writes it produced
+        Transaction = 2,   // transaction entering the mempool
+        Rewind = 3,        // canonical chain rolled back to a height
+    };
+
+    // Freezer: block segments lying deeper than `depth` (and than the
+    // deepest reorg) below the head move into compressed frozen files;
+    // 0 turns it off. Frozen blocks stay readable, at the cost of
+    // decoding their frame.
+    void setFreezeDepth(std::uint64_t depth) { freezeDepth_ = depth; }
+    std::uint64_t freezeDepth() const { return freezeDepth_; }
+
+    // Freeze what has become cold; returns the number of segments frozen.
+    // Compresses without holding the chain lock; meant to be called from
+    // an idle loop, not concurrently with setDataDir.
+    std::size_t freezeColdBlocks();
+
+    // Pruning (see PruneConfig). With a data dir the head state is
+    // checkpointed under <dir>/checkpoints, since a restart can no longer
+    // replay from genesis; blocks are only deleted up to a checkpoint
+    // below the reorg window. Throws std::invalid_argument in archive
+    // mode, which keeps exactly the history pruning drops.
+    void setPruning(const PruneConfig& cfg);
+    const PruneConfig& pruning() const { return pruneCfg_; }
+
+    // Delete whole block segments that fell out of the kept window,
+    // oldest first and within the byte budget; returns the number of
+    // blocks deleted. Runs without holding the chain lock; meant to be
+    // called from an idle loop, not concurrently with setDataDir.
+    std::size_t pruneHistory();
+
+    // Survives pruning of block 0
+    const Bytes32& genesisHash() const { return genesisHash_; }
+    const Bytes32& genesisRoot() const { return genesisRoot_; }
+
+    // Archive mode: keep reverse diffs + checkpoints from the current head on
+    void enableArchive(const ArchiveConfig& cfg);
+    bool archiveEnabled() const { return archive_ != nullptr; }
+
+    // Account state after block `height`; throws std::out_of_range if that
+    // height is in the future or was not archived. Safe from any thread
+    // and never waits for the chain lock.
+    std::optional<Account> accountAt(const Address& addr, std::uint64_t height);
+
+    // Stateless validation: addBlock re-executes received blocks against
+    // their witness and rejects any whose stateAfter does not match
+    void setStatelessValidation(bool enabled) { statelessValidation_ = enabled; }
+    bool statelessValidation() const { return statelessValidation_; }
+
     std::uint64_t chainId() const { return chainId_; }
 
-    // Simple accessors for RPC
-    const std::vector<Transaction>& mempool() const { return mempool_; }
+    // Executable pending transactions in the order the next block takes
+    // them; safe from any thread
+    std::vector<Transaction> mempool() const;
+    // All pending transactions, queued ones included (lookups by hash)
+    const Mempool& pool() const { return mempool_; }
+
+    // Transactions a mined block takes at most; 0 = all executable ones
+    void setMaxBlockTransactions(std::size_t n);
     
     bool validateTransaction(const Transaction& tx, std::string& err) const;
 
-    std::string computeTxRoot(const std::vector<Transaction>& txs) const; // make public for engine
+    // Binary Merkle root of the transactions' hashes; make public for engine
+    Bytes32 computeTxRoot(const std::vector<Transaction>& txs) const;
+
+    // Receipts of transactions that all executed, and their MPT root as
+    // committed to in the header
+    std::vector<Receipt> computeReceipts(const std::vector<Transaction>& txs) const;
+    Bytes32 computeReceiptsRoot(const std::vector<Receipt>& receipts) const;
+
+    // Rebuild an executed block's receipts; true if they match both its
+    // receiptsRoot and the receipts it carries (which RPC serves as-is)
+    bool checkReceipts(const Block& block) const;
+
+    // Block transaction executor (shared with mining engines)
+    const ParallelExecutor& executor() const { return executor_; }
+
+    // Replace the executor's worker pool. Must not be called while a
+    // BlockImporter is running: its execute stage uses executor()
+    // without the chain lock.
+    void setExecutionThreads(std::size_t threads);
+
+    // Execute blocks on `shards` address-prefix partitions instead of the
+    // speculative executor; 0 switches back
+    void setShardCount(std::size_t shards);
+    std::size_t shardCount() const { return sharded_ ? sharded_->shards() : 0; }
+
+    // Speculatively execute the mempool against the head state so block
+    // production can reuse the results. Cheap when nothing changed; meant
+    // to be called while the miner is idle.
+    void preExecutePending();
+
+    // Execute the mempool against the head state, reusing pre-executed
+    // results whose read sets are still valid
+    ExecutionResult executePending();
+
+    // The next block's body, taken and executed under one lock against
+    // the head it builds on. Transactions that fail are left out (and
+    // those with a wrong chain or nonce dropped from the mempool), so
+    // `result` is ok and executed exactly `transactions`.
+    struct PendingBlock {
+        std::uint64_t height{0};    // of the parent
+        Bytes32 parentHash{};
+        MptTrie trie;               // parent state
+        std::vector<Transaction> transactions;
+        ExecutionResult result;
+    };
+    PendingBlock preparePending();
 
 private:
-    std::vector<Block> chain_;
+    std::unique_ptr<BlockStore> store_;
+    ChainIndex index_;
     State state_;
-    std::vector<Transaction> mempool_;
+    // state_ as a trie: built on first use, then updated with the
+    // accounts each commit writes; dropped when a rollback or checkpoint
+    // load changes state_ another way
+    std::optional<MptTrie> trie_;
+    Mempool mempool_;
+    std::atomic<std::size_t> maxBlockTransactions_{0};
     std::mutex mutex_;
     std::uint64_t chainId_{0};
+    ParallelExecutor executor_;
+    SnapshotTree snapshot_;
+    std::unique_ptr<ArchiveStore> archive_;
+    std::mutex archiveMutex_;       // held by accountAt and when archive_ is replaced
+    ArchiveConfig archiveCfg_;
+    bool statelessValidation_{false};
+
+    // Side branches, and the prior values of the accounts each recent
+    // canonical block wrote: journals_.back() undoes the head block
+    ForkTree forks_;
+    std::deque<ReverseDiff> journals_;
+    std::size_t maxReorgDepth_{64};
+
+    std::unique_ptr<WriteAheadLog> wal_;
+    std::uint64_t walSeq_{0};               // last record logged
+    std::uint64_t walCheckpointBytes_{std::uint64_t(64) << 20};
+    std::uint64_t freezeDepth_{0};
+
+    std::string dataDir_;
+    Bytes32 genesisHash_{};
+    Bytes32 genesisRoot_{};
+    PruneConfig pruneCfg_;
+    std::mutex pruneMutex_;                 // one pruneHistory() at a time
+    std::map<std::uint64_t, Bytes32> checkpoints_;  // height -> state root
+    double pruneTokens_{0};                 // byte budget left
+    std::chrono::steady_clock::time_point pruneRefill_;
+
+    Rcu<ChainView> view_;
+    ChangeFeed changes_;
+
+    std::unique_ptr<ShardedExecutor> sharded_;
+    PreExecutionCache preExec_;
+    std::uint64_t pendingVersion_{0};       // bumped on mempool/head changes
+    std::uint64_t preExecutedVersion_{0};
 
     void initGenesis(const GenesisConfig& genesis);
+    bool verifyStateless(const Block& block) const;
+    bool extendLocked(const Block& block);
+    void commitLocked(const Block& block, const SnapshotBase::Entries& writes);
+    ReverseDiff applyWritesLocked(const SnapshotBase::Entries& writes);
+    const MptTrie& trieLocked();
+    Bytes32 rootAfterLocked(const SnapshotBase::Entries& writes);
+    void pushJournalLocked(ReverseDiff undo);
+    bool reorgLocked(const Bytes32& tip);
+    std::vector<Block> rollbackLocked(std::uint64_t target);
+    void replayStored();
+    std::string checkpointPath(std::uint64_t height) const;
+    void loadCheckpoints();
+    void writeCheckpoint();
+    void recoverWalLocked(const WriteAheadLog& wal);
+    void logLocked(WalRecord type, const Bytes& payload);   // buffers; sets walSeq_
+    void checkpointWalLocked();
+    void syncWal(std::uint64_t seq);
+    bool addBlockLocked(const Block& block);
+    void publishViewLocked();
+    void announceLocked(const Block& block, ChainEvent::Kind kind, const SnapshotBase::Entries& accounts,
+                        const std::vector<Address>& deleted = {});
+    ExecutionResult executePendingLocked(const std::vector<Transaction>& pending);
+    std::uint64_t nonceLocked(const Address& addr) const;
+    std::vector<Transaction> pendingLocked() const;
+    PendingBlock preparePendingLocked();
+    // Serial pass over the mempool that fills `txs` without the
+    // transactions that fail
+    ExecutionResult skipFailingLocked(std::vector<Transaction>& txs);
 };
 
 } // namespace gambit
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <optional>
+#include <ostream>
+
+#include "gambit/block_importer.hpp"
+#include "gambit/blockchain.hpp"
+
+namespace gambit {
+
+// Chain export stream: one record per block, in height order,
+// [u32 length][Block::rlpEncode()] with the length little-endian. Used to
+// move a chain between hosts and to bootstrap a node without syncing.
+
+// Write blocks [from, to] of `chain`; returns how many were written.
+// Throws std::runtime_error if the stream fails.
+std::uint64_t exportChain(const Blockchain& chain, std::ostream& out, std::uint64_t from, std::uint64_t to);
+
+// Reads an export stream one record at a time
+class ChainFileReader {
+public:
+    explicit ChainFileReader(std::istream& in) : in_(in) {}
+
+    // Next block's encoding, or nullopt at the end of the stream. Throws
+    // std::runtime_error on a truncated or oversized record.
+    std::optional<Bytes> next();
+
+    std::uint64_t bytesRead() const { return bytes_; }
+
+private:
+    std::istream& in_;
+    std::uint64_t bytes_{0};
+};
+
+// Submit every block of `in` above the chain's current head to
+// `importer`, so an interrupted import can simply be rerun. `onSubmit`
+// runs after each submitted block. Returns how many were submitted;
+// stops early once the importer has failed.
+std::uint64_t importChain(const Blockchain& chain, ChainFileReader& in, BlockImporter& importer,
+                          const std::function<void(std::uint64_t submitted)>& onSubmit = {});
+
+} // namespace gambit
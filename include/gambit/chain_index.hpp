@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "gambit/address_index.hpp"
+#include "gambit/block.hpp"
+
+namespace gambit {
+
+// Hash lookups over the stored chain: block hash -> height and
+// tx hash -> (height, position). A transaction's receipt sits at the
+// same position in its block's receipt list.
+//
+// A block and all of its transactions become visible to readers
+// together. The address activity index is kept alongside and follows
+// add(), remove() and clear().
+class ChainIndex {
+public:
+    struct TxLocation {
+        std::uint64_t height;
+        std::uint32_t position;
+    };
+
+    void add(const Block& block);
+    // Undo add() for a block leaving the canonical chain
+    void remove(const Block& block);
+    // Same, from the block's hash and transaction hashes (pruning)
+    void remove(std::uint64_t height, const Bytes32& hash, const std::vector<Bytes32>& txHashes);
+    void clear();
+
+    std::optional<std::uint64_t> blockHeight(const Bytes32& hash) const;
+    std::optional<TxLocation> transaction(const Bytes32& hash) const;
+
+    std::size_t blocks() const;
+    std::size_t transactions() const;
+
+    AddressIndex& addresses() { return addresses_; }
+    const AddressIndex& addresses() const { return addresses_; }
+
+private:
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<Bytes32, std::uint64_t, Bytes32Hash> blocks_;
+    std::unordered_map<Bytes32, TxLocation, Bytes32Hash> txs_;
+    AddressIndex addresses_;
+};
+
+} // namespace gambit
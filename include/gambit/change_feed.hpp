@@ -0,0 +1,128 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include "gambit/account.hpp"
+#include "gambit/address.hpp"
+#include "gambit/hash.hpp"
+
+namespace gambit {
+
+// One change to the canonical chain. A committed block is announced as
+// its Transaction events, then an Account event per account it wrote,
+// then BlockCommitted; a reverted block as the restored Account values,
+// then BlockReverted. The Block* event closes the group, so consumers can
+// apply a group once it is complete.
+struct ChainEvent {
+    enum class Kind : std::uint8_t { BlockCommitted, BlockReverted, Transaction, Account };
+
+    Kind kind{Kind::BlockCommitted};
+    std::uint64_t height{0};
+    std::uint32_t position{0};  // Transaction: index in the block; Block*: transaction count
+    bool deleted{false};        // Account: removed by the revert
+    Bytes32 hash{};             // Block*: block hash; Transaction: transaction hash
+    Bytes32 stateRoot{};        // Block*: state root once the event applies
+    Address address;            // Account: the account; Transaction: the sender
+    Account account;            // Account: its value once the event applies
+};
+
+// In-process feed of ChainEvents: a single-producer, multi-consumer ring.
+//
+// Every slot is a seqlock (an odd sequence number while it is written)
+// over the event's bytes, so publish() and the consumers never take a
+// lock. Each consumer owns a cursor; a consumer reads slot by slot and
+// re-checks the sequence afterwards, so an event the producer overwrote
+// meanwhile is detected rather than torn.
+//
+// What happens when a consumer falls a whole ring behind is its
+// backpressure policy: Block makes publish() wait for it (nothing is
+// lost; block commits slow down to its pace), Drop lets the producer
+// run over it and the consumer skips to the oldest event still held,
+// counting what it missed.
+//
+// publish() must be serialized by the caller. Subscriptions must not
+// outlive the feed.
+class ChangeFeed {
+    static constexpr std::size_t kWords = (sizeof(ChainEvent) + 7) / 8;
+    static_assert(std::is_trivially_copyable<ChainEvent>::value, "events are copied as raw words");
+
+    struct Slot {
+        std::atomic<std::uint64_t> seq{0};      // 2n + 2 once event n is in
+        std::array<std::atomic<std::uint64_t>, kWords> words{};
+    };
+
+    enum : std::uint32_t { kFree, kClaimed, kBlocking, kDropping };
+
+    struct alignas(64) Reader {
+        std::atomic<std::uint32_t> state{kFree};
+        std::atomic<std::uint64_t> cursor{0};   // next event to read
+    };
+
+public:
+    static constexpr std::size_t kDefaultCapacity = std::size_t(1) << 14;
+    static constexpr std::size_t kMaxSubscribers = 64;
+
+    enum class Backpressure { Block, Drop };
+
+    class Subscription {
+    public:
+        ~Subscription();
+        Subscription(const Subscription&) = delete;
+        Subscription& operator=(const Subscription&) = delete;
+
+        // Next event, or nullopt if the consumer is caught up
+        std::optional<ChainEvent> poll();
+
+        // Next event, waiting up to `timeout` for one
+        std::optional<ChainEvent> next(std::chrono::milliseconds timeout);
+
+        // Events passed over after the producer ran past this consumer
+        // (Drop only)
+        std::uint64_t missed() const { return missed_; }
+
+        // Events published but not read yet
+        std::uint64_t backlog() const;
+
+    private:
+        friend class ChangeFeed;
+        Subscription(ChangeFeed& feed, Reader& reader) : feed_(feed), reader_(reader) {}
+
+        ChangeFeed& feed_;
+        Reader& reader_;
+        std::uint64_t missed_{0};
+    };
+
+    // `capacity` is rounded up to a power of two
+    explicit ChangeFeed(std::size_t capacity = kDefaultCapacity);
+
+    ChangeFeed(const ChangeFeed&) = delete;
+    ChangeFeed& operator=(const ChangeFeed&) = delete;
+
+    // Start reading at the next event published. Throws
+    // std::runtime_error once kMaxSubscribers are attached.
+    std::unique_ptr<Subscription> subscribe(Backpressure policy = Backpressure::Drop);
+
+    // Append an event; with a Block subscriber a full ring behind, waits
+    // for it first
+    void publish(const ChainEvent& event);
+
+    // Events published so far
+    std::uint64_t published() const { return head_.load(std::memory_order_acquire); }
+    std::size_t capacity() const { return slots_.size(); }
+
+private:
+    std::vector<Slot> slots_;
+    std::size_t mask_;
+    alignas(64) std::atomic<std::uint64_t> head_{0};
+    std::array<Reader, kMaxSubscribers> readers_;
+
+    void waitForBlockingReaders(std::uint64_t n) const;
+};
+
+} // namespace gambit
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "gambit/block.hpp"
+
+namespace gambit {
+
+// Blocks that are not on the canonical chain, keyed by hash.
+//
+// Every block's parent is either canonical or itself in the tree, so the
+// tree is a set of branches hanging off canonical ancestors. Blocks
+// enter when they arrive on a side branch or when a reorg takes them off
+// the canonical chain, and leave when they become canonical, turn out
+// to be invalid or fall below the reorg horizon.
+class ForkTree {
+public:
+    // False if the block is already present
+    bool add(const Block& block);
+
+    const Block* find(const Bytes32& hash) const;
+    bool contains(const Bytes32& hash) const { return blocks_.count(hash) != 0; }
+
+    void erase(const Bytes32& hash);
+
+    // Remove `hash` and every block that descends from it
+    void eraseSubtree(const Bytes32& hash);
+
+    // Remove every block at or below `height`
+    void prune(std::uint64_t height);
+
+    // Walk parents from `tip` while they are in the tree; returns the
+    // blocks oldest first. The first block's parent is not in the tree.
+    std::vector<const Block*> branch(const Bytes32& tip) const;
+
+    std::size_t size() const { return blocks_.size(); }
+
+private:
+    std::unordered_map<Bytes32, Block, Bytes32Hash> blocks_;
+};
+
+} // namespace gambit
@@ -0,0 +1,108 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gambit/block_header.hpp"
+#include "gambit/lz.hpp"
+#include "gambit/mapped_file.hpp"
+
+namespace gambit {
+
+struct FreezerOptions {
+    // Dictionary trained per file on its transaction encodings
+    std::size_t dictBytes{std::size_t(32) << 10};
+
+    // Consecutive blocks are compressed together up to this many raw
+    // bytes; reading one block decompresses its whole frame
+    std::size_t frameBytes{std::size_t(64) << 10};
+};
+
+// Immutable, compressed copy of one block segment (frz-NNNNN.dat).
+//
+// Layout, little-endian:
+//   header  [u32 magic "GFRZ"][u32 version][u64 first block]
+//           [u64 segment bytes][u32 dict length][dict]
+//   frames  LZ-compressed runs of consecutive blocks, then of their
+//           encoded headers alone
+//   index   per frame: [u64 file offset][u32 compressed length][u32 raw length]
+//           per block: [u32 frame][u32 offset in frame][u32 length]
+//                      [u32 header frame][u32 offset in frame][u32 length]
+//   footer  [u64 index offset][u32 frames][u32 blocks][u32 magic]
+//
+// The index makes the file seekable: a block read maps straight to
+// one frame. The last frame decoded is cached, so walking blocks in order
+// decodes each frame once. Header frames are cached apart from block
+// frames, so serving headers never decodes a body.
+class FrozenSegment {
+public:
+    // Raw bytes of one block: the decoded frame holding it (shared with
+    // other readers of that frame) and the block's place in it
+    struct Slice {
+        std::shared_ptr<const Bytes> frame;
+        std::size_t offset;
+        std::size_t length;
+    };
+
+    // Compress `blocks` (encoded, heights first, first+1, ...) into
+    // `path`, written via a temporary file and synced before it appears.
+    // `segmentBytes` is the size of the segment being replaced.
+    static void write(const std::string& path, std::uint64_t first, std::uint64_t segmentBytes,
+                      const std::vector<std::pair<const std::uint8_t*, std::size_t>>& blocks,
+                      const FreezerOptions& opts = {});
+
+    // Throws std::runtime_error if the file is missing or malformed
+    explicit FrozenSegment(const std::string& path);
+
+    std::uint64_t first() const { return first_; }
+    std::size_t count() const { return blocks_.size(); }
+    bool contains(std::uint64_t n) const { return n >= first_ && n - first_ < blocks_.size(); }
+
+    std::uint64_t segmentBytes() const { return segmentBytes_; }
+    std::uint64_t fileBytes() const { return file_.size(); }
+
+    // Throws std::out_of_range unless contains(n)
+    Slice read(std::uint64_t n) const;
+
+    // Header of block `n`, from its header frame. Throws
+    // std::out_of_range unless contains(n).
+    BlockHeader header(std::uint64_t n) const;
+
+private:
+    struct Frame {
+        std::uint64_t offset;
+        std::uint32_t length;
+        std::uint32_t rawLength;
+    };
+    struct Entry {
+        std::uint32_t frame;
+        std::uint32_t offset;
+        std::uint32_t length;
+        std::uint32_t headerFrame;
+        std::uint32_t headerOffset;
+        std::uint32_t headerLength;
+    };
+    // Last frame decoded
+    struct FrameCache {
+        std::mutex mutex;
+        std::size_t frame{0};
+        std::shared_ptr<const Bytes> bytes;
+    };
+
+    MappedFile file_;
+    std::uint64_t first_{0};
+    std::uint64_t segmentBytes_{0};
+    lz::Dictionary dict_;
+    std::vector<Frame> frames_;
+    std::vector<Entry> blocks_;
+
+    mutable FrameCache blockCache_;
+    mutable FrameCache headerCache_;
+
+    std::shared_ptr<const Bytes> decode(std::size_t frame, FrameCache& cache) const;
+};
+
+} // namespace gambit
@@ -1,18 +1,22 @@
 #pragma once
 #include <vector>
 #include <cstdint>
+#include <string>
 #include "gambit/address.hpp"
+#include "gambit/uint256.hpp"
 
 namespace gambit {
 
 struct GenesisAccount {
     Address address;
-    std::uint64_t balance{0};
+    uint256 balance;
 };
 
 struct GenesisConfig {
     std::vector<GenesisAccount> premine;
     std::uint64_t chainId{1};
+    // Optional state snapshot (state_snapshot.hpp) loaded before the premine
+    std::string stateFile;
 };
 
 } // namespace gambit
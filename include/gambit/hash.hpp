@@ -14,10 +14,26 @@ std::string toHex(const Bytes& data);
 std::string toHex(const Bytes32& data);
 Bytes       fromHex(const std::string& hex);
 
+// Exactly 32 bytes of hex, with or without "0x"; throws std::runtime_error
+Bytes32     fromHex32(const std::string& hex);
+
 // Keccak-256 hashing
 Bytes   keccak256(const Bytes& input);
 Bytes   keccak256(const std::string& input);
 Bytes32 keccak256_32(const Bytes& input);
 Bytes32 keccak256_32(const std::string& input);
+Bytes32 keccak256_32(const std::uint8_t* data, std::size_t size);
+
+// Hash functor for unordered containers keyed by a 32-byte hash
+struct Bytes32Hash {
+    std::size_t operator()(const Bytes32& h) const noexcept {
+        // Keys are keccak output, so any 8 bytes are uniformly distributed
+        std::size_t v = 0;
+        for (std::size_t i = 0; i < sizeof(std::size_t); ++i) {
+            v = (v << 8) | h[i];
+        }
+        return v;
+    }
+};
 
 } // namespace gambit
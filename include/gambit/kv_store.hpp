@@ -0,0 +1,88 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <vector>
+
+#include "gambit/rlp.hpp"
+
+namespace gambit {
+
+// Cursor over keys in ascending byte order
+class KvIterator {
+public:
+    virtual ~KvIterator() = default;
+    virtual bool valid() const = 0;
+    virtual const Bytes& key() const = 0;
+    virtual const Bytes& value() const = 0;
+    virtual void next() = 0;
+};
+
+// Point-in-time read view; later writes do not affect it
+class KvSnapshot {
+public:
+    virtual ~KvSnapshot() = default;
+    virtual std::optional<Bytes> get(const Bytes& key) const = 0;
+
+    // Keys starting with `prefix` (empty = all keys)
+    virtual std::unique_ptr<KvIterator> iterate(const Bytes& prefix) const = 0;
+};
+
+// Writes applied together by KvStore::write()
+class WriteBatch {
+public:
+    struct Op {
+        Bytes key;
+        std::optional<Bytes> value;   // nullopt = delete
+    };
+
+    void put(Bytes key, Bytes value) { ops_.push_back({std::move(key), std::move(value)}); }
+    void del(Bytes key) { ops_.push_back({std::move(key), std::nullopt}); }
+    void clear() { ops_.clear(); }
+
+    const std::vector<Op>& ops() const { return ops_; }
+    std::size_t size() const { return ops_.size(); }
+    bool empty() const { return ops_.empty(); }
+
+private:
+    std::vector<Op> ops_;
+};
+
+// Ordered byte-string key/value storage shared by the node's
+// persistent structures. Every operation is thread-safe; a batch becomes
+// visible to readers all at once. Later operations in a batch win over
+// earlier ones on the same key.
+class KvStore {
+public:
+    virtual ~KvStore() = default;
+
+    virtual std::optional<Bytes> get(const Bytes& key) const = 0;
+    virtual void write(const WriteBatch& batch) = 0;
+    virtual std::shared_ptr<const KvSnapshot> snapshot() const = 0;
+
+    void put(Bytes key, Bytes value);
+    void del(Bytes key);
+
+    // Keys starting with `prefix` as of now
+    std::unique_ptr<KvIterator> iterate(const Bytes& prefix) const;
+};
+
+// std::map-backed store for tests and ephemeral nodes. Snapshots share
+// the map until the next write copies it.
+class MemoryKvStore : public KvStore {
+public:
+    std::optional<Bytes> get(const Bytes& key) const override;
+    void write(const WriteBatch& batch) override;
+    std::shared_ptr<const KvSnapshot> snapshot() const override;
+
+    std::size_t size() const;
+
+private:
+    using Map = std::map<Bytes, Bytes>;
+
+    mutable std::shared_mutex mutex_;
+    std::shared_ptr<Map> data_ = std::make_shared<Map>();
+};
+
+} // namespace gambit
@@ -1,6 +1,5 @@
 #pragma once
 #include <vector>
-#include <string>
 #include <cstdint>
 
 #include "gambit/address.hpp"
@@ -10,7 +9,7 @@ namespace gambit {
 
 struct Log {
     Address address;
-    std::vector<std::string> topics; // 32-byte hex strings
+    std::vector<Bytes32> topics;
     Bytes data;
 };
 
@@ -0,0 +1,111 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gambit/kv_store.hpp"
+#include "gambit/wal.hpp"
+
+namespace gambit {
+
+struct LsmOptions {
+    // Memtable size at which it is written out as a table
+    std::size_t memtableBytes{std::size_t(4) << 20};
+
+    // Number of adjacent tables each background merge takes
+    std::size_t compactionTrigger{4};
+
+    // Bloom filter size; 10 bits per key gives ~1% false positives
+    std::size_t bloomBitsPerKey{10};
+
+    // fsync the log before write() returns. Off, a crash can lose the
+    // most recent writes, but never leaves a torn batch.
+    bool syncWrites{true};
+};
+
+// Log-structured, file-backed KvStore.
+//
+// Writes go to a write-ahead log and an in-memory sorted memtable. A full
+// memtable is written out as an immutable sorted table (NNNNNN.sst) and
+// the log restarted. Each table carries a bloom filter over its keys and
+// a sparse index, so looking up an absent key usually reads no table
+// data at all and a present one reads a handful of entries. Reads check
+// the memtable, then the tables newest-first.
+//
+// Compaction is size-tiered: once `compactionTrigger` adjacent tables
+// exist where none outweighs the newer ones before it, a background
+// thread merges just those into one, dropping overwritten values (and
+// deletions, if the run reaches the oldest table). Merged tables grow
+// by tiers, so each byte is rewritten about log(total / memtable) times
+// rather than on every merge. MANIFEST names the live tables and is
+// replaced by rename, so a crash leaves either the old or the new set.
+class LsmKvStore : public KvStore {
+public:
+    struct Stats {
+        std::uint64_t flushes{0};
+        std::uint64_t compactions{0};
+        std::uint64_t compactedBytes{0};   // table data written by merges
+        std::uint64_t bloomSkips{0};       // table lookups the filter answered
+        std::uint64_t tableReads{0};       // table lookups that read entries
+    };
+
+    explicit LsmKvStore(const std::string& dir, LsmOptions opts = {});
+    ~LsmKvStore() override;
+
+    LsmKvStore(const LsmKvStore&) = delete;
+    LsmKvStore& operator=(const LsmKvStore&) = delete;
+
+    std::optional<Bytes> get(const Bytes& key) const override;
+    void write(const WriteBatch& batch) override;
+    std::shared_ptr<const KvSnapshot> snapshot() const override;
+
+    // Write the memtable out now
+    void flush();
+
+    // Block until no merge is running or due
+    void waitForCompaction();
+
+    std::size_t tables() const;
+    Stats stats() const;
+
+    // Defined in lsm_store.cpp
+    struct Table;
+    struct Memtable;
+
+private:
+    using TableList = std::vector<std::shared_ptr<Table>>;   // newest first
+
+    std::string dir_;
+    LsmOptions opts_;
+    std::unique_ptr<WriteAheadLog> wal_;
+
+    mutable std::shared_mutex mutex_;
+    std::shared_ptr<Memtable> mem_;
+    std::shared_ptr<const TableList> tables_;
+    std::uint64_t nextId_{1};
+    std::atomic<bool> compactionDue_{false};    // a merge run exists; readable without mutex_
+
+    std::mutex compactMutex_;
+    std::condition_variable compactCv_;
+    bool compacting_{false};
+    bool stopping_{false};
+    std::thread compactor_;
+
+    std::atomic<std::uint64_t> flushes_{0};
+    std::atomic<std::uint64_t> compactions_{0};
+    std::atomic<std::uint64_t> compactedBytes_{0};
+    mutable std::atomic<std::uint64_t> bloomSkips_{0};
+    mutable std::atomic<std::uint64_t> tableReads_{0};
+
+    void flushLocked();
+    void writeManifestLocked() const;
+    void compactLoop();
+    std::string tablePath(std::uint64_t id) const;
+};
+
+} // namespace gambit
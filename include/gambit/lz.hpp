@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "gambit/rlp.hpp"
+
+namespace gambit {
+namespace lz {
+
+// Dictionary-primed LZ77 codec for small records.
+//
+// A single block or transaction is too short for LZ77 to find much
+// repetition in itself. Priming the match window with a dictionary of
+// byte strings common to records of the same kind (RLP headers, gas
+// fields, busy addresses) lets even the first bytes of a record be coded
+// as back-references. The output is a run of [literals, match] sequences
+// with varint lengths and offsets; there is no entropy stage.
+
+// Dictionary bytes plus a hash chain over them, built once and shared by
+// every compress() call
+class Dictionary {
+public:
+    Dictionary() = default;
+    explicit Dictionary(Bytes bytes);
+
+    const Bytes& bytes() const { return bytes_; }
+    std::size_t size() const { return bytes_.size(); }
+
+private:
+    friend Bytes compress(const std::uint8_t* data, std::size_t size, const Dictionary& dict);
+
+    Bytes bytes_;
+    std::vector<std::int32_t> head_;   // hash of 4 bytes -> last position
+    std::vector<std::int32_t> prev_;   // position -> previous one with the same hash
+};
+
+// Up to `maxSize` bytes of the substrings that recur most across
+// `samples`, most useful last (nearest the record, so cheapest to reference)
+Bytes train(const std::vector<Bytes>& samples, std::size_t maxSize);
+
+Bytes compress(const std::uint8_t* data, std::size_t size, const Dictionary& dict);
+
+// Throws std::runtime_error unless `data` decodes to exactly `rawSize` bytes
+Bytes decompress(const std::uint8_t* data, std::size_t size, std::size_t rawSize, const Dictionary& dict);
+
+} // namespace lz
+} // namespace gambit
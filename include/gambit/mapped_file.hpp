@@ -0,0 +1,44 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace gambit {
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Throws std::runtime_error if the file cannot be opened or mapped
+    static MappedFile open(const std::string& path);
+
+    // Map `length` bytes even if the file is shorter, so bytes appended
+    // later show through without remapping; only bytes already written
+    // may be read. Windows cannot map a read-only file past its end and
+    // maps what the file holds, so size() can come out below `length`.
+    static MappedFile open(const std::string& path, std::size_t length);
+
+    const std::uint8_t* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    const std::uint8_t* data_{nullptr};
+    std::size_t size_{0};
+#ifdef _WIN32
+    void* file_{nullptr};
+    void* mapping_{nullptr};
+#else
+    int fd_{-1};
+#endif
+
+    void close();
+};
+
+} // namespace gambit
@@ -0,0 +1,148 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <optional>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "gambit/address.hpp"
+#include "gambit/hash.hpp"
+#include "gambit/transaction.hpp"
+#include "gambit/uint256.hpp"
+
+namespace gambit {
+
+// Pending transactions, per sender in nonce order.
+//
+// A sender's queue is executable up to its first nonce gap, counting
+// from the sender's nonce on the head state; what lies past the gap is
+// queued. The first transaction of every executable queue (its head)
+// sits in an ordered set by gas price, so the best transaction to
+// include next is always at the front. Each queue's last transaction
+// (its tail) sits in one of two sets, cheapest first: one for queues
+// with queued transactions, one for the rest. A full pool evicts from
+// there, so a queue never gets a hole, and it evicts queued tails before
+// executable ones: transactions that cannot run yet never crowd out ones
+// that can.
+//
+// Queued transactions cost their sender nothing, so a sender may queue
+// at most kMaxQueuedPerSender of them, and no nonce may lie
+// kMaxNonceAhead or more past the sender's nonce.
+//
+// Insert, replace and evict are O(log n). select() merges the head set
+// with the successors of what it already took and costs O(k log n) for
+// k transactions.
+//
+// Readers share a lock with each other, so RPC lookups never wait for
+// block production, only for the insert or removal in progress.
+class Mempool {
+public:
+    static constexpr std::size_t kDefaultCapacity = 8192;
+    // A replacement must pay at least this much more per gas
+    static constexpr unsigned kReplaceBumpPercent = 10;
+    // Per-sender limits on transactions that cannot run yet
+    static constexpr std::size_t kMaxQueuedPerSender = 16;
+    static constexpr std::uint64_t kMaxNonceAhead = 64;
+
+    explicit Mempool(std::size_t capacity = kDefaultCapacity) : capacity_(capacity) {}
+
+    // Add a transaction whose sender's nonce on the head state is
+    // `accountNonce`. A transaction with the nonce of a pending one
+    // replaces it if it pays kReplaceBumpPercent more. When the pool is
+    // full, an executable `tx` evicts the cheapest queued tail, or else
+    // the cheapest tail that pays less than it; a queued `tx` only
+    // evicts a cheaper queued tail. False with `err` set if `tx` was not
+    // taken.
+    bool add(const Transaction& tx, std::uint64_t accountNonce, std::string& err);
+
+    // The sender's nonce on the head state changed (block committed or
+    // reverted): drop its transactions below `nonce` and re-rank it
+    void setNonce(const Address& sender, std::uint64_t nonce);
+
+    // Remove one transaction; later ones from its sender stay queued
+    // behind the gap
+    bool remove(const Bytes32& hash);
+
+    bool contains(const Bytes32& hash) const;
+    std::optional<Transaction> find(const Bytes32& hash) const;
+
+    // Up to `limit` executable transactions in the order a block takes
+    // them: highest gas price first, each sender in nonce order, equal
+    // prices first come first served
+    std::vector<Transaction> select(std::size_t limit = std::numeric_limits<std::size_t>::max()) const;
+
+    // Everything held: select() followed by the transactions waiting
+    // behind a nonce gap
+    std::vector<Transaction> all() const;
+
+    void clear();
+
+    std::size_t size() const;
+    std::size_t senders() const;
+    std::size_t capacity() const { return capacity_; }
+
+private:
+    struct Entry {
+        Transaction tx;
+        std::uint64_t seq;   // arrival order, breaks gas price ties
+    };
+
+    struct Sender {
+        std::uint64_t nonce{0};              // next nonce on the head state
+        std::size_t ready{0};                // executable: nonces [nonce, nonce + ready)
+        std::map<std::uint64_t, Entry> txs;  // by nonce
+
+        std::size_t queued() const { return txs.size() - ready; }
+    };
+
+    struct Rank {
+        uint256 price;
+        std::uint64_t seq;
+        Address sender;
+        std::uint64_t nonce;
+    };
+
+    // Highest price first, then oldest
+    struct Better {
+        bool operator()(const Rank& a, const Rank& b) const {
+            if (a.price != b.price) return b.price < a.price;
+            return a.seq < b.seq;
+        }
+    };
+
+    // Lowest price first, then newest
+    struct Cheaper {
+        bool operator()(const Rank& a, const Rank& b) const {
+            if (a.price != b.price) return a.price < b.price;
+            return b.seq < a.seq;
+        }
+    };
+
+    mutable std::shared_mutex mutex_;
+    std::size_t capacity_;
+    std::uint64_t nextSeq_{0};
+    std::unordered_map<Address, Sender, AddressHash> senders_;
+    std::unordered_map<Bytes32, std::pair<Address, std::uint64_t>, Bytes32Hash> byHash_;  // sender, nonce
+    std::set<Rank, Better> heads_;   // first transaction of each executable sender
+    std::set<Rank, Cheaper> tails_;  // last transaction of each sender with nothing queued
+    std::set<Rank, Cheaper> queuedTails_;  // last transaction of each sender with some queued
+
+    static Rank rankOf(const Address& sender, const std::map<std::uint64_t, Entry>::const_iterator& it);
+
+    // Take the sender's head and tail out of the sets / put them back
+    // after its queue or nonce changed
+    void unlink(const Address& sender, const Sender& s);
+    void link(const Address& sender, const Sender& s);
+    static void extendReady(Sender& s);
+    void erase(const Address& sender, std::map<std::uint64_t, Entry>::iterator it);
+    bool evictFor(const Transaction& tx, bool executable);
+    void setNonceLocked(const Address& sender, std::uint64_t nonce);
+    std::vector<Transaction> selectLocked(std::size_t limit) const;
+};
+
+} // namespace gambit
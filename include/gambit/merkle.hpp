@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "gambit/hash.hpp"
+
+namespace gambit {
+namespace merkle {
+
+// Binary Merkle tree over 32-byte leaves (a block's transaction hashes).
+//
+// Leaves are hashed as keccak256(0x00 || leaf) and inner nodes as
+// keccak256(0x01 || left || right), so n leaves cost 2n - 1 hashes. The
+// tags keep an inner node from passing as a leaf: a proof cannot claim a
+// smaller tree whose "leaves" are real subtree roots.
+// Each level pairs nodes 2i and 2i+1; a last, unpaired node moves up
+// unchanged rather than being duplicated, so [a, b, c] and [a, b, c, c]
+// have different roots. The root of no leaves is all zeros.
+//
+// A level is a flat run of fixed-size preimages, so the hashing loop is
+// where a multi-buffer Keccak would slot in.
+
+// Below this many leaves root() stays on the calling thread
+constexpr std::size_t kParallelLeaves = 4096;
+
+// Root of `leaves`. Aligned subtrees are hashed on up to `threads`
+// workers (0 = one per hardware thread) and only the levels above them
+// on this thread, so the sequential depth is log2 of the leaf count.
+Bytes32 root(const std::vector<Bytes32>& leaves, std::size_t threads = 1);
+
+// Sibling hashes from leaf `index` up to the root; levels where the node
+// is unpaired have none
+struct Proof {
+    std::uint64_t index{0};
+    std::uint64_t leaves{0};
+    std::vector<Bytes32> siblings;
+};
+
+// Throws std::out_of_range unless index < leaves.size()
+Proof prove(const std::vector<Bytes32>& leaves, std::uint64_t index);
+
+// True if `leaf` sits at proof.index of a tree with root `root`
+bool verify(const Bytes32& root, const Bytes32& leaf, const Proof& proof);
+
+} // namespace merkle
+} // namespace gambit
@@ -26,6 +26,8 @@ private:
     MiningEngine& engine_;
 
     std::chrono::milliseconds interval_{1000};
+    // How often idle time is used to pre-execute the mempool
+    static constexpr std::chrono::milliseconds kIdlePoll{50};
     std::thread thread_;
     std::atomic<bool> running_{false};
 
@@ -4,11 +4,21 @@
 
 namespace gambit {
 
+// A block template and the state writes of executing it, so the node
+// that built it can commit it (Blockchain::commitVerified) without
+// executing it again
+struct BlockTemplate {
+    Block block;
+    SnapshotBase::Entries writes;
+};
+
 class MiningEngine {
 public:
     virtual ~MiningEngine() = default;
 
-    virtual Block buildBlockTemplate(Blockchain& chain) = 0;
+    virtual BlockTemplate buildTemplate(Blockchain& chain) = 0;
+    // Just the block, for external miners
+    Block buildBlockTemplate(Blockchain& chain) { return buildTemplate(chain).block; }
     virtual bool validateMinedBlock(const Block& block, Blockchain& chain) = 0;
 };
 
@@ -5,12 +5,19 @@
 #include <string>
 #include <cstdint>
 #include <optional>
+#include <map>
+#include <unordered_set>
+#include <utility>
 
 #include "gambit/hash.hpp"
 #include "gambit/rlp.hpp"
 
 namespace gambit {
 
+// Copies share their nodes and are cheap; put() copies the shared nodes
+// on its path, so copies never see each other's changes. Once a trie's
+// rootHash() has been taken, copies of it may be read and updated on
+// other threads while it is updated on its own.
 class MptTrie {
 public:
     MptTrie();
@@ -21,8 +28,28 @@ public:
     // Returns empty optional if not found
     std::optional<Bytes> get(const Bytes& key) const;
 
-    // Root hash (Keccak-256 of RLP(root node))
-    std::string rootHash() const;
+    // Root hash (Keccak-256 of RLP(root node)). Only subtrees changed
+    // since the last call are re-encoded, so calls on one trie must not
+    // overlap.
+    Bytes32 rootHash() const;
+
+    // Encodings of the hashed nodes on the paths to `keys` (root included),
+    // keyed by node hash. Together they prove the values, or absence, of
+    // `keys` and are enough to update them and recompute the root.
+    std::map<Bytes32, Bytes> witness(const std::vector<Bytes>& keys) const;
+
+    // Root hash of the trie holding `entries` (sorted by key, keys unique),
+    // computed bottom-up without building the trie: every node is encoded
+    // and hashed once, and only the current path is kept in memory. The
+    // subtrees under each first key byte are hashed on `threads` threads
+    // (0 = one per hardware thread). Throws std::invalid_argument on
+    // unsorted or duplicate keys.
+    using Entries = std::vector<std::pair<Bytes, Bytes>>;
+    static Bytes32 sortedRoot(const Entries& entries, std::size_t threads = 1);
+
+    // Rebuild a partial trie from witness nodes. Subtrees missing from the
+    // witness are kept as hash stubs; get/put into them throws.
+    static MptTrie fromWitness(const Bytes32& root, const std::map<Bytes32, Bytes>& nodes);
 
 private:
     struct Node;
@@ -32,13 +59,28 @@ private:
         // 0..15 children + optional value
         std::array<NodePtr, 16> children{};
         std::optional<Bytes> value;
+        // Set on subtrees known only by hash (partial tries)
+        std::optional<Bytes32> stub;
+        // Cached RLP encoding; cleared along the path of every put
+        mutable std::optional<Bytes> encoded;
+    };
+
+    // Collects hashed node encodings on marked paths while encoding
+    struct WitnessCollector {
+        const std::unordered_set<const Node*>* onPath;
+        std::map<Bytes32, Bytes>* out;
     };
 
     NodePtr root_;
 
     static std::vector<uint8_t> toNibbles(const Bytes& key);
-    static Bytes encodeNode(const NodePtr& node);
+    static Bytes encodeNode(const NodePtr& node, const WitnessCollector* collect = nullptr);
+    static Bytes encodeChildRef(const NodePtr& child, const WitnessCollector* collect);
     static Bytes encodeNodeValue(const NodePtr& node);
+    static NodePtr decodeNode(const rlp::Decoded& item, const std::map<Bytes32, Bytes>& nodes);
+    static NodePtr decodeChildRef(const rlp::Decoded& item, const std::map<Bytes32, Bytes>& nodes);
+    static Bytes sortedNode(const Entries& e, std::size_t lo, std::size_t hi, std::size_t depth);
+    static Bytes sortedChildRef(const Entries& e, std::size_t lo, std::size_t hi, std::size_t depth);
 };
 
 } // namespace gambit
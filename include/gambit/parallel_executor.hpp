@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <utility>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+
+#include "gambit/address.hpp"
+#include "gambit/account.hpp"
+#include "gambit/state.hpp"
+#include "gambit/transaction.hpp"
+
+namespace gambit {
+
+// Outcome of executing a block's transactions against a base state.
+// `writes` holds the final value of every account the block touched,
+// in first-touch order, ready to be applied with State::set.
+struct ExecutionResult {
+    std::vector<std::pair<Address, Account>> writes;
+    bool ok{true};
+    std::size_t failedIndex{0};   // first failing tx (valid when !ok)
+    std::string error;
+};
+
+// Why `tx` cannot run against `from`, its sender's account as of the
+// transaction's turn in the block, or nullptr if it can: a chain id other
+// than `chainId` (0 accepts any), a nonce other than the sender's next,
+// or a balance short of the value. Every executor rejects by this rule,
+// so a received block cannot replay a transaction or carry one signed
+// for another chain.
+const char* transferError(const Transaction& tx, const Account& from, std::uint64_t chainId);
+
+// Block-STM style optimistic executor.
+//
+// Transactions run speculatively on a worker pool against multi-version
+// account data. Every incarnation records its read set (which version of
+// each account it saw) and write set; a transaction is re-validated once
+// lower transactions have executed and re-executed if any of its reads
+// went stale. The committed result is identical to applying the
+// transactions one by one in block order.
+//
+// The pool's threads are started with the first parallel block and kept
+// for the executor's lifetime; copies share them. One block runs on the
+// pool at a time, a block arriving meanwhile runs on its caller alone.
+class ParallelExecutor {
+public:
+    // Pre-block account lookup; must be safe to call from several threads
+    using AccountReader = std::function<std::optional<Account>(const Address&)>;
+
+    // threads == 0 => std::thread::hardware_concurrency(); transactions
+    // for a chain other than `chainId` fail (0 = any chain)
+    explicit ParallelExecutor(std::size_t threads = 0, std::uint64_t chainId = 0);
+
+    ExecutionResult execute(const State& base, const std::vector<Transaction>& txs) const;
+    ExecutionResult execute(const AccountReader& base, const std::vector<Transaction>& txs) const;
+
+    std::size_t threads() const { return threads_; }
+    std::uint64_t chainId() const { return chainId_; }
+
+private:
+    class WorkerPool;
+
+    std::size_t threads_;
+    std::uint64_t chainId_;
+    std::shared_ptr<WorkerPool> pool_;     // threads_ - 1 helpers; null if serial
+
+    // Blocks smaller than this are executed serially on the caller thread
+    static constexpr std::size_t kMinParallelTxs = 16;
+
+    ExecutionResult executeSerial(const AccountReader& base, const std::vector<Transaction>& txs) const;
+    ExecutionResult executeParallel(const AccountReader& base, const std::vector<Transaction>& txs) const;
+};
+
+} // namespace gambit
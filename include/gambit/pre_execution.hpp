@@ -0,0 +1,78 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <unordered_map>
+
+#include "gambit/address.hpp"
+#include "gambit/account.hpp"
+#include "gambit/hash.hpp"
+#include "gambit/snapshot.hpp"
+#include "gambit/state.hpp"
+#include "gambit/transaction.hpp"
+#include "gambit/parallel_executor.hpp"
+
+namespace gambit {
+
+// Speculative execution results for the pending transactions.
+//
+// The mempool is executed in order against the head state while the node
+// is idle. Entries are keyed by transaction hash and keep the sender and
+// recipient accounts the transaction read, whether it read them from the
+// head or from an earlier transaction, and the accounts it wrote. A later
+// run reuses an entry when it would read the same two accounts again, so
+// a new arrival only re-executes the transactions whose inputs it
+// changed. Reads that came from the head are not repeated for a reused
+// entry.
+//
+// The head is assumed to change only through the writes passed to
+// invalidate(); any other change to it needs a clear().
+class PreExecutionCache {
+public:
+    struct Stats {
+        std::size_t reused{0};
+        std::size_t executed{0};
+    };
+
+    // Transactions for a chain other than `chainId` fail (0 = any chain)
+    explicit PreExecutionCache(std::uint64_t chainId = 0) : chainId_(chainId) {}
+
+    // Result of executing `pending` against `head`, same as
+    // ParallelExecutor::execute. Refreshes the cache as a side effect and,
+    // if every transaction ran, forgets transactions no longer pending.
+    ExecutionResult run(const State& head, const std::vector<Transaction>& pending);
+
+    // True if every pending transaction has a cached entry
+    bool covers(const std::vector<Transaction>& pending) const;
+
+    // The head took these writes (a block was committed): drop the
+    // entries that read or wrote any of the accounts. The block's own
+    // transactions are among them, since their senders' nonces moved.
+    void invalidate(const SnapshotBase::Entries& writes);
+
+    void clear() { entries_.clear(); }
+    std::size_t size() const { return entries_.size(); }
+
+    // Counters from the most recent run()
+    const Stats& lastRun() const { return stats_; }
+
+private:
+    struct Entry {
+        Address from;
+        Address to;
+        bool fromHead;          // read from the head, not an earlier transaction
+        bool toHead;
+        Account readFrom;
+        Account readTo;
+        Account writeFrom;
+        Account writeTo;
+        const char* error{nullptr};
+        std::uint64_t run{0};   // last run() that saw it
+    };
+
+    std::uint64_t chainId_;
+    std::unordered_map<Bytes32, Entry, Bytes32Hash> entries_;
+    std::uint64_t runs_{0};
+    Stats stats_;
+};
+
+} // namespace gambit
@@ -0,0 +1,153 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace gambit {
+
+// Read-copy-update cell holding an immutable value.
+//
+// Readers pin the current version with read(): they announce the current
+// epoch in a free reader slot and load the pointer. No lock is taken and
+// nothing the writer does can make a reader wait. publish() swaps in a
+// new version and retires the old one. A retired version is deleted once
+// every reader slot is idle or announces a later epoch, i.e. once no
+// reader can still hold it.
+//
+// There is no cap on concurrent readers: once every slot is taken, a
+// reader adds a block of overflow slots rather than waiting for one.
+//
+// Writers must be serialized by the caller. Guards must not outlive the
+// cell.
+template <typename T>
+class Rcu {
+    struct alignas(64) Slot {
+        std::atomic<std::uint64_t> epoch{0};   // 0 = idle
+    };
+
+    static constexpr std::size_t kSlots = 128;
+
+    // Extra slots, added by readers when all others are taken; never
+    // unlinked before the cell goes
+    struct Overflow {
+        std::array<Slot, kSlots> slots;
+        Overflow* next{nullptr};
+    };
+
+public:
+    class Guard {
+    public:
+        Guard(Guard&& o) noexcept : slot_(o.slot_), value_(o.value_) { o.slot_ = nullptr; }
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+        Guard& operator=(Guard&&) = delete;
+
+        ~Guard() {
+            if (slot_) slot_->epoch.store(0, std::memory_order_release);
+        }
+
+        const T& operator*() const { return *value_; }
+        const T* operator->() const { return value_; }
+        const T* get() const { return value_; }
+
+    private:
+        friend class Rcu;
+        Guard(Slot* slot, const T* value) : slot_(slot), value_(value) {}
+
+        Slot* slot_;
+        const T* value_;
+    };
+
+    explicit Rcu(T initial = T()) : current_(new T(std::move(initial))) {}
+
+    ~Rcu() {
+        delete current_.load();
+        for (auto& [epoch, value] : retired_) delete value;
+        for (Overflow* o = overflow_.load(); o;) {
+            Overflow* next = o->next;
+            delete o;
+            o = next;
+        }
+    }
+
+    Rcu(const Rcu&) = delete;
+    Rcu& operator=(const Rcu&) = delete;
+
+    Guard read() const {
+        // Start probing at a per-thread slot so threads rarely collide
+        static thread_local std::size_t hint = std::hash<std::thread::id>{}(std::this_thread::get_id());
+        for (std::size_t i = hint; i < hint + kSlots; ++i) {
+            if (claim(slots_[i % kSlots])) {
+                hint = i % kSlots;
+                return Guard(&slots_[i % kSlots], current_.load());
+            }
+        }
+        for (Overflow* o = overflow_.load(); o; o = o->next) {
+            for (Slot& slot : o->slots) {
+                if (claim(slot)) return Guard(&slot, current_.load());
+            }
+        }
+
+        // Every slot is busy: add a block, with our slot claimed before
+        // the writer can see it
+        auto* o = new Overflow;
+        o->slots[0].epoch.store(epoch_.load());
+        o->next = overflow_.load();
+        while (!overflow_.compare_exchange_weak(o->next, o)) {
+        }
+        return Guard(&o->slots[0], current_.load());
+    }
+
+    void publish(T value) {
+        const T* old = current_.exchange(new T(std::move(value)));
+        // Readers that saw `old` announced an epoch <= this one
+        retired_.emplace_back(epoch_.fetch_add(1), old);
+        reclaim();
+    }
+
+    // Versions waiting for readers to move on
+    std::size_t retired() const { return retired_.size(); }
+
+private:
+    mutable std::array<Slot, kSlots> slots_;
+    mutable std::atomic<Overflow*> overflow_{nullptr};
+    std::atomic<const T*> current_;
+    std::atomic<std::uint64_t> epoch_{1};
+    std::vector<std::pair<std::uint64_t, const T*>> retired_;   // writer only
+
+    bool claim(Slot& slot) const {
+        std::uint64_t idle = 0;
+        return slot.epoch.load(std::memory_order_relaxed) == 0 &&
+               slot.epoch.compare_exchange_strong(idle, epoch_.load());
+    }
+
+    void reclaim() {
+        std::uint64_t oldest = std::numeric_limits<std::uint64_t>::max();
+        auto scan = [&](const std::array<Slot, kSlots>& slots) {
+            for (const Slot& slot : slots) {
+                std::uint64_t e = slot.epoch.load();
+                if (e != 0 && e < oldest) oldest = e;
+            }
+        };
+        scan(slots_);
+        for (const Overflow* o = overflow_.load(); o; o = o->next) {
+            scan(o->slots);
+        }
+        std::size_t kept = 0;
+        for (auto& entry : retired_) {
+            if (entry.first < oldest) {
+                delete entry.second;
+            } else {
+                retired_[kept++] = entry;
+            }
+        }
+        retired_.resize(kept);
+    }
+};
+
+} // namespace gambit
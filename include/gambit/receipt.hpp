@@ -15,6 +15,7 @@ struct Receipt {
 
     // Minimal RLP encoding
     Bytes rlpEncode() const;
+    static Receipt rlpDecode(const rlp::Decoded& item);
 };
 
 } // namespace gambit
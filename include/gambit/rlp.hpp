@@ -1,22 +1,30 @@
 #pragma once
+#include <array>
 #include <string>
 #include <vector>
 #include <cstdint>
 
+#include "gambit/uint256.hpp"
+
 namespace gambit {
 
 using Bytes = std::vector<std::uint8_t>;
+using Bytes32 = std::array<std::uint8_t, 32>;
 
 namespace rlp {
 
 // Encode a byte string
 Bytes encodeBytes(const Bytes& input);
 
+// Encode a 32-byte hash (always a 33-byte string item)
+Bytes encodeHash(const Bytes32& input);
+
 // Encode a string (UTF-8)
 Bytes encodeString(const std::string& input);
 
 // Encode an unsigned integer (big-endian, minimal)
 Bytes encodeUint(std::uint64_t value);
+Bytes encodeUint(const uint256& value);
 
 // Encode a list of RLP-encoded items
 Bytes encodeList(const std::vector<Bytes>& items);
@@ -36,5 +44,18 @@ Decoded decode(const Bytes& in, size_t& offset);
 // Convenience: decode full buffer
 Decoded decode(const Bytes& in);
 
+// Non-owning view of one encoded item, for walking RLP in place
+struct ItemRef {
+    const std::uint8_t* begin{nullptr};   // first byte of the header
+    const std::uint8_t* payload{nullptr};
+    std::size_t length{0};                // payload bytes
+    std::size_t size{0};                  // header + payload bytes
+    bool isList{false};
+};
+
+// Parse the header of the item at `p` (`n` bytes available). Throws
+// std::runtime_error if the item runs past the buffer.
+ItemRef peek(const std::uint8_t* p, std::size_t n);
+
 } // namespace rlp
 } // namespace gambit
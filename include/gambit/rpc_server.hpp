@@ -3,6 +3,7 @@
 #include <atomic>
 #include <cstdint>
 #include <string>
+#include <optional>
 
 #include "gambit/blockchain.hpp"
 
@@ -15,6 +16,9 @@ public:
     void start();
     void stop();
 
+    // Answer one JSON-RPC request body (what handleClient serves over HTTP)
+    std::string handleJsonRpc(const std::string& json);
+
 private:
     Blockchain& chain_;
     std::uint16_t port_;
@@ -26,17 +30,25 @@ private:
     void handleClient(int clientFd);
 
     std::string handleRequest(const std::string& httpReq);
-    std::string handleJsonRpc(const std::string& json);
 
     // JSON-RPC method handlers
     std::string handle_blockNumber(const std::string& id);
-    std::string handle_getBalance(const std::string& id, const std::string& addrHex);
+    std::string handle_getBalance(const std::string& id, const std::string& addrHex, const std::string& blockTag);
     std::string handle_sendRawTransaction(const std::string& id, const std::string& txHex);
     
     std::string handle_getBlockByNumber(const std::string& id, const std::string& numHex);
     std::string handle_getBlockByHash(const std::string& id, const std::string& hashHex);
     std::string handle_getTransactionByHash(const std::string& id, const std::string& hashHex);
-    std::string handle_getTransactionCount(const std::string& id, const std::string& addrHex);    
+    std::string handle_getTransactionReceipt(const std::string& id, const std::string& hashHex);
+    // Merkle inclusion proof of a transaction against its block's txRoot
+    std::string handle_getTransactionProof(const std::string& id, const std::string& hashHex);
+    std::string handle_getTransactionCount(const std::string& id, const std::string& addrHex, const std::string& blockTag);
+    // Transactions involving an address, newest first, paged by an opaque cursor
+    std::string handle_getAddressTransactions(const std::string& id, const std::string& addrHex,
+                                              std::size_t limit, const std::string& cursor, bool newestFirst);
+
+    // Account for an eth_* block tag ("latest", "earliest", "pending" or hex height)
+    std::optional<Account> accountForTag(const Address& addr, const std::string& blockTag);
 
     // Tiny helpers
     static std::string httpResponse(const std::string& body, const std::string& status = "200 OK");
@@ -0,0 +1,86 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+#include "gambit/address.hpp"
+#include "gambit/state.hpp"
+#include "gambit/transaction.hpp"
+#include "gambit/parallel_executor.hpp"
+
+namespace gambit {
+
+// Shard-per-core executor.
+//
+// Accounts are statically partitioned by address prefix. Each shard is
+// owned by one pinned worker thread that keeps that partition's accounts in
+// a private map and executes the transactions sent from them. Nothing in
+// the account data is shared between workers. The partitions stay resident
+// across blocks: an account is read from the base State once, and after
+// that only committed writes (commit()) update it. A block runs in two
+// phases:
+//
+//   1. prepare - every shard executes its senders' transactions in block
+//      order. It debits the sender, applies same-shard credits directly,
+//      and queues cross-shard credits in an outbox per destination shard.
+//   2. merge   - every shard applies its inbound credits, ordered by
+//      transaction index.
+//
+// Credits only ever increase balances, so if every prepare-phase debit
+// succeeds, the result equals serial execution. If a debit fails it might
+// have been covered by an earlier cross-shard credit, so the block is
+// re-run serially to get the exact in-order outcome.
+class ShardedExecutor {
+public:
+    struct Stats {
+        std::size_t crossShard{0};   // credits routed through the merge
+        std::size_t loaded{0};       // accounts read from the base State
+        bool fallback{false};        // block was re-run serially
+    };
+
+    // shards == 0 => std::thread::hardware_concurrency() (capped at 256);
+    // transactions for a chain other than `chainId` fail (0 = any chain)
+    explicit ShardedExecutor(std::size_t shards = 0, std::uint64_t chainId = 0);
+    ~ShardedExecutor();
+
+    ShardedExecutor(const ShardedExecutor&) = delete;
+    ShardedExecutor& operator=(const ShardedExecutor&) = delete;
+
+    // `base` must be the state the resident partitions were committed up
+    // to; a block's own writes only become resident through commit()
+    ExecutionResult execute(const State& base, const std::vector<Transaction>& txs);
+
+    // Writes just applied to the base State, whichever executor made them
+    void commit(const std::vector<std::pair<Address, Account>>& writes);
+
+    // The base State changed some other way (rollback, reload); reload
+    // every partition from it on demand
+    void invalidate();
+
+    std::size_t shards() const { return shards_.size(); }
+    std::size_t shardOf(const Address& addr) const;
+
+    // Counters from the most recent execute()
+    const Stats& lastRun() const { return stats_; }
+
+private:
+    struct Shard;
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::uint64_t chainId_;
+    ParallelExecutor serial_;
+    Stats stats_;
+    std::mutex execMutex_;
+
+    // Phase barrier
+    std::mutex doneMutex_;
+    std::condition_variable doneCv_;
+    std::size_t pending_{0};
+
+    void runPhase(int phase);
+    void worker(Shard& shard);
+};
+
+} // namespace gambit
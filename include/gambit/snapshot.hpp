@@ -0,0 +1,155 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <functional>
+
+#include "gambit/address.hpp"
+#include "gambit/account.hpp"
+#include "gambit/hash.hpp"
+#include "gambit/mapped_file.hpp"
+
+namespace gambit {
+
+// Flat address -> (balance, nonce) table at a committed state root.
+//
+// The table is an open-addressing hash table with fixed-width slots, so a
+// lookup is one hash and (typically) one slot probe. It is either held in
+// memory or written to disk once and read back through mmap.
+class SnapshotBase {
+public:
+    using Entries = std::vector<std::pair<Address, Account>>;
+
+    // In-memory table
+    static std::shared_ptr<const SnapshotBase> build(const Bytes32& root,
+                                                     const Entries& accounts);
+
+    // Write the table to `path` and map it
+    static std::shared_ptr<const SnapshotBase> create(const std::string& path,
+                                                      const Bytes32& root,
+                                                      const Entries& accounts);
+
+    // Map a table previously written by create()
+    static std::shared_ptr<const SnapshotBase> load(const std::string& path);
+
+    std::optional<Account> get(const Address& addr) const;
+
+    const Bytes32& root() const { return root_; }
+    std::size_t size() const { return count_; }
+    const std::string& path() const { return path_; }
+
+    void forEach(const std::function<void(const Address&, const Account&)>& fn) const;
+
+private:
+    Bytes owned_;           // in-memory tables
+    MappedFile mapped_;     // on-disk tables
+    const std::uint8_t* slots_{nullptr};
+    std::size_t count_{0};
+    std::size_t capacity_{0};
+    Bytes32 root_{};
+    std::string path_;
+
+    static Bytes encode(const Bytes32& root, const Entries& accounts);
+    void attach(const std::uint8_t* data, std::size_t size);
+};
+
+// Account changes of one block, stacked on top of the base table.
+struct DiffLayer {
+    Bytes32 root{};     // state root after the block
+    // nullopt = account removed (undoing a block that created it)
+    std::unordered_map<Address, std::optional<Account>, AddressHash> accounts;
+};
+
+// Flat snapshot: a base table plus in-memory diff layers for recent blocks.
+//
+// Reads check the diff layers newest-first and then the base; they never
+// touch the trie. Once more than `maxDiffLayers` layers are stacked, a
+// background thread flattens all but the newest half into a new base, so
+// update() stays proportional to the block's writes; layers stacked
+// while it runs stay on top of the result. Readers work on an immutable
+// view and are safe to run alongside update().
+class SnapshotTree {
+    struct View;
+
+public:
+    // One state version, pinned; later updates do not affect it
+    class Version {
+    public:
+        std::optional<Account> get(const Address& addr) const;
+        Bytes32 root() const;
+
+        // Every account of this version, in no particular order
+        void forEach(const std::function<void(const Address&, const Account&)>& fn) const;
+
+    private:
+        friend class SnapshotTree;
+        std::shared_ptr<const View> view_;
+    };
+
+    explicit SnapshotTree(std::size_t maxDiffLayers = 16);
+    ~SnapshotTree();
+
+    // Replace everything with a fresh base (e.g. genesis)
+    void reset(const Bytes32& root, const SnapshotBase::Entries& accounts);
+
+    // Keep base tables as mmap'd files under `dir` from now on. Base
+    // files already in `dir` (left by an earlier run) are deleted; a base
+    // file is deleted as soon as a newer base replaces it.
+    void persistTo(const std::string& dir);
+
+    // Stack a block's account writes on top
+    void update(const Bytes32& root, const SnapshotBase::Entries& writes);
+
+    // Same, also removing `deleted` (used when a reorg undoes a block)
+    void update(const Bytes32& root, const SnapshotBase::Entries& writes,
+                const std::vector<Address>& deleted);
+
+    std::optional<Account> get(const Address& addr) const;
+
+    Bytes32 root() const;
+    std::size_t diffLayers() const;
+
+    // Block until no merge is running or due
+    void waitForMerge();
+
+    Version version() const;
+
+private:
+    struct View {
+        std::shared_ptr<const SnapshotBase> base;
+        std::vector<std::shared_ptr<const DiffLayer>> layers;   // oldest first
+    };
+
+    std::size_t maxDiffLayers_;
+    std::string dir_;
+    std::uint64_t generation_{0};
+
+    std::mutex writeMutex_;         // serializes update/reset/persistTo and merge installs
+    mutable std::mutex mutex_;      // guards view_ pointer only
+    std::shared_ptr<const View> view_;
+    std::atomic<std::size_t> layerCount_{0};    // view_->layers.size(), readable without mutex_
+
+    std::mutex mergeMutex_;
+    std::condition_variable mergeCv_;
+    bool merging_{false};
+    bool stopping_{false};
+    std::thread merger_;
+
+    std::shared_ptr<const View> current() const;
+    void publish(std::shared_ptr<const View> v);
+    std::string nextPathLocked();
+    std::shared_ptr<const SnapshotBase> makeBase(const Bytes32& root,
+                                                 const SnapshotBase::Entries& accounts);
+    static std::shared_ptr<const SnapshotBase> flatten(const View& v, std::size_t merge,
+                                                       const std::string& path);
+    void mergeLoop();
+};
+
+} // namespace gambit
@@ -2,6 +2,8 @@
 #include <unordered_map>
 #include <string>
 #include <vector>
+#include <functional>
+#include <utility>
 
 #include "gambit/address.hpp"
 #include "gambit/account.hpp"
@@ -17,16 +19,40 @@ public:
     State() = default;
     explicit State(const GenesisConfig& genesis);
 
+    // Bulk load (snapshots): the map is sized once and large loads make
+    // their keys on `threads` threads (0 = one per hardware thread). A
+    // repeated address keeps its last account, as with set().
+    static State fromAccounts(const std::vector<std::pair<Address, Account>>& accounts, std::size_t threads = 1);
+
     Account& getOrCreate(const Address& addr);
     const Account* get(const Address& addr) const;
 
+    // Overwrite an account (used to commit executor write sets)
+    void set(const Address& addr, const Account& acc);
+
+    // Remove an account entirely (undoing the block that created it)
+    void erase(const Address& addr);
+
+    // Visit every account (unordered)
+    void forEach(const std::function<void(const Address&, const Account&)>& fn) const;
+
     // Apply tx from a known sender address
     void applyTransaction(const Address& from, const Transaction& tx);
 
     // Compute Merkle-Patricia state root
-    std::string root() const;
+    Bytes32 root() const;
+
+    // Build the account trie (key = 20-byte address, value = RLP[balance, nonce])
+    MptTrie trie() const;
+
+    static Bytes encodeAccount(const Account& acc);
+    static Account decodeAccount(const Bytes& raw);
 
 private:
+    // States at least this large hash their root on all cores, and bulk
+    // loads this large make their keys on several
+    static constexpr std::size_t kParallelRootAccounts = 4096;
+
     // Keyed by lowercase hex address
     std::unordered_map<std::string, Account> accounts_;
 };
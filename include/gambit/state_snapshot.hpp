@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <istream>
+#include <ostream>
+
+#include "gambit/state.hpp"
+
+namespace gambit {
+
+// Portable binary dump of a whole account state, for genesis files with
+// millions of premined accounts and for checkpoints.
+//
+// Layout, integers little-endian:
+//   header  [u32 magic "GSTS"][u32 version][u64 accounts][u32 chunks]
+//           [32-byte state root]
+//   chunk   [u32 accounts][20-byte first address][20-byte last address]
+//           [32-byte keccak256 of the payload][payload]
+//   payload per account, by increasing address:
+//           [20-byte address][32-byte balance, big-endian][u64 nonce]
+//
+// Chunks cover increasing, disjoint address ranges, so each can be
+// checked and decoded on its own, and together they are already in trie
+// key order.
+
+constexpr std::size_t kStateSnapshotChunkAccounts = 4096;
+
+// Write every account of `state`; returns its state root. Throws
+// std::runtime_error if the stream fails.
+Bytes32 writeStateSnapshot(const State& state, std::ostream& out,
+                               std::size_t chunkAccounts = kStateSnapshotChunkAccounts);
+
+// Read a snapshot. Chunks are hash-checked and decoded on `threads`
+// workers (0 = one per hardware thread) while the stream is still being
+// read, then the state root is hashed bottom-up from the sorted accounts
+// and compared with the header. Throws std::runtime_error on a bad chunk
+// hash, out-of-order range, truncated stream or root mismatch.
+State loadStateSnapshot(std::istream& in, std::size_t threads = 0);
+
+// State root recorded in a snapshot's header; reads nothing else. Throws
+// std::runtime_error if the stream is not a snapshot.
+Bytes32 readStateSnapshotRoot(std::istream& in);
+
+} // namespace gambit
@@ -7,6 +7,7 @@
 #include "gambit/keys.hpp"
 #include "gambit/hash.hpp"
 #include "gambit/rlp.hpp"
+#include "gambit/uint256.hpp"
 
 namespace gambit {
 
@@ -14,10 +15,10 @@ class Transaction {
 public:
     // Core fields
     std::uint64_t nonce{0};
-    std::uint64_t gasPrice{0};
+    uint256 gasPrice;
     std::uint64_t gasLimit{0};
     Address to;
-    std::uint64_t value{0};
+    uint256 value;
     std::vector<std::uint8_t> data;
     std::uint64_t chainId{1};
 
@@ -26,8 +27,8 @@ public:
     // Signature fields
     Signature sig;
 
-    // Cached hash (keccak256(rlpEncodeSigned))
-    std::string hash;
+    // Cached hash (keccak256(rlpEncodeSigned)); zero until signed or decoded
+    Bytes32 hash{};
 
 
     // RLP encoding for signing (EIP-155)
@@ -51,8 +52,15 @@ public:
     // Deserialize from hex (optional)
     static Transaction fromHex(const std::string& hex);
 
+    // Deserialize from rlpEncodeSigned() bytes; `from` is only filled in
+    // when `withSender` is set (see recoverSender)
+    static Transaction rlpDecode(const Bytes& raw, bool withSender = true);
+
+    // Recover `from` from the signature
+    void recoverSender();
+
     // Compute transaction hash
-    std::string computeHash() const;
+    Bytes32 computeHash() const;
 };
 
 } // namespace gambit
@@ -0,0 +1,461 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+namespace gambit {
+
+// 256-bit unsigned integer with wrap-around (mod 2^256) arithmetic.
+//
+// Four 64-bit limbs, least significant first. Allocation-free; everything
+// but the string conversions is constexpr. Limb products use a 128-bit
+// multiply where the compiler has one (mul/mulx on x86-64), and carries are
+// written so compilers lower them to add-with-carry chains.
+class uint256 {
+public:
+    constexpr uint256() = default;
+    constexpr uint256(std::uint64_t v) : w_{v, 0, 0, 0} {}
+
+    // Limbs from most to least significant
+    static constexpr uint256 fromWords(std::uint64_t w3, std::uint64_t w2,
+                                       std::uint64_t w1, std::uint64_t w0) {
+        uint256 r;
+        r.w_ = {w0, w1, w2, w3};
+        return r;
+    }
+
+    static constexpr uint256 max() { return fromWords(~0ull, ~0ull, ~0ull, ~0ull); }
+
+    constexpr std::uint64_t word(std::size_t i) const { return w_[i]; }
+    constexpr std::uint64_t low64() const { return w_[0]; }
+    constexpr bool fitsU64() const { return (w_[1] | w_[2] | w_[3]) == 0; }
+    constexpr bool isZero() const { return (w_[0] | w_[1] | w_[2] | w_[3]) == 0; }
+    constexpr explicit operator bool() const { return !isZero(); }
+
+    // Number of significant bits (0 for zero)
+    constexpr unsigned bitLength() const {
+        for (int i = 3; i >= 0; --i) {
+            if (w_[i]) return 64 * i + 64 - clz64(w_[i]);
+        }
+        return 0;
+    }
+
+    // ---------- Arithmetic ----------
+
+    constexpr uint256& operator+=(const uint256& o) { addTo(*this, o); return *this; }
+    constexpr uint256& operator-=(const uint256& o) { subFrom(*this, o); return *this; }
+
+    constexpr uint256& operator*=(const uint256& o) { mulInto(*this, o, *this); return *this; }
+
+    constexpr uint256& operator/=(const uint256& o) { uint256 r; divmod(*this, o, *this, r); return *this; }
+    constexpr uint256& operator%=(const uint256& o) { uint256 q; divmod(*this, o, q, *this); return *this; }
+
+    friend constexpr uint256 operator+(uint256 a, const uint256& b) { return a += b; }
+    friend constexpr uint256 operator-(uint256 a, const uint256& b) { return a -= b; }
+    friend constexpr uint256 operator*(uint256 a, const uint256& b) { return a *= b; }
+    friend constexpr uint256 operator/(uint256 a, const uint256& b) { return a /= b; }
+    friend constexpr uint256 operator%(uint256 a, const uint256& b) { return a %= b; }
+
+    constexpr uint256& operator++() { return *this += 1; }
+    constexpr uint256& operator--() { return *this -= 1; }
+
+    // Checked variants; return true on overflow (out is then truncated)
+    static constexpr bool addOverflow(const uint256& a, const uint256& b, uint256& out) {
+        out = a;
+        return addTo(out, b);
+    }
+
+    static constexpr bool subUnderflow(const uint256& a, const uint256& b, uint256& out) {
+        out = a;
+        return subFrom(out, b);
+    }
+
+    static constexpr bool mulOverflow(const uint256& a, const uint256& b, uint256& out) {
+        return mulInto(a, b, out);
+    }
+
+    // Knuth algorithm D on 64-bit limbs. Throws std::domain_error on b == 0.
+    static constexpr void divmod(const uint256& a, const uint256& b, uint256& q, uint256& r) {
+        if (b.isZero()) {
+            throw std::domain_error("uint256: division by zero");
+        }
+        if (a < b) {
+            q = uint256();
+            r = a;
+            return;
+        }
+
+        int n = 4;
+        while (b.w_[n - 1] == 0) --n;
+        int m = 4;
+        while (a.w_[m - 1] == 0) --m;
+
+        uint256 quot;
+        if (n == 1) {
+            std::uint64_t rem = 0;
+            for (int i = m - 1; i >= 0; --i) {
+                quot.w_[i] = div128(rem, a.w_[i], b.w_[0], rem);
+            }
+            q = quot;
+            r = uint256(rem);
+            return;
+        }
+
+        // Normalize so the divisor's top limb has its high bit set
+        unsigned s = clz64(b.w_[n - 1]);
+        std::uint64_t vn[4] = {0, 0, 0, 0};
+        std::uint64_t un[5] = {0, 0, 0, 0, 0};
+        for (int i = n - 1; i > 0; --i) {
+            vn[i] = (b.w_[i] << s) | (s ? b.w_[i - 1] >> (64 - s) : 0);
+        }
+        vn[0] = b.w_[0] << s;
+        un[m] = s ? a.w_[m - 1] >> (64 - s) : 0;
+        for (int i = m - 1; i > 0; --i) {
+            un[i] = (a.w_[i] << s) | (s ? a.w_[i - 1] >> (64 - s) : 0);
+        }
+        un[0] = a.w_[0] << s;
+
+        for (int j = m - n; j >= 0; --j) {
+            // Estimate qhat from the top two limbs
+            std::uint64_t qhat = 0;
+            std::uint64_t rhat = 0;
+            bool rhatOverflow = false;
+            if (un[j + n] >= vn[n - 1]) {
+                qhat = ~0ull;
+                rhat = un[j + n - 1] + vn[n - 1];
+                rhatOverflow = rhat < vn[n - 1];
+            } else {
+                qhat = div128(un[j + n], un[j + n - 1], vn[n - 1], rhat);
+            }
+            while (!rhatOverflow) {
+                std::uint64_t hi = 0;
+                std::uint64_t lo = mulWide(qhat, vn[n - 2], hi);
+                if (hi < rhat || (hi == rhat && lo <= un[j + n - 2])) break;
+                --qhat;
+                rhat += vn[n - 1];
+                rhatOverflow = rhat < vn[n - 1];
+            }
+
+            // un[j..j+n] -= qhat * vn
+            std::uint64_t carry = 0;
+            std::uint64_t borrow = 0;
+            for (int i = 0; i < n; ++i) {
+                std::uint64_t hi = 0;
+                std::uint64_t lo = mulWide(qhat, vn[i], hi);
+                lo += carry;
+                hi += lo < carry;
+                carry = hi;
+                std::uint64_t t = un[i + j] - lo;
+                std::uint64_t b1 = un[i + j] < lo;
+                un[i + j] = t - borrow;
+                borrow = b1 | (t < borrow);
+            }
+            std::uint64_t t = un[j + n] - carry;
+            std::uint64_t b1 = un[j + n] < carry;
+            un[j + n] = t - borrow;
+            bool negative = b1 | (t < borrow);
+
+            // qhat was one too large: add the divisor back
+            if (negative) {
+                --qhat;
+                std::uint64_t c = 0;
+                for (int i = 0; i < n; ++i) {
+                    std::uint64_t sum = un[i + j] + vn[i];
+                    std::uint64_t c1 = sum < vn[i];
+                    un[i + j] = sum + c;
+                    c = c1 | (un[i + j] < c);
+                }
+                un[j + n] += c;
+            }
+            quot.w_[j] = qhat;
+        }
+
+        uint256 rem;
+        for (int i = 0; i < n; ++i) {
+            rem.w_[i] = (un[i] >> s) | (s ? un[i + 1] << (64 - s) : 0);
+        }
+        q = quot;
+        r = rem;
+    }
+
+    // ---------- Bitwise ----------
+
+    constexpr uint256& operator<<=(unsigned n) {
+        if (n >= 256) return *this = uint256();
+        unsigned limbs = n / 64, bits = n % 64;
+        for (int i = 3; i >= 0; --i) {
+            std::uint64_t v = 0;
+            int src = i - static_cast<int>(limbs);
+            if (src >= 0) {
+                v = w_[src] << bits;
+                if (bits && src > 0) v |= w_[src - 1] >> (64 - bits);
+            }
+            w_[i] = v;
+        }
+        return *this;
+    }
+
+    constexpr uint256& operator>>=(unsigned n) {
+        if (n >= 256) return *this = uint256();
+        unsigned limbs = n / 64, bits = n % 64;
+        for (int i = 0; i < 4; ++i) {
+            std::uint64_t v = 0;
+            unsigned src = i + limbs;
+            if (src < 4) {
+                v = w_[src] >> bits;
+                if (bits && src + 1 < 4) v |= w_[src + 1] << (64 - bits);
+            }
+            w_[i] = v;
+        }
+        return *this;
+    }
+
+    friend constexpr uint256 operator<<(uint256 a, unsigned n) { return a <<= n; }
+    friend constexpr uint256 operator>>(uint256 a, unsigned n) { return a >>= n; }
+
+    friend constexpr uint256 operator&(uint256 a, const uint256& b) {
+        for (int i = 0; i < 4; ++i) a.w_[i] &= b.w_[i];
+        return a;
+    }
+    friend constexpr uint256 operator|(uint256 a, const uint256& b) {
+        for (int i = 0; i < 4; ++i) a.w_[i] |= b.w_[i];
+        return a;
+    }
+    friend constexpr uint256 operator^(uint256 a, const uint256& b) {
+        for (int i = 0; i < 4; ++i) a.w_[i] ^= b.w_[i];
+        return a;
+    }
+    friend constexpr uint256 operator~(uint256 a) {
+        for (int i = 0; i < 4; ++i) a.w_[i] = ~a.w_[i];
+        return a;
+    }
+
+    // ---------- Comparison ----------
+
+    friend constexpr bool operator==(const uint256& a, const uint256& b) {
+        return ((a.w_[0] ^ b.w_[0]) | (a.w_[1] ^ b.w_[1]) |
+                (a.w_[2] ^ b.w_[2]) | (a.w_[3] ^ b.w_[3])) == 0;
+    }
+    friend constexpr bool operator!=(const uint256& a, const uint256& b) { return !(a == b); }
+
+    friend constexpr bool operator<(const uint256& a, const uint256& b) {
+        for (int i = 3; i >= 0; --i) {
+            if (a.w_[i] != b.w_[i]) return a.w_[i] < b.w_[i];
+        }
+        return false;
+    }
+    friend constexpr bool operator>(const uint256& a, const uint256& b) { return b < a; }
+    friend constexpr bool operator<=(const uint256& a, const uint256& b) { return !(b < a); }
+    friend constexpr bool operator>=(const uint256& a, const uint256& b) { return !(a < b); }
+
+    // ---------- Conversions ----------
+
+    // Big-endian, any length up to 32 bytes (RLP integers are minimal)
+    static constexpr uint256 fromBigEndian(const std::uint8_t* p, std::size_t n) {
+        if (n > 32) {
+            throw std::out_of_range("uint256: more than 32 bytes");
+        }
+        uint256 r;
+        for (std::size_t i = 0; i < n; ++i) {
+            std::size_t bit = 8 * (n - 1 - i);
+            r.w_[bit / 64] |= std::uint64_t(p[i]) << (bit % 64);
+        }
+        return r;
+    }
+
+    // Minimal big-endian bytes into out[0..32); returns the length used
+    // (0 for zero)
+    constexpr std::size_t toBigEndian(std::uint8_t* out) const {
+        std::size_t len = (bitLength() + 7) / 8;
+        for (std::size_t i = 0; i < len; ++i) {
+            std::size_t bit = 8 * (len - 1 - i);
+            out[i] = static_cast<std::uint8_t>(w_[bit / 64] >> (bit % 64));
+        }
+        return len;
+    }
+
+    // Ethereum quantity: "0x" + minimal hex digits ("0x0" for zero)
+    std::string toHex() const {
+        static const char* digits = "0123456789abcdef";
+        std::string s = "0x";
+        unsigned nibbles = (bitLength() + 3) / 4;
+        if (nibbles == 0) return "0x0";
+        for (int i = static_cast<int>(nibbles) - 1; i >= 0; --i) {
+            s += digits[(w_[i / 16] >> (4 * (i % 16))) & 0xF];
+        }
+        return s;
+    }
+
+    // Accepts an optional 0x prefix and up to 64 hex digits
+    static uint256 fromHex(const std::string& hex) {
+        std::size_t start = (hex.rfind("0x", 0) == 0 || hex.rfind("0X", 0) == 0) ? 2 : 0;
+        if (hex.size() - start > 64) {
+            throw std::out_of_range("uint256: hex value too large");
+        }
+        uint256 r;
+        for (std::size_t i = start; i < hex.size(); ++i) {
+            char c = hex[i];
+            std::uint64_t v;
+            if (c >= '0' && c <= '9') v = c - '0';
+            else if (c >= 'a' && c <= 'f') v = c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') v = c - 'A' + 10;
+            else throw std::invalid_argument("uint256: invalid hex digit");
+            r <<= 4;
+            r.w_[0] |= v;
+        }
+        return r;
+    }
+
+    std::string toString() const {
+        if (isZero()) return "0";
+        constexpr std::uint64_t kChunk = 10000000000000000000ull;   // 10^19
+        std::string s;
+        uint256 v = *this;
+        while (!v.isZero()) {
+            uint256 q, r;
+            divmod(v, kChunk, q, r);
+            std::uint64_t part = r.w_[0];
+            for (int i = 0; i < 19 && (part || !q.isZero()); ++i) {
+                s += static_cast<char>('0' + part % 10);
+                part /= 10;
+            }
+            v = q;
+        }
+        return std::string(s.rbegin(), s.rend());
+    }
+
+    static uint256 fromString(const std::string& dec) {
+        if (dec.empty()) {
+            throw std::invalid_argument("uint256: empty decimal string");
+        }
+        uint256 r;
+        for (char c : dec) {
+            if (c < '0' || c > '9') {
+                throw std::invalid_argument("uint256: invalid decimal digit");
+            }
+            if (mulOverflow(r, 10, r) || addOverflow(r, std::uint64_t(c - '0'), r)) {
+                throw std::out_of_range("uint256: decimal value too large");
+            }
+        }
+        return r;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const uint256& v) {
+        return os << v.toString();
+    }
+
+private:
+    std::array<std::uint64_t, 4> w_{};
+
+    static constexpr unsigned clz64(std::uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+        return x ? static_cast<unsigned>(__builtin_clzll(x)) : 64;
+#else
+        unsigned n = 0;
+        if (!x) return 64;
+        while (!(x & (1ull << 63))) { x <<= 1; ++n; }
+        return n;
+#endif
+    }
+
+    // 64x64 -> 128 multiply; returns the low half
+    static constexpr std::uint64_t mulWide(std::uint64_t a, std::uint64_t b, std::uint64_t& hi) {
+#ifdef __SIZEOF_INT128__
+        __extension__ using u128 = unsigned __int128;
+        u128 p = static_cast<u128>(a) * b;
+        hi = static_cast<std::uint64_t>(p >> 64);
+        return static_cast<std::uint64_t>(p);
+#else
+        std::uint64_t a0 = a & 0xFFFFFFFF, a1 = a >> 32;
+        std::uint64_t b0 = b & 0xFFFFFFFF, b1 = b >> 32;
+        std::uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+        std::uint64_t mid = (p00 >> 32) + (p01 & 0xFFFFFFFF) + (p10 & 0xFFFFFFFF);
+        hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+        return (mid << 32) | (p00 & 0xFFFFFFFF);
+#endif
+    }
+
+    // (u1:u0) / v with u1 < v; Hacker's Delight divlu
+    static constexpr std::uint64_t div128(std::uint64_t u1, std::uint64_t u0, std::uint64_t v,
+                                          std::uint64_t& rem) {
+        constexpr std::uint64_t b = 1ull << 32;
+        unsigned s = clz64(v);
+        v <<= s;
+        std::uint64_t vn1 = v >> 32, vn0 = v & 0xFFFFFFFF;
+        std::uint64_t un32 = s ? (u1 << s) | (u0 >> (64 - s)) : u1;
+        std::uint64_t un10 = u0 << s;
+        std::uint64_t un1 = un10 >> 32, un0 = un10 & 0xFFFFFFFF;
+
+        std::uint64_t q1 = un32 / vn1, rhat = un32 - q1 * vn1;
+        while (q1 >= b || q1 * vn0 > b * rhat + un1) {
+            --q1;
+            rhat += vn1;
+            if (rhat >= b) break;
+        }
+        std::uint64_t un21 = un32 * b + un1 - q1 * v;
+
+        std::uint64_t q0 = un21 / vn1;
+        rhat = un21 - q0 * vn1;
+        while (q0 >= b || q0 * vn0 > b * rhat + un0) {
+            --q0;
+            rhat += vn1;
+            if (rhat >= b) break;
+        }
+        rem = (un21 * b + un0 - q0 * v) >> s;
+        return q1 * b + q0;
+    }
+
+    // out = a * b (schoolbook, truncated); returns true if the full
+    // product does not fit. `out` may alias an input.
+    static constexpr bool mulInto(const uint256& a, const uint256& b, uint256& out) {
+        bool overflow = false;
+        std::uint64_t r[4] = {0, 0, 0, 0};
+        for (int i = 0; i < 4; ++i) {
+            std::uint64_t carry = 0;
+            for (int j = 0; j < 4; ++j) {
+                if (i + j >= 4) {
+                    overflow |= a.w_[i] && b.w_[j];
+                    continue;
+                }
+                std::uint64_t hi = 0;
+                std::uint64_t lo = mulWide(a.w_[i], b.w_[j], hi);
+                lo += carry;      hi += lo < carry;
+                lo += r[i + j];   hi += lo < r[i + j];
+                r[i + j] = lo;
+                carry = hi;
+            }
+            overflow |= carry != 0;
+        }
+        out.w_ = {r[0], r[1], r[2], r[3]};
+        return overflow;
+    }
+
+    // a += b; returns the carry out
+    static constexpr bool addTo(uint256& a, const uint256& b) {
+        std::uint64_t carry = 0;
+        for (int i = 0; i < 4; ++i) {
+            std::uint64_t s = a.w_[i] + b.w_[i];
+            std::uint64_t c1 = s < a.w_[i];
+            a.w_[i] = s + carry;
+            carry = c1 | (a.w_[i] < s);
+        }
+        return carry != 0;
+    }
+
+    // a -= b; returns the borrow out
+    static constexpr bool subFrom(uint256& a, const uint256& b) {
+        std::uint64_t borrow = 0;
+        for (int i = 0; i < 4; ++i) {
+            std::uint64_t d = a.w_[i] - b.w_[i];
+            std::uint64_t b1 = a.w_[i] < b.w_[i];
+            a.w_[i] = d - borrow;
+            borrow = b1 | (d < borrow);
+        }
+        return borrow != 0;
+    }
+};
+
+} // namespace gambit
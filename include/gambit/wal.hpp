@@ -0,0 +1,73 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "gambit/rlp.hpp"
+
+namespace gambit {
+
+// Append-only write-ahead log with group commit.
+//
+// Each record is framed as [u32 length][u32 crc32][u8 type][payload]
+// (little-endian; length covers type + payload) and is either entirely
+// replayed or not at all. The type byte is the owner's: the chain and
+// LsmKvStore each keep their own log and define their own record types. append() only buffers; sync() makes everything
+// up to a sequence number durable. The first thread to call sync() writes
+// and fsyncs every record buffered so far on behalf of all waiters, so
+// concurrent committers share one fsync instead of queueing behind one
+// each.
+//
+// On open, a torn or corrupt tail is cut off at the last intact record.
+// If a write or fsync fails, sync() throws and the unsynced records stay
+// buffered for the next sync(); none of them is reported durable.
+class WriteAheadLog {
+public:
+    explicit WriteAheadLog(const std::string& path);
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    // Records that were in the log when it was opened, oldest first
+    void replay(const std::function<void(std::uint8_t, const Bytes&)>& fn) const;
+
+    // Buffer a record; returns its sequence number. No I/O.
+    std::uint64_t append(std::uint8_t type, const Bytes& payload);
+
+    // Return once every record up to `seq` is on stable storage
+    void sync(std::uint64_t seq);
+
+    // append() + sync()
+    std::uint64_t commit(std::uint8_t type, const Bytes& payload);
+
+    // Drop every record, buffered or written (after a checkpoint made
+    // them redundant)
+    void reset();
+
+    std::uint64_t bytes() const;    // log file size, including the buffer
+    std::uint64_t syncs() const;    // fsyncs issued so far
+
+private:
+    // After a failed write: truncate the file back to fileSize_ and
+    // reopen it. Leaves file_ null if the file cannot be reopened.
+    void discardUnsyncedLocked();
+
+    std::string path_;
+    std::FILE* file_{nullptr};
+
+    mutable std::mutex mutex_;
+    std::condition_variable flushed_;
+    Bytes buffer_;
+    std::uint64_t appended_{0};     // sequence number of the last append
+    std::uint64_t durable_{0};      // ... of the last record synced
+    std::uint64_t fileSize_{0};
+    std::uint64_t syncs_{0};
+    bool flushing_{false};
+};
+
+} // namespace gambit
@@ -0,0 +1,34 @@
+#pragma once
+#include <vector>
+#include <string>
+
+#include "gambit/hash.hpp"
+#include "gambit/address.hpp"
+#include "gambit/mpt.hpp"
+#include "gambit/rlp.hpp"
+
+namespace gambit {
+
+// Pre-state trie nodes a block touches.
+//
+// Carries every hashed node on the paths to the accounts a block reads or
+// writes, so a node without the full state can re-execute the block on a
+// partial trie and check that it lands on the declared stateAfter.
+struct BlockWitness {
+    std::vector<Bytes> nodes;
+
+    bool empty() const { return nodes.empty(); }
+
+    // Witness for `touched` against the pre-block account trie
+    static BlockWitness build(const MptTrie& pre, const std::vector<Address>& touched);
+
+    // Partial account trie rooted at `root`. Nodes are keyed by their
+    // recomputed hash, so a tampered node simply fails to attach.
+    MptTrie toTrie(const Bytes32& root) const;
+
+    // RLP: list of node encodings
+    Bytes rlpEncode() const;
+    static BlockWitness rlpDecode(const rlp::Decoded& item);
+};
+
+} // namespace gambit
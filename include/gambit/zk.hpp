@@ -1,22 +1,22 @@
 #pragma once
-#include <string>
+#include "gambit/hash.hpp"
 
 namespace gambit {
 
 struct ZkProof {
-    std::string proof;        // opaque proof blob
-    std::string stateBefore;  // state root before block
-    std::string stateAfter;   // state root after block
-    std::string txRoot;       // merkle root of tx list
-    std::string commitment;   // hash(proof || stateBefore || stateAfter || txRoot)
+    Bytes32 proof{};        // opaque proof blob
+    Bytes32 stateBefore{};  // state root before block
+    Bytes32 stateAfter{};   // state root after block
+    Bytes32 txRoot{};       // merkle root of tx list
+    Bytes32 commitment{};   // hash(proof || stateBefore || stateAfter || txRoot)
 };
 
 class ZkProver {
 public:
     // Generate a mock proof for a block
-    static ZkProof generate(const std::string& stateBefore,
-                            const std::string& stateAfter,
-                            const std::string& txRoot);
+    static ZkProof generate(const Bytes32& stateBefore,
+                            const Bytes32& stateAfter,
+                            const Bytes32& txRoot);
 };
 
 class ZkVerifier {
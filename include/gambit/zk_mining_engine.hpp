@@ -6,7 +6,7 @@ namespace gambit {
 
 class ZkMiningEngine : public MiningEngine {
 public:
-    Block buildBlockTemplate(Blockchain& chain) override;
+    BlockTemplate buildTemplate(Blockchain& chain) override;
     bool validateMinedBlock(const Block& block, Blockchain& chain) override;
 };
 
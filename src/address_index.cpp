@@ -0,0 +1,203 @@
+#include "gambit/address_index.hpp"
+#include <algorithm>
+#include <mutex>
+
+namespace gambit {
+
+namespace {
+
+void putVarint(Bytes& out, std::uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<std::uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(v));
+}
+
+std::uint64_t getVarint(const std::uint8_t*& p) {
+    std::uint64_t v = 0;
+    for (int shift = 0;; shift += 7) {
+        std::uint8_t b = *p++;
+        v |= std::uint64_t(b & 0x7f) << shift;
+        if (!(b & 0x80)) return v;
+    }
+}
+
+// Sender and recipient of each transaction, in position order
+template <typename Fn>
+void forEachParty(const Block& block, Fn fn) {
+    for (std::size_t i = 0; i < block.transactions.size(); ++i) {
+        const Transaction& tx = block.transactions[i];
+        AddressIndex::Posting p{block.index, static_cast<std::uint32_t>(i)};
+        bool hasFrom = block.sendersRecovered && !tx.from.isZero();
+        if (hasFrom) fn(tx.from, p);
+        if (!tx.to.isZero() && !(hasFrom && tx.to == tx.from)) fn(tx.to, p);
+    }
+}
+
+} // namespace
+
+void AddressIndex::append(List& list, const Posting& p) {
+    if (list.count % kPagePostings == 0) {
+        list.pages.push_back(Skip{p, list.data.size()});
+    } else if (p.height != list.last.height) {
+        putVarint(list.data, p.height - list.last.height);
+        putVarint(list.data, p.position);
+    } else {
+        putVarint(list.data, 0);
+        putVarint(list.data, p.position - list.last.position - 1);
+    }
+    list.last = p;
+    ++list.count;
+}
+
+void AddressIndex::decodePage(const List& list, std::size_t page, std::vector<Posting>& out) {
+    const std::uint8_t* p = list.data.data() + list.pages[page].offset;
+    const std::uint8_t* end = list.data.data() +
+        (page + 1 < list.pages.size() ? list.pages[page + 1].offset : list.data.size());
+    Posting cur = list.pages[page].first;
+    out.push_back(cur);
+    while (p < end) {
+        std::uint64_t dh = getVarint(p);
+        std::uint64_t pos = getVarint(p);
+        if (dh == 0) {
+            cur.position += static_cast<std::uint32_t>(pos) + 1;
+        } else {
+            cur.height += dh;
+            cur.position = static_cast<std::uint32_t>(pos);
+        }
+        out.push_back(cur);
+    }
+}
+
+void AddressIndex::truncate(List& list, const Posting& from) {
+    // Pages starting at or after `from` go whole; the one before is
+    // re-encoded with what it keeps
+    auto it = std::lower_bound(list.pages.begin(), list.pages.end(), from,
+                               [](const Skip& s, const Posting& p) { return s.first < p; });
+    std::size_t k = it - list.pages.begin();
+    if (k == 0) {
+        list = List{};
+        return;
+    }
+    std::vector<Posting> kept;
+    decodePage(list, k - 1, kept);
+    kept.erase(std::lower_bound(kept.begin(), kept.end(), from), kept.end());
+
+    list.data.resize(list.pages[k - 1].offset);
+    list.pages.resize(k - 1);
+    list.count = (k - 1) * kPagePostings;
+    for (const Posting& p : kept) append(list, p);
+}
+
+void AddressIndex::add(const Block& block) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    forEachParty(block, [&](const Address& addr, const Posting& p) {
+        List& list = lists_[addr];
+        // Re-adding a block that is already indexed changes nothing
+        if (list.count == 0 || list.last < p) append(list, p);
+    });
+}
+
+void AddressIndex::remove(const Block& block) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    Posting from{block.index, 0};
+    forEachParty(block, [&](const Address& addr, const Posting&) {
+        auto it = lists_.find(addr);
+        if (it == lists_.end() || it->second.last < from) return;
+        truncate(it->second, from);
+        if (it->second.count == 0) lists_.erase(it);
+    });
+}
+
+void AddressIndex::prune(std::uint64_t height) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (auto it = lists_.begin(); it != lists_.end();) {
+        List& list = it->second;
+        if (list.last.height < height) {
+            it = lists_.erase(it);
+            continue;
+        }
+        // Page i lies wholly below `height` once page i + 1 starts below it
+        std::size_t drop = 0;
+        while (drop + 1 < list.pages.size() && list.pages[drop + 1].first.height < height) ++drop;
+        if (drop > 0) {
+            std::size_t cut = list.pages[drop].offset;
+            list.data.erase(list.data.begin(), list.data.begin() + static_cast<std::ptrdiff_t>(cut));
+            list.pages.erase(list.pages.begin(), list.pages.begin() + static_cast<std::ptrdiff_t>(drop));
+            for (Skip& s : list.pages) s.offset -= cut;
+            list.count -= drop * kPagePostings;
+        }
+        ++it;
+    }
+}
+
+void AddressIndex::clear() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    lists_.clear();
+}
+
+AddressIndex::Page AddressIndex::query(const Address& addr, Posting from, std::size_t limit, bool newestFirst) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    Page out;
+    auto it = lists_.find(addr);
+    if (it == lists_.end()) return out;
+    const List& list = it->second;
+
+    // Last page starting at or before `from`
+    auto after = std::upper_bound(list.pages.begin(), list.pages.end(), from,
+                                  [](const Posting& p, const Skip& s) { return p < s.first; });
+    std::size_t k = after - list.pages.begin();
+
+    std::vector<Posting> page;
+    auto take = [&](const Posting& p) {
+        if (out.postings.size() == limit) {
+            out.next = p;
+            return false;
+        }
+        out.postings.push_back(p);
+        return true;
+    };
+
+    if (newestFirst) {
+        for (; k > 0; --k) {
+            page.clear();
+            decodePage(list, k - 1, page);
+            for (auto p = page.rbegin(); p != page.rend(); ++p) {
+                if (from < *p) continue;
+                if (!take(*p)) return out;
+            }
+        }
+        return out;
+    }
+
+    for (k = k > 0 ? k - 1 : 0; k < list.pages.size(); ++k) {
+        page.clear();
+        decodePage(list, k, page);
+        for (const Posting& p : page) {
+            if (p < from) continue;
+            if (!take(p)) return out;
+        }
+    }
+    return out;
+}
+
+std::uint64_t AddressIndex::count(const Address& addr) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = lists_.find(addr);
+    return it == lists_.end() ? 0 : it->second.count;
+}
+
+std::size_t AddressIndex::addresses() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return lists_.size();
+}
+
+std::size_t AddressIndex::bytes() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::size_t total = 0;
+    for (const auto& [addr, list] : lists_) total += list.data.size();
+    return total;
+}
+
+} // namespace gambit
@@ -0,0 +1,257 @@
+#include "gambit/archive.hpp"
+#include "byte_io.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace gambit {
+
+namespace {
+
+// Record: [20 address][u8 exists][u256 balance][u64 nonce], little-endian
+constexpr std::size_t kRecord = Address::kSize + 1 + 32 + 8;
+
+void removeTableFile(const SnapshotBase& table) {
+    if (table.path().empty()) return;
+    std::error_code ec;
+    std::filesystem::remove(table.path(), ec);
+}
+
+} // namespace
+
+// ---------- ReverseDiff ----------
+
+ReverseDiff ReverseDiff::build(Entries entries) {
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+        return a.first.bytes() < b.first.bytes();
+    });
+
+    ReverseDiff d;
+    d.data_.resize(entries.size() * kRecord);
+    std::uint8_t* p = d.data_.data();
+    for (const auto& [addr, prior] : entries) {
+        std::memcpy(p, addr.bytes().data(), Address::kSize);
+        p[Address::kSize] = prior ? 1 : 0;
+        putU256(p + Address::kSize + 1, prior ? prior->balance : uint256());
+        putU64(p + Address::kSize + 33, prior ? prior->nonce : 0);
+        p += kRecord;
+    }
+    return d;
+}
+
+std::size_t ReverseDiff::size() const {
+    return data_.size() / kRecord;
+}
+
+bool ReverseDiff::find(const Address& addr, std::optional<Account>& prior) const {
+    std::size_t lo = 0, hi = size();
+    while (lo < hi) {
+        std::size_t mid = (lo + hi) / 2;
+        const std::uint8_t* rec = data_.data() + mid * kRecord;
+        int c = std::memcmp(rec, addr.bytes().data(), Address::kSize);
+        if (c == 0) {
+            if (rec[Address::kSize]) {
+                prior = Account{getU256(rec + Address::kSize + 1), getU64(rec + Address::kSize + 33)};
+            } else {
+                prior = std::nullopt;
+            }
+            return true;
+        }
+        if (c < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return false;
+}
+
+void ReverseDiff::forEach(const std::function<void(const Address&, const std::optional<Account>&)>& fn) const {
+    for (std::size_t i = 0; i < size(); ++i) {
+        const std::uint8_t* rec = data_.data() + i * kRecord;
+        std::array<std::uint8_t, Address::kSize> raw;
+        std::memcpy(raw.data(), rec, Address::kSize);
+        std::optional<Account> prior;
+        if (rec[Address::kSize]) {
+            prior = Account{getU256(rec + Address::kSize + 1), getU64(rec + Address::kSize + 33)};
+        }
+        fn(Address(raw), prior);
+    }
+}
+
+// ---------- ArchiveStore ----------
+
+ArchiveStore::ArchiveStore(const ArchiveConfig& cfg, std::uint64_t height, SnapshotTree::Version state)
+    : cfg_(cfg), first_(height), head_(height), headState_(state)
+{
+    if (cfg_.checkpointInterval == 0) {
+        throw std::invalid_argument("ArchiveStore: checkpointInterval must be > 0");
+    }
+    if (!cfg_.checkpointDir.empty()) {
+        std::filesystem::create_directories(cfg_.checkpointDir);
+        // Tables of an earlier run; their diffs are gone
+        std::error_code ec;
+        for (const auto& e : std::filesystem::directory_iterator(cfg_.checkpointDir, ec)) {
+            if (e.path().filename().string().rfind("checkpoint-", 0) == 0) {
+                std::error_code rm;
+                std::filesystem::remove(e.path(), rm);
+            }
+        }
+    }
+    queueCheckpointLocked(height, std::move(state));
+    builder_ = std::thread(&ArchiveStore::buildLoop, this);
+}
+
+ArchiveStore::~ArchiveStore() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        queue_.clear();
+    }
+    work_.notify_all();
+    builder_.join();
+    for (const auto& [height, table] : checkpoints_) {
+        removeTableFile(*table);
+    }
+}
+
+void ArchiveStore::queueCheckpointLocked(std::uint64_t height, SnapshotTree::Version state) {
+    queue_.push_back({height, std::move(state)});
+    work_.notify_all();
+}
+
+std::shared_ptr<const SnapshotBase> ArchiveStore::buildCheckpoint(std::uint64_t height,
+                                                                  const SnapshotTree::Version& state) const
+{
+    SnapshotBase::Entries entries;
+    state.forEach([&](const Address& a, const Account& acc) {
+        entries.emplace_back(a, acc);
+    });
+
+    if (cfg_.checkpointDir.empty()) {
+        return SnapshotBase::build(state.root(), entries);
+    }
+    std::string path = cfg_.checkpointDir + "/checkpoint-" + std::to_string(height) + ".bin";
+    return SnapshotBase::create(path, state.root(), entries);
+}
+
+void ArchiveStore::buildLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        work_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+        if (stopping_) return;
+        PendingCheckpoint job = std::move(queue_.front());
+        queue_.pop_front();
+        building_ = job.height;
+        discardBuilding_ = false;
+        lock.unlock();
+
+        // A checkpoint only shortens scans; lookups stay correct without it
+        std::shared_ptr<const SnapshotBase> table;
+        try {
+            table = buildCheckpoint(job.height, job.state);
+        } catch (const std::exception&) {
+        }
+
+        lock.lock();
+        if (table) {
+            if (discardBuilding_ || stopping_) {
+                removeTableFile(*table);
+            } else {
+                checkpoints_[job.height] = std::move(table);
+            }
+        }
+        building_.reset();
+        idle_.notify_all();
+    }
+}
+
+void ArchiveStore::waitForCheckpoints() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [&] { return stopping_ || (queue_.empty() && !building_); });
+}
+
+void ArchiveStore::recordBlock(std::uint64_t height, ReverseDiff diff, SnapshotTree::Version after) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (height != head_ + 1) {
+        throw std::runtime_error("ArchiveStore: blocks must be recorded in order");
+    }
+    diffBytes_ += diff.bytes();
+    diffs_.push_back(std::move(diff));
+    head_ = height;
+    headState_ = after;
+
+    if (height % cfg_.checkpointInterval == 0) {
+        queueCheckpointLocked(height, std::move(after));
+    }
+}
+
+void ArchiveStore::rewind(std::uint64_t height, SnapshotTree::Version state) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (height < first_) {
+        throw std::out_of_range("ArchiveStore: cannot rewind below the first archived height");
+    }
+    if (height < head_) {
+        headState_ = std::move(state);
+    }
+    while (head_ > height) {
+        diffBytes_ -= diffs_.back().bytes();
+        diffs_.pop_back();
+        --head_;
+    }
+    for (auto it = checkpoints_.upper_bound(height); it != checkpoints_.end();) {
+        removeTableFile(*it->second);
+        it = checkpoints_.erase(it);
+    }
+    queue_.erase(std::remove_if(queue_.begin(), queue_.end(),
+                                [&](const PendingCheckpoint& c) { return c.height > height; }),
+                 queue_.end());
+    if (building_ && *building_ > height) {
+        discardBuilding_ = true;
+    }
+}
+
+bool ArchiveStore::available(std::uint64_t height) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return height >= first_ && height <= head_;
+}
+
+std::optional<Account> ArchiveStore::accountAt(const Address& addr, std::uint64_t height) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (height < first_ || height > head_) {
+        throw std::out_of_range("ArchiveStore: height not archived");
+    }
+
+    // Nearest checkpoint at or above `height` bounds the scan
+    std::uint64_t limit = head_;
+    std::shared_ptr<const SnapshotBase> checkpoint;
+    auto it = checkpoints_.lower_bound(height);
+    if (it != checkpoints_.end() && it->first <= head_) {
+        limit = it->first;
+        checkpoint = it->second;
+    }
+
+    for (std::uint64_t b = height + 1; b <= limit; ++b) {
+        std::optional<Account> prior;
+        if (diffs_[b - first_ - 1].find(addr, prior)) {
+            return prior;
+        }
+    }
+
+    if (checkpoint) {
+        return checkpoint->get(addr);
+    }
+
+    // Untouched since `height`: the head value still applies
+    return headState_.get(addr);
+}
+
+std::size_t ArchiveStore::checkpoints() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return checkpoints_.size();
+}
+
+std::size_t ArchiveStore::diffBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return diffBytes_;
+}
+
+} // namespace gambit
@@ -0,0 +1,300 @@
+#include "gambit/async_io.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <vector>
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+#ifdef GAMBIT_HAVE_IO_URING
+    #include <linux/io_uring.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+#endif
+
+namespace gambit {
+
+namespace {
+
+// Whole-range positional read/write; stops early only at end of file
+std::int64_t transfer(bool write, int fd, std::uint8_t* buf, std::size_t len, std::uint64_t offset) {
+    std::size_t done = 0;
+    while (done < len) {
+#ifdef _WIN32
+        if (_lseeki64(fd, static_cast<__int64>(offset + done), SEEK_SET) < 0) return -errno;
+        unsigned chunk = static_cast<unsigned>(std::min<std::size_t>(len - done, 1u << 30));
+        int n = write ? _write(fd, buf + done, chunk) : _read(fd, buf + done, chunk);
+#else
+        ssize_t n = write ? ::pwrite(fd, buf + done, len - done, static_cast<off_t>(offset + done))
+                          : ::pread(fd, buf + done, len - done, static_cast<off_t>(offset + done));
+#endif
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -errno;
+        }
+        if (n == 0) break;
+        done += static_cast<std::size_t>(n);
+    }
+    return static_cast<std::int64_t>(done);
+}
+
+class PreadIo : public AsyncIo {
+public:
+    Backend backend() const override { return Backend::Pread; }
+
+    std::size_t submit() override {
+        std::size_t n = 0;
+        while (!queue_.empty()) {
+            Op op = std::move(queue_.front());
+            queue_.pop_front();
+            done_.emplace_back(std::move(op.cb), transfer(op.write, op.fd, op.buf, op.len, op.offset));
+            ++inFlight_;
+            ++n;
+        }
+        return n;
+    }
+
+    std::size_t poll(bool) override {
+        // Callbacks may queue more work, which lands in a fresh list
+        std::vector<std::pair<Callback, std::int64_t>> ready;
+        ready.swap(done_);
+        inFlight_ -= ready.size();
+        for (auto& [cb, result] : ready) {
+            if (cb) cb(result);
+        }
+        return ready.size();
+    }
+
+private:
+    std::vector<std::pair<Callback, std::int64_t>> done_;
+};
+
+#ifdef GAMBIT_HAVE_IO_URING
+
+int uringSetup(unsigned entries, io_uring_params* p) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, p));
+}
+
+int uringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int uringRegister(int fd, unsigned opcode, void* arg, unsigned nrArgs) {
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs));
+}
+
+// Submission and completion rings shared with the kernel. Ring indices
+// are free-running; the kernel reads sq tail / writes cq tail, we write
+// sq tail / cq head.
+class UringIo : public AsyncIo {
+public:
+    // nullptr if the kernel has no usable io_uring (too old, disabled,
+    // or no IORING_OP_READ/WRITE)
+    static std::unique_ptr<UringIo> open(unsigned depth) {
+        std::unique_ptr<UringIo> io(new UringIo());
+        return io->init(depth) ? std::move(io) : nullptr;
+    }
+
+    ~UringIo() override {
+        if (sqes_) ::munmap(sqes_, sqesSize_);
+        if (cqRing_ && cqRing_ != sqRing_) ::munmap(cqRing_, cqRingSize_);
+        if (sqRing_) ::munmap(sqRing_, sqRingSize_);
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    Backend backend() const override { return Backend::IoUring; }
+
+    std::size_t submit() override {
+        unsigned tail = *sqTail_;
+        std::size_t added = 0;
+        while (!queue_.empty() && !freeSlots_.empty()) {
+            Op& op = queue_.front();
+            std::uint32_t slot = freeSlots_.back();
+            freeSlots_.pop_back();
+
+            unsigned idx = tail & sqMask_;
+            io_uring_sqe* sqe = &sqes_[idx];
+            *sqe = io_uring_sqe{};
+            sqe->opcode = op.write ? IORING_OP_WRITE : IORING_OP_READ;
+            sqe->fd = op.fd;
+            sqe->addr = reinterpret_cast<std::uint64_t>(op.buf);
+            sqe->len = static_cast<std::uint32_t>(op.len);
+            sqe->off = op.offset;
+            sqe->user_data = slot;
+            sqArray_[idx] = idx;
+
+            slots_[slot] = std::move(op);
+            queue_.pop_front();
+            ++tail;
+            ++added;
+        }
+        __atomic_store_n(sqTail_, tail, __ATOMIC_RELEASE);
+        pending_ += added;
+        inFlight_ += added;
+
+        while (pending_ > 0) {
+            int n = uringEnter(fd_, static_cast<unsigned>(pending_), 0, 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;      // EAGAIN/EBUSY: entered again by poll()
+            pending_ -= static_cast<std::size_t>(n);
+        }
+        return added;
+    }
+
+    std::size_t poll(bool wait) override {
+        if (wait && inFlight_ > 0 && ready() == 0) {
+            int n;
+            while ((n = uringEnter(fd_, static_cast<unsigned>(pending_), 1, IORING_ENTER_GETEVENTS)) < 0 &&
+                   errno == EINTR)
+            {
+            }
+            if (n > 0) pending_ -= std::min<std::size_t>(pending_, static_cast<std::size_t>(n));
+        } else if (pending_ > 0) {
+            int n = uringEnter(fd_, static_cast<unsigned>(pending_), 0, 0);
+            if (n > 0) pending_ -= static_cast<std::size_t>(n);
+        }
+
+        std::size_t n = 0;
+        unsigned head = *cqHead_;
+        unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            const io_uring_cqe& cqe = cqes_[head & cqMask_];
+            std::uint32_t slot = static_cast<std::uint32_t>(cqe.user_data);
+            std::int64_t res = cqe.res;
+            ++head;
+            __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+
+            Callback cb = std::move(slots_[slot].cb);
+            freeSlots_.push_back(slot);
+            --inFlight_;
+            ++n;
+            if (cb) cb(res);
+            tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+        }
+        return n;
+    }
+
+private:
+    int fd_{-1};
+    void* sqRing_{nullptr};
+    void* cqRing_{nullptr};
+    std::size_t sqRingSize_{0};
+    std::size_t cqRingSize_{0};
+    io_uring_sqe* sqes_{nullptr};
+    std::size_t sqesSize_{0};
+
+    unsigned* sqTail_{nullptr};
+    unsigned sqMask_{0};
+    unsigned* sqArray_{nullptr};
+    unsigned* cqHead_{nullptr};
+    unsigned* cqTail_{nullptr};
+    unsigned cqMask_{0};
+    io_uring_cqe* cqes_{nullptr};
+
+    std::vector<Op> slots_;                 // indexed by sqe user_data
+    std::vector<std::uint32_t> freeSlots_;
+    std::size_t pending_{0};                // in the ring, not yet entered (counted in inFlight_)
+
+    UringIo() = default;
+
+    unsigned ready() const {
+        return __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE) - *cqHead_;
+    }
+
+    bool init(unsigned depth) {
+        io_uring_params p{};
+        fd_ = uringSetup(depth, &p);
+        if (fd_ < 0) return false;
+
+        // Plain read/write opcodes need 5.6+; older kernels use the fallback
+        std::vector<std::uint8_t> probeBuf(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op), 0);
+        auto* probe = reinterpret_cast<io_uring_probe*>(probeBuf.data());
+        if (uringRegister(fd_, IORING_REGISTER_PROBE, probe, 256) < 0 ||
+            probe->last_op < IORING_OP_WRITE ||
+            !(probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) ||
+            !(probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED))
+        {
+            return false;
+        }
+
+        sqRingSize_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cqRingSize_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+
+        sqRing_ = ::mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                         IORING_OFF_SQ_RING);
+        if (sqRing_ == MAP_FAILED) {
+            sqRing_ = nullptr;
+            return false;
+        }
+        if (single) {
+            cqRing_ = sqRing_;
+        } else {
+            cqRing_ = ::mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                             IORING_OFF_CQ_RING);
+            if (cqRing_ == MAP_FAILED) {
+                cqRing_ = nullptr;
+                return false;
+            }
+        }
+        sqesSize_ = p.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = ::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                            IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) return false;
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+        auto* sq = static_cast<std::uint8_t*>(sqRing_);
+        auto* cq = static_cast<std::uint8_t*>(cqRing_);
+        sqTail_ = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+        sqMask_ = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+        sqArray_ = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+        cqHead_ = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+        cqTail_ = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+        cqMask_ = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+
+        // Never more in flight than the submission ring holds, so the
+        // completion ring (twice as large) cannot overflow
+        slots_.resize(p.sq_entries);
+        for (std::uint32_t i = p.sq_entries; i > 0; --i) freeSlots_.push_back(i - 1);
+        return true;
+    }
+};
+
+#endif // GAMBIT_HAVE_IO_URING
+
+} // namespace
+
+std::unique_ptr<AsyncIo> AsyncIo::create(unsigned depth, Backend preferred) {
+#ifdef GAMBIT_HAVE_IO_URING
+    if (preferred == Backend::IoUring) {
+        if (auto io = UringIo::open(depth ? depth : 1)) return io;
+    }
+#else
+    (void)depth;
+    (void)preferred;
+#endif
+    return std::make_unique<PreadIo>();
+}
+
+void AsyncIo::read(int fd, void* buf, std::size_t len, std::uint64_t offset, Callback cb) {
+    queue_.push_back(Op{false, fd, static_cast<std::uint8_t*>(buf), len, offset, std::move(cb)});
+}
+
+void AsyncIo::write(int fd, const void* buf, std::size_t len, std::uint64_t offset, Callback cb) {
+    // The kernel only reads from the buffer of a write
+    queue_.push_back(Op{true, fd, static_cast<std::uint8_t*>(const_cast<void*>(buf)), len, offset, std::move(cb)});
+}
+
+void AsyncIo::drain() {
+    while (!queue_.empty() || inFlight_ > 0) {
+        submit();
+        poll(true);
+    }
+}
+
+} // namespace gambit
@@ -1,40 +1,35 @@
 #include "gambit/block.hpp"
+#include <algorithm>
 #include <chrono>
 #include <stdexcept>
 
 namespace gambit {
 
 Block::Block(std::uint64_t idx,
-             const std::string& prev,
-             const std::string& before,
-             const std::string& after,
-             const std::string& txRoot_,
+             const Bytes32& prev,
+             const Bytes32& before,
+             const Bytes32& after,
+             const Bytes32& txRoot_,
              const ZkProof& proof_)
-    : index(idx),
-      prevHash(prev),
-      stateBefore(before),
-      stateAfter(after),
-      txRoot(txRoot_),
-      proof(proof_)
 {
+    index = idx;
+    prevHash = prev;
+    stateBefore = before;
+    stateAfter = after;
+    txRoot = txRoot_;
+    proof = proof_;
     timestamp = static_cast<std::uint64_t>(
         std::chrono::system_clock::now().time_since_epoch().count()
     );
     hash = computeHash();
 }
 
-std::string Block::computeHash() const {
-    std::string concat =
-        std::to_string(index) + "|" +
-        prevHash + "|" +
-        stateBefore + "|" +
-        stateAfter + "|" +
-        txRoot + "|" +
-        receiptsRoot + "|" +
-        proof.commitment + "|" +
-        std::to_string(timestamp);
-
-    return gambit::toHex(keccak256(concat));
+void Block::recoverSenders() {
+    if (sendersRecovered) return;
+    for (auto& tx : transactions) {
+        tx.recoverSender();
+    }
+    sendersRecovered = true;
 }
 
 std::string Block::toHex() const {
@@ -47,119 +42,94 @@ Block Block::fromHex(const std::string& hex) {
     if (h.rfind("0x", 0) == 0 || h.rfind("0X", 0) == 0) {
         h = h.substr(2);
     }
-
-    Bytes raw = gambit::fromHex(h);
-    auto root = rlp::decode(raw);
-
-    if (!root.isList || root.list.size() < 10) {
-        throw std::runtime_error("Block::fromHex: invalid RLP block");
-    }
-
-    auto& L = root.list;
-
-    auto toUint = [](const Bytes& b) -> std::uint64_t {
-        std::uint64_t v = 0;
-        for (std::uint8_t c : b) {
-            v = (v << 8) | c;
-        }
-        return v;
-    };
-
-    Block b;
-
-    b.index       = toUint(L[0].bytes);
-    b.prevHash    = std::string(L[1].bytes.begin(), L[1].bytes.end());
-    b.stateBefore = std::string(L[2].bytes.begin(), L[2].bytes.end());
-    b.stateAfter  = std::string(L[3].bytes.begin(), L[3].bytes.end());
-    b.txRoot      = std::string(L[4].bytes.begin(), L[4].bytes.end());
-    b.proof.proof      = std::string(L[5].bytes.begin(), L[5].bytes.end());
-    b.proof.commitment = std::string(L[6].bytes.begin(), L[6].bytes.end());
-    b.timestamp  = toUint(L[7].bytes);
-    b.hash       = std::string(L[8].bytes.begin(), L[8].bytes.end());
-
-    // tx list
-    const auto& txListNode = L[9];
-    if (!txListNode.isList) {
-        throw std::runtime_error("Block::fromHex: tx list not a list");
-    }
-
-    for (const auto& item : txListNode.list) {
-        // item.bytes is raw RLP for a single signed tx
-        std::string txHex = "0x" + gambit::toHex(item.bytes);
-        Transaction tx = Transaction::fromHex(txHex);
-        b.transactions.push_back(std::move(tx));
-    }
-
-    return b;
+    return rlpDecode(gambit::fromHex(h), false);
 }
 
-
 Bytes Block::rlpEncode() const {
     using namespace rlp;
 
-    std::vector<Bytes> fields;
-    fields.push_back(encodeUint(index));
-    fields.push_back(encodeString(prevHash));
-    fields.push_back(encodeString(stateBefore));
-    fields.push_back(encodeString(stateAfter));
-    fields.push_back(encodeString(txRoot));
-    fields.push_back(encodeString(proof.proof));
-    fields.push_back(encodeString(proof.commitment));
-    fields.push_back(encodeUint(timestamp));
-    fields.push_back(encodeString(hash));
+    std::vector<Bytes> parts;
+    parts.push_back(header().rlpEncode());
+    parts.push_back(encodeHash(hash));
 
     std::vector<Bytes> txItems;
     for (const auto& tx : transactions) {
         txItems.push_back(tx.rlpEncodeSigned());
     }
-    fields.push_back(encodeList(txItems));
-
-    fields.push_back(encodeBytes(Bytes(logsBloom.bits.begin(), logsBloom.bits.end())));
+    parts.push_back(encodeList(txItems));
 
     std::vector<Bytes> rcItems;
     for (const auto& r : receipts) {
         rcItems.push_back(r.rlpEncode());
     }
-    fields.push_back(encodeList(rcItems));
+    parts.push_back(encodeList(rcItems));
 
-    return encodeList(fields);
+    if (!witness.empty()) {
+        parts.push_back(witness.rlpEncode());
+    }
+
+    return encodeList(parts);
 }
 
-Block Block::rlpDecode(const Bytes& raw) {
-    auto root = rlp::decode(raw);
-    if (!root.isList || root.list.size() < 10)
+std::size_t Block::splitParts(const std::uint8_t* data, std::size_t size, PartRefs& out) {
+    rlp::ItemRef root = rlp::peek(data, size);
+    if (!root.isList) {
+        throw std::runtime_error("Invalid RLP block");
+    }
+    std::size_t count = 0;
+    const std::uint8_t* p = root.payload;
+    const std::uint8_t* end = root.payload + root.length;
+    while (p < end && count < kPartCount) {
+        out[count] = rlp::peek(p, end - p);
+        p += out[count++].size;
+    }
+    if (count < kWitness || !out[kHeader].isList || out[kHash].isList || out[kHash].length != 32 ||
+        !out[kTransactions].isList || !out[kReceipts].isList)
+    {
         throw std::runtime_error("Invalid RLP block");
+    }
+    return count;
+}
 
-    auto& L = root.list;
+BlockHeader Block::decodeHeader(const std::uint8_t* data, std::size_t size) {
+    rlp::ItemRef root = rlp::peek(data, size);
+    if (!root.isList || root.length == 0) {
+        throw std::runtime_error("Invalid RLP block");
+    }
+    rlp::ItemRef header = rlp::peek(root.payload, root.length);
+    return BlockHeader::rlpDecode(header.begin, header.size);
+}
 
-    auto toUint = [](const Bytes& b) -> uint64_t {
-        uint64_t v = 0;
-        for (uint8_t c : b) v = (v << 8) | c;
-        return v;
-    };
+Block Block::rlpDecode(const Bytes& raw, bool withSenders) {
+    PartRefs parts;
+    std::size_t count = splitParts(raw.data(), raw.size(), parts);
 
     Block b;
-    b.index       = toUint(L[0].bytes);
-    b.prevHash    = std::string(L[1].bytes.begin(), L[1].bytes.end());
-    b.stateBefore = std::string(L[2].bytes.begin(), L[2].bytes.end());
-    b.stateAfter  = std::string(L[3].bytes.begin(), L[3].bytes.end());
-    b.txRoot      = std::string(L[4].bytes.begin(), L[4].bytes.end());
-    b.proof.proof      = std::string(L[5].bytes.begin(), L[5].bytes.end());
-    b.proof.commitment = std::string(L[6].bytes.begin(), L[6].bytes.end());
-    b.timestamp = toUint(L[7].bytes);
-    b.hash      = std::string(L[8].bytes.begin(), L[8].bytes.end());
-
-    // tx list
-    auto& txListNode = L[9];
-    if (!txListNode.isList) throw std::runtime_error("Block txs must be list");
-
-    for (const auto& item : txListNode.list) {
-        Transaction tx = Transaction::fromHex("0x" + gambit::toHex(item.bytes));
-        b.transactions.push_back(std::move(tx));
+    b.header() = BlockHeader::rlpDecode(parts[kHeader].begin, parts[kHeader].size);
+    std::copy(parts[kHash].payload, parts[kHash].payload + 32, b.hash.begin());
+
+    // Each tx is re-parsed from its own signed encoding
+    const auto& txs = parts[kTransactions];
+    const std::uint8_t* p = txs.payload;
+    const std::uint8_t* end = txs.payload + txs.length;
+    while (p < end) {
+        rlp::ItemRef tx = rlp::peek(p, end - p);
+        b.transactions.push_back(Transaction::rlpDecode(Bytes(tx.begin, tx.begin + tx.size), withSenders));
+        p += tx.size;
+    }
+    b.sendersRecovered = withSenders || b.transactions.empty();
+
+    auto item = [&](std::size_t i) {
+        return rlp::decode(Bytes(parts[i].begin, parts[i].begin + parts[i].size));
+    };
+    for (const auto& r : item(kReceipts).list) {
+        b.receipts.push_back(Receipt::rlpDecode(r));
+    }
+    if (count > kWitness) {
+        b.witness = BlockWitness::rlpDecode(item(kWitness));
     }
 
     return b;
 }
 
-
 } // namespace gambit
@@ -0,0 +1,88 @@
+#include "gambit/block_header.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace gambit {
+
+Bytes32 BlockHeader::computeHash() const {
+    return keccak256_32(rlpEncode());
+}
+
+Bytes BlockHeader::rlpEncode() const {
+    using namespace rlp;
+
+    std::vector<Bytes> fields;
+    fields.push_back(encodeUint(index));
+    fields.push_back(encodeHash(prevHash));
+    fields.push_back(encodeHash(stateBefore));
+    fields.push_back(encodeHash(stateAfter));
+    fields.push_back(encodeHash(txRoot));
+    fields.push_back(encodeHash(receiptsRoot));
+    fields.push_back(encodeHash(proof.proof));
+    fields.push_back(encodeHash(proof.commitment));
+    fields.push_back(encodeUint(timestamp));
+    fields.push_back(encodeBytes(Bytes(logsBloom.bits.begin(), logsBloom.bits.end())));
+    return encodeList(fields);
+}
+
+void BlockHeader::splitFields(const std::uint8_t* data, std::size_t size, FieldRefs& out) {
+    rlp::ItemRef root = rlp::peek(data, size);
+    if (!root.isList) {
+        throw std::runtime_error("Invalid RLP block header");
+    }
+    std::size_t count = 0;
+    const std::uint8_t* p = root.payload;
+    const std::uint8_t* end = root.payload + root.length;
+    while (p < end && count < kFieldCount) {
+        out[count] = rlp::peek(p, end - p);
+        p += out[count++].size;
+    }
+    if (count != kFieldCount || p != end) {
+        throw std::runtime_error("Invalid RLP block header");
+    }
+}
+
+BlockHeader BlockHeader::rlpDecode(const std::uint8_t* data, std::size_t size) {
+    FieldRefs fields;
+    splitFields(data, size, fields);
+
+    auto hash32 = [&](std::size_t i) {
+        if (fields[i].length != 32 || fields[i].isList) {
+            throw std::runtime_error("Invalid RLP block header: expected a 32-byte hash");
+        }
+        Bytes32 h;
+        std::copy(fields[i].payload, fields[i].payload + 32, h.begin());
+        return h;
+    };
+    auto toUint = [&](std::size_t i) -> std::uint64_t {
+        if (fields[i].length > 8 || fields[i].isList) {
+            throw std::runtime_error("Invalid RLP block header: integer too large");
+        }
+        std::uint64_t v = 0;
+        for (std::size_t k = 0; k < fields[i].length; ++k) v = (v << 8) | fields[i].payload[k];
+        return v;
+    };
+
+    BlockHeader h;
+    h.index        = toUint(kIndex);
+    h.prevHash     = hash32(kPrevHash);
+    h.stateBefore  = hash32(kStateBefore);
+    h.stateAfter   = hash32(kStateAfter);
+    h.txRoot       = hash32(kTxRoot);
+    h.receiptsRoot = hash32(kReceiptsRoot);
+    h.proof.proof      = hash32(kProof);
+    h.proof.commitment = hash32(kCommitment);
+    // The proof's public inputs are the header's own roots; not re-encoded
+    h.proof.stateBefore = h.stateBefore;
+    h.proof.stateAfter  = h.stateAfter;
+    h.proof.txRoot      = h.txRoot;
+    h.timestamp = toUint(kTimestamp);
+
+    if (fields[kLogsBloom].length != Bloom::kBytes || fields[kLogsBloom].isList) {
+        throw std::runtime_error("Invalid RLP block header: bad logs bloom");
+    }
+    std::copy(fields[kLogsBloom].payload, fields[kLogsBloom].payload + Bloom::kBytes, h.logsBloom.bits.begin());
+    return h;
+}
+
+} // namespace gambit
@@ -0,0 +1,328 @@
+#include "gambit/block_importer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace gambit {
+
+namespace {
+
+// Blocks with fewer transactions recover senders on the stage thread
+constexpr std::size_t kMinParallelSenders = 8;
+
+constexpr std::uint64_t kNoFailure = std::numeric_limits<std::uint64_t>::max();
+
+// Bounded FIFO between two stages; pop() returns nullopt once the queue
+// is closed and empty
+template <typename T>
+class Channel {
+public:
+    explicit Channel(std::size_t capacity) : capacity_(std::max<std::size_t>(capacity, 1)) {}
+
+    void push(T value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notFull_.wait(lock, [&] { return items_.size() < capacity_ || closed_; });
+        if (closed_) return;
+        items_.push_back(std::move(value));
+        notEmpty_.notify_one();
+    }
+
+    std::optional<T> pop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notEmpty_.wait(lock, [&] { return !items_.empty() || closed_; });
+        if (items_.empty()) return std::nullopt;
+        T value = std::move(items_.front());
+        items_.pop_front();
+        notFull_.notify_one();
+        return value;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        notFull_.notify_all();
+        notEmpty_.notify_all();
+    }
+
+private:
+    std::size_t capacity_;
+    std::deque<T> items_;
+    bool closed_{false};
+    std::mutex mutex_;
+    std::condition_variable notFull_;
+    std::condition_variable notEmpty_;
+};
+
+struct Job {
+    Block block;
+    SnapshotBase::Entries writes;
+};
+
+} // namespace
+
+struct BlockImporter::Pipeline {
+    Blockchain& chain;
+    State work;                 // execution state, runs ahead of the chain
+    MptTrie trie;               // root stage's copy of the same state
+    std::uint64_t nextIndex;    // index expected from the next decoded block
+
+    Channel<Bytes> raw;
+    Channel<Job> decoded;
+    Channel<Job> recovered;
+    Channel<Job> executed;
+    Channel<Job> verified;
+    std::vector<std::thread> stages;
+
+    // Lowest failing block index; blocks at or above it are dropped
+    std::atomic<std::uint64_t> failAt{kNoFailure};
+    std::mutex resultMutex;
+    Result result;
+    bool finished{false};
+
+    // Sender recovery pool
+    std::vector<std::thread> workers;
+    std::mutex poolMutex;
+    std::condition_variable poolCv;
+    std::condition_variable poolDone;
+    std::vector<Transaction>* batch{nullptr};
+    std::uint64_t batchId{0};
+    std::atomic<std::size_t> nextTx{0};
+    std::size_t recoveredTxs{0};
+    std::size_t activeWorkers{0};
+    std::atomic<bool> batchError{false};
+    bool stopping{false};
+
+    Pipeline(Blockchain& c, std::size_t depth)
+        : chain(c), work(c.state()), trie(c.state().trie()), nextIndex(c.height() + 1),
+          raw(depth), decoded(depth), recovered(depth), executed(depth), verified(depth) {}
+
+    bool dropped(std::uint64_t index) const { return index >= failAt.load(); }
+
+    void fail(std::uint64_t index, const std::string& error) {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        if (index >= failAt.load()) return;
+        failAt.store(index);
+        result.ok = false;
+        result.failedIndex = index;
+        result.error = error;
+    }
+
+    void decodeStage() {
+        while (auto bytes = raw.pop()) {
+            std::uint64_t index = nextIndex++;
+            if (dropped(index)) continue;
+            try {
+                Job job{Block::rlpDecode(*bytes, false), {}};
+                if (job.block.index != index) {
+                    fail(index, "unexpected block number " + std::to_string(job.block.index));
+                    continue;
+                }
+                if (job.block.hash != job.block.computeHash()) {
+                    fail(index, "block hash mismatch");
+                    continue;
+                }
+                decoded.push(std::move(job));
+            } catch (const std::exception& e) {
+                fail(index, std::string("decode: ") + e.what());
+            }
+        }
+        decoded.close();
+    }
+
+    // Proof and signatures, off the commit path: commitVerified only
+    // re-checks that the block links to the head
+    void senderStage() {
+        while (auto job = decoded.pop()) {
+            if (dropped(job->block.index)) continue;
+            if (!ZkVerifier::verify(job->block.proof)) {
+                fail(job->block.index, "invalid proof");
+                continue;
+            }
+            if (!recoverSenders(job->block.transactions)) {
+                fail(job->block.index, "invalid transaction signature");
+                continue;
+            }
+            job->block.sendersRecovered = true;
+            if (chain.computeTxRoot(job->block.transactions) != job->block.txRoot) {
+                fail(job->block.index, "transaction root mismatch");
+                continue;
+            }
+            recovered.push(std::move(*job));
+        }
+        recovered.close();
+    }
+
+    void executeStage() {
+        while (auto job = recovered.pop()) {
+            if (dropped(job->block.index)) continue;
+            ExecutionResult r = chain.executor().execute(work, job->block.transactions);
+            if (!r.ok) {
+                fail(job->block.index, "tx " + std::to_string(r.failedIndex) + ": " + r.error);
+                continue;
+            }
+            if (!chain.checkReceipts(job->block)) {
+                fail(job->block.index, "receipts root mismatch");
+                continue;
+            }
+            for (const auto& [addr, acc] : r.writes) {
+                work.set(addr, acc);
+            }
+            job->writes = std::move(r.writes);
+            executed.push(std::move(*job));
+        }
+        executed.close();
+    }
+
+    void rootStage() {
+        while (auto job = executed.pop()) {
+            if (dropped(job->block.index)) continue;
+            if (trie.rootHash() != job->block.stateBefore) {
+                fail(job->block.index, "stateBefore does not match parent state");
+                continue;
+            }
+            for (const auto& [addr, acc] : job->writes) {
+                trie.put(Bytes(addr.bytes().begin(), addr.bytes().end()), State::encodeAccount(acc));
+            }
+            if (trie.rootHash() != job->block.stateAfter) {
+                fail(job->block.index, "state root mismatch");
+                continue;
+            }
+            verified.push(std::move(*job));
+        }
+        verified.close();
+    }
+
+    void commitStage() {
+        while (auto job = verified.pop()) {
+            if (dropped(job->block.index)) continue;
+            if (!chain.commitVerified(job->block, job->writes)) {
+                fail(job->block.index, "block does not extend the head");
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(resultMutex);
+            ++result.blocks;
+            result.txs += job->block.transactions.size();
+        }
+    }
+
+    // Claims transactions from the current batch until none are left;
+    // returns how many this thread recovered
+    std::size_t drain(std::vector<Transaction>& txs) {
+        std::size_t n = 0;
+        for (std::size_t i = nextTx.fetch_add(1); i < txs.size(); i = nextTx.fetch_add(1)) {
+            try {
+                txs[i].recoverSender();
+            } catch (const std::exception&) {
+                batchError = true;
+            }
+            ++n;
+        }
+        return n;
+    }
+
+    bool recoverSenders(std::vector<Transaction>& txs) {
+        batchError = false;
+        if (workers.empty() || txs.size() < kMinParallelSenders) {
+            nextTx = 0;
+            drain(txs);
+            return !batchError;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            batch = &txs;
+            nextTx = 0;
+            recoveredTxs = 0;
+            ++batchId;
+        }
+        poolCv.notify_all();
+
+        std::size_t n = drain(txs);
+        std::unique_lock<std::mutex> lock(poolMutex);
+        recoveredTxs += n;
+        // Wait for stragglers too, so none touches the next batch's counter
+        poolDone.wait(lock, [&] { return recoveredTxs == txs.size() && activeWorkers == 0; });
+        batch = nullptr;
+        return !batchError;
+    }
+
+    void senderWorker() {
+        std::uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(poolMutex);
+        for (;;) {
+            poolCv.wait(lock, [&] { return stopping || (batch && batchId != seen); });
+            if (stopping) return;
+            seen = batchId;
+            std::vector<Transaction>* txs = batch;
+            ++activeWorkers;
+            lock.unlock();
+
+            std::size_t n = drain(*txs);
+
+            lock.lock();
+            recoveredTxs += n;
+            --activeWorkers;
+            poolDone.notify_all();
+        }
+    }
+};
+
+BlockImporter::BlockImporter(Blockchain& chain, std::size_t senderThreads, std::size_t queueDepth)
+    : p_(std::make_unique<Pipeline>(chain, queueDepth))
+{
+    if (senderThreads == 0) {
+        senderThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // The sender stage thread takes part in recovery itself
+    for (std::size_t i = 1; i < senderThreads; ++i) {
+        p_->workers.emplace_back(&Pipeline::senderWorker, p_.get());
+    }
+
+    p_->stages.emplace_back(&Pipeline::decodeStage, p_.get());
+    p_->stages.emplace_back(&Pipeline::senderStage, p_.get());
+    p_->stages.emplace_back(&Pipeline::executeStage, p_.get());
+    p_->stages.emplace_back(&Pipeline::rootStage, p_.get());
+    p_->stages.emplace_back(&Pipeline::commitStage, p_.get());
+}
+
+BlockImporter::~BlockImporter() {
+    finish();
+}
+
+bool BlockImporter::submit(Bytes encoded) {
+    if (p_->finished || p_->failAt.load() != kNoFailure) {
+        return false;
+    }
+    p_->raw.push(std::move(encoded));
+    return true;
+}
+
+BlockImporter::Result BlockImporter::progress() const {
+    std::lock_guard<std::mutex> lock(p_->resultMutex);
+    return p_->result;
+}
+
+BlockImporter::Result BlockImporter::finish() {
+    if (!p_->finished) {
+        p_->finished = true;
+        p_->raw.close();
+        for (auto& t : p_->stages) t.join();
+
+        {
+            std::lock_guard<std::mutex> lock(p_->poolMutex);
+            p_->stopping = true;
+        }
+        p_->poolCv.notify_all();
+        for (auto& t : p_->workers) t.join();
+    }
+
+    std::lock_guard<std::mutex> lock(p_->resultMutex);
+    return p_->result;
+}
+
+} // namespace gambit
@@ -0,0 +1,686 @@
+#include "gambit/block_store.hpp"
+#include "byte_io.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#ifdef _WIN32
+    #include <io.h>
+    #include <fcntl.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace gambit {
+
+namespace {
+
+constexpr std::size_t kIndexEntry = 16;
+
+// Segment field of the entry that leads a pruned index
+constexpr std::uint32_t kPrunedMarker = 0xFFFFFFFF;
+
+void closeFd(int fd) {
+#ifdef _WIN32
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+}
+
+} // namespace
+
+// ---------- BlockView ----------
+
+BlockView::BlockView(std::shared_ptr<const void> owner, const std::uint8_t* data, std::size_t size)
+    : owner_(std::move(owner)), data_(data), size_(size)
+{
+    // Only the header and hash are parsed here; body parts are located on
+    // use, so header reads never touch the pages holding the body
+    rlp::ItemRef root = rlp::peek(data_, size_);
+    if (!root.isList || root.length == 0) {
+        throw std::runtime_error("Invalid RLP block");
+    }
+    header_ = rlp::peek(root.payload, root.length);
+    const std::uint8_t* p = header_.begin + header_.size;
+    end_ = root.payload + root.length;
+    if (p == end_) {
+        throw std::runtime_error("Invalid RLP block");
+    }
+    hash_ = rlp::peek(p, end_ - p);
+    if (hash_.isList || hash_.length != 32) {
+        throw std::runtime_error("BlockView: expected a 32-byte hash");
+    }
+    BlockHeader::splitFields(header_.begin, header_.size, fields_);
+}
+
+Bytes32 BlockView::hash32(const rlp::ItemRef& f) const {
+    if (f.length != 32) {
+        throw std::runtime_error("BlockView: expected a 32-byte hash");
+    }
+    Bytes32 h;
+    std::copy(f.payload, f.payload + 32, h.begin());
+    return h;
+}
+
+std::uint64_t BlockView::uint(std::size_t field) const {
+    const auto& f = fields_[field];
+    std::uint64_t v = 0;
+    for (std::size_t i = 0; i < f.length; ++i) v = (v << 8) | f.payload[i];
+    return v;
+}
+
+std::uint64_t BlockView::index() const { return uint(BlockHeader::kIndex); }
+std::uint64_t BlockView::timestamp() const { return uint(BlockHeader::kTimestamp); }
+Bytes32 BlockView::hash() const { return hash32(hash_); }
+Bytes32 BlockView::prevHash() const { return hash32(fields_[BlockHeader::kPrevHash]); }
+Bytes32 BlockView::stateBefore() const { return hash32(fields_[BlockHeader::kStateBefore]); }
+Bytes32 BlockView::stateAfter() const { return hash32(fields_[BlockHeader::kStateAfter]); }
+Bytes32 BlockView::txRoot() const { return hash32(fields_[BlockHeader::kTxRoot]); }
+Bytes32 BlockView::receiptsRoot() const { return hash32(fields_[BlockHeader::kReceiptsRoot]); }
+
+BlockHeader BlockView::header() const {
+    return BlockHeader::rlpDecode(header_.begin, header_.size);
+}
+
+rlp::ItemRef BlockView::part(std::size_t part) const {
+    const std::uint8_t* p = hash_.begin + hash_.size;
+    for (std::size_t k = Block::kTransactions; p < end_; ++k) {
+        rlp::ItemRef it = rlp::peek(p, end_ - p);
+        if (k == part) {
+            if (!it.isList) throw std::runtime_error("Invalid RLP block");
+            return it;
+        }
+        p += it.size;
+    }
+    throw std::runtime_error("Invalid RLP block: missing body");
+}
+
+std::size_t BlockView::count(std::size_t p) const {
+    rlp::ItemRef list = part(p);
+    std::size_t n = 0;
+    for (std::size_t off = 0; off < list.length; ++n) {
+        off += rlp::peek(list.payload + off, list.length - off).size;
+    }
+    return n;
+}
+
+rlp::ItemRef BlockView::item(std::size_t p, std::size_t i) const {
+    rlp::ItemRef list = part(p);
+    std::size_t off = 0;
+    for (std::size_t k = 0; off < list.length; ++k) {
+        rlp::ItemRef it = rlp::peek(list.payload + off, list.length - off);
+        if (k == i) return it;
+        off += it.size;
+    }
+    throw std::out_of_range("BlockView: item index out of range");
+}
+
+std::size_t BlockView::txCount() const { return count(Block::kTransactions); }
+std::size_t BlockView::receiptCount() const { return count(Block::kReceipts); }
+
+Transaction BlockView::transaction(std::size_t i, bool withSender) const {
+    rlp::ItemRef tx = item(Block::kTransactions, i);
+    return Transaction::rlpDecode(Bytes(tx.begin, tx.begin + tx.size), withSender);
+}
+
+std::vector<Bytes32> BlockView::txHashes() const {
+    // Stored transactions are their signed encodings, which is what a
+    // transaction hash covers
+    rlp::ItemRef list = part(Block::kTransactions);
+    std::vector<Bytes32> hashes;
+    for (std::size_t off = 0; off < list.length;) {
+        rlp::ItemRef tx = rlp::peek(list.payload + off, list.length - off);
+        hashes.push_back(keccak256_32(tx.begin, tx.size));
+        off += tx.size;
+    }
+    return hashes;
+}
+
+Bytes32 BlockView::txHash(std::size_t i) const {
+    rlp::ItemRef tx = item(Block::kTransactions, i);
+    return keccak256_32(tx.begin, tx.size);
+}
+
+Receipt BlockView::receipt(std::size_t i) const {
+    rlp::ItemRef rc = item(Block::kReceipts, i);
+    return Receipt::rlpDecode(rlp::decode(Bytes(rc.begin, rc.begin + rc.size)));
+}
+
+Block BlockView::toBlock() const {
+    return Block::rlpDecode(Bytes(data_, data_ + size_));
+}
+
+// ---------- BlockStore ----------
+
+BlockStore::BlockStore(const std::string& dir, std::size_t segmentSize)
+    : dir_(dir), segmentSize_(segmentSize)
+{
+    if (segmentSize_ == 0 || segmentSize_ > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::invalid_argument("BlockStore: segment size must fit in 32 bits");
+    }
+    std::filesystem::create_directories(dir_);
+    recover();
+}
+
+BlockStore::~BlockStore() {
+    if (segFile_) std::fclose(segFile_);
+    if (indexFile_) std::fclose(indexFile_);
+    for (const Segment& seg : segments_) {
+        if (seg.fd >= 0) closeFd(seg.fd);
+    }
+}
+
+std::string BlockStore::segmentPath(std::uint32_t id) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "seg-%05u.dat", id);
+    return dir_ + "/" + name;
+}
+
+std::string BlockStore::frozenPath(std::uint32_t id) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "frz-%05u.dat", id);
+    return dir_ + "/" + name;
+}
+
+void BlockStore::recover() {
+    namespace fs = std::filesystem;
+    std::string indexPath = dir_ + "/index.dat";
+
+    Bytes raw;
+    fs::remove(indexPath + ".tmp");
+    if (fs::exists(indexPath)) {
+        std::ifstream in(indexPath, std::ios::binary);
+        raw.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // A pruned index starts at the first kept block, in segment `base`.
+    // Lower segments still on disk were about to be deleted.
+    std::size_t start = 0;
+    std::uint32_t base = 0;
+    if (raw.size() >= 2 * kIndexEntry && getU32(raw.data()) == kPrunedMarker) {
+        first_ = getU64(raw.data() + 8);
+        start = kIndexEntry;
+        base = getU32(raw.data() + start);
+    }
+
+    // A frozen file stands in for its segment; a segment left next to
+    // one was about to be deleted when the process stopped
+    std::vector<std::uint64_t> sizes;
+    std::vector<std::shared_ptr<const FrozenSegment>> frozen;
+    for (std::uint32_t id = 0; id < base; ++id) {
+        fs::remove(segmentPath(id));
+        fs::remove(frozenPath(id));
+        sizes.push_back(0);
+        frozen.push_back(nullptr);
+    }
+    for (std::uint32_t id = base;; ++id) {
+        fs::remove(frozenPath(id) + ".tmp");
+        if (fs::exists(frozenPath(id))) {
+            frozen.push_back(std::make_shared<const FrozenSegment>(frozenPath(id)));
+            sizes.push_back(frozen.back()->segmentBytes());
+            fs::remove(segmentPath(id));
+        } else if (fs::exists(segmentPath(id))) {
+            frozen.push_back(nullptr);
+            sizes.push_back(fs::file_size(segmentPath(id)));
+        } else {
+            break;
+        }
+    }
+
+    // Keep the longest prefix of index entries that move forward through
+    // the segments and are fully backed by segment bytes. Entries may
+    // skip bytes: blocks dropped by truncate() stay behind as dead space.
+    std::uint32_t segment = base;
+    std::uint64_t end = 0;
+    for (std::size_t off = start; off + kIndexEntry <= raw.size(); off += kIndexEntry) {
+        Location loc{getU32(raw.data() + off), getU32(raw.data() + off + 4), getU64(raw.data() + off + 8)};
+        if (loc.segment < segment || loc.segment >= sizes.size() ||
+            (loc.segment == segment && loc.offset < end) ||
+            loc.offset + loc.length > sizes[loc.segment] ||
+            (frozen[loc.segment] && !frozen[loc.segment]->contains(first_ + index_.size())))
+        {
+            break;
+        }
+        index_.push_back(loc);
+        segment = loc.segment;
+        end = loc.offset + loc.length;
+    }
+
+    // Drop the torn tail: extra index bytes, unindexed segment bytes and
+    // segments started after the last indexed block
+    if (fs::exists(indexPath)) {
+        fs::resize_file(indexPath, start + index_.size() * kIndexEntry);
+    }
+    for (std::uint32_t id = 0; id <= segment; ++id) {
+        Segment s;
+        s.path = segmentPath(id);
+        s.size = id == segment ? end : sizes[id];
+        if (id < frozen.size()) s.frozen = frozen[id];
+        s.pruned = id < base;
+        segments_.push_back(s);
+    }
+    if (!segments_.back().frozen && fs::exists(segments_.back().path)) {
+        fs::resize_file(segments_.back().path, end);
+    }
+    for (std::uint32_t id = segment + 1; id < sizes.size(); ++id) {
+        fs::remove(segmentPath(id));
+        fs::remove(frozenPath(id));
+    }
+
+    // Truncated back into a frozen segment: append to a fresh one
+    if (segments_.back().frozen) {
+        Segment s;
+        s.path = segmentPath(segment + 1);
+        segments_.push_back(s);
+    }
+
+    indexFile_ = std::fopen(indexPath.c_str(), "ab");
+    segFile_ = std::fopen(segments_.back().path.c_str(), "ab");
+    if (!indexFile_ || !segFile_) {
+        throw std::runtime_error("BlockStore: cannot open " + dir_);
+    }
+}
+
+void BlockStore::openSegment(std::uint32_t id) {
+    if (segFile_) std::fclose(segFile_);
+    Segment s;
+    s.path = segmentPath(id);
+    segFile_ = std::fopen(s.path.c_str(), "wb");
+    if (!segFile_) {
+        throw std::runtime_error("BlockStore: cannot create " + s.path);
+    }
+    segments_.push_back(s);
+}
+
+void BlockStore::releaseFdLocked(Segment& seg) const {
+    if (seg.fd >= 0 && seg.reads == 0 && (seg.frozen || seg.pruned)) {
+        closeFd(seg.fd);
+        seg.fd = -1;
+    }
+}
+
+std::uint64_t BlockStore::append(const Bytes& encoded) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!persistent()) {
+        memory_.push_back(std::make_shared<const Bytes>(encoded));
+        return first_ + memory_.size() - 1;
+    }
+
+    if (encoded.size() > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("BlockStore: block too large");
+    }
+    if (segments_.back().size > 0 && segments_.back().size + encoded.size() > segmentSize_) {
+        openSegment(static_cast<std::uint32_t>(segments_.size()));
+    }
+
+    Segment& seg = segments_.back();
+    Location loc{static_cast<std::uint32_t>(segments_.size() - 1),
+                 static_cast<std::uint32_t>(encoded.size()), seg.size};
+
+    // Segment bytes first: a crash before the index entry lands only
+    // leaves unindexed bytes, which recovery trims
+    if (std::fwrite(encoded.data(), 1, encoded.size(), segFile_) != encoded.size() ||
+        std::fflush(segFile_) != 0)
+    {
+        throw std::runtime_error("BlockStore: segment write failed");
+    }
+    std::uint8_t entry[kIndexEntry];
+    putU32(entry, loc.segment);
+    putU32(entry + 4, loc.length);
+    putU64(entry + 8, loc.offset);
+    if (std::fwrite(entry, 1, kIndexEntry, indexFile_) != kIndexEntry || std::fflush(indexFile_) != 0) {
+        throw std::runtime_error("BlockStore: index write failed");
+    }
+
+    seg.size += encoded.size();
+    index_.push_back(loc);
+    return first_ + index_.size() - 1;
+}
+
+BlockView BlockStore::get(std::uint64_t n) const {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (n < first_) {
+        throw std::out_of_range("BlockStore: block was pruned");
+    }
+    if (!persistent()) {
+        if (n - first_ >= memory_.size()) {
+            throw std::out_of_range("BlockStore: block not found");
+        }
+        std::shared_ptr<const Bytes> rec = memory_[n - first_];
+        lock.unlock();
+        return BlockView(rec, rec->data(), rec->size());
+    }
+
+    if (n - first_ >= index_.size()) {
+        throw std::out_of_range("BlockStore: block not found");
+    }
+    const Location& loc = index_[n - first_];
+    Segment& seg = segments_[loc.segment];
+
+    if (seg.frozen) {
+        std::shared_ptr<const FrozenSegment> frozen = seg.frozen;
+        lock.unlock();
+        FrozenSegment::Slice slice = frozen->read(n);
+        return BlockView(slice.frame, slice.frame->data() + slice.offset, slice.length);
+    }
+
+    // The active segment is mapped once at its full capacity and new
+    // blocks show through the mapping; remapping is only needed for an
+    // oversized block, or on Windows, which cannot map past the file's end
+    if (!seg.map || seg.map->size() < loc.offset + loc.length) {
+        bool active = loc.segment + 1 == segments_.size();
+        std::size_t length = active ? std::max<std::size_t>(segmentSize_, loc.offset + loc.length) : seg.size;
+        seg.map = std::make_shared<const MappedFile>(MappedFile::open(seg.path, length));
+    }
+    std::shared_ptr<const MappedFile> map = seg.map;
+    lock.unlock();
+    return BlockView(map, map->data() + loc.offset, loc.length);
+}
+
+BlockHeader BlockStore::header(std::uint64_t n) const {
+    std::shared_ptr<const FrozenSegment> frozen;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (persistent() && n >= first_ && n - first_ < index_.size()) {
+            frozen = segments_[index_[n - first_].segment].frozen;
+        }
+    }
+    return frozen ? frozen->header(n) : get(n).header();
+}
+
+void BlockStore::readAsync(AsyncIo& io, std::uint64_t n, std::function<void(std::optional<BlockView>)> done) const {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (!persistent()) {
+        lock.unlock();
+        done(get(n));
+        return;
+    }
+
+    if (n < first_ || n - first_ >= index_.size()) {
+        throw std::out_of_range("BlockStore: block not found");
+    }
+    const Location loc = index_[n - first_];
+    Segment& seg = segments_[loc.segment];
+    if (seg.frozen) {
+        // Decoding is CPU work; there is nothing to queue
+        lock.unlock();
+        done(get(n));
+        return;
+    }
+    if (seg.fd < 0) {
+#ifdef _WIN32
+        seg.fd = _open(seg.path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+        seg.fd = ::open(seg.path.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+        if (seg.fd < 0) {
+            throw std::runtime_error("BlockStore: cannot open " + seg.path);
+        }
+    }
+    int fd = seg.fd;
+    ++seg.reads;
+    lock.unlock();
+
+    auto buf = std::make_shared<Bytes>(loc.length);
+    std::uint32_t id = loc.segment;
+    io.read(fd, buf->data(), buf->size(), loc.offset, [this, id, buf, done = std::move(done)](std::int64_t res) {
+        {
+            std::lock_guard<std::mutex> relock(mutex_);
+            --segments_[id].reads;
+            releaseFdLocked(segments_[id]);
+        }
+        if (res != static_cast<std::int64_t>(buf->size())) {
+            done(std::nullopt);
+            return;
+        }
+        done(BlockView(buf, buf->data(), buf->size()));
+    });
+}
+
+void BlockStore::truncate(std::uint64_t n) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (n < first_) {
+        throw std::out_of_range("BlockStore: cannot truncate into pruned blocks");
+    }
+    if (!persistent()) {
+        if (n - first_ < memory_.size()) memory_.resize(n - first_);
+        return;
+    }
+    if (n - first_ >= index_.size()) return;
+
+    // Segment bytes are left alone: views handed out earlier still point
+    // into them. New blocks are appended after the dead bytes.
+    index_.resize(n - first_);
+    ++truncations_;
+    std::fflush(indexFile_);
+    std::uint64_t marker = first_ > 0 ? kIndexEntry : 0;
+    std::filesystem::resize_file(dir_ + "/index.dat", marker + index_.size() * kIndexEntry);
+}
+
+void BlockStore::sync() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!persistent()) return;
+    for (std::FILE* f : {segFile_, indexFile_}) {
+        if (f) syncFile(f, "BlockStore");
+    }
+}
+
+std::size_t BlockStore::freeze(std::uint64_t below, const FreezerOptions& opts) {
+    if (!persistent()) return 0;
+    std::lock_guard<std::mutex> freezing(freezeMutex_);
+
+    std::size_t count = 0;
+    for (;;) {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        // Oldest segment not yet frozen; never the one being appended to
+        std::uint32_t id = 0;
+        while (id + 1 < segments_.size() && (segments_[id].frozen || segments_[id].pruned)) ++id;
+        if (id + 1 >= segments_.size()) break;
+
+        // Its blocks: index entries run through the segments in order
+        auto inSegment = [](const Location& loc, std::uint32_t s) { return loc.segment < s; };
+        std::size_t first = std::lower_bound(index_.begin(), index_.end(), id, inSegment) - index_.begin();
+        std::size_t end = std::lower_bound(index_.begin() + first, index_.end(), id + 1, inSegment) - index_.begin();
+        if (first_ + end > below) break;
+
+        Segment& seg = segments_[id];
+        if (first < end && (!seg.map || seg.map->size() < seg.size)) {
+            seg.map = std::make_shared<const MappedFile>(MappedFile::open(seg.path));
+        }
+        std::shared_ptr<const MappedFile> map = seg.map;
+        std::vector<std::pair<const std::uint8_t*, std::size_t>> blocks;
+        for (std::size_t n = first; n < end; ++n) {
+            blocks.emplace_back(map->data() + index_[n].offset, index_[n].length);
+        }
+        std::uint64_t segBytes = seg.size;
+        std::string path = seg.path;
+        std::uint64_t height = first_ + first;
+        lock.unlock();
+
+        // The segment is closed, so its bytes no longer change
+        FrozenSegment::write(frozenPath(id), height, segBytes, blocks, opts);
+        auto frozen = std::make_shared<const FrozenSegment>(frozenPath(id));
+
+        // Views handed out earlier keep the old mapping alive; reads queued
+        // on the readAsync fd keep it open until they finish
+        lock.lock();
+        segments_[id].frozen = frozen;
+        segments_[id].map.reset();
+        releaseFdLocked(segments_[id]);
+        lock.unlock();
+
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        ++count;
+    }
+    return count;
+}
+
+Bytes BlockStore::encodeIndex(std::size_t from, std::size_t to) const {
+    Bytes out((to - from) * kIndexEntry);
+    std::uint8_t* p = out.data();
+    for (std::size_t i = from; i < to; ++i, p += kIndexEntry) {
+        putU32(p, index_[i].segment);
+        putU32(p + 4, index_[i].length);
+        putU64(p + 8, index_[i].offset);
+    }
+    return out;
+}
+
+std::size_t BlockStore::prune(std::uint64_t below) {
+    std::lock_guard<std::mutex> pruning(freezeMutex_);
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (!persistent()) {
+        if (memory_.empty()) return 0;
+        std::uint64_t end = std::min<std::uint64_t>(below, first_ + memory_.size() - 1);
+        if (end <= first_) return 0;
+        std::size_t drop = end - first_;
+        memory_.erase(memory_.begin(), memory_.begin() + static_cast<std::ptrdiff_t>(drop));
+        first_ = end;
+        return drop;
+    }
+    if (index_.empty()) return 0;
+
+    // Whole segments below `below`, oldest first, never the one being
+    // appended to nor the one holding the newest block
+    auto inSegment = [](const Location& loc, std::uint32_t s) { return loc.segment < s; };
+    std::size_t drop = 0;
+    std::uint32_t keepFrom = index_.front().segment;
+    while (keepFrom + 1 < segments_.size()) {
+        std::size_t end = std::lower_bound(index_.begin() + drop, index_.end(), keepFrom + 1, inSegment) - index_.begin();
+        if (first_ + end > below || end >= index_.size()) break;
+        drop = end;
+        ++keepFrom;
+    }
+    if (drop == 0) return 0;
+
+    // Write the new index beside the old one while appends go on; only
+    // the entries appended meanwhile are added under the lock
+    std::uint64_t newFirst = first_ + drop;
+    std::size_t copied = index_.size();
+    std::uint64_t truncations = truncations_;
+    Bytes head(kIndexEntry);
+    putU32(head.data(), kPrunedMarker);
+    putU32(head.data() + 4, 0);
+    putU64(head.data() + 8, newFirst);
+    Bytes body = encodeIndex(drop, copied);
+    lock.unlock();
+
+    std::string indexPath = dir_ + "/index.dat";
+    std::string tmpPath = indexPath + ".tmp";
+    std::FILE* tmp = std::fopen(tmpPath.c_str(), "wb");
+    if (!tmp) {
+        throw std::runtime_error("BlockStore: cannot create " + tmpPath);
+    }
+    auto write = [&](const Bytes& b) {
+        if (std::fwrite(b.data(), 1, b.size(), tmp) != b.size()) {
+            std::fclose(tmp);
+            throw std::runtime_error("BlockStore: index write failed");
+        }
+    };
+    write(head);
+    write(body);
+    try {
+        syncFile(tmp, "BlockStore");
+    } catch (...) {
+        std::fclose(tmp);
+        throw;
+    }
+
+    lock.lock();
+    if (index_.size() <= drop || index_[drop - 1].segment >= keepFrom || index_[drop].segment < keepFrom) {
+        // Rewound into the blocks being pruned; leave things as they are
+        std::fclose(tmp);
+        std::error_code ec;
+        std::filesystem::remove(tmpPath, ec);
+        return 0;
+    }
+    if (truncations_ != truncations) {
+        // A reorg rewound past the copied entries: redo the body (rare)
+        std::fclose(tmp);
+        tmp = std::fopen(tmpPath.c_str(), "wb");
+        if (!tmp) {
+            throw std::runtime_error("BlockStore: cannot create " + tmpPath);
+        }
+        write(head);
+        write(encodeIndex(drop, index_.size()));
+    } else {
+        write(encodeIndex(copied, index_.size()));
+    }
+    if (std::fclose(tmp) != 0) {
+        throw std::runtime_error("BlockStore: index write failed");
+    }
+    std::fclose(indexFile_);
+    std::filesystem::rename(tmpPath, indexPath);
+    indexFile_ = std::fopen(indexPath.c_str(), "ab");
+    if (!indexFile_) {
+        throw std::runtime_error("BlockStore: cannot open " + indexPath);
+    }
+
+    // Views handed out earlier keep their mappings alive; as in freeze(),
+    // a readAsync fd stays open until the reads queued on it finish
+    index_.erase(index_.begin(), index_.begin() + static_cast<std::ptrdiff_t>(drop));
+    first_ = newFirst;
+    std::vector<std::string> doomed;
+    for (std::uint32_t id = 0; id < keepFrom; ++id) {
+        Segment& seg = segments_[id];
+        if (seg.pruned) continue;
+        doomed.push_back(seg.frozen ? frozenPath(id) : seg.path);
+        seg.pruned = true;
+        seg.map.reset();
+        seg.frozen.reset();
+        releaseFdLocked(seg);
+    }
+    lock.unlock();
+
+    for (const std::string& path : doomed) {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+    return drop;
+}
+
+std::uint64_t BlockStore::segmentEnd(std::uint64_t n) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (n < first_ || n - first_ >= (persistent() ? index_.size() : memory_.size())) {
+        throw std::out_of_range("BlockStore: block not found");
+    }
+    if (!persistent()) return n + 1;
+
+    auto inSegment = [](const Location& loc, std::uint32_t s) { return loc.segment < s; };
+    std::uint32_t seg = index_[n - first_].segment;
+    return first_ + (std::lower_bound(index_.begin() + (n - first_), index_.end(), seg + 1, inSegment) - index_.begin());
+}
+
+std::uint64_t BlockStore::first() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return first_;
+}
+
+std::size_t BlockStore::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return first_ + (persistent() ? index_.size() : memory_.size());
+}
+
+std::size_t BlockStore::segments() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return segments_.size();
+}
+
+std::size_t BlockStore::frozenSegments() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::count_if(segments_.begin(), segments_.end(), [](const Segment& s) { return s.frozen != nullptr; });
+}
+
+} // namespace gambit
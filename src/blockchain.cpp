@@ -1,31 +1,698 @@
 #include "gambit/blockchain.hpp"
 #include "gambit/hash.hpp"
+#include "gambit/state_snapshot.hpp"
 #include "gambit/zk.hpp"
 #include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <limits>
 #include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace gambit
 {
 
+    namespace
+    {
+        // WAL block record: [block rlp, [[address, account rlp], ...]]
+        Bytes encodeBlockRecord(const Block &block, const SnapshotBase::Entries &writes)
+        {
+            std::vector<Bytes> items;
+            items.reserve(writes.size());
+            for (const auto &[addr, acc] : writes)
+            {
+                items.push_back(rlp::encodeList({rlp::encodeBytes(Bytes(addr.bytes().begin(), addr.bytes().end())),
+                                                 rlp::encodeBytes(State::encodeAccount(acc))}));
+            }
+            return rlp::encodeList({rlp::encodeBytes(block.rlpEncode()), rlp::encodeList(items)});
+        }
+
+        std::pair<Block, SnapshotBase::Entries> decodeBlockRecord(const Bytes &payload)
+        {
+            rlp::Decoded rec = rlp::decode(payload);
+            if (!rec.isList || rec.list.size() != 2 || !rec.list[1].isList)
+            {
+                throw std::runtime_error("wal: malformed block record");
+            }
+            SnapshotBase::Entries writes;
+            for (const auto &w : rec.list[1].list)
+            {
+                if (!w.isList || w.list.size() != 2)
+                {
+                    throw std::runtime_error("wal: malformed block record");
+                }
+                writes.emplace_back(Address::fromBytes(w.list[0].bytes), State::decodeAccount(w.list[1].bytes));
+            }
+            return {Block::rlpDecode(rec.list[0].bytes), std::move(writes)};
+        }
+    } // namespace
+
     Blockchain::Blockchain(const GenesisConfig &genesis)
-        : state_(genesis), chainId_(genesis.chainId)
+        : store_(std::make_unique<BlockStore>()), state_(genesis), chainId_(genesis.chainId),
+          executor_(0, genesis.chainId), preExec_(genesis.chainId)
     {
         initGenesis(genesis);
     }
 
     void Blockchain::initGenesis(const GenesisConfig &genesis)
     {
+        Bytes32 root = state_.root();
         Block genesisBlock(
             0,
-            "0x00",
-            state_.root(),
-            state_.root(),
-            "0x00",
-            ZkProver::generate(state_.root(), state_.root(), "0x00"));
+            Bytes32{},
+            root,
+            root,
+            Bytes32{},
+            ZkProver::generate(root, root, Bytes32{}));
+
+        // Same genesis config => same genesis hash on every node
+        genesisBlock.timestamp = 0;
+        genesisBlock.hash = genesisBlock.computeHash();
+        genesisHash_ = genesisBlock.hash;
+        genesisRoot_ = root;
+
+        store_->append(genesisBlock.rlpEncode());
+        index_.add(genesisBlock);
+
+        SnapshotBase::Entries accounts;
+        state_.forEach([&](const Address &addr, const Account &acc)
+                       { accounts.emplace_back(addr, acc); });
+        snapshot_.reset(root, accounts);
+        publishViewLocked();
+    }
+
+    void Blockchain::publishViewLocked()
+    {
+        BlockView tip = head();
+        ChainView v;
+        v.height = tip.index();
+        v.headHash = tip.hash();
+        v.stateRoot = tip.stateAfter();
+        v.state = snapshot_.version();
+        view_.publish(std::move(v));
+    }
+
+    void Blockchain::announceLocked(const Block &block, ChainEvent::Kind kind, const SnapshotBase::Entries &accounts,
+                                    const std::vector<Address> &deleted)
+    {
+        ChainEvent e;
+        e.height = block.index;
+        if (kind == ChainEvent::Kind::BlockCommitted)
+        {
+            e.kind = ChainEvent::Kind::Transaction;
+            for (std::size_t i = 0; i < block.transactions.size(); ++i)
+            {
+                e.position = static_cast<std::uint32_t>(i);
+                e.hash = block.transactions[i].hash;
+                e.address = block.transactions[i].from;
+                changes_.publish(e);
+            }
+        }
+
+        e = ChainEvent{};
+        e.kind = ChainEvent::Kind::Account;
+        e.height = block.index;
+        for (const auto &[addr, acc] : accounts)
+        {
+            e.address = addr;
+            e.account = acc;
+            changes_.publish(e);
+        }
+        e.account = Account{};
+        e.deleted = true;
+        for (const Address &addr : deleted)
+        {
+            e.address = addr;
+            changes_.publish(e);
+        }
+
+        e = ChainEvent{};
+        e.kind = kind;
+        e.height = block.index;
+        e.position = static_cast<std::uint32_t>(block.transactions.size());
+        e.hash = block.hash;
+        e.stateRoot = kind == ChainEvent::Kind::BlockCommitted ? block.stateAfter : block.stateBefore;
+        changes_.publish(e);
+    }
+
+    void Blockchain::setDataDir(const std::string &dir, std::size_t segmentSize)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto disk = std::make_unique<BlockStore>(dir + "/blocks", segmentSize);
+        dataDir_ = dir;
+        loadCheckpoints();
+        if (disk->empty())
+        {
+            if (store_->first() > 0)
+            {
+                throw std::runtime_error("setDataDir: in-memory history was already pruned");
+            }
+            // Fresh directory: carry over what is in memory so far
+            for (std::uint64_t n = 0; n < store_->size(); ++n)
+            {
+                BlockView v = store_->get(n);
+                disk->append(Bytes(v.data(), v.data() + v.size()));
+            }
+            store_ = std::move(disk);
+        }
+        else
+        {
+            if (store_->size() != 1)
+            {
+                throw std::runtime_error("setDataDir: chain already has blocks");
+            }
+            // Once block 0 is pruned only the recorded genesis hash is left
+            bool sameGenesis;
+            if (disk->first() == 0)
+            {
+                sameGenesis = disk->get(0).stateAfter() == genesisRoot_;
+            }
+            else
+            {
+                Bytes32 stored{};
+                std::ifstream in(dir + "/genesis", std::ios::binary);
+                in.read(reinterpret_cast<char *>(stored.data()), stored.size());
+                sameGenesis = in && stored == genesisHash_;
+            }
+            if (!sameGenesis)
+            {
+                throw std::runtime_error("setDataDir: stored chain has a different genesis");
+            }
+            store_ = std::move(disk);
+            replayStored();
+        }
+
+        if (!std::filesystem::exists(dir + "/genesis"))
+        {
+            std::ofstream out(dir + "/genesis", std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char *>(genesisHash_.data()), genesisHash_.size());
+            if (!out)
+            {
+                throw std::runtime_error("setDataDir: cannot write " + dir + "/genesis");
+            }
+        }
+
+        snapshot_.persistTo(dir + "/snapshot");
+
+        // Re-apply what the log holds beyond the store, then start a fresh log
+        auto wal = std::make_unique<WriteAheadLog>(dir + "/wal.log");
+        recoverWalLocked(*wal);
+        wal_ = std::move(wal);
+        checkpointWalLocked();
+        publishViewLocked();
+    }
+
+    void Blockchain::recoverWalLocked(const WriteAheadLog &wal)
+    {
+        wal.replay([&](std::uint8_t type, const Bytes &payload)
+                   {
+            switch (static_cast<WalRecord>(type))
+            {
+            case WalRecord::Block:
+            {
+                auto [block, writes] = decodeBlockRecord(payload);
+                // Blocks the store already has (or that a later rewind
+                // dropped) are skipped
+                if (block.index != height() + 1 || block.prevHash != head().hash())
+                {
+                    break;
+                }
+                // Checked before anything is applied, so a bad record
+                // leaves the chain as the store had it
+                if (rootAfterLocked(writes) != block.stateAfter)
+                {
+                    throw std::runtime_error("wal: state root mismatch at block " + std::to_string(block.index));
+                }
+                commitLocked(block, writes);
+                break;
+            }
+            case WalRecord::Rewind:
+            {
+                rlp::Decoded h = rlp::decode(payload);
+                std::uint64_t target = 0;
+                for (std::uint8_t b : h.bytes)
+                {
+                    target = (target << 8) | b;
+                }
+                if (target < height())
+                {
+                    if (height() - target > journals_.size())
+                    {
+                        throw std::runtime_error("wal: rewind below the journalled blocks");
+                    }
+                    rollbackLocked(target);
+                }
+                break;
+            }
+            case WalRecord::Transaction:
+            {
+                try
+                {
+                    Transaction tx = Transaction::rlpDecode(payload);
+                    std::string err;
+                    if (validateTransaction(tx, err) && mempool_.add(tx, nonceLocked(tx.from), err))
+                    {
+                        ++pendingVersion_;
+                    }
+                }
+                catch (const std::exception &)
+                {
+                    // Unsigned or malformed: nothing to restore
+                }
+                break;
+            }
+            } });
+    }
+
+    void Blockchain::logLocked(WalRecord type, const Bytes &payload)
+    {
+        walSeq_ = wal_->append(static_cast<std::uint8_t>(type), payload);
+    }
+
+    void Blockchain::checkpointWalLocked()
+    {
+        // Everything logged so far is in the store now; the mempool is
+        // re-logged so it survives the reset
+        store_->sync();
+        wal_->reset();
+        for (const Transaction &tx : mempool_.all())
+        {
+            logLocked(WalRecord::Transaction, tx.rlpEncodeSigned());
+        }
+        wal_->sync(walSeq_);
+    }
+
+    void Blockchain::syncWal(std::uint64_t seq)
+    {
+        // Called without mutex_ held so concurrent callers share an fsync
+        if (wal_ && seq > 0)
+        {
+            wal_->sync(seq);
+        }
+    }
+
+    void Blockchain::replayStored()
+    {
+        // Rebuild head state by re-executing every stored block on top of
+        // genesis; each post-state root must match what the block claims
+        index_.clear();
+        journals_.clear();
+        std::uint64_t from = 1;
+        if (store_->first() == 0)
+        {
+            index_.add(store_->get(0).toBlock());
+        }
+        else
+        {
+            // Genesis was pruned: start from the oldest checkpoint the
+            // stored blocks continue, which re-checks the most of them
+            std::uint64_t first = store_->first();
+            auto cp = checkpoints_.begin();
+            for (; cp != checkpoints_.end(); ++cp)
+            {
+                if (cp->first + 1 < first || cp->first >= store_->size())
+                {
+                    continue;
+                }
+                Bytes32 expected = cp->first + 1 < store_->size() ? store_->get(cp->first + 1).stateBefore()
+                                                                  : store_->get(cp->first).stateAfter();
+                if (cp->second == expected)
+                {
+                    break;
+                }
+            }
+            if (cp == checkpoints_.end())
+            {
+                throw std::runtime_error("replay: blocks below " + std::to_string(first) +
+                                         " were pruned and no state checkpoint follows on");
+            }
+            std::ifstream in(checkpointPath(cp->first), std::ios::binary);
+            state_ = loadStateSnapshot(in, executor_.threads());
+            trie_.reset();
+            if (sharded_)
+            {
+                sharded_->invalidate();
+            }
+            for (std::uint64_t n = first; n <= cp->first; ++n)
+            {
+                index_.add(store_->get(n).toBlock());
+            }
+            from = cp->first + 1;
+        }
+        for (std::uint64_t n = from; n < store_->size(); ++n)
+        {
+            Block block = store_->get(n).toBlock();
+            ExecutionResult result = executor_.execute(state_, block.transactions);
+            if (!result.ok)
+            {
+                throw std::runtime_error("replay: block " + std::to_string(n) + ": " + result.error);
+            }
+            // Journal the most recent blocks so they can still be reorged
+            ReverseDiff undo = applyWritesLocked(result.writes);
+            if (store_->size() - n <= maxReorgDepth_)
+            {
+                pushJournalLocked(std::move(undo));
+            }
+            if (state_.root() != block.stateAfter)
+            {
+                throw std::runtime_error("replay: state root mismatch at block " + std::to_string(n));
+            }
+            index_.add(block);
+        }
+
+        // Every replayed block's root was checked against the state above
+        SnapshotBase::Entries accounts;
+        state_.forEach([&](const Address &addr, const Account &acc)
+                       { accounts.emplace_back(addr, acc); });
+        snapshot_.reset(head().stateAfter(), accounts);
+    }
+
+    void Blockchain::enableArchive(const ArchiveConfig &cfg)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pruneCfg_.keepBlocks > 0)
+        {
+            throw std::invalid_argument("enableArchive: history pruning is on");
+        }
+        archiveCfg_ = cfg;
+        std::lock_guard<std::mutex> archiveLock(archiveMutex_);
+        archive_.reset();   // the old store's builder must be done with the directory
+        archive_ = std::make_unique<ArchiveStore>(cfg, height(), snapshot_.version());
+    }
+
+    void Blockchain::setMaxReorgDepth(std::size_t depth)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        maxReorgDepth_ = depth;
+        while (journals_.size() > maxReorgDepth_)
+        {
+            journals_.pop_front();
+        }
+    }
+
+    std::string Blockchain::checkpointPath(std::uint64_t height) const
+    {
+        return dataDir_ + "/checkpoints/state-" + std::to_string(height) + ".gsts";
+    }
+
+    void Blockchain::loadCheckpoints()
+    {
+        namespace fs = std::filesystem;
+        checkpoints_.clear();
+        fs::create_directories(dataDir_ + "/checkpoints");
+        for (const auto &entry : fs::directory_iterator(dataDir_ + "/checkpoints"))
+        {
+            std::string name = entry.path().filename().string();
+            if (entry.path().extension() == ".tmp")
+            {
+                // Unfinished when the process stopped
+                std::error_code ec;
+                fs::remove(entry.path(), ec);
+                continue;
+            }
+            if (name.rfind("state-", 0) != 0 || entry.path().extension() != ".gsts")
+            {
+                continue;
+            }
+            std::uint64_t height = std::stoull(name.substr(6));
+            std::ifstream in(entry.path(), std::ios::binary);
+            checkpoints_[height] = readStateSnapshotRoot(in);
+        }
+    }
+
+    void Blockchain::writeCheckpoint()
+    {
+        // The published tip is immutable, so this runs beside block
+        // production; only the version is held, not the RCU read guard
+        std::uint64_t height;
+        Bytes32 root;
+        SnapshotTree::Version version;
+        {
+            auto v = view();
+            height = v->height;
+            root = v->stateRoot;
+            version = v->state;
+        }
+        State state;
+        version.forEach([&](const Address &addr, const Account &acc)
+                        { state.set(addr, acc); });
+
+        std::string path = checkpointPath(height);
+        std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (writeStateSnapshot(state, out) != root)
+            {
+                throw std::runtime_error("checkpoint: state root mismatch at block " + std::to_string(height));
+            }
+            out.flush();
+            if (!out)
+            {
+                throw std::runtime_error("checkpoint: cannot write " + tmp);
+            }
+        }
+        std::filesystem::rename(tmp, path);
+        checkpoints_[height] = root;
+    }
+
+    void Blockchain::setPruning(const PruneConfig &cfg)
+    {
+        std::lock_guard<std::mutex> pruning(pruneMutex_);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (cfg.keepBlocks > 0 && archive_)
+        {
+            throw std::invalid_argument("setPruning: archive mode keeps all history");
+        }
+        pruneCfg_ = cfg;
+        pruneTokens_ = static_cast<double>(cfg.bytesPerSecond);
+        pruneRefill_ = std::chrono::steady_clock::now();
+    }
+
+    std::size_t Blockchain::pruneHistory()
+    {
+        std::lock_guard<std::mutex> pruning(pruneMutex_);
+
+        BlockStore *store;
+        std::uint64_t limit;    // first block to keep
+        std::uint64_t settled;  // deepest block a reorg can still replace, minus one
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::uint64_t keep = std::max<std::uint64_t>(pruneCfg_.keepBlocks, maxReorgDepth_ + 1);
+            if (pruneCfg_.keepBlocks == 0 || height() < keep)
+            {
+                return 0;
+            }
+            limit = height() - keep + 1;
+            settled = height() - maxReorgDepth_;
+            store = store_.get();
+        }
+        if (store->first() >= limit)
+        {
+            return 0;
+        }
+
+        // On disk, a restart replays from a checkpoint instead of genesis,
+        // so blocks go only up to the newest settled checkpoint whose state
+        // the next stored block starts from. A fresh one is taken at the
+        // head once none is left to prune up to.
+        std::optional<std::uint64_t> base;
+        if (store->persistent())
+        {
+            for (auto it = checkpoints_.rbegin(); it != checkpoints_.rend() && !base; ++it)
+            {
+                if (it->first >= limit || it->first >= settled || it->first + 1 < store->first())
+                {
+                    continue;
+                }
+                base = it->first;
+                if (it->second != store->get(it->first + 1).stateBefore())
+                {
+                    base.reset();   // taken on a branch that was reorged away
+                }
+            }
+            if (checkpoints_.empty() || checkpoints_.rbegin()->first + 1 < limit)
+            {
+                writeCheckpoint();
+            }
+            if (!base)
+            {
+                return 0;
+            }
+            limit = std::min(limit, *base + 1);
+        }
+
+        std::size_t pruned = 0;
+        for (std::uint64_t first = store->first(); first < limit; first = store->first())
+        {
+            std::uint64_t end = store->segmentEnd(first);
+            if (end > limit)
+            {
+                break;
+            }
+            if (pruneCfg_.bytesPerSecond > 0)
+            {
+                auto now = std::chrono::steady_clock::now();
+                double rate = static_cast<double>(pruneCfg_.bytesPerSecond);
+                pruneTokens_ = std::min(rate, pruneTokens_ + rate * std::chrono::duration<double>(now - pruneRefill_).count());
+                pruneRefill_ = now;
+                if (pruneTokens_ <= 0)
+                {
+                    break;
+                }
+            }
+
+            // Lookups by hash stop finding the blocks before they go
+            std::uint64_t bytes = 0;
+            for (std::uint64_t n = first; n < end; ++n)
+            {
+                BlockView v = store->get(n);
+                bytes += v.size();
+                index_.remove(n, v.hash(), v.txHashes());
+            }
+            pruneTokens_ -= static_cast<double>(bytes);
+            std::size_t dropped = store->prune(end);
+            if (dropped == 0)
+            {
+                break;
+            }
+            pruned += dropped;
+        }
+
+        if (pruned > 0)
+        {
+            index_.addresses().prune(store->first());
+        }
+
+        // Checkpoints the store no longer continues from
+        while (!checkpoints_.empty() && checkpoints_.begin()->first + 1 < store->first())
+        {
+            std::error_code ec;
+            std::filesystem::remove(checkpointPath(checkpoints_.begin()->first), ec);
+            checkpoints_.erase(checkpoints_.begin());
+        }
+        return pruned;
+    }
 
-        chain_.push_back(genesisBlock);
+    std::size_t Blockchain::freezeColdBlocks()
+    {
+        BlockStore *store;
+        std::uint64_t below;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::uint64_t depth = std::max<std::uint64_t>(freezeDepth_, maxReorgDepth_);
+            if (freezeDepth_ == 0 || !store_->persistent() || height() <= depth)
+            {
+                return 0;
+            }
+            below = height() - depth;
+            store = store_.get();
+        }
+        return store->freeze(below);
+    }
+
+    std::optional<Account> Blockchain::accountAt(const Address &addr, std::uint64_t height)
+    {
+        // Served from the published view and the archive's own lock; the
+        // chain lock is never taken, so readers do not hold up imports
+        {
+            auto v = view();
+            if (height > v->height)
+            {
+                throw std::out_of_range("Block not found");
+            }
+            if (height == v->height)
+            {
+                return v->state.get(addr);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(archiveMutex_);
+        if (!archive_ || !archive_->available(height))
+        {
+            throw std::out_of_range("Historical state not available");
+        }
+        return archive_->accountAt(addr, height);
     }
     
+    std::optional<BlockView> Blockchain::blockByHash(const Bytes32 &hash) const
+    {
+        std::optional<std::uint64_t> height = index_.blockHeight(hash);
+        if (!height)
+        {
+            return std::nullopt;
+        }
+        try
+        {
+            BlockView view = store_->get(*height);
+            if (view.hash() != hash)
+            {
+                return std::nullopt;
+            }
+            return view;
+        }
+        catch (const std::out_of_range &)
+        {
+            return std::nullopt;
+        }
+    }
+
+    std::optional<Blockchain::TxBlock> Blockchain::transactionBlock(const Bytes32 &hash) const
+    {
+        std::optional<ChainIndex::TxLocation> loc = index_.transaction(hash);
+        if (!loc)
+        {
+            return std::nullopt;
+        }
+        try
+        {
+            BlockView view = store_->get(loc->height);
+            if (loc->position >= view.txCount() || view.txHash(loc->position) != hash)
+            {
+                return std::nullopt;
+            }
+            return TxBlock{std::move(view), loc->position};
+        }
+        catch (const std::out_of_range &)
+        {
+            return std::nullopt;
+        }
+    }
+
+    std::optional<Blockchain::TxProof> Blockchain::transactionProof(const Bytes32 &hash) const
+    {
+        std::optional<TxBlock> tx = transactionBlock(hash);
+        if (!tx)
+        {
+            return std::nullopt;
+        }
+        const BlockView &block = tx->block;
+        return TxProof{block.hash(), block.header(), merkle::prove(block.txHashes(), tx->position)};
+    }
+
+    std::optional<BlockHeader> Blockchain::headerByHash(const Bytes32 &hash) const
+    {
+        std::optional<std::uint64_t> height = index_.blockHeight(hash);
+        if (!height)
+        {
+            return std::nullopt;
+        }
+        try
+        {
+            BlockHeader header = store_->header(*height);
+            if (header.computeHash() != hash)
+            {
+                return std::nullopt;
+            }
+            return header;
+        }
+        catch (const std::out_of_range &)
+        {
+            return std::nullopt;
+        }
+    }
+
     bool Blockchain::validateTransaction(const Transaction &tx, std::string &err) const
     {
         // 1. chainId
@@ -42,32 +709,31 @@ namespace gambit
             return false;
         }
 
-        // 3. account existence & nonce
-        const Account *acc = state_.get(tx.from);
+        // 3. account existence & nonce (flat snapshot: safe off the writer
+        // thread); later nonces wait in the mempool behind the earlier ones
+        std::optional<Account> acc = snapshot_.get(tx.from);
         std::uint64_t expectedNonce = acc ? acc->nonce : 0;
-        if (tx.nonce != expectedNonce)
+        if (tx.nonce < expectedNonce)
         {
-            err = "Invalid nonce";
+            err = "Nonce too low";
             return false;
         }
 
         // 4. balance >= value + gasPrice * gasLimit (simplified)
-        // Check for multiplication overflow (portable, MSVC-compatible)
-        std::uint64_t gasCost = tx.gasPrice * tx.gasLimit;
-        if (tx.gasPrice != 0 && gasCost / tx.gasPrice != tx.gasLimit)
+        uint256 gasCost;
+        if (uint256::mulOverflow(tx.gasPrice, tx.gasLimit, gasCost))
         {
             err = "Gas cost overflow";
             return false;
         }
-        // Check for addition overflow
-        std::uint64_t needed = gasCost + tx.value;
-        if (needed < gasCost)
+        uint256 needed;
+        if (uint256::addOverflow(gasCost, tx.value, needed))
         {
             err = "Total cost overflow";
             return false;
         }
 
-        std::uint64_t bal = acc ? acc->balance : 0;
+        uint256 bal = acc ? acc->balance : uint256();
         if (bal < needed)
         {
             err = "Insufficient funds";
@@ -79,107 +745,702 @@ namespace gambit
 
     void Blockchain::addTransaction(const Transaction &tx)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        mempool_.push_back(tx);
+        std::unique_lock<std::mutex> lock(mutex_);
+        std::string err;
+        if (!mempool_.add(tx, nonceLocked(tx.from), err))
+        {
+            throw std::runtime_error(err);
+        }
+        if (wal_)
+        {
+            logLocked(WalRecord::Transaction, tx.rlpEncodeSigned());
+        }
+        ++pendingVersion_;
+
+        std::uint64_t seq = walSeq_;
+        lock.unlock();
+        syncWal(seq);
     }
 
-    std::string Blockchain::computeTxRoot(const std::vector<Transaction> &txs) const
+    void Blockchain::preExecutePending()
     {
-        if (txs.empty())
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (preExecutedVersion_ == pendingVersion_)
         {
-            return "0x00";
+            return;
         }
+        preExec_.run(state_, pendingLocked());
+        preExecutedVersion_ = pendingVersion_;
+    }
 
-        // Simple Merkle root: hash(concat(txHex...))
-        std::string concat;
-        for (const auto &tx : txs)
-        {
-            concat += tx.toHex() + "|";
-        }
+    std::uint64_t Blockchain::nonceLocked(const Address &addr) const
+    {
+        const Account *acc = state_.get(addr);
+        return acc ? acc->nonce : 0;
+    }
 
-        return toHex(keccak256(concat));
+    std::vector<Transaction> Blockchain::pendingLocked() const
+    {
+        std::size_t limit = maxBlockTransactions_.load();
+        return mempool_.select(limit ? limit : std::numeric_limits<std::size_t>::max());
     }
 
-    Block Blockchain::mineBlock()
+    std::vector<Transaction> Blockchain::mempool() const
+    {
+        return pendingLocked();
+    }
+
+    void Blockchain::setMaxBlockTransactions(std::size_t n)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        maxBlockTransactions_.store(n);
+        preExec_.clear();
+        ++pendingVersion_;
+    }
+
+    void Blockchain::setExecutionThreads(std::size_t threads)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        executor_ = ParallelExecutor(threads, chainId_);
+    }
+
+    void Blockchain::setShardCount(std::size_t shards)
     {
         std::lock_guard<std::mutex> lock(mutex_);
+        sharded_ = shards ? std::make_unique<ShardedExecutor>(shards, chainId_) : nullptr;
+    }
 
-        std::string before = state_.root();
+    ExecutionResult Blockchain::executePending()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return executePendingLocked(pendingLocked());
+    }
 
-        // Apply transactions (if any)
-        for (const auto &tx : mempool_)
+    ExecutionResult Blockchain::executePendingLocked(const std::vector<Transaction> &pending)
+    {
+        // A warm cache only re-executes invalidated entries; a cold one
+        // is better served by the parallel executors
+        if (!pending.empty() && preExec_.covers(pending))
+        {
+            return preExec_.run(state_, pending);
+        }
+        if (sharded_)
         {
-            state_.applyTransaction(tx.from, tx);
+            return sharded_->execute(state_, pending);
         }
+        return executor_.execute(state_, pending);
+    }
 
-        std::string after = state_.root();
-        std::string txRoot = computeTxRoot(mempool_);
+    Bytes32 Blockchain::computeTxRoot(const std::vector<Transaction> &txs) const
+    {
+        // Binary Merkle tree over the transaction hashes (see merkle.hpp)
+        std::vector<Bytes32> leaves;
+        leaves.reserve(txs.size());
+        for (const auto &tx : txs)
+        {
+            leaves.push_back(tx.hash);
+        }
+        return merkle::root(leaves, 0);
+    }
 
+    std::vector<Receipt> Blockchain::computeReceipts(const std::vector<Transaction> &txs) const
+    {
+        // Transfers charge their whole gas limit and emit no logs; a block
+        // with a failing transaction is never committed
         std::vector<Receipt> receipts;
+        receipts.reserve(txs.size());
         Receipt rc;
         uint64_t cumulativeGas = 0;
-        for (const auto &tx : mempool_)
+        for (const auto &tx : txs)
         {
             cumulativeGas += tx.gasLimit;
             rc.status = true;
             rc.cumulativeGasUsed = cumulativeGas;
-            rc.logs.clear(); // no logs yet
             receipts.push_back(rc);
         }
+        return receipts;
+    }
 
-        // Compute receiptsRoot
+    Bytes32 Blockchain::computeReceiptsRoot(const std::vector<Receipt> &receipts) const
+    {
         MptTrie receiptsTrie;
         for (size_t i = 0; i < receipts.size(); ++i)
         {
             Bytes key{static_cast<uint8_t>(i)};
             receiptsTrie.put(key, receipts[i].rlpEncode());
         }
-        std::string receiptsRoot = receiptsTrie.rootHash();
+        return receiptsTrie.rootHash();
+    }
+
+    bool Blockchain::checkReceipts(const Block &block) const
+    {
+        std::vector<Receipt> local = computeReceipts(block.transactions);
+        if (computeReceiptsRoot(local) != block.receiptsRoot || block.receipts.size() != local.size())
+        {
+            return false;
+        }
+        // Compared one by one: the root's one-byte keys only cover the
+        // last 256 receipts of a larger block
+        for (std::size_t i = 0; i < local.size(); ++i)
+        {
+            if (block.receipts[i].rlpEncode() != local[i].rlpEncode())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    Blockchain::PendingBlock Blockchain::preparePending()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return preparePendingLocked();
+    }
+
+    Blockchain::PendingBlock Blockchain::preparePendingLocked()
+    {
+        PendingBlock p;
+        p.height = height();
+        p.parentHash = head().hash();
+        p.trie = trieLocked();
+
+        // Same writes as applying the transactions in order; if one fails,
+        // a single serial pass builds the block without it
+        p.transactions = pendingLocked();
+        p.result = executePendingLocked(p.transactions);
+        if (!p.result.ok)
+        {
+            p.result = skipFailingLocked(p.transactions);
+        }
+        return p;
+    }
+
+    ExecutionResult Blockchain::skipFailingLocked(std::vector<Transaction> &txs)
+    {
+        // Skipped transactions free their slots for the ones selected after
+        // them, so the pass walks the whole pool
+        std::size_t limit = maxBlockTransactions_.load();
+        if (limit == 0)
+        {
+            limit = std::numeric_limits<std::size_t>::max();
+        }
+        std::vector<Transaction> candidates = mempool_.select();
+        txs.clear();
+
+        ExecutionResult res;
+        std::unordered_map<Address, Account, AddressHash> overlay;
+        std::vector<Address> order;
+        auto load = [&](const Address &a) -> Account &
+        {
+            auto it = overlay.find(a);
+            if (it != overlay.end())
+                return it->second;
+            order.push_back(a);
+            const Account *acc = state_.get(a);
+            return overlay.emplace(a, acc ? *acc : Account{}).first->second;
+        };
+
+        // A failing transaction takes its sender's later ones out of the
+        // block with it (their nonces would have a gap). Only a wrong chain
+        // or nonce is invalid against the head and leaves the pool; a
+        // transfer that cannot be paid yet may be funded by the next block.
+        std::unordered_set<Address, AddressHash> skipped;
+        std::vector<Bytes32> invalid;
+        for (Transaction &tx : candidates)
+        {
+            if (txs.size() == limit)
+            {
+                break;
+            }
+            if (skipped.count(tx.from))
+            {
+                continue;
+            }
+            auto it = overlay.find(tx.from);
+            const Account *acc = it != overlay.end() ? &it->second : state_.get(tx.from);
+            Account sender = acc ? *acc : Account{};
+            if (transferError(tx, sender, executor_.chainId()))
+            {
+                skipped.insert(tx.from);
+                bool wrongChain = executor_.chainId() != 0 && tx.chainId != executor_.chainId();
+                if (wrongChain || tx.nonce != sender.nonce)
+                {
+                    invalid.push_back(tx.hash);
+                }
+                continue;
+            }
+            Account &from = load(tx.from);
+            Account &to = load(tx.to);
+            from.balance -= tx.value;
+            from.nonce += 1;
+            to.balance += tx.value;
+            txs.push_back(std::move(tx));
+        }
+
+        for (const Bytes32 &hash : invalid)
+        {
+            mempool_.remove(hash);
+        }
+        if (!invalid.empty())
+        {
+            ++pendingVersion_;
+        }
+
+        res.writes.reserve(order.size());
+        for (const Address &a : order)
+        {
+            res.writes.emplace_back(a, overlay[a]);
+        }
+        return res;
+    }
+
+    Block Blockchain::mineBlock()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        PendingBlock pending = preparePendingLocked();
+        MptTrie &trie = pending.trie;
+        const ExecutionResult &result = pending.result;
+        Bytes32 before = trie.rootHash();
+
+        std::vector<Address> touched;
+        touched.reserve(result.writes.size());
+        for (const auto &[addr, acc] : result.writes)
+        {
+            touched.push_back(addr);
+        }
+        BlockWitness witness = BlockWitness::build(trie, touched);
+
+        for (const auto &[addr, acc] : result.writes)
+        {
+            trie.put(Bytes(addr.bytes().begin(), addr.bytes().end()), State::encodeAccount(acc));
+        }
+
+        Bytes32 after = trie.rootHash();
+        Bytes32 txRoot = computeTxRoot(pending.transactions);
+
+        std::vector<Receipt> receipts = computeReceipts(pending.transactions);
+        Bytes32 receiptsRoot = computeReceiptsRoot(receipts);
 
         ZkProof proof = ZkProver::generate(before, after, txRoot);
 
         Block block(
-            chain_.size(),
-            chain_.back().hash,
+            pending.height + 1,
+            pending.parentHash,
             before,
             after,
             txRoot,
             proof);
 
-        block.transactions = mempool_; // attach txn (may be empty)
+        block.transactions = std::move(pending.transactions); // attach txn (may be empty)
         block.receipts = receipts;
         block.receiptsRoot = receiptsRoot;
+        block.hash = block.computeHash();
+        block.witness = std::move(witness);
 
-        chain_.push_back(block);
-        mempool_.clear();
+        commitLocked(block, result.writes);
 
+        std::uint64_t seq = walSeq_;
+        lock.unlock();
+        syncWal(seq);
         return block;
     }
 
+    ReverseDiff Blockchain::applyWritesLocked(const SnapshotBase::Entries &writes)
+    {
+        ReverseDiff::Entries priors;
+        priors.reserve(writes.size());
+        for (const auto &[addr, acc] : writes)
+        {
+            const Account *prev = state_.get(addr);
+            priors.emplace_back(addr, prev ? std::optional<Account>(*prev) : std::nullopt);
+            state_.set(addr, acc);
+            if (trie_)
+            {
+                trie_->put(Bytes(addr.bytes().begin(), addr.bytes().end()), State::encodeAccount(acc));
+            }
+        }
+        if (sharded_)
+        {
+            sharded_->commit(writes);
+        }
+        return ReverseDiff::build(std::move(priors));
+    }
+
+    const MptTrie &Blockchain::trieLocked()
+    {
+        if (!trie_)
+        {
+            trie_ = state_.trie();
+        }
+        // Hashed before any copy is taken, so copies updated off the lock
+        // only read the nodes they share with it
+        trie_->rootHash();
+        return *trie_;
+    }
+
+    Bytes32 Blockchain::rootAfterLocked(const SnapshotBase::Entries &writes)
+    {
+        MptTrie trie = trieLocked();
+        for (const auto &[addr, acc] : writes)
+        {
+            trie.put(Bytes(addr.bytes().begin(), addr.bytes().end()), State::encodeAccount(acc));
+        }
+        return trie.rootHash();
+    }
+
+    void Blockchain::pushJournalLocked(ReverseDiff undo)
+    {
+        journals_.push_back(std::move(undo));
+        while (journals_.size() > maxReorgDepth_)
+        {
+            journals_.pop_front();
+        }
+    }
+
+    void Blockchain::commitLocked(const Block &block, const SnapshotBase::Entries &writes)
+    {
+        if (wal_)
+        {
+            logLocked(WalRecord::Block, encodeBlockRecord(block, writes));
+        }
+        ReverseDiff undo = applyWritesLocked(writes);
+        snapshot_.update(block.stateAfter, writes);
+
+        store_->append(block.rlpEncode());
+        index_.add(block);
+
+        // Drop pending transactions the block included (every sender's
+        // nonce moved, so it is among the writes)
+        for (const auto &[addr, acc] : writes)
+        {
+            mempool_.setNonce(addr, acc.nonce);
+        }
+        preExec_.invalidate(writes);
+        ++pendingVersion_;
+
+        if (archive_)
+        {
+            archive_->recordBlock(block.index, undo, snapshot_.version());
+        }
+        pushJournalLocked(std::move(undo));
+
+        // Side branches forking below the reorg horizon can never win
+        if (block.index > maxReorgDepth_ && forks_.size() > 0)
+        {
+            forks_.prune(block.index - maxReorgDepth_);
+        }
+        if (wal_ && wal_->bytes() > walCheckpointBytes_)
+        {
+            checkpointWalLocked();
+        }
+        publishViewLocked();
+        announceLocked(block, ChainEvent::Kind::BlockCommitted, writes);
+    }
+
     bool Blockchain::addBlock(const Block &block)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
+        std::unique_lock<std::mutex> lock(mutex_);
+        bool added = addBlockLocked(block);
+
+        std::uint64_t seq = walSeq_;
+        lock.unlock();
+        syncWal(seq);
+        return added;
+    }
+
+    bool Blockchain::addBlockLocked(const Block &block)
+    {
+        // Header checks only; the body is not looked at before extendLocked
+        if (block.hash != block.computeHash() || forks_.contains(block.hash) ||
+            index_.blockHeight(block.hash) || !ZkVerifier::verify(block.proof))
+        {
+            return false;
+        }
+
+        BlockView tip = head();
+        if (block.prevHash == tip.hash())
+        {
+            return block.index == tip.index() + 1 && extendLocked(block);
+        }
+
+        // Side branch: the parent must be canonical or already in the fork
+        // tree. Reorgs need local state, so stateless nodes only follow
+        // the head.
+        if (statelessValidation_)
+        {
+            return false;
+        }
+        std::optional<std::uint64_t> parentHeight = index_.blockHeight(block.prevHash);
+        const Block *parent = forks_.find(block.prevHash);
+        std::uint64_t expected = parentHeight ? *parentHeight + 1 : parent ? parent->index + 1 : 0;
+        if (expected == 0 || block.index != expected || block.index + maxReorgDepth_ <= tip.index())
+        {
+            return false;
+        }
+        forks_.add(block);
+
+        if (block.index > tip.index())
+        {
+            return reorgLocked(block.hash);
+        }
+        return true;
+    }
+
+    bool Blockchain::extendLocked(const Block &block)
+    {
+        // Blocks from peers arrive with senders unrecovered (Block::fromHex);
+        // pay for that only once the block is about to run
+        if (!block.sendersRecovered)
+        {
+            Block full = block;
+            try
+            {
+                full.recoverSenders();
+            }
+            catch (const std::exception &)
+            {
+                return false;
+            }
+            return extendLocked(full);
+        }
+        if (computeTxRoot(block.transactions) != block.txRoot)
+        {
+            return false;
+        }
+
+        // Stateless mode: re-execute against the block's witness and
+        // check the claimed post-state root without touching local state
+        if (statelessValidation_)
+        {
+            if (!verifyStateless(block) || !checkReceipts(block))
+            {
+                return false;
+            }
+            store_->append(block.rlpEncode());
+            index_.add(block);
+            journals_.clear();
+            for (const Transaction &tx : block.transactions)
+            {
+                mempool_.setNonce(tx.from, tx.nonce + 1);
+            }
+            ++pendingVersion_;
+            publishViewLocked();
+            // The witness run's writes are not kept; only the block is announced
+            announceLocked(block, ChainEvent::Kind::BlockCommitted, {});
+            return true;
+        }
 
-        // Basic checks
-        if (block.index != chain_.size())
+        // Full validation: re-execute on the head state and recompute the root
+        if (block.stateBefore != head().stateAfter())
+        {
+            return false;
+        }
+        ExecutionResult result = executor_.execute(state_, block.transactions);
+        if (!result.ok)
         {
             return false;
         }
-        if (block.prevHash != chain_.back().hash)
+        if (rootAfterLocked(result.writes) != block.stateAfter || !checkReceipts(block))
         {
             return false;
         }
-        if (!ZkVerifier::verify(block.proof))
+
+        commitLocked(block, result.writes);
+        return true;
+    }
+
+    bool Blockchain::reorgLocked(const Bytes32 &tip)
+    {
+        // Copy the branch out; the tree changes while it is applied
+        std::vector<Block> branch;
+        for (const Block *b : forks_.branch(tip))
+        {
+            branch.push_back(*b);
+        }
+        std::uint64_t ancestor = branch.front().index - 1;
+        std::uint64_t oldHeight = height();
+        if (index_.blockHeight(branch.front().prevHash) != ancestor)
+        {
+            return false;   // fork point was pruned
+        }
+        if (oldHeight - ancestor > journals_.size())
+        {
+            return false;   // journals no longer reach the fork point
+        }
+
+        std::vector<Block> orphaned = rollbackLocked(ancestor);
+        std::size_t applied = 0;
+        for (const Block &b : branch)
+        {
+            forks_.erase(b.hash);
+            if (!extendLocked(b))
+            {
+                forks_.add(b);
+                forks_.eraseSubtree(b.hash);
+                break;
+            }
+            ++applied;
+        }
+
+        if (applied < branch.size() && ancestor + applied <= oldHeight)
         {
+            // The valid part of the branch is not longer than the old
+            // chain: go back to it. Its blocks were valid before, so
+            // re-applying them cannot fail.
+            rollbackLocked(ancestor);
+            for (const Block &b : orphaned)
+            {
+                forks_.erase(b.hash);
+                extendLocked(b);
+            }
             return false;
         }
 
-        // Apply block transactions (not included in block struct yet)
-        // For now, assume stateAfter is authoritative
-        // In a real chain, you'd re-execute txs and compare roots.
+        // Orphaned transactions the new branch did not include go back
+        // into the mempool if they are still valid on the new head
+        for (const Block &b : orphaned)
+        {
+            for (const Transaction &tx : b.transactions)
+            {
+                std::string err;
+                if (!index_.transaction(tx.hash) && validateTransaction(tx, err))
+                {
+                    mempool_.add(tx, nonceLocked(tx.from), err);
+                }
+            }
+        }
+        ++pendingVersion_;
+        publishViewLocked();
+        return applied == branch.size();
+    }
+
+    std::vector<Block> Blockchain::rollbackLocked(std::uint64_t target)
+    {
+        if (wal_)
+        {
+            logLocked(WalRecord::Rewind, rlp::encodeUint(target));
+        }
+        std::vector<Block> removed;
+        while (height() > target)
+        {
+            Block block = head().toBlock();
+
+            SnapshotBase::Entries restored;
+            std::vector<Address> deleted;
+            journals_.back().forEach([&](const Address &addr, const std::optional<Account> &prior)
+                                     {
+                                         if (prior)
+                                         {
+                                             state_.set(addr, *prior);
+                                             restored.emplace_back(addr, *prior);
+                                         }
+                                         else
+                                         {
+                                             state_.erase(addr);
+                                             deleted.push_back(addr);
+                                         }
+                                         // Pending transactions wait behind the reverted ones again
+                                         mempool_.setNonce(addr, prior ? prior->nonce : 0);
+                                     });
+            journals_.pop_back();
+            trie_.reset();
+            snapshot_.update(block.stateBefore, restored, deleted);
+
+            index_.remove(block);
+            store_->truncate(block.index);
+            announceLocked(block, ChainEvent::Kind::BlockReverted, restored, deleted);
+            forks_.add(block);
+            removed.push_back(std::move(block));
+        }
+        if (sharded_)
+        {
+            sharded_->invalidate();
+        }
+        std::reverse(removed.begin(), removed.end());
+
+        if (archive_)
+        {
+            if (target >= archive_->firstHeight())
+            {
+                archive_->rewind(target, snapshot_.version());
+            }
+            else
+            {
+                std::lock_guard<std::mutex> archiveLock(archiveMutex_);
+                archive_.reset();
+                archive_ = std::make_unique<ArchiveStore>(archiveCfg_, target, snapshot_.version());
+            }
+        }
+        preExec_.clear();
+        ++pendingVersion_;
+        publishViewLocked();
+        return removed;
+    }
+
+    bool Blockchain::commitVerified(const Block &block, const SnapshotBase::Entries &writes)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        BlockView tip = head();
+        if (block.index != tip.index() + 1 || block.prevHash != tip.hash() ||
+            block.stateBefore != tip.stateAfter())
+        {
+            return false;
+        }
+        commitLocked(block, writes);
 
-        chain_.push_back(block);
+        std::uint64_t seq = walSeq_;
+        lock.unlock();
+        syncWal(seq);
         return true;
     }
 
+    bool Blockchain::verifyStateless(const Block &block) const
+    {
+        if (block.stateBefore != head().stateAfter() || block.witness.empty())
+        {
+            return false;
+        }
+
+        try
+        {
+            MptTrie trie = block.witness.toTrie(block.stateBefore);
+
+            // Resolve every account the block touches up front; a path the
+            // witness does not cover throws here rather than on a worker
+            std::unordered_map<Address, std::optional<Account>, AddressHash> pre;
+            for (const auto &tx : block.transactions)
+            {
+                for (const Address &a : {tx.from, tx.to})
+                {
+                    if (pre.count(a))
+                    {
+                        continue;
+                    }
+                    auto raw = trie.get(Bytes(a.bytes().begin(), a.bytes().end()));
+                    pre[a] = raw ? std::optional<Account>(State::decodeAccount(*raw)) : std::nullopt;
+                }
+            }
+
+            ExecutionResult result = executor_.execute(
+                [&pre](const Address &a) { return pre.at(a); },
+                block.transactions);
+            if (!result.ok)
+            {
+                return false;
+            }
+
+            for (const auto &[addr, acc] : result.writes)
+            {
+                trie.put(Bytes(addr.bytes().begin(), addr.bytes().end()), State::encodeAccount(acc));
+            }
+            return trie.rootHash() == block.stateAfter;
+        }
+        catch (const std::exception &)
+        {
+            return false;
+        }
+    }
+
 } // namespace gambit
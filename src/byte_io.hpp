@@ -0,0 +1,73 @@
+#pragma once
+// Internal: fixed-width little-endian fields and file syncing shared by
+// the on-disk formats (WAL, LSM tables, block store, freezer, snapshots)
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+#include "gambit/rlp.hpp"
+#include "gambit/uint256.hpp"
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+namespace gambit {
+
+inline void putU32(std::uint8_t* p, std::uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<std::uint8_t>(v >> (8 * i));
+}
+
+inline void putU64(std::uint8_t* p, std::uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = static_cast<std::uint8_t>(v >> (8 * i));
+}
+
+inline void putU32(Bytes& out, std::uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<std::uint8_t>(v >> (8 * i)));
+}
+
+inline void putU64(Bytes& out, std::uint64_t v) {
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<std::uint8_t>(v >> (8 * i)));
+}
+
+inline std::uint32_t getU32(const std::uint8_t* p) {
+    std::uint32_t v = 0;
+    for (int i = 3; i >= 0; --i) v = (v << 8) | p[i];
+    return v;
+}
+
+inline std::uint64_t getU64(const std::uint8_t* p) {
+    std::uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+    return v;
+}
+
+// Least significant word first
+inline void putU256(std::uint8_t* p, const uint256& v) {
+    for (int w = 0; w < 4; ++w) putU64(p + 8 * w, v.word(w));
+}
+
+inline uint256 getU256(const std::uint8_t* p) {
+    return uint256::fromWords(getU64(p + 24), getU64(p + 16), getU64(p + 8), getU64(p));
+}
+
+// Flushes stdio buffers and forces the file to disk; `owner` prefixes
+// the error message
+inline void syncFile(std::FILE* f, const char* owner) {
+    if (std::fflush(f) != 0) {
+        throw std::runtime_error(std::string(owner) + ": write failed");
+    }
+#ifdef _WIN32
+    int rc = _commit(_fileno(f));
+#else
+    int rc = ::fsync(fileno(f));
+#endif
+    if (rc != 0) {
+        throw std::runtime_error(std::string(owner) + ": fsync failed");
+    }
+}
+
+} // namespace gambit
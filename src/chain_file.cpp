@@ -0,0 +1,67 @@
+#include "gambit/chain_file.hpp"
+#include <stdexcept>
+
+namespace gambit {
+
+namespace {
+
+// Larger than any block we produce; guards against reading a damaged
+// length as a multi-gigabyte allocation
+constexpr std::uint32_t kMaxRecord = std::uint32_t(1) << 28;
+
+} // namespace
+
+std::uint64_t exportChain(const Blockchain& chain, std::ostream& out, std::uint64_t from, std::uint64_t to) {
+    std::uint64_t written = 0;
+    for (std::uint64_t n = from; n <= to; ++n) {
+        BlockView v = chain.blockView(n);
+        std::uint32_t len = static_cast<std::uint32_t>(v.size());
+        char prefix[4];
+        for (int i = 0; i < 4; ++i) prefix[i] = static_cast<char>(len >> (8 * i));
+        out.write(prefix, sizeof(prefix));
+        out.write(reinterpret_cast<const char*>(v.data()), static_cast<std::streamsize>(v.size()));
+        if (!out) {
+            throw std::runtime_error("exportChain: write failed at block " + std::to_string(n));
+        }
+        ++written;
+    }
+    return written;
+}
+
+std::optional<Bytes> ChainFileReader::next() {
+    std::uint8_t prefix[4];
+    in_.read(reinterpret_cast<char*>(prefix), sizeof(prefix));
+    if (in_.gcount() == 0) return std::nullopt;
+    if (in_.gcount() != sizeof(prefix)) {
+        throw std::runtime_error("ChainFileReader: truncated record header");
+    }
+    std::uint32_t len = 0;
+    for (int i = 3; i >= 0; --i) len = (len << 8) | prefix[i];
+    if (len > kMaxRecord) {
+        throw std::runtime_error("ChainFileReader: record too large");
+    }
+
+    Bytes block(len);
+    in_.read(reinterpret_cast<char*>(block.data()), len);
+    if (static_cast<std::uint32_t>(in_.gcount()) != len) {
+        throw std::runtime_error("ChainFileReader: truncated block");
+    }
+    bytes_ += sizeof(prefix) + len;
+    return block;
+}
+
+std::uint64_t importChain(const Blockchain& chain, ChainFileReader& in, BlockImporter& importer,
+                          const std::function<void(std::uint64_t submitted)>& onSubmit)
+{
+    std::uint64_t have = chain.height();
+    std::uint64_t submitted = 0;
+    while (auto block = in.next()) {
+        if (BlockView(nullptr, block->data(), block->size()).index() <= have) continue;
+        if (!importer.submit(std::move(*block))) break;
+        ++submitted;
+        if (onSubmit) onSubmit(submitted);
+    }
+    return submitted;
+}
+
+} // namespace gambit
@@ -0,0 +1,90 @@
+#include "gambit/chain_index.hpp"
+#include <mutex>
+
+namespace gambit {
+
+namespace {
+
+// Unsigned transactions carry no hash and are not indexed
+bool hasHash(const Transaction& tx) {
+    return tx.hash != Bytes32{};
+}
+
+} // namespace
+
+void ChainIndex::add(const Block& block) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    blocks_[block.hash] = block.index;
+    for (std::size_t i = 0; i < block.transactions.size(); ++i) {
+        const Transaction& tx = block.transactions[i];
+        if (hasHash(tx)) {
+            txs_[tx.hash] = TxLocation{block.index, static_cast<std::uint32_t>(i)};
+        }
+    }
+    lock.unlock();
+    addresses_.add(block);
+}
+
+void ChainIndex::remove(const Block& block) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto b = blocks_.find(block.hash);
+    if (b != blocks_.end() && b->second == block.index) {
+        blocks_.erase(b);
+    }
+    for (const auto& tx : block.transactions) {
+        auto t = hasHash(tx) ? txs_.find(tx.hash) : txs_.end();
+        if (t != txs_.end() && t->second.height == block.index) {
+            txs_.erase(t);
+        }
+    }
+    lock.unlock();
+    addresses_.remove(block);
+}
+
+void ChainIndex::remove(std::uint64_t height, const Bytes32& hash, const std::vector<Bytes32>& txHashes) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto b = blocks_.find(hash);
+    if (b != blocks_.end() && b->second == height) {
+        blocks_.erase(b);
+    }
+    for (const Bytes32& h : txHashes) {
+        auto t = txs_.find(h);
+        if (t != txs_.end() && t->second.height == height) {
+            txs_.erase(t);
+        }
+    }
+}
+
+void ChainIndex::clear() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    blocks_.clear();
+    txs_.clear();
+    lock.unlock();
+    addresses_.clear();
+}
+
+std::optional<std::uint64_t> ChainIndex::blockHeight(const Bytes32& hash) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = blocks_.find(hash);
+    if (it == blocks_.end()) return std::nullopt;
+    return it->second;
+}
+
+std::optional<ChainIndex::TxLocation> ChainIndex::transaction(const Bytes32& hash) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = txs_.find(hash);
+    if (it == txs_.end()) return std::nullopt;
+    return it->second;
+}
+
+std::size_t ChainIndex::blocks() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return blocks_.size();
+}
+
+std::size_t ChainIndex::transactions() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return txs_.size();
+}
+
+} // namespace gambit
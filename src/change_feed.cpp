@@ -0,0 +1,124 @@
+#include "gambit/change_feed.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace gambit {
+
+ChangeFeed::ChangeFeed(std::size_t capacity) {
+    std::size_t size = 1;
+    while (size < capacity) size <<= 1;
+    slots_ = std::vector<Slot>(size);
+    mask_ = size - 1;
+}
+
+std::unique_ptr<ChangeFeed::Subscription> ChangeFeed::subscribe(Backpressure policy) {
+    for (Reader& r : readers_) {
+        std::uint32_t expected = kFree;
+        if (!r.state.compare_exchange_strong(expected, kClaimed, std::memory_order_acq_rel)) continue;
+        r.cursor.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+        r.state.store(policy == Backpressure::Block ? kBlocking : kDropping, std::memory_order_release);
+        return std::unique_ptr<Subscription>(new Subscription(*this, r));
+    }
+    throw std::runtime_error("ChangeFeed: too many subscribers");
+}
+
+void ChangeFeed::waitForBlockingReaders(std::uint64_t n) const {
+    // Event n takes the slot of event n - capacity
+    for (const Reader& r : readers_) {
+        for (unsigned spins = 0; r.state.load(std::memory_order_acquire) == kBlocking &&
+                                 r.cursor.load(std::memory_order_acquire) + slots_.size() <= n;
+             ++spins) {
+            if (spins < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+    }
+}
+
+void ChangeFeed::publish(const ChainEvent& event) {
+    std::uint64_t n = head_.load(std::memory_order_relaxed);
+    if (n >= slots_.size()) {
+        waitForBlockingReaders(n);
+    }
+
+    std::uint64_t raw[kWords] = {};
+    std::memcpy(raw, &event, sizeof(event));
+
+    Slot& slot = slots_[n & mask_];
+    slot.seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (std::size_t i = 0; i < kWords; ++i) {
+        slot.words[i].store(raw[i], std::memory_order_relaxed);
+    }
+    slot.seq.store(2 * n + 2, std::memory_order_release);
+    head_.store(n + 1, std::memory_order_release);
+}
+
+ChangeFeed::Subscription::~Subscription() {
+    reader_.state.store(kFree, std::memory_order_release);
+}
+
+std::optional<ChainEvent> ChangeFeed::Subscription::poll() {
+    std::uint64_t c = reader_.cursor.load(std::memory_order_relaxed);
+    for (;;) {
+        std::uint64_t head = feed_.head_.load(std::memory_order_acquire);
+        if (c >= head) {
+            return std::nullopt;
+        }
+
+        const Slot& slot = feed_.slots_[c & feed_.mask_];
+        std::uint64_t seq = slot.seq.load(std::memory_order_acquire);
+        if (seq == 2 * c + 2) {
+            std::uint64_t raw[kWords];
+            for (std::size_t i = 0; i < kWords; ++i) {
+                raw[i] = slot.words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) == seq) {
+                ChainEvent event;
+                std::memcpy(&event, raw, sizeof(event));
+                // Releases the slot to a producer waiting on this reader
+                reader_.cursor.store(c + 1, std::memory_order_release);
+                return event;
+            }
+        }
+
+        // The producer ran past us: skip to the oldest event it cannot be
+        // writing over right now
+        head = feed_.head_.load(std::memory_order_acquire);
+        std::uint64_t oldest = head - std::min<std::uint64_t>(head, feed_.slots_.size() - 1);
+        if (oldest <= c) oldest = c + 1;
+        missed_ += oldest - c;
+        c = oldest;
+        reader_.cursor.store(c, std::memory_order_release);
+    }
+}
+
+std::optional<ChainEvent> ChangeFeed::Subscription::next(std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (unsigned spins = 0;; ++spins) {
+        if (auto event = poll()) {
+            return event;
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return std::nullopt;
+        }
+        if (spins < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+}
+
+std::uint64_t ChangeFeed::Subscription::backlog() const {
+    std::uint64_t head = feed_.head_.load(std::memory_order_acquire);
+    std::uint64_t c = reader_.cursor.load(std::memory_order_relaxed);
+    return head > c ? head - c : 0;
+}
+
+} // namespace gambit
@@ -0,0 +1,50 @@
+#include "gambit/fork_tree.hpp"
+#include <algorithm>
+
+namespace gambit {
+
+bool ForkTree::add(const Block& block) {
+    return blocks_.emplace(block.hash, block).second;
+}
+
+const Block* ForkTree::find(const Bytes32& hash) const {
+    auto it = blocks_.find(hash);
+    return it == blocks_.end() ? nullptr : &it->second;
+}
+
+void ForkTree::erase(const Bytes32& hash) {
+    blocks_.erase(hash);
+}
+
+void ForkTree::eraseSubtree(const Bytes32& hash) {
+    std::vector<Bytes32> pending{hash};
+    while (!pending.empty()) {
+        Bytes32 h = pending.back();
+        pending.pop_back();
+        blocks_.erase(h);
+        for (const auto& [childHash, child] : blocks_) {
+            if (child.prevHash == h) pending.push_back(childHash);
+        }
+    }
+}
+
+void ForkTree::prune(std::uint64_t height) {
+    for (auto it = blocks_.begin(); it != blocks_.end();) {
+        if (it->second.index <= height) {
+            it = blocks_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+std::vector<const Block*> ForkTree::branch(const Bytes32& tip) const {
+    std::vector<const Block*> out;
+    for (const Block* b = find(tip); b; b = find(b->prevHash)) {
+        out.push_back(b);
+    }
+    std::reverse(out.begin(), out.end());
+    return out;
+}
+
+} // namespace gambit
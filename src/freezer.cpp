@@ -0,0 +1,205 @@
+#include "gambit/freezer.hpp"
+#include "byte_io.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+
+#include "gambit/block.hpp"
+
+namespace gambit {
+
+namespace {
+
+constexpr std::uint32_t kMagic = 0x5a524647;    // "GFRZ"
+constexpr std::uint32_t kVersion = 2;
+constexpr std::size_t kHeader = 28;
+constexpr std::size_t kFrameEntry = 16;
+constexpr std::size_t kBlockEntry = 24;
+constexpr std::size_t kFooter = 20;
+
+// Training input: every transaction encoding in the blocks, or the
+// blocks themselves if they carry none
+std::vector<Bytes> trainingSamples(const std::vector<std::pair<const std::uint8_t*, std::size_t>>& blocks) {
+    std::vector<Bytes> samples;
+    for (const auto& [data, size] : blocks) {
+        Block::PartRefs parts;
+        Block::splitParts(data, size, parts);
+        const rlp::ItemRef& list = parts[Block::kTransactions];
+        for (std::size_t off = 0; off < list.length;) {
+            rlp::ItemRef tx = rlp::peek(list.payload + off, list.length - off);
+            samples.emplace_back(tx.begin, tx.begin + tx.size);
+            off += tx.size;
+        }
+    }
+    if (samples.empty()) {
+        for (const auto& [data, size] : blocks) samples.emplace_back(data, data + size);
+    }
+    return samples;
+}
+
+} // namespace
+
+void FrozenSegment::write(const std::string& path, std::uint64_t first, std::uint64_t segmentBytes,
+                          const std::vector<std::pair<const std::uint8_t*, std::size_t>>& blocks,
+                          const FreezerOptions& opts)
+{
+    // The dictionary is stored in the file, so keep it small next to the data
+    std::size_t rawBytes = 0;
+    for (const auto& block : blocks) rawBytes += block.second;
+    lz::Dictionary dict(lz::train(trainingSamples(blocks), std::min(opts.dictBytes, rawBytes / 16)));
+
+    Bytes out;
+    putU32(out, kMagic);
+    putU32(out, kVersion);
+    putU64(out, first);
+    putU64(out, segmentBytes);
+    putU32(out, static_cast<std::uint32_t>(dict.size()));
+    out.insert(out.end(), dict.bytes().begin(), dict.bytes().end());
+
+    // Group consecutive records into frames of about frameBytes; returns
+    // each record's [frame, offset, length]
+    std::vector<Frame> frames;
+    auto pack = [&](const std::vector<std::pair<const std::uint8_t*, std::size_t>>& records) {
+        std::vector<std::array<std::uint32_t, 3>> placed;
+        Bytes raw;
+        auto flush = [&]() {
+            if (raw.empty()) return;
+            Bytes packed = lz::compress(raw.data(), raw.size(), dict);
+            frames.push_back(Frame{out.size(), static_cast<std::uint32_t>(packed.size()),
+                                   static_cast<std::uint32_t>(raw.size())});
+            out.insert(out.end(), packed.begin(), packed.end());
+            raw.clear();
+        };
+        for (const auto& [data, size] : records) {
+            if (!raw.empty() && raw.size() + size > opts.frameBytes) flush();
+            placed.push_back({static_cast<std::uint32_t>(frames.size()), static_cast<std::uint32_t>(raw.size()),
+                              static_cast<std::uint32_t>(size)});
+            raw.insert(raw.end(), data, data + size);
+        }
+        flush();
+        return placed;
+    };
+
+    // Headers are also packed on their own, so header reads decode a
+    // small header frame instead of the frame holding the bodies
+    std::vector<std::pair<const std::uint8_t*, std::size_t>> headers;
+    for (const auto& [data, size] : blocks) {
+        Block::PartRefs parts;
+        Block::splitParts(data, size, parts);
+        headers.emplace_back(parts[Block::kHeader].begin, parts[Block::kHeader].size);
+    }
+    auto bodies = pack(blocks);
+    auto heads = pack(headers);
+
+    std::uint64_t indexAt = out.size();
+    for (const Frame& f : frames) {
+        putU64(out, f.offset);
+        putU32(out, f.length);
+        putU32(out, f.rawLength);
+    }
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+        for (std::uint32_t v : bodies[i]) putU32(out, v);
+        for (std::uint32_t v : heads[i]) putU32(out, v);
+    }
+    putU64(out, indexAt);
+    putU32(out, static_cast<std::uint32_t>(frames.size()));
+    putU32(out, static_cast<std::uint32_t>(blocks.size()));
+    putU32(out, kMagic);
+
+    std::string tmp = path + ".tmp";
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) throw std::runtime_error("FrozenSegment: cannot create " + tmp);
+    try {
+        if (std::fwrite(out.data(), 1, out.size(), f) != out.size()) {
+            throw std::runtime_error("FrozenSegment: write failed for " + path);
+        }
+        syncFile(f, "FrozenSegment");
+    } catch (...) {
+        std::fclose(f);
+        std::filesystem::remove(tmp);
+        throw;
+    }
+    std::fclose(f);
+    std::filesystem::rename(tmp, path);
+}
+
+FrozenSegment::FrozenSegment(const std::string& path)
+    : file_(MappedFile::open(path))
+{
+    const std::uint8_t* p = file_.data();
+    std::size_t size = file_.size();
+    auto bad = [&]() { return std::runtime_error("FrozenSegment: malformed " + path); };
+
+    if (size < kHeader + kFooter || getU32(p) != kMagic || getU32(p + size - 4) != kMagic) throw bad();
+    if (getU32(p + 4) != kVersion) throw bad();
+    first_ = getU64(p + 8);
+    segmentBytes_ = getU64(p + 16);
+    std::uint32_t dictLen = getU32(p + 24);
+
+    const std::uint8_t* footer = p + size - kFooter;
+    std::uint64_t indexAt = getU64(footer);
+    std::uint32_t frameCount = getU32(footer + 8);
+    std::uint32_t blockCount = getU32(footer + 12);
+    if (kHeader + dictLen > indexAt || indexAt > size - kFooter ||
+        (size - kFooter - indexAt) != std::uint64_t(frameCount) * kFrameEntry + std::uint64_t(blockCount) * kBlockEntry)
+    {
+        throw bad();
+    }
+    dict_ = lz::Dictionary(Bytes(p + kHeader, p + kHeader + dictLen));
+
+    const std::uint8_t* q = p + indexAt;
+    for (std::uint32_t i = 0; i < frameCount; ++i, q += kFrameEntry) {
+        Frame f{getU64(q), getU32(q + 8), getU32(q + 12)};
+        if (f.offset < kHeader + dictLen || f.offset > indexAt || f.length > indexAt - f.offset) throw bad();
+        frames_.push_back(f);
+    }
+    for (std::uint32_t i = 0; i < blockCount; ++i, q += kBlockEntry) {
+        Entry e{getU32(q), getU32(q + 4), getU32(q + 8), getU32(q + 12), getU32(q + 16), getU32(q + 20)};
+        auto inFrame = [&](std::uint32_t frame, std::uint32_t offset, std::uint32_t length) {
+            return frame < frameCount && offset <= frames_[frame].rawLength &&
+                   length <= frames_[frame].rawLength - offset;
+        };
+        if (!inFrame(e.frame, e.offset, e.length) || !inFrame(e.headerFrame, e.headerOffset, e.headerLength)) {
+            throw bad();
+        }
+        blocks_.push_back(e);
+    }
+}
+
+BlockHeader FrozenSegment::header(std::uint64_t n) const {
+    if (!contains(n)) {
+        throw std::out_of_range("FrozenSegment: block not found");
+    }
+    const Entry& e = blocks_[n - first_];
+    std::shared_ptr<const Bytes> frame = decode(e.headerFrame, headerCache_);
+    return BlockHeader::rlpDecode(frame->data() + e.headerOffset, e.headerLength);
+}
+
+FrozenSegment::Slice FrozenSegment::read(std::uint64_t n) const {
+    if (!contains(n)) {
+        throw std::out_of_range("FrozenSegment: block not found");
+    }
+    const Entry& e = blocks_[n - first_];
+    return Slice{decode(e.frame, blockCache_), e.offset, e.length};
+}
+
+std::shared_ptr<const Bytes> FrozenSegment::decode(std::size_t i, FrameCache& cache) const {
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        if (cache.bytes && cache.frame == i) return cache.bytes;
+    }
+
+    // Decode outside the lock so readers of other frames are not held up
+    const Frame& f = frames_[i];
+    auto frame = std::make_shared<const Bytes>(lz::decompress(file_.data() + f.offset, f.length, f.rawLength, dict_));
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        cache.bytes = frame;
+        cache.frame = i;
+    }
+    return frame;
+}
+
+} // namespace gambit
@@ -50,6 +50,16 @@ Bytes fromHex(const std::string& hex) {
     return out;
 }
 
+Bytes32 fromHex32(const std::string& hex) {
+    Bytes raw = fromHex(hex);
+    if (raw.size() != 32) {
+        throw std::runtime_error("Expected 32 bytes of hex");
+    }
+    Bytes32 out;
+    std::copy(raw.begin(), raw.end(), out.begin());
+    return out;
+}
+
 Bytes keccak256(const Bytes& input) {
     Bytes out(32);
     tinykeccak::keccak_256(input.data(), input.size(), out.data());
@@ -72,4 +82,10 @@ Bytes32 keccak256_32(const std::string& input) {
     return keccak256_32(in);
 }
 
+Bytes32 keccak256_32(const std::uint8_t* data, std::size_t size) {
+    Bytes32 out{};
+    tinykeccak::keccak_256(data, size, out.data());
+    return out;
+}
+
 } // namespace gambit
@@ -0,0 +1,103 @@
+#include "gambit/kv_store.hpp"
+#include <algorithm>
+#include <mutex>
+
+namespace gambit {
+
+namespace {
+
+bool hasPrefix(const Bytes& key, const Bytes& prefix) {
+    return key.size() >= prefix.size() && std::equal(prefix.begin(), prefix.end(), key.begin());
+}
+
+using Map = std::map<Bytes, Bytes>;
+
+class MapIterator : public KvIterator {
+public:
+    MapIterator(std::shared_ptr<const Map> map, Bytes prefix)
+        : map_(std::move(map)), prefix_(std::move(prefix)), it_(map_->lower_bound(prefix_)) {}
+
+    bool valid() const override { return it_ != map_->end() && hasPrefix(it_->first, prefix_); }
+    const Bytes& key() const override { return it_->first; }
+    const Bytes& value() const override { return it_->second; }
+    void next() override { ++it_; }
+
+private:
+    std::shared_ptr<const Map> map_;
+    Bytes prefix_;
+    Map::const_iterator it_;
+};
+
+class MapSnapshot : public KvSnapshot {
+public:
+    explicit MapSnapshot(std::shared_ptr<const Map> map) : map_(std::move(map)) {}
+
+    std::optional<Bytes> get(const Bytes& key) const override {
+        auto it = map_->find(key);
+        if (it == map_->end()) return std::nullopt;
+        return it->second;
+    }
+
+    std::unique_ptr<KvIterator> iterate(const Bytes& prefix) const override {
+        return std::make_unique<MapIterator>(map_, prefix);
+    }
+
+private:
+    std::shared_ptr<const Map> map_;
+};
+
+} // namespace
+
+// ---------- KvStore ----------
+
+void KvStore::put(Bytes key, Bytes value) {
+    WriteBatch batch;
+    batch.put(std::move(key), std::move(value));
+    write(batch);
+}
+
+void KvStore::del(Bytes key) {
+    WriteBatch batch;
+    batch.del(std::move(key));
+    write(batch);
+}
+
+std::unique_ptr<KvIterator> KvStore::iterate(const Bytes& prefix) const {
+    return snapshot()->iterate(prefix);
+}
+
+// ---------- MemoryKvStore ----------
+
+std::optional<Bytes> MemoryKvStore::get(const Bytes& key) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = data_->find(key);
+    if (it == data_->end()) return std::nullopt;
+    return it->second;
+}
+
+void MemoryKvStore::write(const WriteBatch& batch) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    // A snapshot still shares the map: copy before changing it
+    if (data_.use_count() > 1) {
+        data_ = std::make_shared<Map>(*data_);
+    }
+    for (const auto& op : batch.ops()) {
+        if (op.value) {
+            (*data_)[op.key] = *op.value;
+        } else {
+            data_->erase(op.key);
+        }
+    }
+}
+
+std::shared_ptr<const KvSnapshot> MemoryKvStore::snapshot() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return std::make_shared<MapSnapshot>(data_);
+}
+
+std::size_t MemoryKvStore::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return data_->size();
+}
+
+} // namespace gambit
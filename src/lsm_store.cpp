@@ -0,0 +1,723 @@
+#include "gambit/lsm_store.hpp"
+#include "byte_io.hpp"
+#include "gambit/mapped_file.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <stdexcept>
+
+namespace gambit {
+
+namespace {
+
+// Table file layout (little-endian):
+//   entries: [u32 keyLen][u32 valueLen | kTombstone][key][value], sorted
+//   index:   [u32 count] + count x [u32 keyLen][key][u64 entry offset]
+//   bloom:   [u32 probes][u32 bytes][bits]
+//   footer:  [u64 index offset][u64 bloom offset][u32 entries][u32 magic]
+constexpr std::uint32_t kTombstone = 0xFFFFFFFFu;
+constexpr std::uint32_t kMagic = 0x4D534C47;    // "GLSM"
+constexpr std::size_t kFooter = 24;
+constexpr std::size_t kIndexInterval = 16;      // entries per sparse index key
+
+// Type byte of the records in kv.log, each an encodeBatch() payload
+constexpr std::uint8_t kBatchRecord = 1;
+
+bool hasPrefix(const std::uint8_t* key, std::size_t n, const Bytes& prefix) {
+    return n >= prefix.size() && std::equal(prefix.begin(), prefix.end(), key);
+}
+
+int compareKeys(const std::uint8_t* a, std::size_t an, const std::uint8_t* b, std::size_t bn) {
+    int c = std::memcmp(a, b, std::min(an, bn));
+    if (c != 0) return c;
+    return an < bn ? -1 : an > bn ? 1 : 0;
+}
+
+// 64-bit FNV-1a with a final mix; the two halves drive the bloom probes
+std::uint64_t keyHash(const std::uint8_t* p, std::size_t n) {
+    std::uint64_t h = 0xcbf29ce484222325ull;
+    for (std::size_t i = 0; i < n; ++i) {
+        h ^= p[i];
+        h *= 0x100000001b3ull;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return h;
+}
+
+// WAL payload: [u32 ops] + ops x [u8 put][u32 keyLen][key]([u32 valueLen][value] if put)
+Bytes encodeBatch(const WriteBatch& batch) {
+    Bytes out(4);
+    putU32(out.data(), static_cast<std::uint32_t>(batch.size()));
+    for (const auto& op : batch.ops()) {
+        std::uint8_t len[4];
+        out.push_back(op.value ? 1 : 0);
+        putU32(len, static_cast<std::uint32_t>(op.key.size()));
+        out.insert(out.end(), len, len + 4);
+        out.insert(out.end(), op.key.begin(), op.key.end());
+        if (op.value) {
+            putU32(len, static_cast<std::uint32_t>(op.value->size()));
+            out.insert(out.end(), len, len + 4);
+            out.insert(out.end(), op.value->begin(), op.value->end());
+        }
+    }
+    return out;
+}
+
+WriteBatch decodeBatch(const Bytes& in) {
+    auto need = [&](std::size_t pos, std::size_t n) {
+        if (in.size() < pos || in.size() - pos < n) throw std::runtime_error("LsmKvStore: malformed log record");
+    };
+    WriteBatch batch;
+    need(0, 4);
+    std::uint32_t count = getU32(in.data());
+    std::size_t pos = 4;
+    for (std::uint32_t i = 0; i < count; ++i) {
+        need(pos, 5);
+        bool put = in[pos] != 0;
+        std::uint32_t klen = getU32(&in[pos + 1]);
+        pos += 5;
+        need(pos, klen);
+        Bytes key(in.begin() + pos, in.begin() + pos + klen);
+        pos += klen;
+        if (!put) {
+            batch.del(std::move(key));
+            continue;
+        }
+        need(pos, 4);
+        std::uint32_t vlen = getU32(&in[pos]);
+        pos += 4;
+        need(pos, vlen);
+        batch.put(std::move(key), Bytes(in.begin() + pos, in.begin() + pos + vlen));
+        pos += vlen;
+    }
+    return batch;
+}
+
+// Streams sorted entries into a table file
+class TableBuilder {
+public:
+    TableBuilder(const std::string& path, std::size_t bitsPerKey)
+        : path_(path), bitsPerKey_(std::max<std::size_t>(bitsPerKey, 1))
+    {
+        file_ = std::fopen(path.c_str(), "wb");
+        if (!file_) throw std::runtime_error("LsmKvStore: cannot create " + path);
+    }
+
+    ~TableBuilder() {
+        if (file_) std::fclose(file_);
+    }
+
+    void add(const std::uint8_t* key, std::size_t klen, const std::uint8_t* value, std::size_t vlen, bool tombstone) {
+        if (entries_ % kIndexInterval == 0) {
+            index_.emplace_back(Bytes(key, key + klen), offset_);
+        }
+        hashes_.push_back(keyHash(key, klen));
+
+        std::uint8_t header[8];
+        putU32(header, static_cast<std::uint32_t>(klen));
+        putU32(header + 4, tombstone ? kTombstone : static_cast<std::uint32_t>(vlen));
+        put(header, 8);
+        put(key, klen);
+        if (!tombstone) put(value, vlen);
+        ++entries_;
+    }
+
+    std::uint32_t entries() const { return entries_; }
+
+    void finish() {
+        std::uint64_t indexOffset = offset_;
+        std::uint8_t buf[8];
+        putU32(buf, static_cast<std::uint32_t>(index_.size()));
+        put(buf, 4);
+        for (const auto& [key, off] : index_) {
+            putU32(buf, static_cast<std::uint32_t>(key.size()));
+            put(buf, 4);
+            put(key.data(), key.size());
+            putU64(buf, off);
+            put(buf, 8);
+        }
+
+        // k = ln2 * bits/key probes minimises false positives
+        std::uint64_t bloomOffset = offset_;
+        std::size_t bits = std::max<std::size_t>(64, hashes_.size() * bitsPerKey_);
+        Bytes bloom((bits + 7) / 8, 0);
+        bits = bloom.size() * 8;
+        std::uint32_t probes = static_cast<std::uint32_t>(std::clamp<std::size_t>(bitsPerKey_ * 69 / 100, 1, 30));
+        for (std::uint64_t h : hashes_) {
+            std::uint64_t delta = (h >> 33) | (h << 31);
+            for (std::uint32_t i = 0; i < probes; ++i, h += delta) {
+                bloom[(h % bits) / 8] |= static_cast<std::uint8_t>(1u << ((h % bits) % 8));
+            }
+        }
+        putU32(buf, probes);
+        put(buf, 4);
+        putU32(buf, static_cast<std::uint32_t>(bloom.size()));
+        put(buf, 4);
+        put(bloom.data(), bloom.size());
+
+        std::uint8_t footer[kFooter];
+        putU64(footer, indexOffset);
+        putU64(footer + 8, bloomOffset);
+        putU32(footer + 16, entries_);
+        putU32(footer + 20, kMagic);
+        put(footer, kFooter);
+
+        syncFile(file_, "LsmKvStore");
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+
+private:
+    std::string path_;
+    std::size_t bitsPerKey_;
+    std::FILE* file_{nullptr};
+    std::uint64_t offset_{0};
+    std::uint32_t entries_{0};
+    std::vector<std::pair<Bytes, std::uint64_t>> index_;
+    std::vector<std::uint64_t> hashes_;
+
+    void put(const std::uint8_t* p, std::size_t n) {
+        if (n && std::fwrite(p, 1, n, file_) != n) {
+            throw std::runtime_error("LsmKvStore: write failed on " + path_);
+        }
+        offset_ += n;
+    }
+};
+
+} // namespace
+
+// ---------- Memtable / Table ----------
+
+struct LsmKvStore::Memtable {
+    std::map<Bytes, std::optional<Bytes>> entries;   // nullopt = deleted
+    std::size_t bytes{0};
+};
+
+struct LsmKvStore::Table {
+    struct Entry {
+        const std::uint8_t* key;
+        std::uint32_t klen;
+        const std::uint8_t* value;
+        std::uint32_t vlen;
+        bool tombstone;
+        std::uint64_t next;     // offset of the following entry
+    };
+
+    std::uint64_t id{0};
+    std::string path;
+    MappedFile file;
+    std::uint64_t dataEnd{0};
+    std::uint32_t entries{0};
+    std::vector<std::pair<Bytes, std::uint64_t>> index;
+    const std::uint8_t* bloom{nullptr};
+    std::size_t bloomBits{0};
+    std::uint32_t probes{0};
+    std::atomic<bool> obsolete{false};
+
+    Table(std::uint64_t tableId, const std::string& tablePath) : id(tableId), path(tablePath) {
+        file = MappedFile::open(path);
+        const std::uint8_t* d = file.data();
+        std::size_t n = file.size();
+        if (n < kFooter || getU32(d + n - 4) != kMagic) {
+            throw std::runtime_error("LsmKvStore: bad table " + path);
+        }
+        std::uint64_t indexOffset = getU64(d + n - kFooter);
+        std::uint64_t bloomOffset = getU64(d + n - kFooter + 8);
+        entries = getU32(d + n - kFooter + 16);
+        dataEnd = indexOffset;
+        if (indexOffset > bloomOffset || bloomOffset + 8 > n - kFooter) {
+            throw std::runtime_error("LsmKvStore: bad table " + path);
+        }
+
+        std::size_t pos = indexOffset;
+        std::uint32_t count = getU32(d + pos);
+        pos += 4;
+        index.reserve(count);
+        for (std::uint32_t i = 0; i < count; ++i) {
+            std::uint32_t klen = getU32(d + pos);
+            index.emplace_back(Bytes(d + pos + 4, d + pos + 4 + klen), getU64(d + pos + 4 + klen));
+            pos += 12 + klen;
+        }
+
+        probes = getU32(d + bloomOffset);
+        bloomBits = std::size_t(getU32(d + bloomOffset + 4)) * 8;
+        bloom = d + bloomOffset + 8;
+    }
+
+    ~Table() {
+        if (obsolete) {
+            file = MappedFile();
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+        }
+    }
+
+    bool mayContain(const Bytes& key) const {
+        std::uint64_t h = keyHash(key.data(), key.size());
+        std::uint64_t delta = (h >> 33) | (h << 31);
+        for (std::uint32_t i = 0; i < probes; ++i, h += delta) {
+            std::size_t bit = h % bloomBits;
+            if (!(bloom[bit / 8] & (1u << (bit % 8)))) return false;
+        }
+        return true;
+    }
+
+    Entry entryAt(std::uint64_t off) const {
+        const std::uint8_t* p = file.data() + off;
+        Entry e;
+        e.klen = getU32(p);
+        std::uint32_t vlen = getU32(p + 4);
+        e.tombstone = vlen == kTombstone;
+        e.vlen = e.tombstone ? 0 : vlen;
+        e.key = p + 8;
+        e.value = e.key + e.klen;
+        e.next = off + 8 + e.klen + e.vlen;
+        return e;
+    }
+
+    // Offset of the first entry that may be >= key
+    std::uint64_t seek(const Bytes& key) const {
+        auto it = std::upper_bound(index.begin(), index.end(), key,
+                                   [](const Bytes& k, const std::pair<Bytes, std::uint64_t>& e) { return k < e.first; });
+        std::uint64_t off = it == index.begin() ? 0 : std::prev(it)->second;
+        while (off < dataEnd) {
+            Entry e = entryAt(off);
+            if (compareKeys(e.key, e.klen, key.data(), key.size()) >= 0) break;
+            off = e.next;
+        }
+        return off;
+    }
+
+    // Outer nullopt: key not in this table; inner nullopt: deleted here
+    std::optional<std::optional<Bytes>> find(const Bytes& key) const {
+        std::uint64_t off = seek(key);
+        if (off >= dataEnd) return std::nullopt;
+        Entry e = entryAt(off);
+        if (compareKeys(e.key, e.klen, key.data(), key.size()) != 0) return std::nullopt;
+        if (e.tombstone) return std::optional<Bytes>();
+        return std::optional<Bytes>(Bytes(e.value, e.value + e.vlen));
+    }
+};
+
+namespace {
+
+using Memtable = LsmKvStore::Memtable;
+using Table = LsmKvStore::Table;
+
+// Size-tiered choice of the next merge: the newest run of `trigger`
+// adjacent tables (newest-first) in which no table is larger than all
+// the newer ones in the run together. A merged table then only rejoins a
+// merge once as much newer data has piled up in front of it, while a
+// small table left behind an older run is taken along. Tables below
+// `floor` count as `floor`, so small flushes tier together. Returns
+// {first index, count}; count is 0 if none is due.
+std::pair<std::size_t, std::size_t> pickMerge(const std::vector<std::shared_ptr<Table>>& tables,
+                                              std::size_t trigger, std::uint64_t floor)
+{
+    trigger = std::max<std::size_t>(trigger, 2);
+    auto size = [&](std::size_t i) { return std::max<std::uint64_t>(tables[i]->dataEnd, floor); };
+    for (std::size_t first = 0; first + trigger <= tables.size(); ++first) {
+        std::uint64_t sum = size(first);
+        std::size_t n = 1;
+        for (; n < trigger && size(first + n) <= sum; ++n) sum += size(first + n);
+        if (n == trigger) return {first, n};
+    }
+    return {0, 0};
+}
+
+// One sorted input of a merge: a memtable or a table
+class Source {
+public:
+    virtual ~Source() = default;
+    virtual bool valid() const = 0;
+    virtual const std::uint8_t* key() const = 0;
+    virtual std::size_t keySize() const = 0;
+    virtual bool tombstone() const = 0;
+    virtual const std::uint8_t* value() const = 0;
+    virtual std::size_t valueSize() const = 0;
+    virtual void next() = 0;
+};
+
+class MemSource : public Source {
+public:
+    MemSource(std::shared_ptr<const Memtable> mem, const Bytes& from)
+        : mem_(std::move(mem)), it_(mem_->entries.lower_bound(from)) {}
+
+    bool valid() const override { return it_ != mem_->entries.end(); }
+    const std::uint8_t* key() const override { return it_->first.data(); }
+    std::size_t keySize() const override { return it_->first.size(); }
+    bool tombstone() const override { return !it_->second; }
+    const std::uint8_t* value() const override { return it_->second->data(); }
+    std::size_t valueSize() const override { return it_->second->size(); }
+    void next() override { ++it_; }
+
+private:
+    std::shared_ptr<const Memtable> mem_;
+    std::map<Bytes, std::optional<Bytes>>::const_iterator it_;
+};
+
+class TableSource : public Source {
+public:
+    TableSource(std::shared_ptr<const Table> table, const Bytes& from)
+        : table_(std::move(table)), off_(table_->seek(from)) { load(); }
+
+    bool valid() const override { return off_ < table_->dataEnd; }
+    const std::uint8_t* key() const override { return e_.key; }
+    std::size_t keySize() const override { return e_.klen; }
+    bool tombstone() const override { return e_.tombstone; }
+    const std::uint8_t* value() const override { return e_.value; }
+    std::size_t valueSize() const override { return e_.vlen; }
+    void next() override { off_ = e_.next; load(); }
+
+private:
+    std::shared_ptr<const Table> table_;
+    std::uint64_t off_;
+    Table::Entry e_{};
+
+    void load() {
+        if (valid()) e_ = table_->entryAt(off_);
+    }
+};
+
+// Merges newest-first sources; on equal keys the newest wins and the
+// others are skipped
+class Merger {
+public:
+    explicit Merger(std::vector<std::unique_ptr<Source>> sources) : sources_(std::move(sources)) { pick(); }
+
+    bool valid() const { return current_ != nullptr; }
+    Source& current() const { return *current_; }
+
+    void next() {
+        Bytes key(current_->key(), current_->key() + current_->keySize());
+        for (auto& s : sources_) {
+            if (s->valid() && compareKeys(s->key(), s->keySize(), key.data(), key.size()) == 0) s->next();
+        }
+        pick();
+    }
+
+private:
+    std::vector<std::unique_ptr<Source>> sources_;
+    Source* current_{nullptr};
+
+    void pick() {
+        current_ = nullptr;
+        for (auto& s : sources_) {
+            if (!s->valid()) continue;
+            if (!current_ || compareKeys(s->key(), s->keySize(), current_->key(), current_->keySize()) < 0) {
+                current_ = s.get();
+            }
+        }
+    }
+};
+
+class LsmIterator : public KvIterator {
+public:
+    LsmIterator(std::vector<std::unique_ptr<Source>> sources, Bytes prefix)
+        : merger_(std::move(sources)), prefix_(std::move(prefix)) { settle(); }
+
+    bool valid() const override { return valid_; }
+    const Bytes& key() const override { return key_; }
+    const Bytes& value() const override { return value_; }
+    void next() override {
+        merger_.next();
+        settle();
+    }
+
+private:
+    Merger merger_;
+    Bytes prefix_;
+    bool valid_{false};
+    Bytes key_;
+    Bytes value_;
+
+    // Skip deletions; stop past the prefix
+    void settle() {
+        while (merger_.valid() && merger_.current().tombstone() &&
+               hasPrefix(merger_.current().key(), merger_.current().keySize(), prefix_))
+        {
+            merger_.next();
+        }
+        valid_ = merger_.valid() && hasPrefix(merger_.current().key(), merger_.current().keySize(), prefix_);
+        if (valid_) {
+            Source& s = merger_.current();
+            key_.assign(s.key(), s.key() + s.keySize());
+            value_.assign(s.value(), s.value() + s.valueSize());
+        }
+    }
+};
+
+class LsmSnapshot : public KvSnapshot {
+public:
+    LsmSnapshot(std::shared_ptr<const Memtable> mem, std::shared_ptr<const std::vector<std::shared_ptr<Table>>> tables)
+        : mem_(std::move(mem)), tables_(std::move(tables)) {}
+
+    std::optional<Bytes> get(const Bytes& key) const override {
+        auto it = mem_->entries.find(key);
+        if (it != mem_->entries.end()) return it->second;
+        for (const auto& t : *tables_) {
+            if (!t->mayContain(key)) continue;
+            if (auto found = t->find(key)) return *found;
+        }
+        return std::nullopt;
+    }
+
+    std::unique_ptr<KvIterator> iterate(const Bytes& prefix) const override {
+        std::vector<std::unique_ptr<Source>> sources;
+        sources.push_back(std::make_unique<MemSource>(mem_, prefix));
+        for (const auto& t : *tables_) sources.push_back(std::make_unique<TableSource>(t, prefix));
+        return std::make_unique<LsmIterator>(std::move(sources), prefix);
+    }
+
+private:
+    std::shared_ptr<const Memtable> mem_;
+    std::shared_ptr<const std::vector<std::shared_ptr<Table>>> tables_;
+};
+
+} // namespace
+
+// ---------- LsmKvStore ----------
+
+LsmKvStore::LsmKvStore(const std::string& dir, LsmOptions opts)
+    : dir_(dir), opts_(opts), mem_(std::make_shared<Memtable>())
+{
+    std::filesystem::create_directories(dir_);
+
+    // MANIFEST: "next <id>" then one "table <id>" line per table, newest first
+    auto tables = std::make_shared<TableList>();
+    std::ifstream manifest(dir_ + "/MANIFEST");
+    std::string word;
+    std::uint64_t id = 0;
+    while (manifest >> word >> id) {
+        if (word == "next") {
+            nextId_ = id;
+        } else if (word == "table") {
+            tables->push_back(std::make_shared<Table>(id, tablePath(id)));
+        }
+    }
+    tables_ = tables;
+    compactionDue_ = pickMerge(*tables_, opts_.compactionTrigger, opts_.memtableBytes).second > 0;
+
+    // Tables a crash left behind before they made it into the manifest
+    for (const auto& entry : std::filesystem::directory_iterator(dir_)) {
+        if (entry.path().extension() != ".sst") continue;
+        std::uint64_t fileId = std::strtoull(entry.path().stem().string().c_str(), nullptr, 10);
+        bool live = std::any_of(tables->begin(), tables->end(), [&](const auto& t) { return t->id == fileId; });
+        if (!live) std::filesystem::remove(entry.path());
+    }
+
+    wal_ = std::make_unique<WriteAheadLog>(dir_ + "/kv.log");
+    wal_->replay([&](std::uint8_t type, const Bytes& payload) {
+        if (type != kBatchRecord) return;
+        WriteBatch batch = decodeBatch(payload);
+        for (const auto& op : batch.ops()) {
+            mem_->bytes += op.key.size() + (op.value ? op.value->size() : 0) + 16;
+            mem_->entries[op.key] = op.value;
+        }
+    });
+
+    compactor_ = std::thread(&LsmKvStore::compactLoop, this);
+}
+
+LsmKvStore::~LsmKvStore() {
+    {
+        std::lock_guard<std::mutex> lock(compactMutex_);
+        stopping_ = true;
+    }
+    compactCv_.notify_all();
+    compactor_.join();
+}
+
+std::string LsmKvStore::tablePath(std::uint64_t id) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "/%06llu.sst", static_cast<unsigned long long>(id));
+    return dir_ + name;
+}
+
+std::optional<Bytes> LsmKvStore::get(const Bytes& key) const {
+    std::shared_ptr<const TableList> tables;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = mem_->entries.find(key);
+        if (it != mem_->entries.end()) return it->second;
+        tables = tables_;
+    }
+    for (const auto& t : *tables) {
+        if (!t->mayContain(key)) {
+            ++bloomSkips_;
+            continue;
+        }
+        ++tableReads_;
+        if (auto found = t->find(key)) return *found;
+    }
+    return std::nullopt;
+}
+
+void LsmKvStore::write(const WriteBatch& batch) {
+    if (batch.empty()) return;
+    Bytes record = encodeBatch(batch);
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    std::uint64_t seq = wal_->append(kBatchRecord, record);
+
+    // A snapshot still shares the memtable: copy before changing it
+    if (mem_.use_count() > 1) {
+        mem_ = std::make_shared<Memtable>(*mem_);
+    }
+    for (const auto& op : batch.ops()) {
+        mem_->bytes += op.key.size() + (op.value ? op.value->size() : 0) + 16;
+        mem_->entries[op.key] = op.value;
+    }
+    if (mem_->bytes >= opts_.memtableBytes) {
+        flushLocked();
+    }
+    lock.unlock();
+
+    if (opts_.syncWrites) {
+        wal_->sync(seq);
+    }
+}
+
+std::shared_ptr<const KvSnapshot> LsmKvStore::snapshot() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return std::make_shared<LsmSnapshot>(mem_, tables_);
+}
+
+void LsmKvStore::flush() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    flushLocked();
+}
+
+void LsmKvStore::flushLocked() {
+    if (mem_->entries.empty()) return;
+
+    std::uint64_t id = nextId_++;
+    TableBuilder builder(tablePath(id), opts_.bloomBitsPerKey);
+    for (const auto& [key, value] : mem_->entries) {
+        builder.add(key.data(), key.size(), value ? value->data() : nullptr, value ? value->size() : 0, !value);
+    }
+    builder.finish();
+
+    auto tables = std::make_shared<TableList>();
+    tables->push_back(std::make_shared<Table>(id, tablePath(id)));
+    tables->insert(tables->end(), tables_->begin(), tables_->end());
+    tables_ = tables;
+    compactionDue_ = pickMerge(*tables_, opts_.compactionTrigger, opts_.memtableBytes).second > 0;
+    writeManifestLocked();
+
+    // The table now holds everything the log did
+    wal_->reset();
+    mem_ = std::make_shared<Memtable>();
+    ++flushes_;
+
+    if (compactionDue_) {
+        // Taking the lock orders this with the compactor's check
+        { std::lock_guard<std::mutex> wake(compactMutex_); }
+        compactCv_.notify_all();
+    }
+}
+
+void LsmKvStore::writeManifestLocked() const {
+    std::string tmp = dir_ + "/MANIFEST.tmp";
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) throw std::runtime_error("LsmKvStore: cannot write manifest");
+    std::fprintf(f, "next %llu\n", static_cast<unsigned long long>(nextId_));
+    for (const auto& t : *tables_) {
+        std::fprintf(f, "table %llu\n", static_cast<unsigned long long>(t->id));
+    }
+    syncFile(f, "LsmKvStore");
+    std::fclose(f);
+    std::filesystem::rename(tmp, dir_ + "/MANIFEST");
+}
+
+void LsmKvStore::compactLoop() {
+    std::unique_lock<std::mutex> lock(compactMutex_);
+    for (;;) {
+        compactCv_.wait(lock, [&] { return stopping_ || compactionDue_; });
+        if (stopping_) return;
+        compacting_ = true;
+        lock.unlock();
+
+        // Flushes only add tables in front, so the run stays adjacent
+        // while it is merged
+        TableList inputs;
+        bool oldest = false;
+        std::uint64_t id;
+        {
+            std::unique_lock<std::shared_mutex> l(mutex_);
+            auto [first, count] = pickMerge(*tables_, opts_.compactionTrigger, opts_.memtableBytes);
+            inputs.assign(tables_->begin() + first, tables_->begin() + first + count);
+            oldest = first + count == tables_->size();
+            id = nextId_++;
+        }
+
+        if (!inputs.empty()) {
+            // Deletions can only be dropped if nothing older lies beneath
+            std::vector<std::unique_ptr<Source>> sources;
+            for (const auto& t : inputs) sources.push_back(std::make_unique<TableSource>(t, Bytes{}));
+            Merger merger(std::move(sources));
+            {
+                TableBuilder builder(tablePath(id), opts_.bloomBitsPerKey);
+                for (; merger.valid(); merger.next()) {
+                    Source& s = merger.current();
+                    if (s.tombstone() && oldest) continue;
+                    builder.add(s.key(), s.keySize(), s.value(), s.valueSize(), s.tombstone());
+                }
+                builder.finish();
+            }
+            auto merged = std::make_shared<Table>(id, tablePath(id));
+            compactedBytes_ += merged->dataEnd;
+
+            {
+                // The merged table takes the run's place
+                std::unique_lock<std::shared_mutex> l(mutex_);
+                auto tables = std::make_shared<TableList>();
+                for (const auto& t : *tables_) {
+                    if (t == inputs.front()) {
+                        tables->push_back(merged);
+                    } else if (std::find(inputs.begin(), inputs.end(), t) == inputs.end()) {
+                        tables->push_back(t);
+                    }
+                }
+                tables_ = tables;
+                compactionDue_ = pickMerge(*tables_, opts_.compactionTrigger, opts_.memtableBytes).second > 0;
+                writeManifestLocked();
+                for (const auto& t : inputs) t->obsolete = true;
+            }
+            inputs.clear();
+            ++compactions_;
+        }
+
+        lock.lock();
+        compacting_ = false;
+        compactCv_.notify_all();
+    }
+}
+
+void LsmKvStore::waitForCompaction() {
+    std::unique_lock<std::mutex> lock(compactMutex_);
+    compactCv_.wait(lock, [&] { return stopping_ || (!compacting_ && !compactionDue_); });
+}
+
+std::size_t LsmKvStore::tables() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return tables_->size();
+}
+
+LsmKvStore::Stats LsmKvStore::stats() const {
+    Stats s;
+    s.flushes = flushes_;
+    s.compactions = compactions_;
+    s.compactedBytes = compactedBytes_;
+    s.bloomSkips = bloomSkips_;
+    s.tableReads = tableReads_;
+    return s;
+}
+
+} // namespace gambit
@@ -0,0 +1,236 @@
+#include "gambit/lz.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace gambit {
+namespace lz {
+
+namespace {
+
+constexpr std::size_t kMinMatch = 4;
+constexpr int kHashBits = 15;
+constexpr int kMaxChain = 16;              // candidates tried per position
+constexpr std::size_t kGoodMatch = 64;     // stop searching at this length
+
+// Training: grams scored, segment length, input cap
+constexpr std::size_t kGram = 6;
+constexpr int kGramBits = 20;
+constexpr std::size_t kSegment = 64;
+constexpr std::size_t kMaxTrainingBytes = std::size_t(4) << 20;
+
+std::uint32_t hash4(const std::uint8_t* p) {
+    std::uint32_t v;
+    std::memcpy(&v, p, 4);
+    return (v * 2654435761u) >> (32 - kHashBits);
+}
+
+std::uint32_t hashGram(const std::uint8_t* p) {
+    std::uint64_t v = 0;
+    std::memcpy(&v, p, kGram);
+    return static_cast<std::uint32_t>((v * 0x9E3779B97F4A7C15ull) >> (64 - kGramBits));
+}
+
+std::size_t matchLength(const std::uint8_t* a, const std::uint8_t* b, std::size_t max) {
+    std::size_t n = 0;
+    while (n < max && a[n] == b[n]) ++n;
+    return n;
+}
+
+void putVarint(Bytes& out, std::uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<std::uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(v));
+}
+
+// Token: high nibble literal count, low nibble match length - kMinMatch;
+// 15 in either means a varint with the rest follows
+void putSequence(Bytes& out, const std::uint8_t* lit, std::size_t litLen, std::size_t dist, std::size_t matchLen) {
+    std::size_t ml = matchLen ? matchLen - kMinMatch : 0;
+    out.push_back(static_cast<std::uint8_t>((std::min<std::size_t>(litLen, 15) << 4) | std::min<std::size_t>(ml, 15)));
+    if (litLen >= 15) putVarint(out, litLen - 15);
+    out.insert(out.end(), lit, lit + litLen);
+    if (matchLen == 0) return;
+    putVarint(out, dist);
+    if (ml >= 15) putVarint(out, ml - 15);
+}
+
+[[noreturn]] void corrupt() {
+    throw std::runtime_error("lz: corrupt input");
+}
+
+} // namespace
+
+Dictionary::Dictionary(Bytes bytes)
+    : bytes_(std::move(bytes)), head_(std::size_t(1) << kHashBits, -1), prev_(bytes_.size(), -1)
+{
+    for (std::size_t p = 0; p + kMinMatch <= bytes_.size(); ++p) {
+        std::uint32_t h = hash4(bytes_.data() + p);
+        prev_[p] = head_[h];
+        head_[h] = static_cast<std::int32_t>(p);
+    }
+}
+
+Bytes train(const std::vector<Bytes>& samples, std::size_t maxSize) {
+    Bytes all;
+    for (const Bytes& s : samples) {
+        if (all.size() >= kMaxTrainingBytes) break;
+        all.insert(all.end(), s.begin(), s.end());
+    }
+    if (all.size() <= maxSize) return all;
+
+    // How often each gram occurs; grams seen once are worth nothing
+    std::vector<std::uint32_t> freq(std::size_t(1) << kGramBits, 0);
+    std::size_t grams = all.size() - kGram + 1;
+    for (std::size_t p = 0; p < grams; ++p) ++freq[hashGram(all.data() + p)];
+    auto worth = [&](std::size_t p) -> std::uint64_t {
+        std::uint32_t f = freq[hashGram(all.data() + p)];
+        return f > 1 ? f : 0;
+    };
+
+    // Split the samples into one epoch per dictionary segment and take the
+    // best-scoring segment of each. Grams a taken segment covers are
+    // zeroed so later epochs look for something else.
+    std::size_t epochs = std::max<std::size_t>(1, maxSize / kSegment);
+    std::size_t epochLen = std::max(all.size() / epochs, kSegment);
+    std::size_t span = kSegment - kGram + 1;    // grams per segment
+    std::vector<std::pair<std::uint64_t, std::size_t>> picked;   // score, start
+    for (std::size_t begin = 0; begin + kSegment <= all.size(); begin += epochLen) {
+        std::size_t last = std::min(begin + epochLen, all.size()) - kSegment;
+        std::uint64_t score = 0;
+        for (std::size_t p = begin; p < begin + span; ++p) score += worth(p);
+        std::uint64_t best = score;
+        std::size_t bestAt = begin;
+        for (std::size_t p = begin + 1; p <= last; ++p) {
+            score += worth(p + span - 1);
+            score -= worth(p - 1);
+            if (score > best) {
+                best = score;
+                bestAt = p;
+            }
+        }
+        if (best == 0) continue;
+        picked.emplace_back(best, bestAt);
+        for (std::size_t p = bestAt; p < bestAt + span; ++p) freq[hashGram(all.data() + p)] = 0;
+    }
+
+    std::sort(picked.begin(), picked.end());
+    if (picked.size() * kSegment > maxSize) {
+        picked.erase(picked.begin(), picked.end() - maxSize / kSegment);
+    }
+    Bytes dict;
+    for (const auto& [score, at] : picked) {
+        dict.insert(dict.end(), all.begin() + at, all.begin() + at + kSegment);
+    }
+    return dict;
+}
+
+Bytes compress(const std::uint8_t* data, std::size_t size, const Dictionary& dict) {
+    Bytes out;
+    out.reserve(size / 2 + 16);
+
+    const std::uint8_t* dictBytes = dict.bytes_.data();
+    std::size_t dictSize = dict.bytes_.size();
+    std::vector<std::int32_t> head(std::size_t(1) << kHashBits, -1);
+    std::vector<std::int32_t> prev(size, -1);
+    auto insert = [&](std::size_t p) {
+        std::uint32_t h = hash4(data + p);
+        prev[p] = head[h];
+        head[h] = static_cast<std::int32_t>(p);
+    };
+
+    std::size_t anchor = 0;
+    std::size_t pos = 0;
+    while (pos + kMinMatch <= size) {
+        std::uint32_t h = hash4(data + pos);
+        std::size_t bestLen = 0;
+        std::size_t bestDist = 0;
+
+        // Earlier in the record first: nearer, so shorter offsets
+        std::int32_t c = head[h];
+        for (int n = 0; c >= 0 && n < kMaxChain && bestLen < kGoodMatch; ++n, c = prev[c]) {
+            std::size_t len = matchLength(data + c, data + pos, size - pos);
+            if (len > bestLen) {
+                bestLen = len;
+                bestDist = pos - static_cast<std::size_t>(c);
+            }
+        }
+        if (dictSize > 0) {
+            c = dict.head_[h];
+            for (int n = 0; c >= 0 && n < kMaxChain && bestLen < kGoodMatch; ++n, c = dict.prev_[c]) {
+                std::size_t len = matchLength(dictBytes + c, data + pos,
+                                              std::min(size - pos, dictSize - static_cast<std::size_t>(c)));
+                if (len > bestLen) {
+                    bestLen = len;
+                    bestDist = pos + dictSize - static_cast<std::size_t>(c);
+                }
+            }
+        }
+
+        if (bestLen < kMinMatch) {
+            insert(pos++);
+            continue;
+        }
+        putSequence(out, data + anchor, pos - anchor, bestDist, bestLen);
+        std::size_t end = pos + bestLen;
+        for (; pos < end; ++pos) {
+            if (pos + kMinMatch <= size) insert(pos);
+        }
+        anchor = pos;
+    }
+    if (anchor < size) putSequence(out, data + anchor, size - anchor, 0, 0);
+    return out;
+}
+
+Bytes decompress(const std::uint8_t* data, std::size_t size, std::size_t rawSize, const Dictionary& dict) {
+    Bytes out;
+    out.reserve(rawSize);
+    const Bytes& d = dict.bytes();
+
+    std::size_t i = 0;
+    auto varint = [&]() -> std::uint64_t {
+        std::uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (i >= size) corrupt();
+            std::uint8_t b = data[i++];
+            v |= std::uint64_t(b & 0x7f) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        corrupt();
+    };
+
+    while (out.size() < rawSize) {
+        if (i >= size) corrupt();
+        std::uint8_t token = data[i++];
+
+        std::uint64_t lit = token >> 4;
+        if (lit == 15) lit += varint();
+        if (lit > size - i || lit > rawSize - out.size()) corrupt();
+        out.insert(out.end(), data + i, data + i + lit);
+        i += lit;
+        if (out.size() == rawSize) break;   // last sequence has no match
+
+        std::uint64_t dist = varint();
+        std::uint64_t len = (token & 15) + kMinMatch;
+        if ((token & 15) == 15) len += varint();
+        if (dist == 0 || dist > out.size() + d.size() || len > rawSize - out.size()) corrupt();
+
+        // Position in the window [dictionary | output]; a match may start
+        // in the dictionary and run on into the output
+        std::size_t v = d.size() + out.size() - dist;
+        for (; len > 0 && v < d.size(); --len, ++v) out.push_back(d[v]);
+        v -= d.size();
+        for (; len > 0; --len, ++v) {
+            std::uint8_t b = out[v];
+            out.push_back(b);
+        }
+    }
+    if (i != size) corrupt();
+    return out;
+}
+
+} // namespace lz
+} // namespace gambit
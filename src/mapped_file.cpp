@@ -0,0 +1,137 @@
+#include "gambit/mapped_file.hpp"
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace gambit {
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+#ifdef _WIN32
+        file_ = std::exchange(other.file_, nullptr);
+        mapping_ = std::exchange(other.mapping_, nullptr);
+#else
+        fd_ = std::exchange(other.fd_, -1);
+#endif
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+MappedFile MappedFile::open(const std::string& path) {
+    MappedFile m;
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("MappedFile: cannot open " + path);
+    }
+    m.file_ = file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        throw std::runtime_error("MappedFile: cannot stat " + path);
+    }
+    m.size_ = static_cast<std::size_t>(size.QuadPart);
+    if (m.size_ == 0) {
+        return m;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        throw std::runtime_error("MappedFile: cannot map " + path);
+    }
+    m.mapping_ = mapping;
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        throw std::runtime_error("MappedFile: cannot map " + path);
+    }
+    m.data_ = static_cast<const std::uint8_t*>(view);
+    return m;
+}
+
+MappedFile MappedFile::open(const std::string& path, std::size_t) {
+    return open(path);
+}
+
+void MappedFile::close() {
+    if (data_) UnmapViewOfFile(data_);
+    if (mapping_) CloseHandle(mapping_);
+    if (file_) CloseHandle(file_);
+    data_ = nullptr;
+    mapping_ = nullptr;
+    file_ = nullptr;
+    size_ = 0;
+}
+
+#else
+
+namespace {
+constexpr std::size_t kWholeFile = std::numeric_limits<std::size_t>::max();
+}
+
+MappedFile MappedFile::open(const std::string& path) {
+    return open(path, kWholeFile);
+}
+
+MappedFile MappedFile::open(const std::string& path, std::size_t length) {
+    MappedFile m;
+    m.fd_ = ::open(path.c_str(), O_RDONLY);
+    if (m.fd_ < 0) {
+        throw std::runtime_error("MappedFile: cannot open " + path);
+    }
+
+    m.size_ = length;
+    if (length == kWholeFile) {
+        struct stat st{};
+        if (fstat(m.fd_, &st) != 0) {
+            throw std::runtime_error("MappedFile: cannot stat " + path);
+        }
+        m.size_ = static_cast<std::size_t>(st.st_size);
+    }
+    if (m.size_ == 0) {
+        return m;
+    }
+
+    // Pages past the end of the file fill in as the file grows
+    // (MAP_SHARED shares the page cache with the writer)
+    void* p = mmap(nullptr, m.size_, PROT_READ, MAP_SHARED, m.fd_, 0);
+    if (p == MAP_FAILED) {
+        throw std::runtime_error("MappedFile: cannot map " + path);
+    }
+    m.data_ = static_cast<const std::uint8_t*>(p);
+    return m;
+}
+
+void MappedFile::close() {
+    if (data_) munmap(const_cast<std::uint8_t*>(data_), size_);
+    if (fd_ >= 0) ::close(fd_);
+    data_ = nullptr;
+    fd_ = -1;
+    size_ = 0;
+}
+
+#endif
+
+} // namespace gambit
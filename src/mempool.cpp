@@ -0,0 +1,244 @@
+#include "gambit/mempool.hpp"
+#include <iterator>
+#include <mutex>
+#include <queue>
+
+namespace gambit {
+
+Mempool::Rank Mempool::rankOf(const Address& sender, const std::map<std::uint64_t, Entry>::const_iterator& it) {
+    return Rank{it->second.tx.gasPrice, it->second.seq, sender, it->first};
+}
+
+void Mempool::unlink(const Address& sender, const Sender& s) {
+    if (s.txs.empty()) return;
+    heads_.erase(rankOf(sender, s.txs.begin()));
+    (s.queued() ? queuedTails_ : tails_).erase(rankOf(sender, std::prev(s.txs.end())));
+}
+
+void Mempool::link(const Address& sender, const Sender& s) {
+    if (s.txs.empty()) return;
+    if (s.txs.begin()->first == s.nonce) heads_.insert(rankOf(sender, s.txs.begin()));
+    (s.queued() ? queuedTails_ : tails_).insert(rankOf(sender, std::prev(s.txs.end())));
+}
+
+void Mempool::extendReady(Sender& s) {
+    // Walks only the transactions that just became executable
+    auto it = s.txs.find(s.nonce + s.ready);
+    while (it != s.txs.end() && it->first == s.nonce + s.ready) {
+        ++s.ready;
+        ++it;
+    }
+}
+
+void Mempool::erase(const Address& sender, std::map<std::uint64_t, Entry>::iterator it) {
+    auto sit = senders_.find(sender);
+    Sender& s = sit->second;
+    unlink(sender, s);
+    if (it->first < s.nonce + s.ready) s.ready = it->first - s.nonce;
+    byHash_.erase(it->second.tx.hash);
+    s.txs.erase(it);
+    if (s.txs.empty()) {
+        senders_.erase(sit);
+    } else {
+        link(sender, s);
+    }
+}
+
+bool Mempool::add(const Transaction& tx, std::uint64_t accountNonce, std::string& err) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (byHash_.count(tx.hash)) {
+        err = "Already known";
+        return false;
+    }
+    if (tx.nonce < accountNonce) {
+        err = "Nonce too low";
+        return false;
+    }
+    if (tx.nonce - accountNonce >= kMaxNonceAhead) {
+        err = "Nonce too high";
+        return false;
+    }
+    setNonceLocked(tx.from, accountNonce);
+
+    auto sit = senders_.find(tx.from);
+    if (sit != senders_.end()) {
+        Sender& s = sit->second;
+        auto old = s.txs.find(tx.nonce);
+        if (old != s.txs.end()) {
+            const uint256& price = old->second.tx.gasPrice;
+            uint256 bump;
+            if (uint256::mulOverflow(price, kReplaceBumpPercent, bump) || !(price < tx.gasPrice) ||
+                tx.gasPrice < price + bump / 100) {
+                err = "Replacement transaction underpriced";
+                return false;
+            }
+            unlink(tx.from, s);
+            byHash_.erase(old->second.tx.hash);
+            old->second = Entry{tx, nextSeq_++};
+            byHash_.emplace(tx.hash, std::make_pair(tx.from, tx.nonce));
+            link(tx.from, s);
+            return true;
+        }
+    }
+
+    // Any other nonce is either next in line or past a gap
+    bool executable = tx.nonce == accountNonce + (sit != senders_.end() ? sit->second.ready : 0);
+    if (!executable && sit != senders_.end() && sit->second.queued() >= kMaxQueuedPerSender) {
+        err = "Too many queued transactions";
+        return false;
+    }
+    if (byHash_.size() >= capacity_ && !evictFor(tx, executable)) {
+        err = "Mempool full";
+        return false;
+    }
+
+    auto [it, fresh] = senders_.try_emplace(tx.from);
+    Sender& s = it->second;
+    if (fresh) s.nonce = accountNonce;
+    unlink(tx.from, s);
+    s.txs.emplace(tx.nonce, Entry{tx, nextSeq_++});
+    byHash_.emplace(tx.hash, std::make_pair(tx.from, tx.nonce));
+    extendReady(s);
+    link(tx.from, s);
+    return true;
+}
+
+bool Mempool::evictFor(const Transaction& tx, bool executable) {
+    // Evicting the sender's own tail would only leave `tx` behind a gap
+    auto evictable = [&](const Rank& r) { return !(r.sender == tx.from && r.nonce < tx.nonce); };
+
+    // A queued tail makes way for any executable transaction, and for a
+    // queued one that pays more
+    if (!queuedTails_.empty()) {
+        const Rank& cheapest = *queuedTails_.begin();
+        if (evictable(cheapest) && (executable || cheapest.price < tx.gasPrice)) {
+            erase(cheapest.sender, senders_.at(cheapest.sender).txs.find(cheapest.nonce));
+            return true;
+        }
+    }
+    if (!executable || tails_.empty()) {
+        return false;
+    }
+    const Rank& cheapest = *tails_.begin();
+    if (!(cheapest.price < tx.gasPrice) || !evictable(cheapest)) {
+        return false;
+    }
+    erase(cheapest.sender, senders_.at(cheapest.sender).txs.find(cheapest.nonce));
+    return true;
+}
+
+void Mempool::setNonce(const Address& sender, std::uint64_t nonce) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    setNonceLocked(sender, nonce);
+}
+
+void Mempool::setNonceLocked(const Address& sender, std::uint64_t nonce) {
+    auto sit = senders_.find(sender);
+    if (sit == senders_.end() || sit->second.nonce == nonce) return;
+    Sender& s = sit->second;
+    unlink(sender, s);
+    s.nonce = nonce;
+    while (!s.txs.empty() && s.txs.begin()->first < nonce) {
+        byHash_.erase(s.txs.begin()->second.tx.hash);
+        s.txs.erase(s.txs.begin());
+    }
+    s.ready = 0;
+    extendReady(s);
+    if (s.txs.empty()) {
+        senders_.erase(sit);
+    } else {
+        link(sender, s);
+    }
+}
+
+bool Mempool::remove(const Bytes32& hash) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto h = byHash_.find(hash);
+    if (h == byHash_.end()) return false;
+    auto [sender, nonce] = h->second;
+    erase(sender, senders_.at(sender).txs.find(nonce));
+    return true;
+}
+
+bool Mempool::contains(const Bytes32& hash) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return byHash_.count(hash) != 0;
+}
+
+std::optional<Transaction> Mempool::find(const Bytes32& hash) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto h = byHash_.find(hash);
+    if (h == byHash_.end()) return std::nullopt;
+    return senders_.at(h->second.first).txs.at(h->second.second).tx;
+}
+
+std::vector<Transaction> Mempool::select(std::size_t limit) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return selectLocked(limit);
+}
+
+std::vector<Transaction> Mempool::selectLocked(std::size_t limit) const {
+    // Successors of taken transactions wait here; the head set itself is
+    // only walked, never copied
+    struct Worse {
+        bool operator()(const Rank& a, const Rank& b) const { return Better{}(b, a); }
+    };
+    std::priority_queue<Rank, std::vector<Rank>, Worse> next;
+
+    std::vector<Transaction> out;
+    auto head = heads_.begin();
+    while (out.size() < limit) {
+        Rank r;
+        if (head != heads_.end() && (next.empty() || Better{}(*head, next.top()))) {
+            r = *head++;
+        } else if (!next.empty()) {
+            r = next.top();
+            next.pop();
+        } else {
+            break;
+        }
+        const Sender& s = senders_.at(r.sender);
+        auto it = s.txs.find(r.nonce);
+        out.push_back(it->second.tx);
+        auto succ = std::next(it);
+        if (succ != s.txs.end() && succ->first == r.nonce + 1) next.push(rankOf(r.sender, succ));
+    }
+    return out;
+}
+
+std::vector<Transaction> Mempool::all() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::vector<Transaction> out = selectLocked(std::numeric_limits<std::size_t>::max());
+    for (const auto& [sender, s] : senders_) {
+        std::uint64_t expected = s.nonce;
+        for (const auto& [nonce, e] : s.txs) {
+            if (nonce == expected) {
+                ++expected;
+            } else {
+                out.push_back(e.tx);
+            }
+        }
+    }
+    return out;
+}
+
+void Mempool::clear() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    senders_.clear();
+    byHash_.clear();
+    heads_.clear();
+    tails_.clear();
+    queuedTails_.clear();
+}
+
+std::size_t Mempool::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return byHash_.size();
+}
+
+std::size_t Mempool::senders() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return senders_.size();
+}
+
+} // namespace gambit
@@ -0,0 +1,128 @@
+#include "gambit/merkle.hpp"
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+namespace gambit {
+namespace merkle {
+
+namespace {
+
+constexpr std::uint8_t kLeafTag = 0x00;
+constexpr std::uint8_t kNodeTag = 0x01;
+
+// Workers take whole subtrees of at least this many leaves
+constexpr std::size_t kSubtreeLeaves = 1024;
+
+Bytes32 hashLeaf(const Bytes32& leaf) {
+    std::uint8_t buf[33];
+    buf[0] = kLeafTag;
+    std::copy(leaf.begin(), leaf.end(), buf + 1);
+    return keccak256_32(buf, sizeof(buf));
+}
+
+Bytes32 hashNode(const Bytes32& left, const Bytes32& right) {
+    std::uint8_t buf[65];
+    buf[0] = kNodeTag;
+    std::copy(left.begin(), left.end(), buf + 1);
+    std::copy(right.begin(), right.end(), buf + 33);
+    return keccak256_32(buf, sizeof(buf));
+}
+
+// Hash one level in place: nodes [0, n) become the next level's
+// [0, (n + 1) / 2); returns its size
+std::size_t reduce(Bytes32* nodes, std::size_t n) {
+    std::size_t out = 0;
+    for (std::size_t i = 0; i + 1 < n; i += 2) nodes[out++] = hashNode(nodes[i], nodes[i + 1]);
+    if (n % 2) nodes[out++] = nodes[n - 1];
+    return out;
+}
+
+std::vector<Bytes32> hashLeaves(const Bytes32* leaves, std::size_t n) {
+    std::vector<Bytes32> level(n);
+    for (std::size_t i = 0; i < n; ++i) level[i] = hashLeaf(leaves[i]);
+    return level;
+}
+
+Bytes32 subtreeRoot(const Bytes32* leaves, std::size_t n) {
+    std::vector<Bytes32> level = hashLeaves(leaves, n);
+    while (n > 1) n = reduce(level.data(), n);
+    return level[0];
+}
+
+} // namespace
+
+Bytes32 root(const std::vector<Bytes32>& leaves, std::size_t threads) {
+    if (leaves.empty()) {
+        return Bytes32{};
+    }
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (threads == 1 || leaves.size() < kParallelLeaves) {
+        return subtreeRoot(leaves.data(), leaves.size());
+    }
+
+    // Subtrees of a power-of-two span line up with the levels, so their
+    // roots are nodes of the full tree. About four per worker keeps the
+    // last ones from running alone.
+    std::size_t span = kSubtreeLeaves;
+    while (span * threads * 4 < leaves.size()) span *= 2;
+    std::size_t count = (leaves.size() + span - 1) / span;
+
+    std::vector<Bytes32> tops(count);
+    std::atomic<std::size_t> next{0};
+    auto worker = [&]() {
+        for (std::size_t i; (i = next.fetch_add(1)) < count;) {
+            std::size_t lo = i * span;
+            tops[i] = subtreeRoot(leaves.data() + lo, std::min(span, leaves.size() - lo));
+        }
+    };
+    std::vector<std::thread> pool;
+    for (std::size_t t = 1; t < std::min(threads, count); ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+
+    while (count > 1) count = reduce(tops.data(), count);
+    return tops[0];
+}
+
+Proof prove(const std::vector<Bytes32>& leaves, std::uint64_t index) {
+    if (index >= leaves.size()) {
+        throw std::out_of_range("merkle::prove: leaf index out of range");
+    }
+    Proof proof{index, leaves.size(), {}};
+    std::vector<Bytes32> level = hashLeaves(leaves.data(), leaves.size());
+    std::size_t n = level.size();
+    std::size_t pos = index;
+    while (n > 1) {
+        if ((pos ^ 1) < n) proof.siblings.push_back(level[pos ^ 1]);
+        n = reduce(level.data(), n);
+        pos /= 2;
+    }
+    return proof;
+}
+
+bool verify(const Bytes32& root, const Bytes32& leaf, const Proof& proof) {
+    if (proof.index >= proof.leaves) {
+        return false;
+    }
+    Bytes32 h = hashLeaf(leaf);
+    std::uint64_t n = proof.leaves;
+    std::uint64_t pos = proof.index;
+    std::size_t used = 0;
+    while (n > 1) {
+        if ((pos ^ 1) < n) {
+            if (used == proof.siblings.size()) return false;
+            const Bytes32& sibling = proof.siblings[used++];
+            h = (pos & 1) ? hashNode(sibling, h) : hashNode(h, sibling);
+        }
+        n = (n + 1) / 2;
+        pos /= 2;
+    }
+    return used == proof.siblings.size() && h == root;
+}
+
+} // namespace merkle
+} // namespace gambit
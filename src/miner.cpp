@@ -1,4 +1,5 @@
 #include "gambit/miner.hpp"
+#include <algorithm>
 #include <iostream>
 
 namespace gambit {
@@ -39,19 +40,39 @@ bool Miner::submitWork(const Block& b) {
 void Miner::loop() {
     while (running_) {
         try {
-            Block block = engine_.buildBlockTemplate(chain_);
-            chain_.addBlock(block);
-            p2p_.broadcastNewBlock(block);
-            std::cout << "[Miner] Mined block #" << block.index << "\n";
-            std::cout << "Mined block #" << block.index 
-                      << " hash=0x" << block.hash
-                      << " proof=" << block.proof.proof
-                      << " (nonce=" << block.nonce << ")\n";
+            // Executed while building it; only the link to the head
+            // can have gone stale since (a peer's block got in first)
+            BlockTemplate tmpl = engine_.buildTemplate(chain_);
+            const Block& block = tmpl.block;
+            if (chain_.commitVerified(block, tmpl.writes)) {
+                p2p_.broadcastNewBlock(block);
+                std::cout << "[Miner] Mined block #" << block.index << "\n";
+                std::cout << "Mined block #" << block.index 
+                          << " hash=0x" << toHex(block.hash)
+                          << " proof=0x" << toHex(block.proof.proof)
+                          << " (nonce=" << block.nonce << ")\n";
+            }
         } catch (...) {
             // ignore
         }
 
-        std::this_thread::sleep_for(interval_);
+        try {
+            chain_.freezeColdBlocks();
+        } catch (const std::exception& e) {
+            std::cerr << "[Miner] Freezer: " << e.what() << "\n";
+        }
+        try {
+            chain_.pruneHistory();
+        } catch (const std::exception& e) {
+            std::cerr << "[Miner] Pruning: " << e.what() << "\n";
+        }
+
+        // Pre-execute incoming transactions until the next interval
+        auto deadline = std::chrono::steady_clock::now() + interval_;
+        while (running_ && std::chrono::steady_clock::now() < deadline) {
+            chain_.preExecutePending();
+            std::this_thread::sleep_for(std::min(interval_, kIdlePoll));
+        }
     }
 }
 
@@ -1,7 +1,41 @@
 #include "gambit/mpt.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
 
 namespace gambit {
 
+namespace {
+
+constexpr std::uint8_t kEmptyString = 0x80;   // RLP of an empty child / value
+
+std::uint8_t nibbleAt(const Bytes& key, std::size_t depth) {
+    std::uint8_t b = key[depth / 2];
+    return depth % 2 == 0 ? b >> 4 : b & 0x0F;
+}
+
+// RLP list around an already concatenated payload
+Bytes wrapList(const Bytes& payload) {
+    Bytes out;
+    out.reserve(payload.size() + 9);
+    if (payload.size() < 56) {
+        out.push_back(static_cast<std::uint8_t>(0xC0 + payload.size()));
+    } else {
+        std::uint8_t len[8];
+        std::size_t n = 0;
+        for (std::size_t v = payload.size(); v > 0; v >>= 8) len[n++] = static_cast<std::uint8_t>(v);
+        out.push_back(static_cast<std::uint8_t>(0xF7 + n));
+        while (n > 0) out.push_back(len[--n]);
+    }
+    out.insert(out.end(), payload.begin(), payload.end());
+    return out;
+}
+
+} // namespace
+
 MptTrie::MptTrie()
     : root_(std::make_shared<Node>()) {}
 
@@ -16,13 +50,30 @@ std::vector<uint8_t> MptTrie::toNibbles(const Bytes& key) {
 }
 
 void MptTrie::put(const Bytes& key, const Bytes& value) {
+    // Nodes another copy of the trie still shares are copied before they
+    // change; nodes only this trie holds are changed in place
+    auto own = [](NodePtr& slot) {
+        if (slot.use_count() > 1) {
+            slot = std::make_shared<Node>(*slot);
+        } else {
+            // Pairs with the release of a copy that let go of it
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        slot->encoded.reset();
+    };
     auto nibbles = toNibbles(key);
-    NodePtr node = root_;
+    own(root_);
+    Node* node = root_.get();
     for (auto nib : nibbles) {
-        if (!node->children[nib]) {
-            node->children[nib] = std::make_shared<Node>();
+        NodePtr& child = node->children[nib];
+        if (!child) {
+            child = std::make_shared<Node>();
+        } else if (child->stub) {
+            throw std::runtime_error("MptTrie::put: path not covered by witness");
+        } else {
+            own(child);
         }
-        node = node->children[nib];
+        node = child.get();
     }
     node->value = value;
 }
@@ -35,6 +86,9 @@ std::optional<Bytes> MptTrie::get(const Bytes& key) const {
             return std::nullopt;
         }
         node = node->children[nib];
+        if (node->stub) {
+            throw std::runtime_error("MptTrie::get: path not covered by witness");
+        }
     }
     if (!node->value) return std::nullopt;
     return node->value;
@@ -48,30 +102,240 @@ Bytes MptTrie::encodeNodeValue(const NodePtr& node) {
     return rlp::encodeBytes(*node->value);
 }
 
-Bytes MptTrie::encodeNode(const NodePtr& node) {
+Bytes MptTrie::encodeChildRef(const NodePtr& child, const WitnessCollector* collect) {
+    if (!child) {
+        return rlp::encodeBytes({});  // empty
+    }
+    if (child->stub) {
+        return rlp::encodeBytes(Bytes(child->stub->begin(), child->stub->end()));
+    }
+
+    // Children shorter than a hash are embedded, others referenced by hash
+    Bytes enc = encodeNode(child, collect);
+    if (enc.size() < 32) {
+        return enc;
+    }
+    Bytes32 h = keccak256_32(enc);
+    if (collect && collect->onPath->count(child.get())) {
+        (*collect->out)[h] = enc;
+    }
+    return rlp::encodeBytes(Bytes(h.begin(), h.end()));
+}
+
+Bytes MptTrie::encodeNode(const NodePtr& node, const WitnessCollector* collect) {
+    // Unchanged subtrees reuse their encoding; witness paths are walked
+    // so their hashed nodes get collected
+    if (node->encoded && !(collect && collect->onPath->count(node.get()))) {
+        return *node->encoded;
+    }
+
     std::vector<Bytes> fields;
     fields.reserve(17);
 
     // 16 children as hashes/embedded
     for (const auto& child : node->children) {
-        if (!child) {
-            fields.push_back(rlp::encodeBytes({}));  // empty
-        } else {
-            // For simplicity, always embed full child RLP (no hash-shortcut)
-            Bytes enc = encodeNode(child);
-            fields.push_back(rlp::encodeBytes(enc));
-        }
+        fields.push_back(encodeChildRef(child, collect));
     }
 
     // value
     fields.push_back(encodeNodeValue(node));
-    return rlp::encodeList(fields);
+    Bytes enc = rlp::encodeList(fields);
+    // A node that already has its encoding may be shared with other
+    // copies; only witness walks get here for it, and they leave it be
+    if (!node->encoded) node->encoded = enc;
+    return enc;
+}
+
+Bytes32 MptTrie::rootHash() const {
+    return keccak256_32(encodeNode(root_));
+}
+
+std::map<Bytes32, Bytes> MptTrie::witness(const std::vector<Bytes>& keys) const {
+    std::unordered_set<const Node*> onPath;
+    for (const auto& key : keys) {
+        NodePtr node = root_;
+        onPath.insert(node.get());
+        for (auto nib : toNibbles(key)) {
+            node = node->children[nib];
+            if (!node || node->stub) break;
+            onPath.insert(node.get());
+        }
+    }
+
+    std::map<Bytes32, Bytes> out;
+    WitnessCollector collect{&onPath, &out};
+    Bytes rootEnc = encodeNode(root_, &collect);
+    out[keccak256_32(rootEnc)] = rootEnc;
+    return out;
+}
+
+// Same encoding as encodeNode for the node at `depth` nibbles whose
+// subtree holds e[lo, hi), all of which share the first `depth` nibbles
+Bytes MptTrie::sortedNode(const Entries& e, std::size_t lo, std::size_t hi, std::size_t depth) {
+    Bytes value(1, kEmptyString);
+    std::size_t i = lo;
+    if (i < hi && e[i].first.size() * 2 == depth) {
+        value = rlp::encodeBytes(e[i].second);
+        ++i;
+        if (i < hi && e[i].first.size() * 2 == depth) {
+            throw std::invalid_argument("MptTrie::sortedRoot: duplicate key");
+        }
+    }
+
+    Bytes payload;
+    std::size_t next = 0;   // first nibble slot not yet written
+    while (i < hi) {
+        std::uint8_t nib = nibbleAt(e[i].first, depth);
+        if (nib < next) {
+            throw std::invalid_argument("MptTrie::sortedRoot: keys not sorted");
+        }
+        std::size_t j = i + 1;
+        while (j < hi && e[j].first.size() * 2 > depth && nibbleAt(e[j].first, depth) == nib) ++j;
+        payload.insert(payload.end(), nib - next, kEmptyString);
+        Bytes ref = sortedChildRef(e, i, j, depth + 1);
+        payload.insert(payload.end(), ref.begin(), ref.end());
+        next = nib + 1u;
+        i = j;
+        if (i < hi && e[i].first.size() * 2 <= depth) {
+            throw std::invalid_argument("MptTrie::sortedRoot: keys not sorted");
+        }
+    }
+    payload.insert(payload.end(), 16 - next, kEmptyString);
+    payload.insert(payload.end(), value.begin(), value.end());
+    return wrapList(payload);
 }
 
-std::string MptTrie::rootHash() const {
-    Bytes enc = encodeNode(root_);
-    Bytes h = keccak256(enc);
-    return "0x" + gambit::toHex(h);
+Bytes MptTrie::sortedChildRef(const Entries& e, std::size_t lo, std::size_t hi, std::size_t depth) {
+    Bytes enc = sortedNode(e, lo, hi, depth);
+    if (enc.size() < 32) {
+        return enc;
+    }
+    Bytes32 h = keccak256_32(enc);
+    return rlp::encodeBytes(Bytes(h.begin(), h.end()));
+}
+
+Bytes32 MptTrie::sortedRoot(const Entries& entries, std::size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (threads == 1) {
+        return keccak256_32(sortedNode(entries, 0, entries.size(), 0));
+    }
+
+    // The empty key is the root's value; every other key has a first byte
+    std::size_t first = entries.empty() || !entries[0].first.empty() ? 0 : 1;
+    std::vector<std::size_t> start(257, entries.size());
+    for (std::size_t i = entries.size(); i-- > first;) {
+        if (entries[i].first.empty()) {
+            throw std::invalid_argument("MptTrie::sortedRoot: keys not sorted");
+        }
+        start[entries[i].first[0]] = i;
+    }
+    for (std::size_t b = 256; b-- > 0;) start[b] = std::min(start[b], start[b + 1]);
+    for (std::size_t i = first + 1; i < entries.size(); ++i) {
+        if (entries[i].first[0] < entries[i - 1].first[0]) {
+            throw std::invalid_argument("MptTrie::sortedRoot: keys not sorted");
+        }
+    }
+
+    // Subtrees at depth 2 (one per first byte) in parallel, then the 16
+    // depth-1 nodes and the root on this thread
+    std::vector<Bytes> refs(256);
+    std::atomic<std::size_t> nextByte{0};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto worker = [&]() {
+        for (std::size_t b = nextByte++; b < 256; b = nextByte++) {
+            if (start[b] == start[b + 1]) continue;
+            try {
+                refs[b] = sortedChildRef(entries, start[b], start[b + 1], 2);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) error = std::current_exception();
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (std::size_t t = 1; t < std::min<std::size_t>(threads, 256); ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+    if (error) std::rethrow_exception(error);
+
+    Bytes root;
+    for (std::size_t hiNib = 0; hiNib < 16; ++hiNib) {
+        if (start[hiNib * 16] == start[hiNib * 16 + 16]) {
+            root.push_back(kEmptyString);
+            continue;
+        }
+        Bytes payload;
+        for (std::size_t lo = 0; lo < 16; ++lo) {
+            const Bytes& ref = refs[hiNib * 16 + lo];
+            if (ref.empty()) {
+                payload.push_back(kEmptyString);
+            } else {
+                payload.insert(payload.end(), ref.begin(), ref.end());
+            }
+        }
+        payload.push_back(kEmptyString);   // byte keys never end mid-byte
+        Bytes enc = wrapList(payload);
+        if (enc.size() < 32) {
+            root.insert(root.end(), enc.begin(), enc.end());
+        } else {
+            Bytes32 h = keccak256_32(enc);
+            Bytes ref = rlp::encodeBytes(Bytes(h.begin(), h.end()));
+            root.insert(root.end(), ref.begin(), ref.end());
+        }
+    }
+    Bytes value = first ? rlp::encodeBytes(entries[0].second) : Bytes(1, kEmptyString);
+    root.insert(root.end(), value.begin(), value.end());
+    return keccak256_32(wrapList(root));
+}
+
+MptTrie::NodePtr MptTrie::decodeChildRef(const rlp::Decoded& item, const std::map<Bytes32, Bytes>& nodes) {
+    if (item.isList) {
+        return decodeNode(item, nodes);   // embedded
+    }
+    if (item.bytes.empty()) {
+        return nullptr;
+    }
+    if (item.bytes.size() != 32) {
+        throw std::runtime_error("MptTrie: bad child reference");
+    }
+
+    Bytes32 h{};
+    std::copy(item.bytes.begin(), item.bytes.end(), h.begin());
+    auto it = nodes.find(h);
+    if (it == nodes.end()) {
+        auto stub = std::make_shared<Node>();
+        stub->stub = h;
+        return stub;
+    }
+    return decodeNode(rlp::decode(it->second), nodes);
+}
+
+MptTrie::NodePtr MptTrie::decodeNode(const rlp::Decoded& item, const std::map<Bytes32, Bytes>& nodes) {
+    if (!item.isList || item.list.size() != 17) {
+        throw std::runtime_error("MptTrie: bad node encoding");
+    }
+    auto node = std::make_shared<Node>();
+    for (std::size_t i = 0; i < 16; ++i) {
+        node->children[i] = decodeChildRef(item.list[i], nodes);
+    }
+    // Empty values are indistinguishable from "no value" on the wire
+    if (!item.list[16].bytes.empty()) {
+        node->value = item.list[16].bytes;
+    }
+    return node;
+}
+
+MptTrie MptTrie::fromWitness(const Bytes32& root, const std::map<Bytes32, Bytes>& nodes) {
+    auto it = nodes.find(root);
+    if (it == nodes.end()) {
+        throw std::runtime_error("MptTrie::fromWitness: root node missing");
+    }
+    MptTrie t;
+    t.root_ = decodeNode(rlp::decode(it->second), nodes);
+    return t;
 }
 
 } // namespace gambit
@@ -0,0 +1,612 @@
+#include "gambit/parallel_executor.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace gambit {
+
+namespace {
+
+constexpr std::size_t kStorage = static_cast<std::size_t>(-1);
+
+// Transfer semantics shared by the serial and parallel paths. Must stay in
+// lockstep with State::applyTransaction. `to` is ignored for self-transfers.
+// Returns why the transfer cannot run, nullptr once it has.
+const char* applyTransfer(const Transaction& tx, std::uint64_t chainId, bool self, Account& from, Account& to) {
+    if (const char* err = transferError(tx, from, chainId)) {
+        return err;
+    }
+    from.balance -= tx.value;
+    from.nonce   += 1;
+    if (self) {
+        from.balance += tx.value;
+    } else {
+        to.balance += tx.value;
+    }
+    return nullptr;
+}
+
+// ---------- Multi-version memory ----------
+
+struct MvEntry {
+    std::uint32_t incarnation{0};
+    Account value;
+    bool estimate{false};   // writer was aborted; readers must wait for it
+};
+
+struct MvSlot {
+    std::mutex mu;
+    std::map<std::size_t, MvEntry> versions;   // keyed by tx index
+    bool baseLoaded{false};
+    Account base;
+};
+
+struct ReadDescriptor {
+    std::size_t slot;
+    std::size_t txIdx;          // kStorage => value came from the base state
+    std::uint32_t incarnation;
+};
+
+enum class Status { ReadyToExecute, Executing, Executed, Aborting };
+
+struct TxState {
+    std::mutex mu;              // guards incarnation + status
+    std::uint32_t incarnation{0};
+    Status status{Status::ReadyToExecute};
+
+    std::mutex depMu;           // guards dependents
+    std::vector<std::size_t> dependents;
+
+    std::mutex outMu;           // guards last incarnation's output
+    std::vector<ReadDescriptor> reads;
+    std::vector<std::size_t> writtenSlots;
+    const char* error{nullptr};   // why the last incarnation failed
+};
+
+struct Task {
+    enum Kind { None, Execute, Validate } kind{None};
+    std::size_t idx{0};
+    std::uint32_t incarnation{0};
+};
+
+void fetchMin(std::atomic<std::size_t>& a, std::size_t v) {
+    std::size_t cur = a.load();
+    while (v < cur && !a.compare_exchange_weak(cur, v)) {
+    }
+}
+
+class BlockStm {
+public:
+    BlockStm(const ParallelExecutor::AccountReader& base, const std::vector<Transaction>& txs, std::uint64_t chainId)
+        : base_(base), txs_(txs), chainId_(chainId), n_(txs.size()),
+          fromSlot_(txs.size()), toSlot_(txs.size()),
+          tx_(new TxState[txs.size()])
+    {
+        std::unordered_map<Address, std::size_t, AddressHash> slotOf;
+        auto slotFor = [&](const Address& a) {
+            auto it = slotOf.find(a);
+            if (it != slotOf.end()) return it->second;
+            std::size_t s = slotAddrs_.size();
+            slotOf.emplace(a, s);
+            slotAddrs_.push_back(a);
+            return s;
+        };
+        for (std::size_t i = 0; i < n_; ++i) {
+            fromSlot_[i] = slotFor(txs[i].from);
+            toSlot_[i]   = slotFor(txs[i].to);
+        }
+        slots_.reset(new MvSlot[slotAddrs_.size()]);
+    }
+
+    void worker() {
+        Task task;
+        while (!done_.load()) {
+            if (task.kind == Task::Execute) {
+                task = tryExecute(task);
+            } else if (task.kind == Task::Validate) {
+                task = needsReexecution(task);
+            } else {
+                task = nextTask();
+                if (task.kind == Task::None) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    ExecutionResult result() const {
+        ExecutionResult res;
+        for (std::size_t i = 0; i < n_; ++i) {
+            if (tx_[i].error) {
+                res.ok = false;
+                res.failedIndex = i;
+                res.error = tx_[i].error;
+                return res;
+            }
+        }
+        res.writes.reserve(slotAddrs_.size());
+        for (std::size_t s = 0; s < slotAddrs_.size(); ++s) {
+            const auto& versions = slots_[s].versions;
+            if (!versions.empty()) {
+                res.writes.emplace_back(slotAddrs_[s], versions.rbegin()->second.value);
+            }
+        }
+        return res;
+    }
+
+private:
+    const ParallelExecutor::AccountReader& base_;
+    const std::vector<Transaction>& txs_;
+    const std::uint64_t chainId_;
+    const std::size_t n_;
+
+    std::vector<Address> slotAddrs_;
+    std::vector<std::size_t> fromSlot_;
+    std::vector<std::size_t> toSlot_;
+    std::unique_ptr<MvSlot[]> slots_;
+    std::unique_ptr<TxState[]> tx_;
+
+    std::atomic<std::size_t> executionIdx_{0};
+    std::atomic<std::size_t> validationIdx_{0};
+    std::atomic<std::size_t> decreaseCnt_{0};
+    std::atomic<long> numActiveTasks_{0};
+    std::atomic<bool> done_{false};
+
+    // ---------- MVMemory ----------
+
+    enum class ReadStatus { Ok, Storage, Dependency };
+
+    struct ReadResult {
+        ReadStatus status;
+        std::size_t txIdx;
+        std::uint32_t incarnation;
+        Account value;
+    };
+
+    ReadResult mvRead(std::size_t slot, std::size_t txIdx) {
+        MvSlot& s = slots_[slot];
+        std::lock_guard<std::mutex> lock(s.mu);
+
+        auto it = s.versions.lower_bound(txIdx);
+        if (it == s.versions.begin()) {
+            if (!s.baseLoaded) {
+                s.base = base_(slotAddrs_[slot]).value_or(Account{});
+                s.baseLoaded = true;
+            }
+            return {ReadStatus::Storage, kStorage, 0, s.base};
+        }
+        --it;
+        if (it->second.estimate) {
+            return {ReadStatus::Dependency, it->first, 0, Account{}};
+        }
+        return {ReadStatus::Ok, it->first, it->second.incarnation, it->second.value};
+    }
+
+    // Apply a new incarnation's output. Returns true if it wrote an account
+    // the previous incarnation did not (lower validations must be redone).
+    bool mvRecord(std::size_t idx, std::uint32_t inc,
+                  std::vector<ReadDescriptor> reads,
+                  const std::vector<std::pair<std::size_t, Account>>& writes,
+                  const char* error)
+    {
+        TxState& t = tx_[idx];
+        std::vector<std::size_t> prev;
+        {
+            std::lock_guard<std::mutex> lock(t.outMu);
+            prev = t.writtenSlots;
+        }
+
+        bool wroteNew = false;
+        std::vector<std::size_t> now;
+        now.reserve(writes.size());
+        for (const auto& [slot, value] : writes) {
+            {
+                std::lock_guard<std::mutex> lock(slots_[slot].mu);
+                slots_[slot].versions[idx] = MvEntry{inc, value, false};
+            }
+            now.push_back(slot);
+            if (std::find(prev.begin(), prev.end(), slot) == prev.end()) {
+                wroteNew = true;
+            }
+        }
+        for (std::size_t slot : prev) {
+            if (std::find(now.begin(), now.end(), slot) == now.end()) {
+                std::lock_guard<std::mutex> lock(slots_[slot].mu);
+                slots_[slot].versions.erase(idx);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(t.outMu);
+        t.reads = std::move(reads);
+        t.writtenSlots = std::move(now);
+        t.error = error;
+        return wroteNew;
+    }
+
+    void mvConvertWritesToEstimates(std::size_t idx) {
+        std::vector<std::size_t> written;
+        {
+            std::lock_guard<std::mutex> lock(tx_[idx].outMu);
+            written = tx_[idx].writtenSlots;
+        }
+        for (std::size_t slot : written) {
+            std::lock_guard<std::mutex> lock(slots_[slot].mu);
+            slots_[slot].versions[idx].estimate = true;
+        }
+    }
+
+    bool mvValidateReadSet(std::size_t idx) {
+        std::vector<ReadDescriptor> reads;
+        {
+            std::lock_guard<std::mutex> lock(tx_[idx].outMu);
+            reads = tx_[idx].reads;
+        }
+        for (const auto& rd : reads) {
+            ReadResult r = mvRead(rd.slot, idx);
+            if (r.status == ReadStatus::Dependency) return false;
+            if (r.status == ReadStatus::Storage && rd.txIdx != kStorage) return false;
+            if (r.status == ReadStatus::Ok &&
+                (rd.txIdx != r.txIdx || rd.incarnation != r.incarnation)) return false;
+        }
+        return true;
+    }
+
+    // ---------- Scheduler ----------
+
+    void decreaseExecutionIdx(std::size_t target) {
+        fetchMin(executionIdx_, target);
+        decreaseCnt_++;
+    }
+
+    void decreaseValidationIdx(std::size_t target) {
+        fetchMin(validationIdx_, target);
+        decreaseCnt_++;
+    }
+
+    void checkDone() {
+        std::size_t observed = decreaseCnt_.load();
+        if (std::min(executionIdx_.load(), validationIdx_.load()) >= n_ &&
+            numActiveTasks_.load() == 0 &&
+            observed == decreaseCnt_.load())
+        {
+            done_ = true;
+        }
+    }
+
+    Task tryIncarnate(std::size_t idx) {
+        if (idx < n_) {
+            std::lock_guard<std::mutex> lock(tx_[idx].mu);
+            if (tx_[idx].status == Status::ReadyToExecute) {
+                tx_[idx].status = Status::Executing;
+                return Task{Task::Execute, idx, tx_[idx].incarnation};
+            }
+        }
+        return Task{};
+    }
+
+    Task nextVersionToExecute() {
+        if (executionIdx_.load() >= n_) {
+            checkDone();
+            return Task{};
+        }
+        numActiveTasks_++;
+        Task t = tryIncarnate(executionIdx_.fetch_add(1));
+        if (t.kind == Task::None) numActiveTasks_--;
+        return t;
+    }
+
+    Task nextVersionToValidate() {
+        if (validationIdx_.load() >= n_) {
+            checkDone();
+            return Task{};
+        }
+        numActiveTasks_++;
+        std::size_t idx = validationIdx_.fetch_add(1);
+        if (idx < n_) {
+            std::lock_guard<std::mutex> lock(tx_[idx].mu);
+            if (tx_[idx].status == Status::Executed) {
+                return Task{Task::Validate, idx, tx_[idx].incarnation};
+            }
+        }
+        numActiveTasks_--;
+        return Task{};
+    }
+
+    Task nextTask() {
+        if (validationIdx_.load() < executionIdx_.load()) {
+            return nextVersionToValidate();
+        }
+        return nextVersionToExecute();
+    }
+
+    // Park `idx` until `blocking` finishes executing. Returns false if
+    // `blocking` already finished (caller should simply retry).
+    bool addDependency(std::size_t idx, std::size_t blocking) {
+        std::lock_guard<std::mutex> depLock(tx_[blocking].depMu);
+        {
+            std::lock_guard<std::mutex> lock(tx_[blocking].mu);
+            if (tx_[blocking].status == Status::Executed) {
+                return false;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(tx_[idx].mu);
+            tx_[idx].status = Status::Aborting;
+        }
+        tx_[blocking].dependents.push_back(idx);
+        numActiveTasks_--;
+        return true;
+    }
+
+    void setReadyStatus(std::size_t idx) {
+        std::lock_guard<std::mutex> lock(tx_[idx].mu);
+        tx_[idx].incarnation += 1;
+        tx_[idx].status = Status::ReadyToExecute;
+    }
+
+    Task finishExecution(std::size_t idx, std::uint32_t inc, bool wroteNew) {
+        {
+            std::lock_guard<std::mutex> lock(tx_[idx].mu);
+            tx_[idx].status = Status::Executed;
+        }
+        std::vector<std::size_t> deps;
+        {
+            std::lock_guard<std::mutex> lock(tx_[idx].depMu);
+            deps.swap(tx_[idx].dependents);
+        }
+        if (!deps.empty()) {
+            for (std::size_t d : deps) setReadyStatus(d);
+            decreaseExecutionIdx(*std::min_element(deps.begin(), deps.end()));
+        }
+
+        if (validationIdx_.load() > idx) {
+            if (wroteNew) {
+                decreaseValidationIdx(idx);
+            } else {
+                return Task{Task::Validate, idx, inc};
+            }
+        }
+        numActiveTasks_--;
+        return Task{};
+    }
+
+    bool tryValidationAbort(std::size_t idx, std::uint32_t inc) {
+        std::lock_guard<std::mutex> lock(tx_[idx].mu);
+        if (tx_[idx].incarnation == inc && tx_[idx].status == Status::Executed) {
+            tx_[idx].status = Status::Aborting;
+            return true;
+        }
+        return false;
+    }
+
+    Task finishValidation(std::size_t idx, bool aborted) {
+        if (aborted) {
+            setReadyStatus(idx);
+            decreaseValidationIdx(idx + 1);
+            if (executionIdx_.load() > idx) {
+                Task t = tryIncarnate(idx);
+                if (t.kind != Task::None) return t;
+            }
+        }
+        numActiveTasks_--;
+        return Task{};
+    }
+
+    // ---------- Task bodies ----------
+
+    Task tryExecute(const Task& task) {
+        const std::size_t idx = task.idx;
+        const Transaction& tx = txs_[idx];
+        const bool self = fromSlot_[idx] == toSlot_[idx];
+
+        while (true) {
+            std::vector<ReadDescriptor> reads;
+            std::size_t blocking = kStorage;
+
+            auto read = [&](std::size_t slot, Account& out) {
+                ReadResult r = mvRead(slot, idx);
+                if (r.status == ReadStatus::Dependency) {
+                    blocking = r.txIdx;
+                    return false;
+                }
+                reads.push_back({slot, r.txIdx, r.incarnation});
+                out = r.value;
+                return true;
+            };
+
+            Account from, to;
+            bool readOk = read(fromSlot_[idx], from) && (self || read(toSlot_[idx], to));
+            if (!readOk) {
+                if (addDependency(idx, blocking)) {
+                    return Task{};
+                }
+                continue;
+            }
+
+            std::vector<std::pair<std::size_t, Account>> writes;
+            const char* error = applyTransfer(tx, chainId_, self, from, to);
+            if (!error) {
+                writes.emplace_back(fromSlot_[idx], from);
+                if (!self) writes.emplace_back(toSlot_[idx], to);
+            }
+
+            bool wroteNew = mvRecord(idx, task.incarnation, std::move(reads), writes, error);
+            return finishExecution(idx, task.incarnation, wroteNew);
+        }
+    }
+
+    Task needsReexecution(const Task& task) {
+        bool valid = mvValidateReadSet(task.idx);
+        bool aborted = !valid && tryValidationAbort(task.idx, task.incarnation);
+        if (aborted) {
+            mvConvertWritesToEstimates(task.idx);
+        }
+        return finishValidation(task.idx, aborted);
+    }
+};
+
+} // namespace
+
+// Helper threads that join the calling thread on a block
+class ParallelExecutor::WorkerPool {
+public:
+    explicit WorkerPool(std::size_t helpers) : helpers_(helpers) {}
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto& t : threads_) t.join();
+    }
+
+    // Runs `job` on the caller and every helper and returns once all of
+    // them are out of it; false (job not run) if another block holds the
+    // pool
+    bool tryRun(const std::function<void()>& job) {
+        std::unique_lock<std::mutex> run(runMutex_, std::try_to_lock);
+        if (!run.owns_lock()) {
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (threads_.empty()) {
+                threads_.reserve(helpers_);
+                for (std::size_t i = 0; i < helpers_; ++i) {
+                    threads_.emplace_back(&WorkerPool::loop, this);
+                }
+            }
+            job_ = &job;
+            ++jobId_;
+        }
+        wake_.notify_all();
+
+        job();
+
+        // A helper that wakes after this point skips the job
+        std::unique_lock<std::mutex> lock(mutex_);
+        job_ = nullptr;
+        idle_.wait(lock, [&] { return active_ == 0; });
+        return true;
+    }
+
+private:
+    std::size_t helpers_;
+    std::vector<std::thread> threads_;
+    std::mutex runMutex_;               // held by the caller whose block is on the pool
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    const std::function<void()>* job_{nullptr};
+    std::uint64_t jobId_{0};
+    std::size_t active_{0};
+    bool stopping_{false};
+
+    void loop() {
+        std::uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            wake_.wait(lock, [&] { return stopping_ || jobId_ != seen; });
+            if (stopping_) return;
+            seen = jobId_;
+            const std::function<void()>* job = job_;
+            if (!job) continue;
+            ++active_;
+            lock.unlock();
+
+            (*job)();
+
+            lock.lock();
+            --active_;
+            idle_.notify_all();
+        }
+    }
+};
+
+const char* transferError(const Transaction& tx, const Account& from, std::uint64_t chainId) {
+    if (chainId != 0 && tx.chainId != chainId) {
+        return "Invalid chainId";
+    }
+    if (tx.nonce != from.nonce) {
+        return "Invalid nonce";
+    }
+    if (from.balance < tx.value) {
+        return "Insufficient balance";
+    }
+    return nullptr;
+}
+
+ParallelExecutor::ParallelExecutor(std::size_t threads, std::uint64_t chainId)
+    : threads_(threads), chainId_(chainId)
+{
+    if (threads_ == 0) {
+        threads_ = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (threads_ > 1) {
+        pool_ = std::make_shared<WorkerPool>(threads_ - 1);
+    }
+}
+
+ExecutionResult ParallelExecutor::execute(const State& base, const std::vector<Transaction>& txs) const {
+    return execute([&base](const Address& a) -> std::optional<Account> {
+        const Account* acc = base.get(a);
+        return acc ? std::optional<Account>(*acc) : std::nullopt;
+    }, txs);
+}
+
+ExecutionResult ParallelExecutor::execute(const AccountReader& base, const std::vector<Transaction>& txs) const {
+    if (threads_ <= 1 || txs.size() < kMinParallelTxs) {
+        return executeSerial(base, txs);
+    }
+    return executeParallel(base, txs);
+}
+
+ExecutionResult ParallelExecutor::executeSerial(const AccountReader& base, const std::vector<Transaction>& txs) const {
+    ExecutionResult res;
+    std::unordered_map<Address, Account, AddressHash> overlay;
+    std::vector<Address> order;
+
+    auto load = [&](const Address& a) -> Account& {
+        auto it = overlay.find(a);
+        if (it != overlay.end()) return it->second;
+        order.push_back(a);
+        return overlay.emplace(a, base(a).value_or(Account{})).first->second;
+    };
+
+    for (std::size_t i = 0; i < txs.size(); ++i) {
+        const Transaction& tx = txs[i];
+        Account& from = load(tx.from);
+        Account& to   = load(tx.to);
+        if (const char* error = applyTransfer(tx, chainId_, tx.from == tx.to, from, to)) {
+            res.ok = false;
+            res.failedIndex = i;
+            res.error = error;
+            return res;
+        }
+    }
+
+    res.writes.reserve(order.size());
+    for (const auto& a : order) {
+        res.writes.emplace_back(a, overlay[a]);
+    }
+    return res;
+}
+
+ExecutionResult ParallelExecutor::executeParallel(const AccountReader& base, const std::vector<Transaction>& txs) const {
+    BlockStm stm(base, txs, chainId_);
+
+    std::function<void()> job = [&stm] { stm.worker(); };
+    if (!pool_->tryRun(job)) {
+        job();
+    }
+
+    return stm.result();
+}
+
+} // namespace gambit
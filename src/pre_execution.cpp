@@ -0,0 +1,114 @@
+#include "gambit/pre_execution.hpp"
+#include <unordered_set>
+
+namespace gambit {
+
+namespace {
+
+bool sameAccount(const Account& a, const Account& b) {
+    return a.balance == b.balance && a.nonce == b.nonce;
+}
+
+} // namespace
+
+ExecutionResult PreExecutionCache::run(const State& head, const std::vector<Transaction>& pending) {
+    stats_ = Stats{};
+    ++runs_;
+
+    // Accounts written so far in this run
+    std::unordered_map<Address, Account, AddressHash> overlay;
+    std::vector<Address> order;
+    auto current = [&](const Address& a) -> Account {
+        auto it = overlay.find(a);
+        if (it != overlay.end()) return it->second;
+        const Account* acc = head.get(a);
+        return acc ? *acc : Account{};
+    };
+    // The entry saw what this run has for `a`: the same value from an
+    // earlier transaction, or the head for both (which only changes
+    // through invalidate(), so it is not read again)
+    auto unchanged = [&](const Address& a, bool fromHead, const Account& seen) {
+        auto it = overlay.find(a);
+        if (it == overlay.end()) return fromHead;
+        return sameAccount(it->second, seen);
+    };
+    auto write = [&](const Address& a, const Account& acc) {
+        auto [it, inserted] = overlay.insert_or_assign(a, acc);
+        if (inserted) order.push_back(a);
+    };
+
+    ExecutionResult res;
+    for (std::size_t i = 0; i < pending.size(); ++i) {
+        const Transaction& tx = pending[i];
+        auto cached = entries_.find(tx.hash);
+
+        bool reusable = cached != entries_.end()
+            && unchanged(tx.from, cached->second.fromHead, cached->second.readFrom)
+            && unchanged(tx.to, cached->second.toHead, cached->second.readTo);
+
+        if (reusable) {
+            ++stats_.reused;
+        } else {
+            // Same transfer semantics as State::applyTransaction
+            Account from = current(tx.from);
+            Account to   = current(tx.to);
+            Entry e{tx.from, tx.to, !overlay.count(tx.from), !overlay.count(tx.to), from, to, from, to,
+                    transferError(tx, from, chainId_)};
+            if (!e.error) {
+                e.writeFrom.balance -= tx.value;
+                e.writeFrom.nonce   += 1;
+                if (tx.from == tx.to) {
+                    e.writeFrom.balance += tx.value;
+                    e.writeTo = e.writeFrom;
+                } else {
+                    e.writeTo.balance += tx.value;
+                }
+            }
+            cached = entries_.insert_or_assign(tx.hash, e).first;
+            ++stats_.executed;
+        }
+
+        Entry& e = cached->second;
+        e.run = runs_;
+        if (e.error) {
+            res.ok = false;
+            res.failedIndex = i;
+            res.error = e.error;
+            return res;
+        }
+        write(tx.from, e.writeFrom);
+        if (tx.from != tx.to) {
+            write(tx.to, e.writeTo);
+        }
+    }
+
+    // Transactions that left the pool
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        it = it->second.run == runs_ ? std::next(it) : entries_.erase(it);
+    }
+
+    res.writes.reserve(order.size());
+    for (const auto& a : order) {
+        res.writes.emplace_back(a, overlay[a]);
+    }
+    return res;
+}
+
+bool PreExecutionCache::covers(const std::vector<Transaction>& pending) const {
+    for (const Transaction& tx : pending) {
+        if (!entries_.count(tx.hash)) return false;
+    }
+    return true;
+}
+
+void PreExecutionCache::invalidate(const SnapshotBase::Entries& writes) {
+    if (writes.empty() || entries_.empty()) return;
+    std::unordered_set<Address, AddressHash> written;
+    for (const auto& [addr, acc] : writes) written.insert(addr);
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        const Entry& e = it->second;
+        it = written.count(e.from) || written.count(e.to) ? entries_.erase(it) : std::next(it);
+    }
+}
+
+} // namespace gambit
@@ -1,4 +1,6 @@
 #include "gambit/receipt.hpp"
+#include <algorithm>
+#include <stdexcept>
 
 namespace gambit {
 
@@ -16,7 +18,7 @@ Bytes Receipt::rlpEncode() const {
         lf.push_back(encodeBytes(Bytes(log.address.bytes().begin(), log.address.bytes().end())));
         std::vector<Bytes> topicBytes;
         for (const auto& t : log.topics) {
-            topicBytes.push_back(encodeBytes(fromHex(t)));
+            topicBytes.push_back(encodeHash(t));
         }
         lf.push_back(encodeList(topicBytes));
         lf.push_back(encodeBytes(log.data));
@@ -27,4 +29,37 @@ Bytes Receipt::rlpEncode() const {
     return encodeList(fields);
 }
 
+Receipt Receipt::rlpDecode(const rlp::Decoded& item) {
+    if (!item.isList || item.list.size() != 3 || !item.list[2].isList) {
+        throw std::runtime_error("Receipt::rlpDecode: invalid RLP receipt");
+    }
+    auto toUint = [](const Bytes& b) -> std::uint64_t {
+        std::uint64_t v = 0;
+        for (std::uint8_t c : b) v = (v << 8) | c;
+        return v;
+    };
+
+    Receipt r;
+    r.status = toUint(item.list[0].bytes) != 0;
+    r.cumulativeGasUsed = toUint(item.list[1].bytes);
+    for (const auto& l : item.list[2].list) {
+        if (!l.isList || l.list.size() != 3) {
+            throw std::runtime_error("Receipt::rlpDecode: invalid RLP log");
+        }
+        Log log;
+        log.address = Address::fromBytes(l.list[0].bytes);
+        for (const auto& t : l.list[1].list) {
+            if (t.bytes.size() != 32) {
+                throw std::runtime_error("Receipt::rlpDecode: invalid topic");
+            }
+            Bytes32 topic;
+            std::copy(t.bytes.begin(), t.bytes.end(), topic.begin());
+            log.topics.push_back(topic);
+        }
+        log.data = l.list[2].bytes;
+        r.logs.push_back(std::move(log));
+    }
+    return r;
+}
+
 } // namespace gambit
@@ -35,6 +35,14 @@ Bytes encodeBytes(const Bytes& input) {
     return out;
 }
 
+Bytes encodeHash(const Bytes32& input) {
+    Bytes out;
+    out.reserve(33);
+    out.push_back(0x80 + 32);
+    out.insert(out.end(), input.begin(), input.end());
+    return out;
+}
+
 Bytes encodeString(const std::string& input) {
     Bytes bytes(input.begin(), input.end());
     return encodeBytes(bytes);
@@ -54,6 +62,12 @@ Bytes encodeUint(std::uint64_t value) {
     return encodeBytes(tmp);
 }
 
+Bytes encodeUint(const uint256& value) {
+    std::uint8_t buf[32];
+    std::size_t len = value.toBigEndian(buf);
+    return encodeBytes(Bytes(buf, buf + len));
+}
+
 Bytes encodeList(const std::vector<Bytes>& items) {
     Bytes payload;
     for (const auto& item : items) {
@@ -133,5 +147,39 @@ Decoded decode(const Bytes& in) {
     return decode(in, off);
 }
 
+ItemRef peek(const std::uint8_t* p, std::size_t n) {
+    if (n == 0) throw std::runtime_error("RLP peek overflow");
+
+    ItemRef item;
+    item.begin = p;
+    std::uint8_t prefix = p[0];
+    std::size_t header = 1;
+
+    if (prefix < 0x80) {
+        item.payload = p;
+        item.length = 1;
+        item.size = 1;
+        return item;
+    }
+
+    item.isList = prefix >= 0xC0;
+    std::size_t len = prefix - (item.isList ? 0xC0 : 0x80);
+    if (len > 55) {
+        std::size_t numBytes = len - 55;
+        if (1 + numBytes > n) throw std::runtime_error("RLP long length overflow");
+        len = 0;
+        for (std::size_t i = 0; i < numBytes; ++i) {
+            len = (len << 8) | p[1 + i];
+        }
+        header += numBytes;
+    }
+    if (len > n - header) throw std::runtime_error("RLP item overflow");
+
+    item.payload = p + header;
+    item.length = len;
+    item.size = header + len;
+    return item;
+}
+
 } // namespace rlp
 } // namespace gambit
@@ -7,6 +7,7 @@
 #include "nlohmann/json.hpp"
 
 #include <map>
+#include <optional>
 
 #ifdef _WIN32
 #include <winsock2.h>
@@ -29,6 +30,46 @@ using json = nlohmann::json;
 namespace gambit
 {
 
+    // Hashes are binary in the core; JSON carries them as "0x" + 64 hex digits
+    static std::string hashToJson(const Bytes32 &hash)
+    {
+        return "0x" + toHex(hash);
+    }
+
+    // JSON-RPC quantities are minimal hex: 0 is "0x0", 200 is "0xc8"
+    static std::string quantityToJson(std::uint64_t v)
+    {
+        char buf[24];
+        std::snprintf(buf, sizeof(buf), "0x%llx", static_cast<unsigned long long>(v));
+        return buf;
+    }
+
+    static std::optional<Bytes32> hashFromJson(const std::string &hex)
+    {
+        try
+        {
+            return fromHex32(hex);
+        }
+        catch (const std::exception &)
+        {
+            return std::nullopt;
+        }
+    }
+
+    // Block objects are served from the header alone; bodies stay cold
+    static std::string headerToJson(const BlockHeader &h, const Bytes32 &hash)
+    {
+        return "{"
+               "\"number\":\"" + quantityToJson(h.index) + "\","
+               "\"hash\":\"" + hashToJson(hash) + "\","
+               "\"parentHash\":\"" + hashToJson(h.prevHash) + "\","
+               "\"stateRoot\":\"" + hashToJson(h.stateAfter) + "\","
+               "\"txRoot\":\"" + hashToJson(h.txRoot) + "\","
+               "\"receiptsRoot\":\"" + hashToJson(h.receiptsRoot) + "\","
+               "\"timestamp\":\"" + quantityToJson(h.timestamp) + "\""
+               "}";
+    }
+
     RpcServer::RpcServer(Blockchain &chain, std::uint16_t port)
         : chain_(chain), port_(port) {}
 
@@ -179,7 +220,8 @@ namespace gambit
             else if (method == "eth_getBalance")
             {
                 std::string addr = req["params"][0];
-                return handle_getBalance(id, addr);
+                std::string tag = req["params"].size() > 1 ? req["params"][1].get<std::string>() : "latest";
+                return handle_getBalance(id, addr, tag);
             }
             else if (method == "eth_sendRawTransaction")
             {
@@ -208,10 +250,31 @@ namespace gambit
                 std::string h = req["params"][0];
                 return handle_getTransactionByHash(id, h);
             }
+            else if (method == "eth_getTransactionReceipt")
+            {
+                std::string h = req["params"][0];
+                return handle_getTransactionReceipt(id, h);
+            }
+            else if (method == "gambit_getTransactionProof")
+            {
+                std::string h = req["params"][0];
+                return handle_getTransactionProof(id, h);
+            }
+            else if (method == "gambit_getAddressTransactions")
+            {
+                // [address, {"limit": n, "cursor": "0x..", "order": "asc" | "desc"}]
+                std::string addr = req["params"][0];
+                json opts = req["params"].size() > 1 ? req["params"][1] : json::object();
+                std::size_t limit = opts.value("limit", std::size_t(100));
+                std::string cursor = opts.value("cursor", std::string());
+                bool newestFirst = opts.value("order", std::string("desc")) != "asc";
+                return handle_getAddressTransactions(id, addr, limit, cursor, newestFirst);
+            }
             else if (method == "eth_getTransactionCount")
             {
                 std::string addr = req["params"][0];
-                return handle_getTransactionCount(id, addr);
+                std::string tag = req["params"].size() > 1 ? req["params"][1].get<std::string>() : "latest";
+                return handle_getTransactionCount(id, addr, tag);
             }
 
             // TODO: miner_start, miner_stop, miner_setInterval, eth_getWork, eth_submitWork
@@ -229,29 +292,47 @@ namespace gambit
 
     std::string RpcServer::handle_blockNumber(const std::string &id)
     {
-        std::uint64_t height = chain_.chain().empty() ? 0 : chain_.chain().back().index;
+        std::uint64_t height = chain_.view()->height;
         // Return as hex, like eth_blockNumber
-        char buf[32];
-        std::snprintf(buf, sizeof(buf), "0x%llx", static_cast<unsigned long long>(height));
-        return jsonResult(id, "\"" + std::string(buf) + "\"");
+        return jsonResult(id, "\"" + quantityToJson(height) + "\"");
     }
 
-    std::string RpcServer::handle_getBalance(const std::string &id, const std::string &addrHex)
+    std::optional<Account> RpcServer::accountForTag(const Address &addr, const std::string &blockTag)
     {
-        try
+        if (blockTag == "latest" || blockTag == "pending")
         {
-            Address addr = Address::fromHex(addrHex);
-            const Account *acc = chain_.state().get(addr);
-            std::uint64_t bal = acc ? acc->balance : 0;
+            return chain_.view()->state.get(addr);
+        }
+        std::uint64_t height = blockTag == "earliest" ? 0 : std::stoull(blockTag, nullptr, 16);
+        return chain_.accountAt(addr, height);
+    }
 
-            char buf[64];
-            std::snprintf(buf, sizeof(buf), "0x%llx", static_cast<unsigned long long>(bal));
-            return jsonResult(id, "\"" + std::string(buf) + "\"");
+    std::string RpcServer::handle_getBalance(const std::string &id, const std::string &addrHex, const std::string &blockTag)
+    {
+        Address addr;
+        try
+        {
+            addr = Address::fromHex(addrHex);
         }
         catch (...)
         {
             return jsonError(id, -32602, "Invalid address");
         }
+
+        try
+        {
+            std::optional<Account> acc = accountForTag(addr, blockTag);
+            uint256 bal = acc ? acc->balance : uint256();
+            return jsonResult(id, "\"" + bal.toHex() + "\"");
+        }
+        catch (const std::out_of_range &e)
+        {
+            return jsonError(id, -32000, e.what());
+        }
+        catch (...)
+        {
+            return jsonError(id, -32602, "Invalid block tag");
+        }
     }
 
     std::string RpcServer::handle_sendRawTransaction(const std::string &id, const std::string &txHex)
@@ -266,10 +347,17 @@ namespace gambit
                 return jsonError(id, -32000, err);
             }
 
-            chain_.addTransaction(tx);
+            try
+            {
+                chain_.addTransaction(tx);
+            }
+            catch (const std::runtime_error &e)
+            {
+                // Rejected by the mempool
+                return jsonError(id, -32000, e.what());
+            }
 
-            std::string txHash = tx.hash.empty() ? tx.computeHash() : tx.hash;
-            return jsonResult(id, "\"" + txHash + "\"");
+            return jsonResult(id, "\"" + hashToJson(tx.hash) + "\"");
         }
         catch (const std::exception &e)
         {
@@ -281,141 +369,283 @@ namespace gambit
     {
         uint64_t num = std::stoull(numHex, nullptr, 16);
 
-        const auto &chain = chain_.chain();
-        if (num >= chain.size())
+        if (num > chain_.view()->height || num < chain_.firstBlock())
         {
             return jsonResult(id, "null");
         }
 
-        const Block &b = chain[num];
-
-        std::string out = "{"
-                          "\"number\":\"0x" +
-                          numHex + "\","
-                                   "\"hash\":\"" +
-                          b.hash + "\","
-                                   "\"parentHash\":\"" +
-                          b.prevHash + "\","
-                                       "\"stateRoot\":\"" +
-                          b.stateAfter + "\","
-                                         "\"txRoot\":\"" +
-                          b.txRoot + "\","
-                                     "\"timestamp\":\"0x" +
-                          toHex(rlp::encodeUint(b.timestamp)) + "\""
-                                                                "}";
-
-        return jsonResult(id, out);
+        BlockHeader h = chain_.headerAt(num);
+        return jsonResult(id, headerToJson(h, h.computeHash()));
     }
 
     std::string RpcServer::handle_getBlockByHash(const std::string &id, const std::string &hashHex)
     {
-        std::cout << "[DEBUG] Searching for hash: " << hashHex << "\n";
-        
-        const auto &chain = chain_.chain();
-        std::cout << "[DEBUG] Chain has " << chain.size() << " blocks\n";
-        
-        for (const auto &b : chain)
-        {
-            std::cout << "[DEBUG] Block #" << b.index << " hash: " << b.hash << "\n";
-            
-            // Normalize hashes for comparison (strip 0x prefix)
-            std::string storedHash = b.hash;
-            std::string searchHash = hashHex;
-            
-            if (storedHash.rfind("0x", 0) == 0 || storedHash.rfind("0X", 0) == 0)
-                storedHash = storedHash.substr(2);
-            
-            if (searchHash.rfind("0x", 0) == 0 || searchHash.rfind("0X", 0) == 0)
-                searchHash = searchHash.substr(2);
-            
-            if (storedHash == searchHash)
-            {
-                std::cout << "[DEBUG] FOUND BLOCK #" << b.index << "\n";
-                std::string out = "{"
-                                  "\"number\":\"0x" + toHex(rlp::encodeUint(b.index)) + "\","
-                                  "\"hash\":\"0x" + b.hash + "\","
-                                  "\"parentHash\":\"0x" + b.prevHash + "\","
-                                  "\"stateRoot\":\"0x" + b.stateAfter + "\","
-                                  "\"txRoot\":\"0x" + b.txRoot + "\","
-                                  "\"timestamp\":\"0x" + toHex(rlp::encodeUint(b.timestamp)) + "\""
-                                  "}";
-                return jsonResult(id, out);
-            }
+        std::optional<Bytes32> hash = hashFromJson(hashHex);
+        if (!hash)
+        {
+            return jsonError(id, -32602, "Invalid block hash");
         }
-        std::cout << "[DEBUG] No matching block found\n";
-        return jsonResult(id, "null");
+        std::optional<BlockHeader> h = chain_.headerByHash(*hash);
+        if (!h)
+        {
+            return jsonResult(id, "null");
+        }
+        return jsonResult(id, headerToJson(*h, *hash));
     }
 
     std::string RpcServer::handle_getTransactionByHash(const std::string &id, const std::string &hashHex)
     {
-        // Search mempool
-        for (const auto &tx : chain_.mempool())
+        std::optional<Bytes32> hash = hashFromJson(hashHex);
+        if (!hash)
         {
-            if (tx.hash == hashHex)
-            {
-                std::string out = "{"
-                                  "\"hash\":\"" +
-                                  tx.hash + "\","
-                                            "\"from\":\"" +
-                                  tx.from.toHex() + "\","
-                                                    "\"to\":\"" +
-                                  tx.to.toHex() + "\","
-                                                  "\"value\":\"0x" +
-                                  toHex(rlp::encodeUint(tx.value)) + "\","
-                                                                     "\"nonce\":\"0x" +
-                                  toHex(rlp::encodeUint(tx.nonce)) + "\""
-                                                                     "}";
-                return jsonResult(id, out);
-            }
+            return jsonError(id, -32602, "Invalid transaction hash");
+        }
+
+        // Mined transactions
+        if (auto loc = chain_.transactionBlock(*hash))
+        {
+            const BlockView &b = loc->block;
+            Transaction tx = b.transaction(loc->position);
+            std::string out = "{"
+                              "\"hash\":\"" +
+                              hashToJson(tx.hash) + "\","
+                                        "\"blockHash\":\"" +
+                              hashToJson(b.hash()) + "\","
+                                         "\"blockNumber\":\"" +
+                              quantityToJson(b.index()) + "\","
+                                                                  "\"transactionIndex\":\"" +
+                              quantityToJson(loc->position) + "\","
+                                                                      "\"from\":\"" +
+                              tx.from.toHex() + "\","
+                                                "\"to\":\"" +
+                              tx.to.toHex() + "\","
+                                              "\"value\":\"" +
+                              tx.value.toHex() + "\","
+                                                 "\"nonce\":\"" +
+                              quantityToJson(tx.nonce) + "\""
+                                                                 "}";
+            return jsonResult(id, out);
         }
 
-        // Search blocks
-        for (const auto &b : chain_.chain())
+        // Pending transactions
+        if (std::optional<Transaction> tx = chain_.pool().find(*hash))
         {
-            for (const auto &tx : b.transactions)
+            std::string out = "{"
+                              "\"hash\":\"" +
+                              hashToJson(tx->hash) + "\","
+                                         "\"from\":\"" +
+                              tx->from.toHex() + "\","
+                                                 "\"to\":\"" +
+                              tx->to.toHex() + "\","
+                                               "\"value\":\"" +
+                              tx->value.toHex() + "\","
+                                                  "\"nonce\":\"" +
+                              quantityToJson(tx->nonce) + "\""
+                                                                  "}";
+            return jsonResult(id, out);
+        }
+
+        return jsonResult(id, "null");
+    }
+
+    std::string RpcServer::handle_getTransactionReceipt(const std::string &id, const std::string &hashHex)
+    {
+        std::optional<Bytes32> hash = hashFromJson(hashHex);
+        if (!hash)
+        {
+            return jsonError(id, -32602, "Invalid transaction hash");
+        }
+        auto loc = chain_.transactionBlock(*hash);
+        if (!loc)
+        {
+            return jsonResult(id, "null");
+        }
+
+        const BlockView &b = loc->block;
+        if (loc->position >= b.receiptCount())
+        {
+            return jsonResult(id, "null");
+        }
+
+        Transaction tx = b.transaction(loc->position);
+        Receipt rc = b.receipt(loc->position);
+        std::uint64_t prevGas = loc->position > 0 ? b.receipt(loc->position - 1).cumulativeGasUsed : 0;
+
+        json logs = json::array();
+        for (std::size_t i = 0; i < rc.logs.size(); ++i)
+        {
+            const Log &log = rc.logs[i];
+            json topics = json::array();
+            for (const Bytes32 &t : log.topics)
             {
-                if (tx.hash == hashHex)
-                {
-                    std::string out = "{"
-                                      "\"hash\":\"" +
-                                      tx.hash + "\","
-                                                "\"blockHash\":\"" +
-                                      b.hash + "\","
-                                               "\"blockNumber\":\"0x" +
-                                      toHex(rlp::encodeUint(b.index)) + "\","
-                                                                        "\"from\":\"" +
-                                      tx.from.toHex() + "\","
-                                                        "\"to\":\"" +
-                                      tx.to.toHex() + "\","
-                                                      "\"value\":\"0x" +
-                                      toHex(rlp::encodeUint(tx.value)) + "\","
-                                                                         "\"nonce\":\"0x" +
-                                      toHex(rlp::encodeUint(tx.nonce)) + "\""
-                                                                         "}";
-                    return jsonResult(id, out);
-                }
+                topics.push_back(hashToJson(t));
             }
+            logs.push_back({{"address", log.address.toHex()},
+                            {"topics", topics},
+                            {"data", "0x" + toHex(log.data)},
+                            {"logIndex", quantityToJson(i)}});
         }
 
-        return jsonResult(id, "null");
+        json out = {
+            {"transactionHash", hashToJson(tx.hash)},
+            {"transactionIndex", quantityToJson(loc->position)},
+            {"blockHash", hashToJson(b.hash())},
+            {"blockNumber", quantityToJson(b.index())},
+            {"from", tx.from.toHex()},
+            {"to", tx.to.toHex()},
+            {"cumulativeGasUsed", quantityToJson(rc.cumulativeGasUsed)},
+            {"gasUsed", quantityToJson(rc.cumulativeGasUsed - prevGas)},
+            {"status", rc.status ? "0x1" : "0x0"},
+            {"logs", logs}};
+        return jsonResult(id, out.dump());
+    }
+
+    std::string RpcServer::handle_getTransactionProof(const std::string &id, const std::string &hashHex)
+    {
+        std::optional<Bytes32> hash = hashFromJson(hashHex);
+        if (!hash)
+        {
+            return jsonError(id, -32602, "Invalid transaction hash");
+        }
+        std::optional<Blockchain::TxProof> p = chain_.transactionProof(*hash);
+        if (!p)
+        {
+            return jsonResult(id, "null");
+        }
+
+        json siblings = json::array();
+        for (const Bytes32 &s : p->proof.siblings)
+        {
+            siblings.push_back(hashToJson(s));
+        }
+        json out = {
+            {"transactionHash", hashToJson(*hash)},
+            {"blockHash", hashToJson(p->blockHash)},
+            {"blockNumber", quantityToJson(p->header.index)},
+            {"txRoot", hashToJson(p->header.txRoot)},
+            {"index", quantityToJson(p->proof.index)},
+            {"leaves", quantityToJson(p->proof.leaves)},
+            {"siblings", siblings}};
+        return jsonResult(id, out.dump());
     }
 
-    std::string RpcServer::handle_getTransactionCount(const std::string &id, const std::string &addrHex)
+    std::string RpcServer::handle_getTransactionCount(const std::string &id, const std::string &addrHex, const std::string &blockTag)
     {
+        Address addr;
         try
         {
-            Address addr = Address::fromHex(addrHex);
-            const Account *acc = chain_.state().get(addr);
+            addr = Address::fromHex(addrHex);
+        }
+        catch (...)
+        {
+            return jsonError(id, -32602, "Invalid address");
+        }
+
+        try
+        {
+            std::optional<Account> acc = accountForTag(addr, blockTag);
             uint64_t nonce = acc ? acc->nonce : 0;
+            return jsonResult(id, "\"" + quantityToJson(nonce) + "\"");
+        }
+        catch (const std::out_of_range &e)
+        {
+            return jsonError(id, -32000, e.what());
+        }
+        catch (...)
+        {
+            return jsonError(id, -32602, "Invalid block tag");
+        }
+    }
 
-            char buf[32];
-            std::snprintf(buf, sizeof(buf), "0x%llx", (unsigned long long)nonce);
-            return jsonResult(id, "\"" + std::string(buf) + "\"");
+    std::string RpcServer::handle_getAddressTransactions(const std::string &id, const std::string &addrHex,
+                                                         std::size_t limit, const std::string &cursor, bool newestFirst)
+    {
+        Address addr;
+        try
+        {
+            addr = Address::fromHex(addrHex);
         }
         catch (...)
         {
             return jsonError(id, -32602, "Invalid address");
         }
+        if (limit == 0 || limit > 1000)
+        {
+            return jsonError(id, -32602, "limit must be between 1 and 1000");
+        }
+
+        // Cursor: "0x" + hex of (height << 32 | position) of the next posting
+        AddressIndex::Posting from;
+        if (!cursor.empty())
+        {
+            try
+            {
+                std::uint64_t key = std::stoull(cursor, nullptr, 16);
+                from = {key >> 32, static_cast<std::uint32_t>(key)};
+            }
+            catch (...)
+            {
+                return jsonError(id, -32602, "Invalid cursor");
+            }
+        }
+        else if (newestFirst)
+        {
+            from = {UINT64_MAX, UINT32_MAX};
+        }
+
+        AddressIndex::Page page = chain_.addressHistory(addr, from, limit, newestFirst);
+
+        // One block read per height, however many of its transactions
+        // match. A reorg after the index was read can put other
+        // transactions at the posted positions, so each one must still
+        // involve the address; the recipient is checked before paying
+        // for sender recovery.
+        json txs = json::array();
+        std::optional<std::uint64_t> height;
+        std::optional<BlockView> block;
+        for (const AddressIndex::Posting &p : page.postings)
+        {
+            if (p.height != height)
+            {
+                try
+                {
+                    block = chain_.blockView(p.height);
+                }
+                catch (const std::out_of_range &)
+                {
+                    block.reset();     // pruned meanwhile
+                }
+                height = p.height;
+            }
+            if (!block || p.position >= block->txCount())
+            {
+                continue;
+            }
+            Transaction tx = block->transaction(p.position, false);
+            if (tx.to != addr)
+            {
+                tx.recoverSender();
+                if (tx.from != addr)
+                {
+                    continue;
+                }
+            }
+            txs.push_back({{"hash", hashToJson(tx.hash)},
+                           {"blockNumber", quantityToJson(p.height)},
+                           {"transactionIndex", quantityToJson(p.position)}});
+        }
+
+        json out = {{"transactions", txs},
+                    {"total", quantityToJson(chain_.addressTransactionCount(addr))},
+                    {"next", nullptr}};
+        if (page.next)
+        {
+            char buf[24];
+            std::snprintf(buf, sizeof(buf), "0x%llx",
+                          (unsigned long long)((page.next->height << 32) | page.next->position));
+            out["next"] = buf;
+        }
+        return jsonResult(id, out.dump());
     }
 
     // ---------- HTTP + JSON helpers ----------
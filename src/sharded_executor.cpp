@@ -0,0 +1,268 @@
+#include "gambit/sharded_executor.hpp"
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#ifdef _WIN32
+    #include <windows.h>
+#elif defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+namespace gambit {
+
+namespace {
+
+constexpr std::size_t kMaxShards = 256;
+constexpr std::size_t kNone = static_cast<std::size_t>(-1);
+
+enum Phase { kIdle, kPrepare, kMerge, kStop };
+
+struct Credit {
+    std::size_t txIdx;
+    Address to;
+    uint256 value;
+};
+
+// Best effort; an unpinned worker is still correct
+void pinToCore(std::thread& t, std::size_t core) {
+#ifdef _WIN32
+    SetThreadAffinityMask(t.native_handle(), DWORD_PTR(1) << (core % (sizeof(DWORD_PTR) * 8)));
+#elif defined(__linux__)
+    unsigned n = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core % n, &set);
+    pthread_setaffinity_np(t.native_handle(), sizeof(set), &set);
+#else
+    (void)t;
+    (void)core;
+#endif
+}
+
+} // namespace
+
+struct ShardedExecutor::Shard {
+    std::size_t id{0};
+    std::thread thread;
+
+    std::mutex mu;
+    std::condition_variable cv;
+    int phase{kIdle};
+
+    // Per-block inputs (set by execute() before prepare)
+    const State* base{nullptr};
+    const std::vector<Transaction>* txs{nullptr};
+    std::vector<std::size_t> queue;                 // indices of txs sent from this shard
+    std::vector<const std::vector<Credit>*> inbox;  // other shards' outboxes to us
+
+    // Owned partition: committed accounts, kept across blocks
+    std::unordered_map<Address, Account, AddressHash> resident;
+    std::size_t loaded{0};
+
+    // This block's accounts, on top of `resident`
+    std::unordered_map<Address, Account, AddressHash> accounts;
+    std::vector<std::vector<Credit>> outbox;        // per destination shard
+    std::size_t failedIdx{kNone};
+
+    Account& local(const Address& a) {
+        auto it = accounts.find(a);
+        if (it != accounts.end()) return it->second;
+        auto r = resident.find(a);
+        if (r == resident.end()) {
+            const Account* acc = base->get(a);
+            r = resident.emplace(a, acc ? *acc : Account{}).first;
+            ++loaded;
+        }
+        return accounts.emplace(a, r->second).first->second;
+    }
+};
+
+ShardedExecutor::ShardedExecutor(std::size_t shards, std::uint64_t chainId)
+    : chainId_(chainId), serial_(1, chainId) {
+    if (shards == 0) {
+        shards = std::max(1u, std::thread::hardware_concurrency());
+    }
+    shards = std::min(shards, kMaxShards);
+
+    shards_.reserve(shards);
+    for (std::size_t i = 0; i < shards; ++i) {
+        auto s = std::make_unique<Shard>();
+        s->id = i;
+        s->outbox.resize(shards);
+        shards_.push_back(std::move(s));
+    }
+    for (auto& s : shards_) {
+        s->thread = std::thread(&ShardedExecutor::worker, this, std::ref(*s));
+        pinToCore(s->thread, s->id);
+    }
+}
+
+ShardedExecutor::~ShardedExecutor() {
+    for (auto& s : shards_) {
+        {
+            std::lock_guard<std::mutex> lock(s->mu);
+            s->phase = kStop;
+        }
+        s->cv.notify_one();
+    }
+    for (auto& s : shards_) {
+        if (s->thread.joinable()) s->thread.join();
+    }
+}
+
+std::size_t ShardedExecutor::shardOf(const Address& addr) const {
+    const auto& b = addr.bytes();
+    std::size_t prefix = (std::size_t(b[0]) << 8) | b[1];
+    return (prefix * shards_.size()) >> 16;
+}
+
+void ShardedExecutor::worker(Shard& shard) {
+    for (;;) {
+        int phase;
+        {
+            std::unique_lock<std::mutex> lock(shard.mu);
+            shard.cv.wait(lock, [&] { return shard.phase != kIdle; });
+            phase = shard.phase;
+        }
+        if (phase == kStop) {
+            return;
+        }
+
+        if (phase == kPrepare) {
+            for (std::size_t idx : shard.queue) {
+                const Transaction& tx = (*shard.txs)[idx];
+                Account& from = shard.local(tx.from);
+                // Only this shard moves the sender's nonce; a failure here
+                // is re-run serially for the exact error
+                if (transferError(tx, from, chainId_)) {
+                    shard.failedIdx = idx;
+                    break;
+                }
+                from.balance -= tx.value;
+                from.nonce   += 1;
+                if (tx.from == tx.to) {
+                    from.balance += tx.value;
+                    continue;
+                }
+                std::size_t dest = shardOf(tx.to);
+                if (dest == shard.id) {
+                    shard.local(tx.to).balance += tx.value;
+                } else {
+                    shard.outbox[dest].push_back({idx, tx.to, tx.value});
+                }
+            }
+        } else if (phase == kMerge) {
+            std::vector<const Credit*> in;
+            for (const auto* box : shard.inbox) {
+                for (const auto& c : *box) in.push_back(&c);
+            }
+            std::sort(in.begin(), in.end(), [](const Credit* a, const Credit* b) {
+                return a->txIdx < b->txIdx;
+            });
+            for (const Credit* c : in) {
+                shard.local(c->to).balance += c->value;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(shard.mu);
+            shard.phase = kIdle;
+        }
+        std::lock_guard<std::mutex> lock(doneMutex_);
+        if (--pending_ == 0) {
+            doneCv_.notify_one();
+        }
+    }
+}
+
+void ShardedExecutor::runPhase(int phase) {
+    {
+        std::lock_guard<std::mutex> lock(doneMutex_);
+        pending_ = shards_.size();
+    }
+    for (auto& s : shards_) {
+        {
+            std::lock_guard<std::mutex> lock(s->mu);
+            s->phase = phase;
+        }
+        s->cv.notify_one();
+    }
+    std::unique_lock<std::mutex> lock(doneMutex_);
+    doneCv_.wait(lock, [&] { return pending_ == 0; });
+}
+
+ExecutionResult ShardedExecutor::execute(const State& base, const std::vector<Transaction>& txs) {
+    std::lock_guard<std::mutex> lock(execMutex_);
+    stats_ = Stats{};
+
+    // Route each transaction to its sender's shard
+    for (auto& s : shards_) {
+        s->base = &base;
+        s->txs = &txs;
+        s->queue.clear();
+        s->inbox.clear();
+        s->accounts.clear();
+        s->loaded = 0;
+        for (auto& box : s->outbox) box.clear();
+        s->failedIdx = kNone;
+    }
+    for (std::size_t i = 0; i < txs.size(); ++i) {
+        shards_[shardOf(txs[i].from)]->queue.push_back(i);
+    }
+
+    runPhase(kPrepare);
+
+    bool failed = false;
+    for (auto& s : shards_) {
+        failed |= s->failedIdx != kNone;
+    }
+    if (failed) {
+        stats_.fallback = true;
+        return serial_.execute(base, txs);
+    }
+
+    for (auto& dst : shards_) {
+        for (auto& src : shards_) {
+            const auto& box = src->outbox[dst->id];
+            if (!box.empty()) {
+                dst->inbox.push_back(&box);
+                stats_.crossShard += box.size();
+            }
+        }
+    }
+
+    runPhase(kMerge);
+
+    for (auto& s : shards_) {
+        stats_.loaded += s->loaded;
+    }
+
+    // Writes in first-touch order, like the other executors
+    ExecutionResult res;
+    std::unordered_set<Address, AddressHash> seen;
+    for (const auto& tx : txs) {
+        for (const Address& a : {tx.from, tx.to}) {
+            if (seen.insert(a).second) {
+                res.writes.emplace_back(a, shards_[shardOf(a)]->accounts.at(a));
+            }
+        }
+    }
+    return res;
+}
+
+void ShardedExecutor::commit(const std::vector<std::pair<Address, Account>>& writes) {
+    std::lock_guard<std::mutex> lock(execMutex_);
+    for (const auto& [a, acc] : writes) {
+        shards_[shardOf(a)]->resident[a] = acc;
+    }
+}
+
+void ShardedExecutor::invalidate() {
+    std::lock_guard<std::mutex> lock(execMutex_);
+    for (auto& s : shards_) s->resident.clear();
+}
+
+} // namespace gambit
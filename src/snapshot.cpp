@@ -0,0 +1,395 @@
+#include "gambit/snapshot.hpp"
+#include "byte_io.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace gambit {
+
+namespace {
+
+// File layout (little-endian):
+//   header  [magic "GSNP"][u32 version][u64 count][u64 capacity][32 root][8 pad]
+//   slots   capacity x [u8 used][20 address][3 pad][u256 balance][u64 nonce]
+constexpr char kMagic[4] = {'G', 'S', 'N', 'P'};
+constexpr std::uint32_t kVersion = 2;
+constexpr std::size_t kHeaderSize = 64;
+constexpr std::size_t kSlotSize = 64;
+
+std::size_t slotCapacity(std::size_t count) {
+    std::size_t cap = 16;
+    while (cap < count * 2) cap <<= 1;   // load factor <= 0.5
+    return cap;
+}
+
+// Readers still holding a view keep its mapping alive; the file itself
+// can go now (POSIX unlink semantics / FILE_SHARE_DELETE)
+void removeBaseFile(const SnapshotBase& base) {
+    if (base.path().empty()) return;
+    std::error_code ec;
+    std::filesystem::remove(base.path(), ec);
+}
+
+// Base files an earlier run left in `dir` (the generation counter
+// restarts at 0, so they would only pile up or be overwritten)
+void removeStaleBaseFiles(const std::string& dir, const std::string& keep) {
+    std::error_code ec;
+    for (const auto& e : std::filesystem::directory_iterator(dir, ec)) {
+        std::string name = e.path().filename().string();
+        bool base = name.rfind("snapshot-", 0) == 0 &&
+                    (e.path().extension() == ".bin" || e.path().extension() == ".tmp");
+        if (base && e.path().string() != keep) {
+            std::error_code rm;
+            std::filesystem::remove(e.path(), rm);
+        }
+    }
+}
+
+} // namespace
+
+// ---------- SnapshotBase ----------
+
+Bytes SnapshotBase::encode(const Bytes32& root, const Entries& accounts) {
+    std::size_t cap = slotCapacity(accounts.size());
+    Bytes out(kHeaderSize + cap * kSlotSize, 0);
+
+    std::memcpy(out.data(), kMagic, 4);
+    out[4] = static_cast<std::uint8_t>(kVersion);
+    putU64(out.data() + 8, accounts.size());
+    putU64(out.data() + 16, cap);
+    std::memcpy(out.data() + 24, root.data(), 32);
+
+    std::uint8_t* slots = out.data() + kHeaderSize;
+    for (const auto& [addr, acc] : accounts) {
+        std::size_t i = AddressHash{}(addr) & (cap - 1);
+        while (true) {
+            std::uint8_t* s = slots + i * kSlotSize;
+            if (!s[0] || std::memcmp(s + 1, addr.bytes().data(), Address::kSize) == 0) {
+                s[0] = 1;
+                std::memcpy(s + 1, addr.bytes().data(), Address::kSize);
+                putU256(s + 24, acc.balance);
+                putU64(s + 56, acc.nonce);
+                break;
+            }
+            i = (i + 1) & (cap - 1);
+        }
+    }
+    return out;
+}
+
+void SnapshotBase::attach(const std::uint8_t* data, std::size_t size) {
+    if (size < kHeaderSize || std::memcmp(data, kMagic, 4) != 0 || data[4] != kVersion) {
+        throw std::runtime_error("SnapshotBase: bad header");
+    }
+    count_ = static_cast<std::size_t>(getU64(data + 8));
+    capacity_ = static_cast<std::size_t>(getU64(data + 16));
+    if (capacity_ == 0 || (capacity_ & (capacity_ - 1)) != 0 ||
+        size < kHeaderSize + capacity_ * kSlotSize)
+    {
+        throw std::runtime_error("SnapshotBase: truncated table");
+    }
+    std::memcpy(root_.data(), data + 24, 32);
+    slots_ = data + kHeaderSize;
+}
+
+std::shared_ptr<const SnapshotBase> SnapshotBase::build(const Bytes32& root,
+                                                        const Entries& accounts)
+{
+    auto base = std::make_shared<SnapshotBase>();
+    base->owned_ = encode(root, accounts);
+    base->attach(base->owned_.data(), base->owned_.size());
+    return base;
+}
+
+std::shared_ptr<const SnapshotBase> SnapshotBase::create(const std::string& path,
+                                                         const Bytes32& root,
+                                                         const Entries& accounts)
+{
+    Bytes enc = encode(root, accounts);
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("SnapshotBase: cannot write " + tmp);
+        }
+        out.write(reinterpret_cast<const char*>(enc.data()), static_cast<std::streamsize>(enc.size()));
+        if (!out) {
+            throw std::runtime_error("SnapshotBase: short write " + tmp);
+        }
+    }
+    std::filesystem::rename(tmp, path);
+    return load(path);
+}
+
+std::shared_ptr<const SnapshotBase> SnapshotBase::load(const std::string& path) {
+    auto base = std::make_shared<SnapshotBase>();
+    base->mapped_ = MappedFile::open(path);
+    base->attach(base->mapped_.data(), base->mapped_.size());
+    base->path_ = path;
+    return base;
+}
+
+std::optional<Account> SnapshotBase::get(const Address& addr) const {
+    std::size_t i = AddressHash{}(addr) & (capacity_ - 1);
+    while (true) {
+        const std::uint8_t* s = slots_ + i * kSlotSize;
+        if (!s[0]) {
+            return std::nullopt;
+        }
+        if (std::memcmp(s + 1, addr.bytes().data(), Address::kSize) == 0) {
+            return Account{getU256(s + 24), getU64(s + 56)};
+        }
+        i = (i + 1) & (capacity_ - 1);
+    }
+}
+
+void SnapshotBase::forEach(const std::function<void(const Address&, const Account&)>& fn) const {
+    for (std::size_t i = 0; i < capacity_; ++i) {
+        const std::uint8_t* s = slots_ + i * kSlotSize;
+        if (!s[0]) continue;
+        std::array<std::uint8_t, Address::kSize> raw{};
+        std::memcpy(raw.data(), s + 1, Address::kSize);
+        fn(Address(raw), Account{getU256(s + 24), getU64(s + 56)});
+    }
+}
+
+// ---------- SnapshotTree ----------
+
+SnapshotTree::SnapshotTree(std::size_t maxDiffLayers)
+    : maxDiffLayers_(std::max<std::size_t>(maxDiffLayers, 2))
+{
+    merger_ = std::thread(&SnapshotTree::mergeLoop, this);
+}
+
+SnapshotTree::~SnapshotTree() {
+    {
+        std::lock_guard<std::mutex> lock(mergeMutex_);
+        stopping_ = true;
+    }
+    mergeCv_.notify_all();
+    merger_.join();
+}
+
+std::shared_ptr<const SnapshotTree::View> SnapshotTree::current() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return view_;
+}
+
+void SnapshotTree::publish(std::shared_ptr<const View> v) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    view_ = std::move(v);
+}
+
+// Empty when bases stay in memory
+std::string SnapshotTree::nextPathLocked() {
+    if (dir_.empty()) return {};
+    return dir_ + "/snapshot-" + std::to_string(generation_++) + ".bin";
+}
+
+std::shared_ptr<const SnapshotBase> SnapshotTree::makeBase(const Bytes32& root,
+                                                           const SnapshotBase::Entries& accounts)
+{
+    std::string path = nextPathLocked();
+    if (path.empty()) {
+        return SnapshotBase::build(root, accounts);
+    }
+    return SnapshotBase::create(path, root, accounts);
+}
+
+void SnapshotTree::reset(const Bytes32& root, const SnapshotBase::Entries& accounts) {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    auto old = current();
+    auto v = std::make_shared<View>();
+    v->base = makeBase(root, accounts);
+    publish(std::move(v));
+    layerCount_ = 0;
+    if (old) removeBaseFile(*old->base);
+}
+
+void SnapshotTree::persistTo(const std::string& dir) {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    std::filesystem::create_directories(dir);
+    dir_ = dir;
+
+    auto cur = current();
+    removeStaleBaseFiles(dir, cur ? cur->base->path() : std::string());
+    if (!cur) return;
+
+    SnapshotBase::Entries entries;
+    entries.reserve(cur->base->size());
+    cur->base->forEach([&](const Address& a, const Account& acc) {
+        entries.emplace_back(a, acc);
+    });
+
+    auto v = std::make_shared<View>(*cur);
+    v->base = makeBase(cur->base->root(), entries);
+    publish(std::move(v));
+    removeBaseFile(*cur->base);
+}
+
+void SnapshotTree::update(const Bytes32& root, const SnapshotBase::Entries& writes) {
+    update(root, writes, {});
+}
+
+void SnapshotTree::update(const Bytes32& root, const SnapshotBase::Entries& writes,
+                          const std::vector<Address>& deleted)
+{
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    auto cur = current();
+    if (!cur) {
+        throw std::runtime_error("SnapshotTree::update: no base");
+    }
+
+    auto layer = std::make_shared<DiffLayer>();
+    layer->root = root;
+    for (const auto& [addr, acc] : writes) {
+        layer->accounts[addr] = acc;
+    }
+    for (const Address& addr : deleted) {
+        layer->accounts[addr] = std::nullopt;
+    }
+
+    auto v = std::make_shared<View>(*cur);
+    v->layers.push_back(std::move(layer));
+    layerCount_ = v->layers.size();
+    publish(std::move(v));
+
+    if (layerCount_ > maxDiffLayers_) {
+        // Taking the lock orders this with the merger's check
+        { std::lock_guard<std::mutex> wake(mergeMutex_); }
+        mergeCv_.notify_all();
+    }
+}
+
+std::shared_ptr<const SnapshotBase> SnapshotTree::flatten(const View& v, std::size_t merge,
+                                                          const std::string& path)
+{
+    // The base with the oldest `merge` layers applied
+    std::unordered_map<Address, Account, AddressHash> merged;
+    merged.reserve(v.base->size());
+    v.base->forEach([&](const Address& a, const Account& acc) {
+        merged[a] = acc;
+    });
+    for (std::size_t i = 0; i < merge; ++i) {
+        for (const auto& [addr, acc] : v.layers[i]->accounts) {
+            if (acc) {
+                merged[addr] = *acc;
+            } else {
+                merged.erase(addr);
+            }
+        }
+    }
+
+    SnapshotBase::Entries entries(merged.begin(), merged.end());
+    const Bytes32& root = v.layers[merge - 1]->root;
+    if (path.empty()) {
+        return SnapshotBase::build(root, entries);
+    }
+    return SnapshotBase::create(path, root, entries);
+}
+
+void SnapshotTree::mergeLoop() {
+    std::unique_lock<std::mutex> lock(mergeMutex_);
+    for (;;) {
+        mergeCv_.wait(lock, [&] { return stopping_ || layerCount_ > maxDiffLayers_; });
+        if (stopping_) return;
+        merging_ = true;
+        lock.unlock();
+
+        std::shared_ptr<const View> from;
+        std::string path;
+        {
+            std::lock_guard<std::mutex> l(writeMutex_);
+            from = current();
+            if (from && from->layers.size() > maxDiffLayers_) path = nextPathLocked();
+        }
+
+        if (from && from->layers.size() > maxDiffLayers_) {
+            // The newest half stays in memory
+            std::size_t merge = from->layers.size() - maxDiffLayers_ / 2;
+            auto base = flatten(*from, merge, path);
+
+            // Layers stacked meanwhile stay on top of the new base. A
+            // reset or persistTo replaced the base under us, so the
+            // result is stale; the loop looks again.
+            std::lock_guard<std::mutex> l(writeMutex_);
+            auto cur = current();
+            if (cur->base == from->base) {
+                auto v = std::make_shared<View>();
+                v->base = std::move(base);
+                v->layers.assign(cur->layers.begin() + static_cast<std::ptrdiff_t>(merge), cur->layers.end());
+                layerCount_ = v->layers.size();
+                publish(std::move(v));
+                removeBaseFile(*from->base);
+            } else {
+                removeBaseFile(*base);
+            }
+        }
+
+        lock.lock();
+        merging_ = false;
+        mergeCv_.notify_all();
+    }
+}
+
+void SnapshotTree::waitForMerge() {
+    std::unique_lock<std::mutex> lock(mergeMutex_);
+    mergeCv_.wait(lock, [&] { return stopping_ || (!merging_ && layerCount_ <= maxDiffLayers_); });
+}
+
+std::optional<Account> SnapshotTree::Version::get(const Address& addr) const {
+    if (!view_) return std::nullopt;
+
+    for (auto it = view_->layers.rbegin(); it != view_->layers.rend(); ++it) {
+        auto found = (*it)->accounts.find(addr);
+        if (found != (*it)->accounts.end()) {
+            return found->second;
+        }
+    }
+    return view_->base->get(addr);
+}
+
+Bytes32 SnapshotTree::Version::root() const {
+    if (!view_) return Bytes32{};
+    return view_->layers.empty() ? view_->base->root() : view_->layers.back()->root;
+}
+
+void SnapshotTree::Version::forEach(const std::function<void(const Address&, const Account&)>& fn) const {
+    if (!view_) return;
+
+    // The newest layer touching an account decides it; the base covers
+    // the rest
+    std::unordered_map<Address, std::optional<Account>, AddressHash> changed;
+    for (auto it = view_->layers.rbegin(); it != view_->layers.rend(); ++it) {
+        for (const auto& [addr, acc] : (*it)->accounts) changed.emplace(addr, acc);
+    }
+    view_->base->forEach([&](const Address& a, const Account& acc) {
+        if (changed.find(a) == changed.end()) fn(a, acc);
+    });
+    for (const auto& [addr, acc] : changed) {
+        if (acc) fn(addr, *acc);
+    }
+}
+
+SnapshotTree::Version SnapshotTree::version() const {
+    Version v;
+    v.view_ = current();
+    return v;
+}
+
+std::optional<Account> SnapshotTree::get(const Address& addr) const {
+    return version().get(addr);
+}
+
+Bytes32 SnapshotTree::root() const {
+    return version().root();
+}
+
+std::size_t SnapshotTree::diffLayers() const {
+    auto v = current();
+    return v ? v->layers.size() : 0;
+}
+
+} // namespace gambit
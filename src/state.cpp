@@ -1,17 +1,55 @@
 #include "gambit/state.hpp"
 #include <algorithm>
+#include <fstream>
 #include <stdexcept>
+#include <thread>
 #include "gambit/rlp.hpp"
 #include "gambit/mpt.hpp"
+#include "gambit/state_snapshot.hpp"
 
 namespace gambit {
 
 State::State(const GenesisConfig& genesis) {
+    if (!genesis.stateFile.empty()) {
+        std::ifstream in(genesis.stateFile, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("State: cannot open " + genesis.stateFile);
+        }
+        *this = loadStateSnapshot(in);
+    }
     for (const auto& ga : genesis.premine) {
         accounts_[ga.address.toHex(false)] = Account{ga.balance, 0};
     }
 }
 
+State State::fromAccounts(const std::vector<std::pair<Address, Account>>& accounts, std::size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::vector<std::string> keys(accounts.size());
+    auto makeKeys = [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t i = lo; i < hi; ++i) keys[i] = accounts[i].first.toHex(false);
+    };
+    if (threads == 1 || accounts.size() < kParallelRootAccounts) {
+        makeKeys(0, accounts.size());
+    } else {
+        std::size_t step = (accounts.size() + threads - 1) / threads;
+        std::vector<std::thread> pool;
+        for (std::size_t lo = step; lo < accounts.size(); lo += step) {
+            pool.emplace_back(makeKeys, lo, std::min(lo + step, accounts.size()));
+        }
+        makeKeys(0, std::min(step, accounts.size()));
+        for (auto& t : pool) t.join();
+    }
+
+    State state;
+    state.accounts_.reserve(accounts.size());
+    for (std::size_t i = 0; i < accounts.size(); ++i) {
+        state.accounts_.insert_or_assign(std::move(keys[i]), accounts[i].second);
+    }
+    return state;
+}
+
 Account& State::getOrCreate(const Address& addr) {
     auto key = addr.toHex(false);
     return accounts_[key]; // default-initialized if missing
@@ -24,10 +62,27 @@ const Account* State::get(const Address& addr) const {
     return &it->second;
 }
 
+void State::set(const Address& addr, const Account& acc) {
+    accounts_[addr.toHex(false)] = acc;
+}
+
+void State::erase(const Address& addr) {
+    accounts_.erase(addr.toHex(false));
+}
+
+void State::forEach(const std::function<void(const Address&, const Account&)>& fn) const {
+    for (const auto& [addrHex, acc] : accounts_) {
+        fn(Address::fromHex(addrHex), acc);
+    }
+}
+
 void State::applyTransaction(const Address& from, const Transaction& tx) {
     Account& fromAcc = getOrCreate(from);
     Account& toAcc   = getOrCreate(tx.to);
 
+    if (tx.nonce != fromAcc.nonce) {
+        throw std::runtime_error("Invalid nonce");
+    }
     if (fromAcc.balance < tx.value) {
         throw std::runtime_error("Insufficient balance");
     }
@@ -37,24 +92,49 @@ void State::applyTransaction(const Address& from, const Transaction& tx) {
     toAcc.balance   += tx.value;
 }
 
-std::string State::root() const {
+Bytes State::encodeAccount(const Account& acc) {
+    // Value = RLP[ balance, nonce ]
+    std::vector<Bytes> fields;
+    fields.push_back(rlp::encodeUint(acc.balance));
+    fields.push_back(rlp::encodeUint(acc.nonce));
+    return rlp::encodeList(fields);
+}
+
+Account State::decodeAccount(const Bytes& raw) {
+    auto node = rlp::decode(raw);
+    if (!node.isList || node.list.size() != 2) {
+        throw std::runtime_error("State::decodeAccount: invalid RLP account");
+    }
+    auto toUint = [](const Bytes& b) -> std::uint64_t {
+        std::uint64_t v = 0;
+        for (std::uint8_t c : b) v = (v << 8) | c;
+        return v;
+    };
+    const Bytes& balance = node.list[0].bytes;
+    return Account{uint256::fromBigEndian(balance.data(), balance.size()), toUint(node.list[1].bytes)};
+}
+
+MptTrie State::trie() const {
     MptTrie trie;
 
     for (const auto& [addrHex, acc] : accounts_) {
         // Key = 20-byte address
-        Bytes key = fromHex(addrHex);
-
-        // Value = RLP[ balance, nonce ]
-        std::vector<Bytes> fields;
-        fields.push_back(rlp::encodeUint(acc.balance));
-        fields.push_back(rlp::encodeUint(acc.nonce));
+        trie.put(fromHex(addrHex), encodeAccount(acc));
+    }
 
-        Bytes value = rlp::encodeList(fields);
+    return trie;
+}
 
-        trie.put(key, value);
+Bytes32 State::root() const {
+    // Same root as trie().rootHash(), but hashed bottom-up from sorted keys
+    MptTrie::Entries entries;
+    entries.reserve(accounts_.size());
+    for (const auto& [addrHex, acc] : accounts_) {
+        entries.emplace_back(fromHex(addrHex), encodeAccount(acc));
     }
-
-    return trie.rootHash();
+    std::sort(entries.begin(), entries.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    return MptTrie::sortedRoot(entries, entries.size() >= kParallelRootAccounts ? 0 : 1);
 }
 
 } // namespace gambit
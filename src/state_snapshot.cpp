@@ -0,0 +1,263 @@
+#include "gambit/state_snapshot.hpp"
+#include "byte_io.hpp"
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gambit/snapshot.hpp"
+
+namespace gambit {
+
+namespace {
+
+constexpr std::uint32_t kMagic = 0x53545347;    // "GSTS"
+constexpr std::uint32_t kVersion = 1;
+constexpr std::size_t kHeader = 52;
+constexpr std::size_t kChunkHeader = 76;
+constexpr std::size_t kRecord = 60;
+
+// Chunks waiting for a worker; bounds memory while reading
+constexpr std::size_t kQueuedChunks = 64;
+
+bool addressLess(const Address& a, const Address& b) {
+    return a.bytes() < b.bytes();
+}
+
+void write(std::ostream& out, const std::uint8_t* p, std::size_t n) {
+    out.write(reinterpret_cast<const char*>(p), static_cast<std::streamsize>(n));
+    if (!out) {
+        throw std::runtime_error("writeStateSnapshot: write failed");
+    }
+}
+
+void read(std::istream& in, std::uint8_t* p, std::size_t n) {
+    in.read(reinterpret_cast<char*>(p), static_cast<std::streamsize>(n));
+    if (static_cast<std::size_t>(in.gcount()) != n) {
+        throw std::runtime_error("loadStateSnapshot: truncated snapshot");
+    }
+}
+
+struct Chunk {
+    std::size_t index;
+    std::array<std::uint8_t, kChunkHeader> header;
+    Bytes payload;
+};
+
+// What a worker makes of one chunk
+struct Decoded {
+    SnapshotBase::Entries accounts;
+    MptTrie::Entries trie;
+};
+
+} // namespace
+
+Bytes32 writeStateSnapshot(const State& state, std::ostream& out, std::size_t chunkAccounts) {
+    if (chunkAccounts == 0) {
+        throw std::invalid_argument("writeStateSnapshot: empty chunks");
+    }
+    SnapshotBase::Entries accounts;
+    state.forEach([&](const Address& addr, const Account& acc) { accounts.emplace_back(addr, acc); });
+    std::sort(accounts.begin(), accounts.end(),
+              [](const auto& a, const auto& b) { return addressLess(a.first, b.first); });
+    Bytes32 root = state.root();
+
+    std::size_t chunks = (accounts.size() + chunkAccounts - 1) / chunkAccounts;
+    std::uint8_t header[kHeader];
+    putU32(header, kMagic);
+    putU32(header + 4, kVersion);
+    putU64(header + 8, accounts.size());
+    putU32(header + 16, static_cast<std::uint32_t>(chunks));
+    std::copy(root.begin(), root.end(), header + 20);
+    write(out, header, kHeader);
+
+    for (std::size_t c = 0; c < chunks; ++c) {
+        std::size_t lo = c * chunkAccounts;
+        std::size_t hi = std::min(lo + chunkAccounts, accounts.size());
+
+        Bytes payload((hi - lo) * kRecord, 0);
+        for (std::size_t i = lo; i < hi; ++i) {
+            std::uint8_t* rec = payload.data() + (i - lo) * kRecord;
+            const auto& [addr, acc] = accounts[i];
+            std::copy(addr.bytes().begin(), addr.bytes().end(), rec);
+            std::uint8_t balance[32];
+            std::size_t len = acc.balance.toBigEndian(balance);
+            std::copy(balance, balance + len, rec + 20 + (32 - len));
+            putU64(rec + 52, acc.nonce);
+        }
+
+        std::uint8_t ch[kChunkHeader];
+        putU32(ch, static_cast<std::uint32_t>(hi - lo));
+        std::copy(accounts[lo].first.bytes().begin(), accounts[lo].first.bytes().end(), ch + 4);
+        std::copy(accounts[hi - 1].first.bytes().begin(), accounts[hi - 1].first.bytes().end(), ch + 24);
+        Bytes32 hash = keccak256_32(payload);
+        std::copy(hash.begin(), hash.end(), ch + 44);
+        write(out, ch, kChunkHeader);
+        write(out, payload.data(), payload.size());
+    }
+    return root;
+}
+
+Bytes32 readStateSnapshotRoot(std::istream& in) {
+    std::uint8_t header[kHeader];
+    read(in, header, kHeader);
+    if (getU32(header) != kMagic || getU32(header + 4) != kVersion) {
+        throw std::runtime_error("readStateSnapshotRoot: not a state snapshot");
+    }
+    Bytes32 root;
+    std::copy(header + 20, header + kHeader, root.begin());
+    return root;
+}
+
+State loadStateSnapshot(std::istream& in, std::size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::uint8_t header[kHeader];
+    read(in, header, kHeader);
+    if (getU32(header) != kMagic || getU32(header + 4) != kVersion) {
+        throw std::runtime_error("loadStateSnapshot: not a state snapshot");
+    }
+    std::uint64_t total = getU64(header + 8);
+    std::uint32_t chunkCount = getU32(header + 16);
+    Bytes32 root;
+    std::copy(header + 20, header + kHeader, root.begin());
+
+    // Reader (this thread) -> queue -> workers checking and decoding chunks
+    std::vector<Decoded> decoded(chunkCount);
+    std::deque<Chunk> queue;
+    bool done = false;
+    std::string error;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+
+    auto fail = [&](const std::string& what) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (error.empty()) error = what;
+    };
+
+    auto worker = [&]() {
+        for (;;) {
+            std::optional<Chunk> chunk;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                notEmpty.wait(lock, [&] { return !queue.empty() || done; });
+                if (queue.empty()) return;
+                chunk = std::move(queue.front());
+                queue.pop_front();
+                notFull.notify_one();
+            }
+
+            const std::uint8_t* h = chunk->header.data();
+            Bytes32 hash = keccak256_32(chunk->payload);
+            if (!std::equal(hash.begin(), hash.end(), h + 44)) {
+                fail("loadStateSnapshot: hash mismatch in chunk " + std::to_string(chunk->index));
+                continue;
+            }
+
+            Decoded& out = decoded[chunk->index];
+            std::size_t n = chunk->payload.size() / kRecord;
+            out.accounts.reserve(n);
+            out.trie.reserve(n);
+            bool ordered = true;
+            for (std::size_t i = 0; i < n; ++i) {
+                const std::uint8_t* rec = chunk->payload.data() + i * kRecord;
+                std::array<std::uint8_t, Address::kSize> raw;
+                std::copy(rec, rec + Address::kSize, raw.begin());
+                Address addr(raw);
+                Account acc{uint256::fromBigEndian(rec + 20, 32), getU64(rec + 52)};
+                if (i > 0 && !addressLess(out.accounts.back().first, addr)) ordered = false;
+                out.trie.emplace_back(Bytes(rec, rec + Address::kSize), State::encodeAccount(acc));
+                out.accounts.emplace_back(addr, acc);
+            }
+            const std::uint8_t* payload = chunk->payload.data();
+            if (!ordered || std::memcmp(h + 4, payload, Address::kSize) != 0 ||
+                std::memcmp(h + 24, payload + (n - 1) * kRecord, Address::kSize) != 0)
+            {
+                fail("loadStateSnapshot: chunk " + std::to_string(chunk->index) + " does not match its range");
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (std::size_t t = 0; t < threads; ++t) pool.emplace_back(worker);
+
+    try {
+        std::uint64_t seen = 0;
+        std::array<std::uint8_t, Address::kSize> prevLast{};
+        for (std::uint32_t c = 0; c < chunkCount; ++c) {
+            Chunk chunk{c, {}, {}};
+            read(in, chunk.header.data(), kChunkHeader);
+            std::uint32_t n = getU32(chunk.header.data());
+            const std::uint8_t* first = chunk.header.data() + 4;
+            const std::uint8_t* last = chunk.header.data() + 24;
+            if (n == 0 || seen + n > total || std::memcmp(first, last, Address::kSize) > 0 ||
+                (c > 0 && std::memcmp(prevLast.data(), first, Address::kSize) >= 0))
+            {
+                throw std::runtime_error("loadStateSnapshot: chunk " + std::to_string(c) + " out of order");
+            }
+            std::copy(last, last + Address::kSize, prevLast.begin());
+            seen += n;
+
+            chunk.payload.resize(std::size_t(n) * kRecord);
+            read(in, chunk.payload.data(), chunk.payload.size());
+
+            std::unique_lock<std::mutex> lock(mutex);
+            notFull.wait(lock, [&] { return queue.size() < kQueuedChunks; });
+            queue.push_back(std::move(chunk));
+            notEmpty.notify_one();
+        }
+        if (seen != total) {
+            throw std::runtime_error("loadStateSnapshot: account count mismatch");
+        }
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+            queue.clear();
+        }
+        notEmpty.notify_all();
+        for (auto& t : pool) t.join();
+        throw;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+    }
+    notEmpty.notify_all();
+    for (auto& t : pool) t.join();
+    if (!error.empty()) {
+        throw std::runtime_error(error);
+    }
+
+    // Chunks are in key order, so the trie entries already are
+    MptTrie::Entries entries;
+    entries.reserve(total);
+    for (Decoded& d : decoded) {
+        std::move(d.trie.begin(), d.trie.end(), std::back_inserter(entries));
+        d.trie = {};
+    }
+    if (MptTrie::sortedRoot(entries, threads) != root) {
+        throw std::runtime_error("loadStateSnapshot: state root mismatch");
+    }
+    entries = {};
+
+    SnapshotBase::Entries accounts;
+    accounts.reserve(total);
+    for (Decoded& d : decoded) {
+        std::move(d.accounts.begin(), d.accounts.end(), std::back_inserter(accounts));
+        d.accounts = {};
+    }
+    return State::fromAccounts(accounts, threads);
+}
+
+} // namespace gambit
@@ -107,7 +107,11 @@ namespace gambit
             h = h.substr(2);
         }
 
-        Bytes raw = gambit::fromHex(h);
+        return rlpDecode(gambit::fromHex(h));
+    }
+
+    Transaction Transaction::rlpDecode(const Bytes &raw, bool withSender)
+    {
         auto root = rlp::decode(raw);
 
         if (!root.isList || root.list.size() < 9)
@@ -122,11 +126,15 @@ namespace gambit
                 v = (v << 8) | c;
             return v;
         };
+        auto toUint256 = [](const Bytes &b)
+        {
+            return uint256::fromBigEndian(b.data(), b.size());
+        };
 
         Transaction tx;
 
         tx.nonce = toUint(L[0].bytes);
-        tx.gasPrice = toUint(L[1].bytes);
+        tx.gasPrice = toUint256(L[1].bytes);
         tx.gasLimit = toUint(L[2].bytes);
 
         if (L[3].bytes.empty())
@@ -138,7 +146,7 @@ namespace gambit
             tx.to = Address::fromBytes(L[3].bytes);
         }
 
-        tx.value = toUint(L[4].bytes);
+        tx.value = toUint256(L[4].bytes);
         tx.data = L[5].bytes;
 
         std::uint64_t vFull = toUint(L[6].bytes);
@@ -148,32 +156,37 @@ namespace gambit
         if (tx.sig.r.size() != 32 || tx.sig.s.size() != 32)
             throw std::runtime_error("Transaction::fromHex: invalid r/s size");
 
+        // Keep only the recovery id; rlpEncodeSigned rebuilds v from chainId
         if (vFull >= 35)
         {
             tx.chainId = (vFull - 35) / 2;
-            tx.sig.v = static_cast<std::uint8_t>(vFull); // keep full v for recovery
+            tx.sig.v = static_cast<std::uint8_t>(vFull - 35 - 2 * tx.chainId);
         }
         else
         {
             tx.chainId = 0;
-            tx.sig.v = static_cast<std::uint8_t>(vFull);
+            tx.sig.v = static_cast<std::uint8_t>(vFull >= 27 ? vFull - 27 : vFull);
         }
 
         // Compute tx hash
         tx.hash = tx.computeHash();
 
-        // Recover sender
-        Bytes32 msgHash = tx.signingHash();
-        tx.from = Keys::recoverAddress(msgHash, tx.sig, tx.chainId);
+        if (withSender)
+        {
+            tx.recoverSender();
+        }
 
         return tx;
     }
 
-    std::string Transaction::computeHash() const
+    void Transaction::recoverSender()
     {
-        Bytes encoded = rlpEncodeSigned();
-        Bytes h = keccak256(encoded);
-        return "0x" + gambit::toHex(h);
+        from = Keys::recoverAddress(signingHash(), sig, chainId);
+    }
+
+    Bytes32 Transaction::computeHash() const
+    {
+        return keccak256_32(rlpEncodeSigned());
     }
 
     void Transaction::signWith(const KeyPair &key)
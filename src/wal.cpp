@@ -0,0 +1,194 @@
+#include "gambit/wal.hpp"
+#include "byte_io.hpp"
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace gambit {
+
+namespace {
+
+constexpr std::size_t kHeader = 9;
+
+std::uint32_t crc32(const std::uint8_t* data, std::size_t n) {
+    static const std::array<std::uint32_t, 256> table = [] {
+        std::array<std::uint32_t, 256> t{};
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            std::uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    std::uint32_t c = 0xFFFFFFFFu;
+    for (std::size_t i = 0; i < n; ++i) c = table[(c ^ data[i]) & 0xFF] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
+
+Bytes readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return Bytes(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// Calls fn for each intact record; returns the length of the intact prefix
+std::size_t scan(const Bytes& log, const std::function<void(std::uint8_t, const Bytes&)>& fn) {
+    std::size_t pos = 0;
+    while (log.size() - pos >= kHeader) {
+        std::uint32_t length = getU32(&log[pos]);
+        if (length == 0 || log.size() - pos - 8 < length ||
+            crc32(&log[pos + 8], length) != getU32(&log[pos + 4]))
+        {
+            break;
+        }
+        if (fn) {
+            fn(log[pos + 8], Bytes(log.begin() + pos + kHeader, log.begin() + pos + 8 + length));
+        }
+        pos += 8 + length;
+    }
+    return pos;
+}
+
+} // namespace
+
+WriteAheadLog::WriteAheadLog(const std::string& path) : path_(path) {
+    std::filesystem::path p(path);
+    if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
+
+    if (std::filesystem::exists(path)) {
+        Bytes log = readFile(path);
+        fileSize_ = scan(log, nullptr);
+        if (fileSize_ != log.size()) {
+            std::filesystem::resize_file(path, fileSize_);
+        }
+    }
+    file_ = std::fopen(path.c_str(), "ab");
+    if (!file_) {
+        throw std::runtime_error("WriteAheadLog: cannot open " + path);
+    }
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    try {
+        sync(appended_);
+    } catch (const std::exception&) {
+    }
+    if (file_) std::fclose(file_);
+}
+
+void WriteAheadLog::replay(const std::function<void(std::uint8_t, const Bytes&)>& fn) const {
+    Bytes log = readFile(path_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    log.resize(std::min<std::size_t>(log.size(), fileSize_));
+    scan(log, fn);
+}
+
+std::uint64_t WriteAheadLog::append(std::uint8_t type, const Bytes& payload) {
+    if (payload.size() >= 0xFFFFFFFFu) {
+        throw std::runtime_error("WriteAheadLog: record too large");
+    }
+    std::uint8_t header[kHeader];
+    header[8] = type;
+    putU32(header, static_cast<std::uint32_t>(payload.size() + 1));
+
+    // CRC covers the type byte and the payload
+    Bytes body;
+    body.reserve(payload.size() + 1);
+    body.push_back(header[8]);
+    body.insert(body.end(), payload.begin(), payload.end());
+    putU32(header + 4, crc32(body.data(), body.size()));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffer_.insert(buffer_.end(), header, header + 8);
+    buffer_.insert(buffer_.end(), body.begin(), body.end());
+    return ++appended_;
+}
+
+void WriteAheadLog::sync(std::uint64_t seq) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (durable_ < seq) {
+        if (flushing_) {
+            // Another thread's write may already cover `seq`
+            flushed_.wait(lock);
+            continue;
+        }
+
+        // Become the leader: write everything buffered so far
+        flushing_ = true;
+        Bytes batch;
+        batch.swap(buffer_);
+        std::uint64_t upTo = appended_;
+        lock.unlock();
+
+        try {
+            if (!file_) throw std::runtime_error("WriteAheadLog: cannot reopen " + path_);
+            if (std::fwrite(batch.data(), 1, batch.size(), file_) != batch.size()) {
+                throw std::runtime_error("WriteAheadLog: write failed");
+            }
+            syncFile(file_, "WriteAheadLog");
+        } catch (...) {
+            lock.lock();
+            // Nothing in the batch is durable: put it back ahead of newer
+            // records and cut any partial write off the file, so the next
+            // leader rewrites it and replay never stops at a torn record
+            buffer_.insert(buffer_.begin(), batch.begin(), batch.end());
+            discardUnsyncedLocked();
+            flushing_ = false;
+            flushed_.notify_all();
+            throw;
+        }
+
+        lock.lock();
+        flushing_ = false;
+        fileSize_ += batch.size();
+        durable_ = upTo;
+        ++syncs_;
+        flushed_.notify_all();
+    }
+}
+
+void WriteAheadLog::discardUnsyncedLocked() {
+    // stdio may still hold part of the failed write; drop it with the
+    // handle rather than letting a later flush append it
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    std::error_code ec;
+    std::filesystem::resize_file(path_, fileSize_, ec);
+    if (!ec) file_ = std::fopen(path_.c_str(), "ab");
+}
+
+std::uint64_t WriteAheadLog::commit(std::uint8_t type, const Bytes& payload) {
+    std::uint64_t seq = append(type, payload);
+    sync(seq);
+    return seq;
+}
+
+void WriteAheadLog::reset() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    flushed_.wait(lock, [&] { return !flushing_; });
+    if (!file_) {
+        throw std::runtime_error("WriteAheadLog: cannot reopen " + path_);
+    }
+    buffer_.clear();
+    std::fflush(file_);
+    std::filesystem::resize_file(path_, 0);
+    syncFile(file_, "WriteAheadLog");
+    fileSize_ = 0;
+    durable_ = appended_;
+}
+
+std::uint64_t WriteAheadLog::bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return fileSize_ + buffer_.size();
+}
+
+std::uint64_t WriteAheadLog::syncs() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return syncs_;
+}
+
+} // namespace gambit
@@ -0,0 +1,50 @@
+#include "gambit/witness.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace gambit {
+
+BlockWitness BlockWitness::build(const MptTrie& pre, const std::vector<Address>& touched) {
+    std::vector<Bytes> keys;
+    keys.reserve(touched.size());
+    for (const auto& a : touched) {
+        keys.emplace_back(a.bytes().begin(), a.bytes().end());
+    }
+
+    BlockWitness w;
+    for (auto& [hash, enc] : pre.witness(keys)) {
+        w.nodes.push_back(std::move(enc));
+    }
+    return w;
+}
+
+MptTrie BlockWitness::toTrie(const Bytes32& root) const {
+    std::map<Bytes32, Bytes> byHash;
+    for (const auto& enc : nodes) {
+        byHash[keccak256_32(enc)] = enc;
+    }
+    return MptTrie::fromWitness(root, byHash);
+}
+
+Bytes BlockWitness::rlpEncode() const {
+    std::vector<Bytes> items;
+    items.reserve(nodes.size());
+    for (const auto& enc : nodes) {
+        items.push_back(rlp::encodeBytes(enc));
+    }
+    return rlp::encodeList(items);
+}
+
+BlockWitness BlockWitness::rlpDecode(const rlp::Decoded& item) {
+    if (!item.isList) {
+        throw std::runtime_error("BlockWitness: witness must be a list");
+    }
+    BlockWitness w;
+    w.nodes.reserve(item.list.size());
+    for (const auto& n : item.list) {
+        w.nodes.push_back(n.bytes);
+    }
+    return w;
+}
+
+} // namespace gambit
@@ -1,11 +1,24 @@
 #include "gambit/zk.hpp"
-#include "gambit/hash.hpp"
+#include <initializer_list>
 
 namespace gambit {
 
-ZkProof ZkProver::generate(const std::string& stateBefore,
-                           const std::string& stateAfter,
-                           const std::string& txRoot)
+namespace {
+
+Bytes32 hashConcat(std::initializer_list<const Bytes32*> parts) {
+    Bytes concat;
+    concat.reserve(32 * parts.size());
+    for (const Bytes32* p : parts) {
+        concat.insert(concat.end(), p->begin(), p->end());
+    }
+    return keccak256_32(concat);
+}
+
+} // namespace
+
+ZkProof ZkProver::generate(const Bytes32& stateBefore,
+                           const Bytes32& stateAfter,
+                           const Bytes32& txRoot)
 {
     ZkProof p;
     p.stateBefore = stateBefore;
@@ -13,20 +26,17 @@ ZkProof ZkProver::generate(const std::string& stateBefore,
     p.txRoot      = txRoot;
 
     // Mock proof: hash of inputs
-    std::string concat = stateBefore + "|" + stateAfter + "|" + txRoot;
-    p.proof = toHex(keccak256(concat));
+    p.proof = hashConcat({&stateBefore, &stateAfter, &txRoot});
 
     // Commitment = keccak256(proof || stateBefore || stateAfter || txRoot)
-    std::string c = p.proof + "|" + stateBefore + "|" + stateAfter + "|" + txRoot;
-    p.commitment = toHex(keccak256(c));
+    p.commitment = hashConcat({&p.proof, &stateBefore, &stateAfter, &txRoot});
 
     return p;
 }
 
 bool ZkVerifier::verify(const ZkProof& proof) {
     // Recompute commitment
-    std::string c = proof.proof + "|" + proof.stateBefore + "|" + proof.stateAfter + "|" + proof.txRoot;
-    std::string expected = toHex(keccak256(c));
+    Bytes32 expected = hashConcat({&proof.proof, &proof.stateBefore, &proof.stateAfter, &proof.txRoot});
 
     return expected == proof.commitment;
 }
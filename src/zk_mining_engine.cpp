@@ -2,33 +2,43 @@
 
 namespace gambit {
 
-Block ZkMiningEngine::buildBlockTemplate(Blockchain& chain) {
-    const auto& mempool = chain.mempool();
-
-    std::string before = chain.state().root();
+BlockTemplate ZkMiningEngine::buildTemplate(Blockchain& chain) {
+    // Body, parent and execution all come from one look at the chain;
+    // unpayable transactions are already out of the mempool
+    Blockchain::PendingBlock pending = chain.preparePending();
+    MptTrie& trie = pending.trie;
+    Bytes32 before = trie.rootHash();
+
+    std::vector<Address> touched;
+    for (const auto& [addr, acc] : pending.result.writes) {
+        touched.push_back(addr);
+    }
+    BlockWitness witness = BlockWitness::build(trie, touched);
 
-    // Apply txs to a temporary state (if any)
-    State temp = chain.state();
-    for (const auto& tx : mempool) {
-        temp.applyTransaction(tx.from, tx);
+    for (const auto& [addr, acc] : pending.result.writes) {
+        trie.put(Bytes(addr.bytes().begin(), addr.bytes().end()), State::encodeAccount(acc));
     }
 
-    std::string after = temp.root();
-    std::string txRoot = chain.computeTxRoot(mempool);
+    Bytes32 after = trie.rootHash();
+    Bytes32 txRoot = chain.computeTxRoot(pending.transactions);
 
     ZkProof proof = ZkProver::generate(before, after, txRoot);
 
     Block b(
-        chain.chain().size(),
-        chain.chain().back().hash,
+        pending.height + 1,
+        pending.parentHash,
         before,
         after,
         txRoot,
         proof
     );
 
-    b.transactions = mempool;  // may be empty
-    return b;
+    b.receipts = chain.computeReceipts(pending.transactions);
+    b.receiptsRoot = chain.computeReceiptsRoot(b.receipts);
+    b.hash = b.computeHash();
+    b.transactions = std::move(pending.transactions);  // may be empty
+    b.witness = std::move(witness);
+    return BlockTemplate{std::move(b), std::move(pending.result.writes)};
 }
 
 bool ZkMiningEngine::validateMinedBlock(const Block& block, Blockchain& chain) {
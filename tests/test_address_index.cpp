@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include "gambit/address_index.hpp"
+#include "gambit/blockchain.hpp"
+#include "gambit/keys.hpp"
+
+#include <algorithm>
+
+using namespace gambit;
+
+namespace {
+
+using Posting = AddressIndex::Posting;
+
+Address addressOf(int i) {
+    Bytes raw(20, 0);
+    raw[0] = static_cast<std::uint8_t>(i + 1);
+    return Address::fromBytes(raw);
+}
+
+// Block `height` with transfers from `froms[i]` to `tos[i]`
+Block makeBlock(std::uint64_t height, const std::vector<int>& froms, const std::vector<int>& tos) {
+    Block b;
+    b.index = height;
+    for (std::size_t i = 0; i < froms.size(); ++i) {
+        Transaction tx;
+        tx.from = addressOf(froms[i]);
+        tx.to = addressOf(tos[i]);
+        b.transactions.push_back(tx);
+    }
+    return b;
+}
+
+std::vector<Posting> readAll(const AddressIndex& index, const Address& addr, std::size_t limit, bool newestFirst) {
+    std::vector<Posting> all;
+    Posting from = newestFirst ? Posting{UINT64_MAX, UINT32_MAX} : Posting{};
+    for (;;) {
+        AddressIndex::Page page = index.query(addr, from, limit, newestFirst);
+        EXPECT_LE(page.postings.size(), limit);
+        all.insert(all.end(), page.postings.begin(), page.postings.end());
+        if (!page.next) return all;
+        from = *page.next;
+    }
+}
+
+} // namespace
+
+// Pages chain through every posting in both directions, whatever the
+// page size; a cursor in the middle resumes there
+TEST(AddressIndexTest, PagesThroughPostings) {
+    AddressIndex index;
+    std::vector<Posting> expected;
+    for (std::uint64_t h = 1; h <= 400; ++h) {
+        // Address 0 sends every other transaction, and now and then to itself
+        std::vector<int> froms, tos;
+        for (int i = 0; i < static_cast<int>(h % 5); ++i) {
+            froms.push_back(i % 2 ? 1 : 0);
+            tos.push_back(h % 7 == 0 ? 0 : 2);
+        }
+        for (std::size_t i = 0; i < froms.size(); ++i) {
+            if (froms[i] == 0 || tos[i] == 0) expected.push_back({h, static_cast<std::uint32_t>(i)});
+        }
+        index.add(makeBlock(h, froms, tos));
+    }
+    Address a = addressOf(0);
+    ASSERT_GT(expected.size(), 3 * AddressIndex::kPagePostings);
+    EXPECT_EQ(index.count(a), expected.size());
+    EXPECT_LT(index.bytes(), 3 * (expected.size() + index.count(addressOf(1)) + index.count(addressOf(2))));
+
+    for (std::size_t limit : {1u, 7u, 128u, 1000u}) {
+        EXPECT_EQ(readAll(index, a, limit, false), expected);
+        std::vector<Posting> reversed(expected.rbegin(), expected.rend());
+        EXPECT_EQ(readAll(index, a, limit, true), reversed);
+    }
+
+    Posting mid = expected[expected.size() / 2];
+    AddressIndex::Page page = index.query(a, mid, 3);
+    ASSERT_EQ(page.postings.size(), 3u);
+    EXPECT_EQ(page.postings[0], mid);
+    EXPECT_EQ(page.postings[2], expected[expected.size() / 2 + 2]);
+    page = index.query(a, mid, 3, true);
+    EXPECT_EQ(page.postings[2], expected[expected.size() / 2 - 2]);
+
+    EXPECT_TRUE(index.query(addressOf(9), Posting{}, 10).postings.empty());
+    EXPECT_EQ(index.count(addressOf(9)), 0u);
+}
+
+// Reorgs cut lists back from the tail, pruning drops whole pages from
+// the front; what is left still reads back in order
+TEST(AddressIndexTest, ReorgAndPrune) {
+    AddressIndex index;
+    std::vector<Block> blocks;
+    for (std::uint64_t h = 1; h <= 600; ++h) {
+        blocks.push_back(makeBlock(h, {0, 0, 1}, {1, 2, 0}));
+        index.add(blocks.back());
+    }
+    Address a = addressOf(0);
+    ASSERT_EQ(index.count(a), 1800u);
+
+    for (std::uint64_t h = 600; h > 550; --h) index.remove(blocks[h - 1]);
+    EXPECT_EQ(index.count(a), 1650u);
+    std::vector<Posting> all = readAll(index, a, 100, false);
+    ASSERT_EQ(all.size(), 1650u);
+    EXPECT_EQ(all.back(), (Posting{550, 2}));
+
+    index.add(makeBlock(551, {3}, {0}));
+    EXPECT_EQ(index.query(a, Posting{551, 0}, 10).postings, (std::vector<Posting>{{551, 0}}));
+
+    index.prune(300);
+    std::uint64_t left = index.count(a);
+    EXPECT_LT(left, 1651u - 3 * 299 + AddressIndex::kPagePostings);
+    EXPECT_GE(left, 1651u - 3 * 299);
+    all = readAll(index, a, 50, true);
+    ASSERT_EQ(all.size(), left);
+    EXPECT_EQ(all.front(), (Posting{551, 0}));
+    EXPECT_LT(all.back().height, 300u);
+
+    // Addresses with nothing left above the limit are forgotten
+    index.prune(551);
+    EXPECT_EQ(index.count(addressOf(2)), 0u);
+    EXPECT_EQ(index.count(addressOf(3)), 1u);
+    EXPECT_EQ(index.query(a, Posting{}, 1000).postings.back(), (Posting{551, 0}));
+}
+
+// The chain indexes senders and recipients as blocks land and serves
+// them newest first
+TEST(AddressIndexTest, BlockchainHistory) {
+    KeyPair alice = KeyPair::random();
+    GenesisConfig g;
+    g.chainId = 1337;
+    g.premine.push_back({alice.address(), 1000000});
+    Blockchain chain(g);
+
+    Address bob = Address::fromHex("0x1234567890123456789012345678901234567890");
+    std::vector<Bytes32> sent;
+    for (std::uint64_t n = 0; n < 5; ++n) {
+        Transaction tx;
+        tx.nonce = n;
+        tx.gasPrice = 1;
+        tx.gasLimit = 21000;
+        tx.to = bob;
+        tx.value = 10;
+        tx.chainId = 1337;
+        tx.signWith(alice);
+        chain.addTransaction(tx);
+        sent.push_back(tx.hash);
+        chain.mineBlock();
+    }
+
+    AddressIndex::Page page = chain.addressHistory(alice.address(), {UINT64_MAX, UINT32_MAX}, 2, true);
+    ASSERT_EQ(page.postings.size(), 2u);
+    EXPECT_EQ(page.postings[0].height, 5u);
+    EXPECT_EQ(chain.blockView(page.postings[1].height).txHashes()[page.postings[1].position], sent[3]);
+    ASSERT_TRUE(page.next.has_value());
+    EXPECT_EQ(page.next->height, 3u);
+    EXPECT_EQ(chain.addressTransactionCount(bob), 5u);
+    EXPECT_EQ(chain.addressHistory(bob, {}, 10).postings.front().height, 1u);
+}
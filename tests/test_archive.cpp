@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+#include "gambit/archive.hpp"
+#include "gambit/blockchain.hpp"
+#include "test_util.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <random>
+
+using namespace gambit;
+using namespace gambit::testutil;
+
+class ArchiveTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+
+    // Snapshot tree holding `state`, as the chain keeps next to it
+    static void resetTree(SnapshotTree& tree, const State& state) {
+        SnapshotBase::Entries entries;
+        state.forEach([&](const Address& a, const Account& acc) { entries.emplace_back(a, acc); });
+        tree.reset(keccak256_32("root-0"), entries);
+    }
+};
+
+// Reverse diffs answer membership and prior values
+TEST_F(ArchiveTest, ReverseDiffFind) {
+    ReverseDiff d = ReverseDiff::build({
+        {addr(3), Account{30, 3}},
+        {addr(1), std::nullopt},
+        {addr(2), Account{20, 2}},
+    });
+
+    EXPECT_EQ(d.size(), 3u);
+
+    std::optional<Account> prior;
+    ASSERT_TRUE(d.find(addr(2), prior));
+    ASSERT_TRUE(prior.has_value());
+    EXPECT_EQ(prior->balance, 20u);
+
+    ASSERT_TRUE(d.find(addr(1), prior));
+    EXPECT_FALSE(prior.has_value());
+
+    EXPECT_FALSE(d.find(addr(9), prior));
+}
+
+// Every historical lookup matches a full per-block copy of the state
+TEST_F(ArchiveTest, RandomHistoryMatchesReference) {
+    for (std::uint64_t interval : {1u, 4u, 16u, 1000u}) {
+        std::mt19937 rng(7);
+        GenesisConfig g;
+        for (std::uint32_t i = 0; i < 8; ++i) g.premine.push_back({addr(i), 1000});
+
+        State state(g);
+        SnapshotTree tree;
+        resetTree(tree, state);
+        ArchiveConfig cfg;
+        cfg.checkpointInterval = interval;
+        ArchiveStore archive(cfg, 0, tree.version());
+
+        std::vector<std::map<std::uint32_t, uint256>> history;   // balance per height
+        auto capture = [&]() {
+            std::map<std::uint32_t, uint256> m;
+            for (std::uint32_t i = 0; i < 16; ++i) {
+                const Account* a = state.get(addr(i));
+                if (a) m[i] = a->balance;
+            }
+            history.push_back(m);
+        };
+        capture();
+
+        for (std::uint64_t h = 1; h <= 40; ++h) {
+            ReverseDiff::Entries priors;
+            for (int k = 0; k < 3; ++k) {
+                Address a = addr(rng() % 16);
+                const Account* prev = state.get(a);
+                bool seen = false;
+                for (const auto& p : priors) seen |= p.first == a;
+                if (!seen) priors.emplace_back(a, prev ? std::optional<Account>(*prev) : std::nullopt);
+                state.set(a, Account{rng() % 5000, h});
+            }
+            SnapshotBase::Entries writes;
+            for (const auto& p : priors) writes.emplace_back(p.first, *state.get(p.first));
+            tree.update(keccak256_32("root-" + std::to_string(h)), writes);
+            archive.recordBlock(h, ReverseDiff::build(priors), tree.version());
+            capture();
+        }
+
+        // Same answers whether or not the checkpoints are built yet
+        for (bool built : {false, true}) {
+            if (built) {
+                archive.waitForCheckpoints();
+                EXPECT_EQ(archive.checkpoints(), 1 + 40 / interval);
+            }
+            for (std::uint64_t h = 0; h <= 40; ++h) {
+                for (std::uint32_t i = 0; i < 16; ++i) {
+                    std::optional<Account> got = archive.accountAt(addr(i), h);
+                    auto it = history[h].find(i);
+                    if (it == history[h].end()) {
+                        EXPECT_FALSE(got.has_value()) << "interval=" << interval << " h=" << h << " i=" << i;
+                    } else {
+                        ASSERT_TRUE(got.has_value()) << "interval=" << interval << " h=" << h << " i=" << i;
+                        EXPECT_EQ(got->balance, it->second);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Checkpoint files follow the archive: tables from an earlier run are
+// deleted, rewound ones go with their blocks, and the rest with the store
+TEST_F(ArchiveTest, CheckpointFilesDoNotLeak) {
+    std::string dir = (std::filesystem::temp_directory_path() /
+                       ("gambit_archive_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()))).string();
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::ofstream(dir + "/checkpoint-99.bin") << "stale";
+    auto files = [&] {
+        return static_cast<std::size_t>(std::distance(std::filesystem::directory_iterator(dir),
+                                                      std::filesystem::directory_iterator()));
+    };
+
+    GenesisConfig g;
+    g.premine.push_back({addr(0), 1000});
+    State state(g);
+    SnapshotTree tree;
+    resetTree(tree, state);
+    ArchiveConfig cfg;
+    cfg.checkpointInterval = 2;
+    cfg.checkpointDir = dir;
+    {
+        ArchiveStore archive(cfg, 0, tree.version());
+        for (std::uint64_t h = 1; h <= 6; ++h) {
+            std::optional<Account> prior = *state.get(addr(0));
+            state.set(addr(0), Account{1000 - h, h});
+            tree.update(keccak256_32("root-" + std::to_string(h)), {{addr(0), *state.get(addr(0))}});
+            archive.recordBlock(h, ReverseDiff::build({{addr(0), prior}}), tree.version());
+        }
+        archive.waitForCheckpoints();
+        EXPECT_EQ(archive.checkpoints(), 4u);
+        EXPECT_EQ(files(), 4u);
+        EXPECT_FALSE(std::filesystem::exists(dir + "/checkpoint-99.bin"));
+
+        archive.rewind(3, tree.version());
+        EXPECT_EQ(files(), 2u);
+        EXPECT_EQ(archive.accountAt(addr(0), 2)->nonce, 2u);
+    }
+    EXPECT_EQ(files(), 0u);
+    std::filesystem::remove_all(dir);
+}
+
+// Heights outside the archived range are rejected
+TEST_F(ArchiveTest, OutOfRange) {
+    SnapshotTree tree;
+    ArchiveStore archive(ArchiveConfig{}, 5, tree.version());
+
+    EXPECT_TRUE(archive.available(5));
+    EXPECT_FALSE(archive.available(4));
+    EXPECT_FALSE(archive.available(6));
+    EXPECT_THROW(archive.accountAt(addr(0), 6), std::out_of_range);
+    EXPECT_THROW(archive.recordBlock(7, ReverseDiff::build({}), tree.version()), std::runtime_error);
+}
+
+// Blockchain answers balance queries for past blocks in archive mode
+TEST_F(ArchiveTest, BlockchainHistoricalBalance) {
+    GenesisConfig g;
+    g.chainId = 1337;
+    g.premine.push_back({addr(0), 1000});
+
+    Blockchain chain(g);
+    ArchiveConfig cfg;
+    cfg.checkpointInterval = 2;
+    chain.enableArchive(cfg);
+
+    for (std::uint64_t v : {100u, 200u, 300u}) {
+        Transaction tx;
+        tx.nonce = v / 100 - 1;
+        tx.from = addr(0);
+        tx.to = addr(1);
+        tx.value = v;
+        tx.chainId = 1337;
+        tx.hash = tx.computeHash();
+        chain.addTransaction(tx);
+        chain.mineBlock();
+    }
+
+    EXPECT_EQ(chain.accountAt(addr(0), 0)->balance, 1000u);
+    EXPECT_EQ(chain.accountAt(addr(0), 1)->balance, 900u);
+    EXPECT_EQ(chain.accountAt(addr(0), 2)->balance, 700u);
+    EXPECT_EQ(chain.accountAt(addr(0), 3)->balance, 400u);
+    EXPECT_FALSE(chain.accountAt(addr(1), 0).has_value());
+    EXPECT_EQ(chain.accountAt(addr(1), 2)->balance, 300u);
+    EXPECT_EQ(chain.accountAt(addr(0), 2)->nonce, 2u);
+    EXPECT_THROW(chain.accountAt(addr(0), 4), std::out_of_range);
+}
@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include "gambit/async_io.hpp"
+#include "gambit/block_store.hpp"
+#include "gambit/keys.hpp"
+
+#include <cerrno>
+#include <filesystem>
+#include <random>
+
+#ifdef _WIN32
+    #include <io.h>
+    #include <fcntl.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+using namespace gambit;
+
+class AsyncIoTest : public ::testing::TestWithParam<AsyncIo::Backend> {
+protected:
+    std::string dir;
+
+    void SetUp() override {
+        dir = (std::filesystem::temp_directory_path() /
+               ("gambit_aio_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) + "_" +
+                std::to_string(static_cast<int>(GetParam())))).string();
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    static int openFile(const std::string& path) {
+#ifdef _WIN32
+        return _open(path.c_str(), _O_RDWR | _O_CREAT | _O_BINARY, 0644);
+#else
+        return ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+#endif
+    }
+
+    static void closeFile(int fd) {
+#ifdef _WIN32
+        _close(fd);
+#else
+        ::close(fd);
+#endif
+    }
+
+    // Blocks 0 .. n-1, one signed transaction each with nonce == height
+    static void fill(BlockStore& store, std::uint64_t n) {
+        KeyPair kp = KeyPair::random();
+        for (std::uint64_t i = 0; i < n; ++i) {
+            Block b(i, keccak256_32("prev"), keccak256_32("before"), keccak256_32("after" + std::to_string(i)),
+                    keccak256_32("txroot"), ZkProver::generate(keccak256_32("before"), keccak256_32("after"), keccak256_32("txroot")));
+            Transaction tx;
+            tx.nonce = i;
+            tx.chainId = 1337;
+            tx.signWith(kp);
+            b.transactions.push_back(tx);
+            store.append(b.rlpEncode());
+        }
+    }
+};
+
+// Queued writes land, then many reads in flight at once return the data
+TEST_P(AsyncIoTest, WriteThenReadBack) {
+    auto io = AsyncIo::create(32, GetParam());
+    if (GetParam() == AsyncIo::Backend::Pread) {
+        EXPECT_EQ(io->backend(), AsyncIo::Backend::Pread);
+    }
+
+    int fd = openFile(dir + "/data");
+    ASSERT_GE(fd, 0);
+    constexpr std::size_t kBlock = 4096;
+    constexpr std::size_t kBlocks = 64;
+    std::vector<Bytes> blocks(kBlocks, Bytes(kBlock));
+    std::mt19937 rng(5);
+    for (auto& b : blocks) for (auto& x : b) x = static_cast<std::uint8_t>(rng());
+
+    std::size_t written = 0;
+    for (std::size_t i = 0; i < kBlocks; ++i) {
+        io->write(fd, blocks[i].data(), kBlock, i * kBlock, [&](std::int64_t r) { written += r == kBlock; });
+    }
+    io->drain();
+    EXPECT_EQ(written, kBlocks);
+
+    // More reads than the queue depth, in random order
+    std::vector<Bytes> out(200, Bytes(kBlock));
+    std::vector<std::size_t> which(out.size());
+    std::size_t matched = 0;
+    for (std::size_t i = 0; i < out.size(); ++i) {
+        which[i] = rng() % kBlocks;
+        io->read(fd, out[i].data(), kBlock, which[i] * kBlock,
+                 [&, i](std::int64_t r) { matched += r == kBlock && out[i] == blocks[which[i]]; });
+    }
+    EXPECT_EQ(io->queued(), out.size());
+    io->drain();
+    EXPECT_EQ(matched, out.size());
+    EXPECT_EQ(io->inFlight(), 0u);
+
+    // Reads past the end come back short; a bad descriptor reports -errno
+    Bytes tail(100);
+    std::int64_t shortRead = -1;
+    std::int64_t badFd = 0;
+    io->read(fd, tail.data(), tail.size(), kBlocks * kBlock - 10, [&](std::int64_t r) { shortRead = r; });
+    io->read(-1, tail.data(), tail.size(), 0, [&](std::int64_t r) { badFd = r; });
+    io->drain();
+    EXPECT_EQ(shortRead, 10);
+    EXPECT_EQ(badFd, -EBADF);
+    closeFile(fd);
+}
+
+// Async block reads return the same blocks as the mapped path
+TEST_P(AsyncIoTest, BlockStoreReads) {
+    auto io = AsyncIo::create(16, GetParam());
+    BlockStore store(dir + "/blocks", 8192);
+    fill(store, 40);
+    ASSERT_GT(store.segments(), 1u);
+
+    std::size_t ok = 0;
+    for (std::uint64_t i = 0; i < 40; ++i) {
+        std::uint64_t n = (i * 7) % 40;
+        store.readAsync(*io, n, [&, n](std::optional<BlockView> v) {
+            ok += v && v->hash() == store.get(n).hash() && v->transaction(0).nonce == n;
+        });
+    }
+    io->drain();
+    EXPECT_EQ(ok, 40u);
+    EXPECT_THROW(store.readAsync(*io, 40, [](std::optional<BlockView>) {}), std::out_of_range);
+}
+
+#ifdef __linux__
+// The fd of a pruned segment is closed once the read queued on it has
+// run, so the deleted file's space is given back
+TEST_P(AsyncIoTest, PrunedSegmentFdClosed) {
+    auto io = AsyncIo::create(16, GetParam());
+    BlockStore store(dir + "/blocks", 8192);
+    fill(store, 40);
+
+    // Open descriptors of deleted segment files
+    auto deletedFds = [&] {
+        std::size_t n = 0;
+        for (const auto& e : std::filesystem::directory_iterator("/proc/self/fd")) {
+            std::error_code ec;
+            std::string target = std::filesystem::read_symlink(e.path(), ec).string();
+            n += !ec && target.find("seg-") != std::string::npos && target.find("(deleted)") != std::string::npos;
+        }
+        return n;
+    };
+
+    std::optional<std::uint64_t> read;
+    store.readAsync(*io, 0, [&](std::optional<BlockView> v) {
+        if (v) read = v->transaction(0).nonce;
+    });
+    ASSERT_GT(store.prune(store.segmentEnd(0)), 0u);
+    EXPECT_EQ(deletedFds(), 1u);
+
+    io->drain();
+    EXPECT_EQ(read, 0u);
+    EXPECT_EQ(deletedFds(), 0u);
+}
+#endif
+
+INSTANTIATE_TEST_SUITE_P(Backends, AsyncIoTest,
+                         ::testing::Values(AsyncIo::Backend::IoUring, AsyncIo::Backend::Pread));
@@ -33,17 +33,17 @@ TEST_F(BlockTest, DefaultConstruction) {
     Block block;
     
     EXPECT_EQ(block.index, 0u);
-    EXPECT_TRUE(block.prevHash.empty());
+    EXPECT_EQ(block.prevHash, Bytes32{});
     EXPECT_EQ(block.timestamp, 0u);
     EXPECT_TRUE(block.transactions.empty());
 }
 
 // Test block construction with parameters
 TEST_F(BlockTest, ParameterizedConstruction) {
-    std::string prevHash = "0x1234";
-    std::string stateBefore = "0xabcd";
-    std::string stateAfter = "0xef01";
-    std::string txRoot = "0x5678";
+    Bytes32 prevHash = keccak256_32("1234");
+    Bytes32 stateBefore = keccak256_32("abcd");
+    Bytes32 stateAfter = keccak256_32("ef01");
+    Bytes32 txRoot = keccak256_32("5678");
     ZkProof proof;
     
     Block block(1, prevHash, stateBefore, stateAfter, txRoot, proof);
@@ -59,16 +59,16 @@ TEST_F(BlockTest, ParameterizedConstruction) {
 TEST_F(BlockTest, ComputeHash) {
     Block block;
     block.index = 1;
-    block.prevHash = "0x0000000000000000000000000000000000000000000000000000000000000000";
+    block.prevHash = Bytes32{};
     block.timestamp = 1234567890;
     
-    std::string hash = block.computeHash();
+    Bytes32 hash = block.computeHash();
     
     // Hash should not be empty
-    EXPECT_FALSE(hash.empty());
+    EXPECT_NE(hash, Bytes32{});
     
     // Hash should be deterministic
-    std::string hash2 = block.computeHash();
+    Bytes32 hash2 = block.computeHash();
     EXPECT_EQ(hash, hash2);
 }
 
@@ -76,12 +76,12 @@ TEST_F(BlockTest, ComputeHash) {
 TEST_F(BlockTest, DifferentHashes) {
     Block block1;
     block1.index = 1;
-    block1.prevHash = "0x0000";
+    block1.prevHash = Bytes32{};
     block1.timestamp = 1000;
     
     Block block2;
     block2.index = 2;
-    block2.prevHash = "0x0000";
+    block2.prevHash = Bytes32{};
     block2.timestamp = 1000;
     
     EXPECT_NE(block1.computeHash(), block2.computeHash());
@@ -91,7 +91,7 @@ TEST_F(BlockTest, DifferentHashes) {
 TEST_F(BlockTest, RlpEncode) {
     Block block;
     block.index = 1;
-    block.prevHash = "0x0000";
+    block.prevHash = Bytes32{};
     block.timestamp = 1234567890;
     
     Bytes encoded = block.rlpEncode();
@@ -107,9 +107,9 @@ TEST_F(BlockTest, RlpEncode) {
 TEST_F(BlockTest, RlpDecode) {
     Block original;
     original.index = 42;
-    original.prevHash = "0xdeadbeef";
-    original.stateBefore = "0xaabb";
-    original.stateAfter = "0xccdd";
+    original.prevHash = keccak256_32("deadbeef");
+    original.stateBefore = keccak256_32("aabb");
+    original.stateAfter = keccak256_32("ccdd");
     original.timestamp = 1234567890;
     
     Bytes encoded = original.rlpEncode();
@@ -117,6 +117,8 @@ TEST_F(BlockTest, RlpDecode) {
     
     EXPECT_EQ(decoded.index, original.index);
     EXPECT_EQ(decoded.prevHash, original.prevHash);
+    EXPECT_EQ(decoded.stateBefore, original.stateBefore);
+    EXPECT_EQ(decoded.stateAfter, original.stateAfter);
     EXPECT_EQ(decoded.timestamp, original.timestamp);
 }
 
@@ -124,7 +126,7 @@ TEST_F(BlockTest, RlpDecode) {
 TEST_F(BlockTest, ToHex) {
     Block block;
     block.index = 1;
-    block.prevHash = "0x0000";
+    block.prevHash = Bytes32{};
     block.timestamp = 1234567890;
     
     std::string hex = block.toHex();
@@ -140,7 +142,7 @@ TEST_F(BlockTest, ToHex) {
 TEST_F(BlockTest, FromHex) {
     Block original;
     original.index = 42;
-    original.prevHash = "0xdeadbeef";
+    original.prevHash = keccak256_32("deadbeef");
     original.timestamp = 1234567890;
     
     std::string hex = original.toHex();
@@ -155,7 +157,7 @@ TEST_F(BlockTest, FromHex) {
 TEST_F(BlockTest, BlockWithTransactions) {
     Block block;
     block.index = 1;
-    block.prevHash = "0x0000";
+    block.prevHash = Bytes32{};
     block.timestamp = 1234567890;
     
     // Add some test transactions
@@ -165,41 +167,36 @@ TEST_F(BlockTest, BlockWithTransactions) {
     EXPECT_EQ(block.transactions.size(), 2u);
     
     // Compute hash should still work
-    std::string hash = block.computeHash();
-    EXPECT_FALSE(hash.empty());
+    Bytes32 hash = block.computeHash();
+    EXPECT_NE(hash, Bytes32{});
 }
 
 // Test genesis block (index 0)
 TEST_F(BlockTest, GenesisBlock) {
     Block genesis;
     genesis.index = 0;
-    genesis.prevHash = "0x0000000000000000000000000000000000000000000000000000000000000000";
+    genesis.prevHash = Bytes32{};
     genesis.timestamp = 0;
     
     EXPECT_EQ(genesis.index, 0u);
     
-    std::string hash = genesis.computeHash();
-    EXPECT_FALSE(hash.empty());
+    Bytes32 hash = genesis.computeHash();
+    EXPECT_NE(hash, Bytes32{});
 }
 
 // Test block hash format
 TEST_F(BlockTest, HashFormat) {
     Block block;
     block.index = 1;
-    block.prevHash = "0x0000";
+    block.prevHash = Bytes32{};
     block.timestamp = 1234567890;
     
-    std::string hash = block.computeHash();
+    Bytes32 hash = block.computeHash();
     
-    // Should be hex format
-    for (char c : hash) {
-        if (c != 'x') {
-            bool isHex = (c >= '0' && c <= '9') || 
-                         (c >= 'a' && c <= 'f') || 
-                         (c >= 'A' && c <= 'F');
-            EXPECT_TRUE(isHex);
-        }
-    }
+    // Binary in the block; any header change moves it
+    EXPECT_EQ(toHex(hash).size(), 64u);
+    block.stateAfter[31] ^= 0x01;
+    EXPECT_NE(block.computeHash(), hash);
 }
 
 // Test logs bloom in block
@@ -221,10 +218,58 @@ TEST_F(BlockTest, LogsBloom) {
 TEST_F(BlockTest, BlockWithReceipts) {
     Block block;
     block.index = 1;
-    block.prevHash = "0x0000";
+    block.prevHash = Bytes32{};
     block.timestamp = 1234567890;
     
     // Receipts vector should be available
     EXPECT_TRUE(block.receipts.empty());
 }
 
+
+// The header encodes and hashes on its own; the block hash is the
+// header hash, and headers decode from a block without its body
+TEST_F(BlockTest, HeaderEncodedSeparately) {
+    Block block(3, keccak256_32("prev"), keccak256_32("before"), keccak256_32("after"),
+                keccak256_32("txroot"), ZkProof{});
+    block.receiptsRoot = keccak256_32("receipts");
+    block.logsBloom.bits[7] = 0x40;
+    block.hash = block.computeHash();
+    block.transactions.push_back(createTestTransaction());
+
+    Bytes header = block.header().rlpEncode();
+    EXPECT_EQ(block.hash, keccak256_32(header));
+
+    BlockHeader decoded = BlockHeader::rlpDecode(header);
+    EXPECT_EQ(decoded.rlpEncode(), header);
+    EXPECT_EQ(decoded.receiptsRoot, block.receiptsRoot);
+    EXPECT_EQ(decoded.logsBloom.bits, block.logsBloom.bits);
+
+    Bytes encoded = block.rlpEncode();
+    EXPECT_EQ(Block::decodeHeader(encoded.data(), encoded.size()).rlpEncode(), header);
+
+    // Bodies do not move the hash
+    Block other = block;
+    other.transactions.clear();
+    EXPECT_EQ(other.computeHash(), block.hash);
+
+    header.pop_back();
+    EXPECT_THROW(BlockHeader::rlpDecode(header), std::runtime_error);
+}
+
+// Blocks from peers decode without recovering senders; recoverSenders
+// fills them in once
+TEST_F(BlockTest, FromHexDefersSenders) {
+    Block block;
+    block.index = 1;
+    block.transactions.push_back(createTestTransaction());
+    Address sender = block.transactions[0].from;
+
+    Block received = Block::fromHex(block.toHex());
+    EXPECT_FALSE(received.sendersRecovered);
+    EXPECT_EQ(received.transactions[0].hash, block.transactions[0].hash);
+
+    received.recoverSenders();
+    EXPECT_TRUE(received.sendersRecovered);
+    EXPECT_EQ(received.transactions[0].from, sender);
+    EXPECT_TRUE(Block::rlpDecode(block.rlpEncode()).sendersRecovered);
+}
@@ -0,0 +1,253 @@
+#include <gtest/gtest.h>
+#include "gambit/block_importer.hpp"
+#include "gambit/chain_file.hpp"
+#include "gambit/keys.hpp"
+#include "gambit/zk_mining_engine.hpp"
+
+#include <sstream>
+
+using namespace gambit;
+
+class BlockImporterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        for (int i = 0; i < 4; ++i) keys.push_back(KeyPair::random());
+        genesis.chainId = 1337;
+        for (const auto& k : keys) genesis.premine.push_back({k.address(), 1000000});
+    }
+    void TearDown() override {}
+
+    std::vector<KeyPair> keys;
+    GenesisConfig genesis;
+
+    Transaction signedTransfer(std::size_t from, std::uint64_t nonce, std::uint64_t value) const {
+        Transaction tx;
+        tx.nonce = nonce;
+        tx.gasPrice = 1;
+        tx.gasLimit = 21000;
+        tx.to = keys[(from + 1) % keys.size()].address();
+        tx.value = value;
+        tx.chainId = 1337;
+        tx.signWith(keys[from]);
+        return tx;
+    }
+
+    // Mines `blocks` blocks of `perBlock` transfers each on a fresh chain
+    std::vector<Bytes> mineChain(Blockchain& chain, std::size_t blocks, std::size_t perBlock) const {
+        std::vector<std::uint64_t> nonces(keys.size(), 0);
+        std::vector<Bytes> out;
+        for (std::size_t b = 0; b < blocks; ++b) {
+            for (std::size_t i = 0; i < perBlock; ++i) {
+                std::size_t from = (b + i) % keys.size();
+                chain.addTransaction(signedTransfer(from, nonces[from]++, 10 + i));
+            }
+            out.push_back(chain.mineBlock().rlpEncode());
+        }
+        return out;
+    }
+};
+
+// Importing another node's blocks reproduces its head and state
+TEST_F(BlockImporterTest, ImportMatchesSource) {
+    Blockchain source(genesis);
+    std::vector<Bytes> blocks = mineChain(source, 12, 20);
+
+    Blockchain chain(genesis);
+    BlockImporter importer(chain, 4, 2);
+    for (const auto& b : blocks) EXPECT_TRUE(importer.submit(b));
+    BlockImporter::Result r = importer.finish();
+
+    EXPECT_TRUE(r.ok) << r.error;
+    EXPECT_EQ(r.blocks, 12u);
+    EXPECT_EQ(r.txs, 240u);
+    EXPECT_EQ(chain.height(), 12u);
+    EXPECT_EQ(chain.head().hash(), source.head().hash());
+    EXPECT_EQ(chain.state().root(), source.state().root());
+    EXPECT_EQ(chain.snapshot().root(), source.state().root());
+    EXPECT_TRUE(chain.findTransaction(source.blockView(7).transaction(3).hash).has_value());
+}
+
+// The first block with a wrong post-state root stops the import
+TEST_F(BlockImporterTest, StopsAtBadRoot) {
+    Blockchain source(genesis);
+    std::vector<Bytes> blocks = mineChain(source, 6, 3);
+
+    Block bad = Block::rlpDecode(blocks[3]);
+    bad.stateAfter = bad.stateBefore;
+    bad.proof = ZkProver::generate(bad.stateBefore, bad.stateAfter, bad.txRoot);
+    blocks[3] = bad.rlpEncode();
+
+    Blockchain chain(genesis);
+    BlockImporter importer(chain);
+    for (const auto& b : blocks) importer.submit(b);
+    BlockImporter::Result r = importer.finish();
+
+    EXPECT_FALSE(r.ok);
+    EXPECT_EQ(r.failedIndex, 4u);
+    EXPECT_EQ(r.blocks, 3u);
+    EXPECT_EQ(chain.height(), 3u);
+    EXPECT_EQ(chain.head().hash(), source.blockView(3).hash());
+    EXPECT_FALSE(importer.submit(blocks[5]));
+}
+
+// A forged signature fails sender recovery or execution, not the process
+TEST_F(BlockImporterTest, RejectsForgedSender) {
+    Blockchain source(genesis);
+    std::vector<Bytes> blocks = mineChain(source, 2, 10);
+
+    Block forged = Block::rlpDecode(blocks[1]);
+    forged.transactions[4].value = 999999;   // signature no longer matches
+    blocks[1] = forged.rlpEncode();
+
+    Blockchain chain(genesis);
+    BlockImporter importer(chain, 2);
+    for (const auto& b : blocks) importer.submit(b);
+    BlockImporter::Result r = importer.finish();
+
+    EXPECT_FALSE(r.ok);
+    EXPECT_EQ(r.failedIndex, 2u);
+    EXPECT_EQ(chain.height(), 1u);
+}
+
+// addBlock re-executes received blocks and applies their writes
+TEST_F(BlockImporterTest, AddBlockReexecutes) {
+    Blockchain chain(genesis);
+    chain.addTransaction(signedTransfer(0, 0, 500));
+    ZkMiningEngine engine;
+    Block tmpl = engine.buildBlockTemplate(chain);
+
+    Block lie = tmpl;
+    lie.stateAfter = lie.stateBefore;
+    lie.proof = ZkProver::generate(lie.stateBefore, lie.stateAfter, lie.txRoot);
+    EXPECT_FALSE(chain.addBlock(lie));
+
+    ASSERT_TRUE(chain.addBlock(tmpl));
+    EXPECT_EQ(chain.state().root(), tmpl.stateAfter);
+    EXPECT_EQ(chain.snapshot().get(keys[1].address())->balance, 1000500u);
+    EXPECT_TRUE(chain.mempool().empty());
+}
+
+// A block whose hash or proof does not match its header or whose
+// transactions do not match its tx root is refused before execution
+TEST_F(BlockImporterTest, RejectsBadProofAndTxRoot) {
+    Blockchain source(genesis);
+    std::vector<Bytes> blocks = mineChain(source, 3, 4);
+    const char* errors[] = {"invalid proof", "transaction root mismatch", "block hash mismatch"};
+
+    for (int c = 0; c < 3; ++c) {
+        std::vector<Bytes> copy = blocks;
+        Block bad = Block::rlpDecode(copy[1]);
+        if (c == 0) {
+            bad.proof.commitment[0] ^= 0x01;
+            bad.hash = bad.computeHash();
+        } else if (c == 1) {
+            bad.transactions.pop_back();
+        } else {
+            bad.timestamp += 1;
+        }
+        copy[1] = bad.rlpEncode();
+
+        Blockchain chain(genesis);
+        BlockImporter importer(chain, 2);
+        for (const auto& b : copy) importer.submit(b);
+        BlockImporter::Result r = importer.finish();
+        EXPECT_FALSE(r.ok);
+        EXPECT_EQ(r.failedIndex, 2u);
+        EXPECT_EQ(r.error, errors[c]);
+        EXPECT_EQ(chain.height(), 1u);
+    }
+}
+
+// A block that carries one signed transaction twice, with a consistent
+// header, fails on the replayed nonce instead of paying out twice
+TEST_F(BlockImporterTest, RejectsDuplicatedTransaction) {
+    Blockchain source(genesis);
+    std::vector<Bytes> blocks = mineChain(source, 3, 4);
+
+    Block dup = Block::rlpDecode(blocks[1]);
+    dup.transactions.push_back(dup.transactions[0]);
+    dup.txRoot = source.computeTxRoot(dup.transactions);
+    dup.proof = ZkProver::generate(dup.stateBefore, dup.stateAfter, dup.txRoot);
+    dup.hash = dup.computeHash();
+    blocks[1] = dup.rlpEncode();
+
+    Blockchain chain(genesis);
+    BlockImporter importer(chain, 2);
+    for (const auto& b : blocks) importer.submit(b);
+    BlockImporter::Result r = importer.finish();
+    EXPECT_FALSE(r.ok);
+    EXPECT_EQ(r.failedIndex, 2u);
+    EXPECT_EQ(r.error, "tx 4: Invalid nonce");
+    EXPECT_EQ(chain.height(), 1u);
+    EXPECT_FALSE(chain.addBlock(dup));
+}
+
+// Receipts are rebuilt from execution: made-up receipts are refused
+// whether or not the header's receiptsRoot was forged to match them
+TEST_F(BlockImporterTest, RejectsForgedReceipts) {
+    Blockchain source(genesis);
+    std::vector<Bytes> blocks = mineChain(source, 3, 4);
+
+    for (bool forgeRoot : {false, true}) {
+        Block bad = Block::rlpDecode(blocks[1]);
+        bad.receipts[2].cumulativeGasUsed = 1;
+        bad.receipts[2].status = false;
+        if (forgeRoot) {
+            bad.receiptsRoot = source.computeReceiptsRoot(bad.receipts);
+            bad.hash = bad.computeHash();
+        }
+        std::vector<Bytes> copy = blocks;
+        copy[1] = bad.rlpEncode();
+
+        Blockchain chain(genesis);
+        BlockImporter importer(chain, 2);
+        for (const auto& b : copy) importer.submit(b);
+        BlockImporter::Result r = importer.finish();
+        EXPECT_FALSE(r.ok);
+        EXPECT_EQ(r.failedIndex, 2u);
+        EXPECT_EQ(r.error, "receipts root mismatch");
+        EXPECT_EQ(chain.height(), 1u);
+        EXPECT_FALSE(chain.addBlock(bad));
+        EXPECT_TRUE(chain.addBlock(Block::rlpDecode(blocks[1])));
+    }
+}
+
+// An exported chain imports into a fresh node; rerunning an import skips
+// blocks already present, and a cut-off stream is reported
+TEST_F(BlockImporterTest, ExportImportRoundTrip) {
+    Blockchain source(genesis);
+    mineChain(source, 8, 5);
+
+    std::stringstream file;
+    EXPECT_EQ(exportChain(source, file, 1, source.height()), 8u);
+    std::string bytes = file.str();
+
+    Blockchain chain(genesis);
+    {
+        std::istringstream half(bytes);
+        ChainFileReader reader(half);
+        BlockImporter importer(chain, 2);
+        for (int i = 0; i < 3; ++i) importer.submit(*reader.next());
+        EXPECT_EQ(importer.finish().blocks, 3u);
+    }
+    {
+        std::istringstream in(bytes);
+        ChainFileReader reader(in);
+        BlockImporter importer(chain, 2);
+        std::uint64_t calls = 0;
+        EXPECT_EQ(importChain(chain, reader, importer, [&](std::uint64_t) { ++calls; }), 5u);
+        EXPECT_EQ(calls, 5u);
+        BlockImporter::Result r = importer.finish();
+        EXPECT_TRUE(r.ok) << r.error;
+        EXPECT_EQ(r.txs, 25u);
+        EXPECT_EQ(reader.bytesRead(), bytes.size());
+    }
+    EXPECT_EQ(chain.height(), 8u);
+    EXPECT_EQ(chain.head().hash(), source.head().hash());
+    EXPECT_EQ(chain.state().root(), source.state().root());
+
+    std::istringstream cut(bytes.substr(0, bytes.size() - 10));
+    ChainFileReader reader(cut);
+    for (int i = 0; i < 7; ++i) EXPECT_TRUE(reader.next().has_value());
+    EXPECT_THROW(reader.next(), std::runtime_error);
+}
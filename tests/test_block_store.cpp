@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+#include "gambit/block_store.hpp"
+#include "gambit/blockchain.hpp"
+#include "gambit/keys.hpp"
+#include "test_util.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace gambit;
+using namespace gambit::testutil;
+
+class BlockStoreTest : public ::testing::Test {
+protected:
+    std::string dir;
+
+    void SetUp() override {
+        dir = (std::filesystem::temp_directory_path() /
+               ("gambit_blocks_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) +
+                "_" + ::testing::UnitTest::GetInstance()->current_test_info()->name())).string();
+        std::filesystem::remove_all(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    static void appendGarbage(const std::string& path, std::size_t n) {
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        out << std::string(n, '\x5a');
+    }
+};
+
+// Block RLP round trip keeps transactions, receipts and roots
+TEST_F(BlockStoreTest, BlockRoundTrip) {
+    Block b = makeBlock(7, 3);
+    Receipt rc;
+    rc.cumulativeGasUsed = 42000;
+    rc.logs.push_back(Log{b.transactions[0].to, {keccak256_32("topic")}, Bytes{1, 2, 3}});
+    b.receipts.push_back(rc);
+    b.receiptsRoot = keccak256_32("rroot");
+
+    Block d = Block::rlpDecode(b.rlpEncode());
+    EXPECT_EQ(d.index, 7u);
+    EXPECT_EQ(d.hash, b.hash);
+    EXPECT_EQ(d.receiptsRoot, keccak256_32("rroot"));
+    ASSERT_EQ(d.transactions.size(), 3u);
+    EXPECT_EQ(d.transactions[2].hash, b.transactions[2].hash);
+    EXPECT_EQ(d.transactions[2].from, b.transactions[2].from);
+    ASSERT_EQ(d.receipts.size(), 1u);
+    EXPECT_EQ(d.receipts[0].cumulativeGasUsed, 42000u);
+    ASSERT_EQ(d.receipts[0].logs.size(), 1u);
+    EXPECT_EQ(d.receipts[0].logs[0].topics, rc.logs[0].topics);
+    EXPECT_EQ(d.receipts[0].logs[0].data, (Bytes{1, 2, 3}));
+}
+
+// Views read header fields and single transactions in place
+TEST_F(BlockStoreTest, ViewMatchesBlock) {
+    BlockStore store;
+    Block b = makeBlock(0, 4);
+    EXPECT_EQ(store.append(b.rlpEncode()), 0u);
+
+    BlockView v = store.get(0);
+    EXPECT_EQ(v.index(), b.index);
+    EXPECT_EQ(v.timestamp(), b.timestamp);
+    EXPECT_EQ(v.hash(), b.hash);
+    EXPECT_EQ(v.prevHash(), b.prevHash);
+    EXPECT_EQ(v.stateAfter(), b.stateAfter);
+    EXPECT_EQ(v.txRoot(), b.txRoot);
+    EXPECT_EQ(v.header().rlpEncode(), b.header().rlpEncode());
+    EXPECT_EQ(store.header(0).computeHash(), b.hash);
+    ASSERT_EQ(v.txCount(), 4u);
+    EXPECT_EQ(v.transaction(3).hash, b.transactions[3].hash);
+    EXPECT_THROW(v.transaction(4), std::out_of_range);
+    EXPECT_EQ(v.toBlock().hash, b.hash);
+    EXPECT_THROW(store.get(1), std::out_of_range);
+}
+
+// Blocks survive reopening and roll over into new segments
+TEST_F(BlockStoreTest, PersistsAcrossSegments) {
+    std::vector<Block> blocks;
+    {
+        BlockStore store(dir, 2048);
+        for (std::uint64_t i = 0; i < 20; ++i) {
+            blocks.push_back(makeBlock(i, 2));
+            store.append(blocks.back().rlpEncode());
+            EXPECT_EQ(store.get(i / 2).hash(), blocks[i / 2].hash);
+        }
+        EXPECT_GT(store.segments(), 1u);
+    }
+
+    BlockStore store(dir, 2048);
+    ASSERT_EQ(store.size(), 20u);
+    for (std::uint64_t i = 0; i < 20; ++i) {
+        BlockView v = store.get(i);
+        EXPECT_EQ(v.index(), i);
+        EXPECT_EQ(v.hash(), blocks[i].hash);
+        EXPECT_EQ(v.transaction(1).hash, blocks[i].transactions[1].hash);
+    }
+}
+
+#ifndef _WIN32
+// The active segment is mapped once: blocks appended after the first
+// read come through the same mapping
+TEST_F(BlockStoreTest, ActiveSegmentMappedOnce) {
+    BlockStore store(dir, 1 << 20);
+    store.append(makeBlock(0, 2).rlpEncode());
+    BlockView first = store.get(0);
+    for (std::uint64_t i = 1; i < 10; ++i) {
+        Block b = makeBlock(i, 2);
+        store.append(b.rlpEncode());
+        BlockView v = store.get(i);
+        EXPECT_EQ(v.hash(), b.hash);
+        EXPECT_EQ(store.get(0).data(), first.data());
+    }
+}
+#endif
+
+// A torn tail write is dropped on open and appends continue after it
+TEST_F(BlockStoreTest, RecoversTornTail) {
+    std::size_t segments = 0;
+    {
+        BlockStore store(dir, 4096);
+        for (std::uint64_t i = 0; i < 6; ++i) store.append(makeBlock(i, 1).rlpEncode());
+        segments = store.segments();
+    }
+    // Half an index entry, and segment bytes that were never indexed
+    appendGarbage(dir + "/index.dat", 7);
+    char name[32];
+    std::snprintf(name, sizeof(name), "/seg-%05zu.dat", segments - 1);
+    appendGarbage(dir + name, 300);
+
+    {
+        BlockStore store(dir, 4096);
+        EXPECT_EQ(store.size(), 6u);
+        Block b = makeBlock(6, 1);
+        EXPECT_EQ(store.append(b.rlpEncode()), 6u);
+        EXPECT_EQ(store.get(6).hash(), b.hash);
+    }
+
+    BlockStore store(dir, 4096);
+    ASSERT_EQ(store.size(), 7u);
+    EXPECT_EQ(store.get(5).index(), 5u);
+    EXPECT_EQ(store.get(6).index(), 6u);
+}
+
+// Truncated blocks stay gone after reopening; new blocks take their place
+TEST_F(BlockStoreTest, TruncateAndReopen) {
+    {
+        BlockStore store(dir, 2048);
+        for (std::uint64_t i = 0; i < 12; ++i) store.append(makeBlock(i, 2).rlpEncode());
+        store.truncate(5);
+        EXPECT_EQ(store.size(), 5u);
+        EXPECT_THROW(store.get(5), std::out_of_range);
+        Block b = makeBlock(5, 3);
+        EXPECT_EQ(store.append(b.rlpEncode()), 5u);
+        EXPECT_EQ(store.get(5).txCount(), 3u);
+    }
+
+    BlockStore store(dir, 2048);
+    ASSERT_EQ(store.size(), 6u);
+    EXPECT_EQ(store.get(4).index(), 4u);
+    EXPECT_EQ(store.get(5).txCount(), 3u);
+
+    BlockStore mem;
+    mem.append(makeBlock(0, 1).rlpEncode());
+    mem.append(makeBlock(1, 1).rlpEncode());
+    mem.truncate(1);
+    EXPECT_EQ(mem.size(), 1u);
+}
+
+// A node restarted on the same data dir replays its stored blocks
+TEST_F(BlockStoreTest, BlockchainRestart) {
+    KeyPair kp = KeyPair::random();
+    GenesisConfig g;
+    g.chainId = 1337;
+    g.premine.push_back({kp.address(), 1000000});
+
+    Bytes32 head;
+    Bytes32 root;
+    {
+        Blockchain chain(g);
+        chain.setDataDir(dir);
+        for (std::uint64_t n = 0; n < 3; ++n) {
+            chain.addTransaction(signedTransfer(kp, n, 1000 * (n + 1)));
+            chain.mineBlock();
+        }
+        head = chain.head().hash();
+        root = chain.state().root();
+    }
+
+    Blockchain chain(g);
+    chain.setDataDir(dir);
+    EXPECT_EQ(chain.height(), 3u);
+    EXPECT_EQ(chain.head().hash(), head);
+    EXPECT_EQ(chain.state().root(), root);
+    EXPECT_EQ(chain.snapshot().root(), root);
+    EXPECT_EQ(chain.blockAt(2).transactions.size(), 1u);
+    EXPECT_EQ(chain.blockByHash(head)->index(), 3u);
+
+    GenesisConfig other = g;
+    other.premine[0].balance = 1;
+    Blockchain mismatched(other);
+    EXPECT_THROW(mismatched.setDataDir(dir), std::runtime_error);
+}
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include "gambit/chain_index.hpp"
+#include "gambit/blockchain.hpp"
+#include "gambit/keys.hpp"
+#include "test_util.hpp"
+
+using namespace gambit;
+using namespace gambit::testutil;
+
+class ChainIndexTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+};
+
+// Lookups by binary hash; hex (any case, with or without 0x) is parsed
+// only at the RPC boundary
+TEST_F(ChainIndexTest, IndexesBinaryHashes) {
+    Block b(4, keccak256_32("prev"), keccak256_32("before"), keccak256_32("after"), keccak256_32("txroot"),
+            ZkProver::generate(keccak256_32("before"), keccak256_32("after"), keccak256_32("txroot")));
+    Transaction tx = signedTransfer(KeyPair::random(), 0, 1);
+    b.transactions = {Transaction{}, tx};
+
+    ChainIndex index;
+    index.add(b);
+
+    std::string upper = toHex(b.hash);
+    for (char& c : upper) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    EXPECT_EQ(index.blockHeight(b.hash), 4u);
+    EXPECT_EQ(index.blockHeight(fromHex32("0x" + toHex(b.hash))), 4u);
+    EXPECT_EQ(index.blockHeight(fromHex32(upper)), 4u);
+    EXPECT_FALSE(index.blockHeight(keccak256_32("other")).has_value());
+    EXPECT_THROW(fromHex32("0xdeadbeef"), std::runtime_error);
+
+    auto loc = index.transaction(tx.hash);
+    ASSERT_TRUE(loc.has_value());
+    EXPECT_EQ(loc->height, 4u);
+    EXPECT_EQ(loc->position, 1u);
+
+    // Unsigned transactions have no hash and are not indexed
+    EXPECT_EQ(index.transactions(), 1u);
+
+    index.remove(b);
+    EXPECT_FALSE(index.blockHeight(b.hash).has_value());
+    EXPECT_EQ(index.transactions(), 0u);
+}
+
+// Mined blocks, their transactions and receipts are found by hash
+TEST_F(ChainIndexTest, BlockchainLookups) {
+    KeyPair kp = KeyPair::random();
+    GenesisConfig g;
+    g.chainId = 1337;
+    g.premine.push_back({kp.address(), 1000000});
+    Blockchain chain(g);
+
+    std::vector<Transaction> txs;
+    for (std::uint64_t n = 0; n < 3; ++n) {
+        txs.push_back(signedTransfer(kp, n, 10 + n));
+        chain.addTransaction(txs.back());
+    }
+    Block b = chain.mineBlock();
+
+    auto view = chain.blockByHash(b.hash);
+    ASSERT_TRUE(view.has_value());
+    EXPECT_EQ(view->index(), 1u);
+    EXPECT_EQ(chain.blockByHash(chain.blockView(0).hash())->index(), 0u);
+
+    auto loc = chain.findTransaction(txs[2].hash);
+    ASSERT_TRUE(loc.has_value());
+    EXPECT_EQ(loc->height, 1u);
+    EXPECT_EQ(loc->position, 2u);
+    EXPECT_EQ(view->transaction(loc->position).hash, txs[2].hash);
+    ASSERT_EQ(view->receiptCount(), 3u);
+    EXPECT_EQ(view->receipt(loc->position).cumulativeGasUsed, 3 * 21000u);
+
+    EXPECT_FALSE(chain.findTransaction(Bytes32{}).has_value());
+}
@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+#include "gambit/blockchain.hpp"
+#include "gambit/change_feed.hpp"
+#include "gambit/keys.hpp"
+
+#include <thread>
+
+using namespace gambit;
+
+namespace {
+
+ChainEvent eventAt(std::uint64_t n) {
+    ChainEvent e;
+    e.kind = ChainEvent::Kind::Account;
+    e.height = n;
+    e.account.nonce = n * 3;
+    e.account.balance = n * 7;
+    return e;
+}
+
+// Everything published that the consumer has not read yet
+std::vector<ChainEvent> drain(ChangeFeed::Subscription& sub) {
+    std::vector<ChainEvent> out;
+    while (auto e = sub.poll()) out.push_back(*e);
+    return out;
+}
+
+} // namespace
+
+// Every consumer sees events in publish order; a Drop consumer that is a
+// ring behind skips to the oldest event still held and counts the rest
+TEST(ChangeFeedTest, OrderAndDropPolicy) {
+    ChangeFeed feed(5);
+    EXPECT_EQ(feed.capacity(), 8u);
+
+    auto early = feed.subscribe();
+    feed.publish(eventAt(0));
+    auto late = feed.subscribe();
+    for (std::uint64_t n = 1; n < 4; ++n) feed.publish(eventAt(n));
+
+    std::vector<ChainEvent> got = drain(*early);
+    ASSERT_EQ(got.size(), 4u);
+    for (std::uint64_t n = 0; n < 4; ++n) {
+        EXPECT_EQ(got[n].height, n);
+        EXPECT_EQ(got[n].account.balance, n * 7);
+    }
+    EXPECT_EQ(late->backlog(), 3u);
+    EXPECT_EQ(late->poll()->height, 1u);
+
+    for (std::uint64_t n = 4; n < 30; ++n) feed.publish(eventAt(n));
+    got = drain(*late);
+    ASSERT_FALSE(got.empty());
+    EXPECT_EQ(got.back().height, 29u);
+    EXPECT_EQ(late->missed() + got.size(), 28u);
+    EXPECT_LT(got.size(), feed.capacity());
+    for (std::size_t i = 1; i < got.size(); ++i) EXPECT_EQ(got[i].height, got[i - 1].height + 1);
+    EXPECT_EQ(early->missed(), 0u);
+    EXPECT_EQ(feed.published(), 30u);
+}
+
+// A Block consumer holds the producer back instead of losing events;
+// slots are handed back as subscriptions go away
+TEST(ChangeFeedTest, BlockPolicyHoldsProducer) {
+    ChangeFeed feed(16);
+    auto sub = feed.subscribe(ChangeFeed::Backpressure::Block);
+    const std::uint64_t total = 20000;
+
+    std::thread producer([&] {
+        for (std::uint64_t n = 0; n < total; ++n) feed.publish(eventAt(n));
+    });
+    std::uint64_t expected = 0;
+    while (expected < total) {
+        auto e = sub->next(std::chrono::milliseconds(5000));
+        ASSERT_TRUE(e.has_value());
+        ASSERT_EQ(e->height, expected);
+        ASSERT_EQ(e->account.nonce, expected * 3);
+        ++expected;
+        EXPECT_LE(sub->backlog(), feed.capacity());
+    }
+    producer.join();
+    EXPECT_EQ(sub->missed(), 0u);
+
+    std::vector<std::unique_ptr<ChangeFeed::Subscription>> all;
+    while (all.size() + 1 < ChangeFeed::kMaxSubscribers) all.push_back(feed.subscribe());
+    EXPECT_THROW(feed.subscribe(), std::runtime_error);
+    all.pop_back();
+    EXPECT_NO_THROW(feed.subscribe());
+}
+
+// The chain announces each committed block as its transactions, the
+// accounts it wrote and the block itself; a reorg announces the blocks
+// it reverts, newest first, before the branch that replaces them
+TEST(ChangeFeedTest, BlockchainAnnouncesCommitsAndReverts) {
+    std::vector<KeyPair> keys;
+    for (int i = 0; i < 2; ++i) keys.push_back(KeyPair::random());
+    GenesisConfig g;
+    g.chainId = 1337;
+    for (const auto& k : keys) g.premine.push_back({k.address(), 1000000});
+    Address bob = Address::fromHex("0x1234567890123456789012345678901234567890");
+
+    auto mine = [&](Blockchain& chain, std::size_t from, std::size_t n) {
+        std::vector<Block> out;
+        for (std::size_t i = 0; i < n; ++i) {
+            Transaction tx;
+            tx.nonce = i;
+            tx.gasPrice = 1;
+            tx.gasLimit = 21000;
+            tx.to = bob;
+            tx.value = 100;
+            tx.chainId = 1337;
+            tx.signWith(keys[from]);
+            chain.addTransaction(tx);
+            out.push_back(chain.mineBlock());
+        }
+        return out;
+    };
+
+    Blockchain a(g), b(g), node(g);
+    std::vector<Block> main = mine(a, 0, 2);
+    std::vector<Block> side = mine(b, 1, 3);
+    auto sub = node.changes().subscribe(ChangeFeed::Backpressure::Block);
+
+    ASSERT_TRUE(node.addBlock(main[0]));
+    std::vector<ChainEvent> got = drain(*sub);
+    ASSERT_GE(got.size(), 4u);
+    EXPECT_EQ(got[0].kind, ChainEvent::Kind::Transaction);
+    EXPECT_EQ(got[0].hash, main[0].transactions[0].hash);
+    EXPECT_EQ(got[0].address, keys[0].address());
+    bool sawBob = false;
+    for (std::size_t i = 1; i + 1 < got.size(); ++i) {
+        EXPECT_EQ(got[i].kind, ChainEvent::Kind::Account);
+        if (got[i].address == bob) {
+            sawBob = true;
+            EXPECT_EQ(got[i].account.balance, 100u);
+        }
+    }
+    EXPECT_TRUE(sawBob);
+    EXPECT_EQ(got.back().kind, ChainEvent::Kind::BlockCommitted);
+    EXPECT_EQ(got.back().hash, main[0].hash);
+    EXPECT_EQ(got.back().position, 1u);
+    EXPECT_EQ(got.back().stateRoot, main[0].stateAfter);
+
+    ASSERT_TRUE(node.addBlock(main[1]));
+    for (const auto& blk : side) node.addBlock(blk);
+    ASSERT_EQ(node.head().hash(), side[2].hash);
+
+    std::vector<std::pair<ChainEvent::Kind, std::uint64_t>> blocks;
+    bool bobDeleted = false;
+    for (const ChainEvent& e : drain(*sub)) {
+        if (e.kind == ChainEvent::Kind::BlockCommitted || e.kind == ChainEvent::Kind::BlockReverted) {
+            blocks.push_back({e.kind, e.height});
+        }
+        if (e.kind == ChainEvent::Kind::Account && e.address == bob && e.deleted) bobDeleted = true;
+        if (e.kind == ChainEvent::Kind::BlockCommitted && e.height == 3) {
+            EXPECT_EQ(e.stateRoot, b.state().root());
+        }
+    }
+    using K = ChainEvent::Kind;
+    std::vector<std::pair<K, std::uint64_t>> expected{
+        {K::BlockCommitted, 2}, {K::BlockReverted, 2}, {K::BlockReverted, 1},
+        {K::BlockCommitted, 1}, {K::BlockCommitted, 2}, {K::BlockCommitted, 3}};
+    EXPECT_EQ(blocks, expected);
+    EXPECT_TRUE(bobDeleted);
+}
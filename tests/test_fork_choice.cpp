@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include "gambit/blockchain.hpp"
+#include "gambit/keys.hpp"
+#include "gambit/zk.hpp"
+
+using namespace gambit;
+
+class ForkChoiceTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        for (int i = 0; i < 3; ++i) keys.push_back(KeyPair::random());
+        genesis.chainId = 1337;
+        for (const auto& k : keys) genesis.premine.push_back({k.address(), 1000000});
+    }
+    void TearDown() override {}
+
+    std::vector<KeyPair> keys;
+    GenesisConfig genesis;
+
+    Transaction signedTransfer(std::size_t from, std::uint64_t nonce, std::uint64_t value) const {
+        Transaction tx;
+        tx.nonce = nonce;
+        tx.gasPrice = 1;
+        tx.gasLimit = 21000;
+        tx.to = keys[2].address();
+        tx.value = value;
+        tx.chainId = 1337;
+        tx.signWith(keys[from]);
+        return tx;
+    }
+
+    // A chain of `n` blocks, each with one transfer from keys[from];
+    // different senders give different branches
+    std::vector<Block> mineBranch(Blockchain& chain, std::size_t from, std::size_t n) const {
+        std::vector<Block> out;
+        for (std::size_t i = 0; i < n; ++i) {
+            chain.addTransaction(signedTransfer(from, i, 100 + i));
+            out.push_back(chain.mineBlock());
+        }
+        return out;
+    }
+};
+
+// A shorter or equally long side branch is kept but does not move the head
+TEST_F(ForkChoiceTest, SideBranchDoesNotReorg) {
+    Blockchain a(genesis), b(genesis), node(genesis);
+    std::vector<Block> main = mineBranch(a, 0, 3);
+    std::vector<Block> side = mineBranch(b, 1, 3);
+
+    for (const auto& blk : main) ASSERT_TRUE(node.addBlock(blk));
+    for (const auto& blk : side) EXPECT_TRUE(node.addBlock(blk));
+
+    EXPECT_EQ(node.height(), 3u);
+    EXPECT_EQ(node.head().hash(), main[2].hash);
+    EXPECT_EQ(node.state().root(), a.state().root());
+    EXPECT_EQ(node.forkBlocks(), 3u);
+    EXPECT_FALSE(node.addBlock(side[1]));   // already known
+}
+
+// A longer branch takes over; the old one can take over again later
+TEST_F(ForkChoiceTest, ReorgsToLongerBranchAndBack) {
+    Blockchain a(genesis), b(genesis), node(genesis);
+    std::vector<Block> main = mineBranch(a, 0, 5);
+    std::vector<Block> side = mineBranch(b, 1, 4);
+    node.enableArchive(ArchiveConfig{2, ""});
+
+    for (int i = 0; i < 3; ++i) ASSERT_TRUE(node.addBlock(main[i]));
+    for (const auto& blk : side) EXPECT_TRUE(node.addBlock(blk));
+
+    EXPECT_EQ(node.height(), 4u);
+    EXPECT_EQ(node.head().hash(), side[3].hash);
+    EXPECT_EQ(node.state().root(), b.state().root());
+    EXPECT_EQ(node.snapshot().root(), b.state().root());
+    EXPECT_EQ(node.view()->headHash, side[3].hash);
+    EXPECT_FALSE(node.findTransaction(main[0].transactions[0].hash).has_value());
+    EXPECT_TRUE(node.findTransaction(side[2].transactions[0].hash).has_value());
+    EXPECT_FALSE(node.blockByHash(main[2].hash).has_value());
+    EXPECT_EQ(node.forkBlocks(), 3u);
+    EXPECT_EQ(node.accountAt(keys[1].address(), 2)->nonce, 2u);
+    EXPECT_EQ(node.accountAt(keys[0].address(), 2)->nonce, 0u);
+
+    // The orphaned transfers are pending again, in nonce order
+    ASSERT_EQ(node.mempool().size(), 3u);
+    EXPECT_EQ(node.mempool()[0].hash, main[0].transactions[0].hash);
+    EXPECT_EQ(node.mempool()[2].hash, main[2].transactions[0].hash);
+
+    EXPECT_TRUE(node.addBlock(main[3]));
+    EXPECT_EQ(node.head().hash(), side[3].hash);   // tie: first seen stays
+    EXPECT_TRUE(node.addBlock(main[4]));
+    EXPECT_EQ(node.height(), 5u);
+    EXPECT_EQ(node.head().hash(), main[4].hash);
+    EXPECT_EQ(node.state().root(), a.state().root());
+    EXPECT_EQ(node.snapshot().get(keys[1].address())->nonce, 0u);
+    EXPECT_EQ(node.forkBlocks(), 4u);
+    ASSERT_EQ(node.mempool().size(), 4u);
+    EXPECT_EQ(node.mempool()[0].hash, side[0].transactions[0].hash);
+}
+
+// A branch with an invalid block leaves the old chain in place
+TEST_F(ForkChoiceTest, InvalidBranchRestoresChain) {
+    Blockchain a(genesis), b(genesis), node(genesis);
+    std::vector<Block> main = mineBranch(a, 0, 2);
+    std::vector<Block> side = mineBranch(b, 1, 3);
+
+    Block& bad = side[2];
+    bad.stateAfter = bad.stateBefore;
+    bad.proof = ZkProver::generate(bad.stateBefore, bad.stateAfter, bad.txRoot);
+    bad.hash = bad.computeHash();
+
+    for (const auto& blk : main) ASSERT_TRUE(node.addBlock(blk));
+    EXPECT_TRUE(node.addBlock(side[0]));
+    EXPECT_TRUE(node.addBlock(side[1]));
+    EXPECT_FALSE(node.addBlock(bad));
+
+    EXPECT_EQ(node.height(), 2u);
+    EXPECT_EQ(node.head().hash(), main[1].hash);
+    EXPECT_EQ(node.state().root(), a.state().root());
+    EXPECT_EQ(node.snapshot().root(), a.state().root());
+    EXPECT_TRUE(node.findTransaction(main[0].transactions[0].hash).has_value());
+    EXPECT_EQ(node.forkBlocks(), 2u);
+}
+
+// Branches forking below the reorg horizon are refused
+TEST_F(ForkChoiceTest, RespectsMaxReorgDepth) {
+    Blockchain a(genesis), b(genesis), node(genesis);
+    std::vector<Block> main = mineBranch(a, 0, 4);
+    std::vector<Block> side = mineBranch(b, 1, 5);
+    node.setMaxReorgDepth(2);
+
+    for (const auto& blk : main) ASSERT_TRUE(node.addBlock(blk));
+    EXPECT_FALSE(node.addBlock(side[0]));
+    EXPECT_FALSE(node.addBlock(side[1]));
+    EXPECT_EQ(node.forkBlocks(), 0u);
+    EXPECT_EQ(node.head().hash(), main[3].hash);
+}
+
+// Blocks as received from peers: a header that does not match its hash
+// is refused, and senders are recovered only to execute
+TEST_F(ForkChoiceTest, PeerBlocksCheckHeaderFirst) {
+    Blockchain a(genesis), node(genesis);
+    std::vector<Block> main = mineBranch(a, 0, 2);
+
+    Block tampered = Block::fromHex(main[0].toHex());
+    tampered.timestamp += 1;
+    EXPECT_FALSE(node.addBlock(tampered));
+
+    for (const auto& blk : main) ASSERT_TRUE(node.addBlock(Block::fromHex(blk.toHex())));
+    EXPECT_EQ(node.state().root(), a.state().root());
+    EXPECT_EQ(node.headerAt(2).computeHash(), main[1].hash);
+    ASSERT_TRUE(node.headerByHash(main[0].hash).has_value());
+    EXPECT_EQ(node.headerByHash(main[0].hash)->index, 1u);
+    EXPECT_FALSE(node.headerByHash(keccak256_32("missing")).has_value());
+}
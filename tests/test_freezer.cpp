@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include "gambit/block_store.hpp"
+#include "gambit/freezer.hpp"
+#include "gambit/keys.hpp"
+#include "gambit/lz.hpp"
+#include "test_util.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace gambit;
+using namespace gambit::testutil;
+
+class FreezerTest : public ::testing::Test {
+protected:
+    std::string dir;
+
+    void SetUp() override {
+        dir = (std::filesystem::temp_directory_path() /
+               ("gambit_freezer_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) +
+                "_" + ::testing::UnitTest::GetInstance()->current_test_info()->name())).string();
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+};
+
+// Records round-trip with and without a dictionary; a trained dictionary
+// shrinks single transactions, and damaged input is refused
+TEST_F(FreezerTest, LzRoundTrip) {
+    KeyPair kp = KeyPair::random();
+    std::vector<Bytes> samples;
+    for (std::uint64_t i = 0; i < 200; ++i) samples.push_back(signedTransfer(kp, i, 1000 + i).rlpEncodeSigned());
+
+    lz::Dictionary none;
+    lz::Dictionary trained(lz::train(samples, 4096));
+    EXPECT_GT(trained.size(), 0u);
+    EXPECT_LE(trained.size(), 4096u);
+
+    Bytes tx = signedTransfer(kp, 500, 77).rlpEncodeSigned();
+    Bytes plain = lz::compress(tx.data(), tx.size(), none);
+    Bytes primed = lz::compress(tx.data(), tx.size(), trained);
+    EXPECT_LT(primed.size(), plain.size());
+    EXPECT_EQ(lz::decompress(plain.data(), plain.size(), tx.size(), none), tx);
+    EXPECT_EQ(lz::decompress(primed.data(), primed.size(), tx.size(), trained), tx);
+
+    Bytes runs(5000, 0);
+    for (std::size_t i = 0; i < runs.size(); ++i) runs[i] = static_cast<std::uint8_t>((i / 7) % 5);
+    Bytes packed = lz::compress(runs.data(), runs.size(), trained);
+    EXPECT_LT(packed.size(), runs.size() / 10);
+    EXPECT_EQ(lz::decompress(packed.data(), packed.size(), runs.size(), trained), runs);
+
+    Bytes empty = lz::compress(nullptr, 0, trained);
+    EXPECT_TRUE(lz::decompress(empty.data(), empty.size(), 0, trained).empty());
+
+    EXPECT_THROW(lz::decompress(primed.data(), primed.size(), tx.size(), none), std::runtime_error);
+    EXPECT_THROW(lz::decompress(primed.data(), primed.size() - 1, tx.size(), trained), std::runtime_error);
+    EXPECT_THROW(lz::decompress(primed.data(), primed.size(), tx.size() + 1, trained), std::runtime_error);
+}
+
+// Any block of a frozen file decodes on its own; damaged files are refused
+TEST_F(FreezerTest, FrameIndexReadsSingleBlocks) {
+    std::vector<Bytes> encoded;
+    std::vector<std::pair<const std::uint8_t*, std::size_t>> blocks;
+    std::uint64_t raw = 0;
+    for (std::uint64_t i = 0; i < 40; ++i) encoded.push_back(makeBlock(100 + i, 3).rlpEncode());
+    for (const Bytes& b : encoded) {
+        blocks.emplace_back(b.data(), b.size());
+        raw += b.size();
+    }
+
+    FreezerOptions opts;
+    opts.frameBytes = 4096;
+    std::string path = dir + "/frz-00000.dat";
+    FrozenSegment::write(path, 100, raw, blocks, opts);
+    EXPECT_FALSE(std::filesystem::exists(path + ".tmp"));
+
+    FrozenSegment frozen(path);
+    EXPECT_EQ(frozen.first(), 100u);
+    EXPECT_EQ(frozen.count(), 40u);
+    EXPECT_EQ(frozen.segmentBytes(), raw);
+    EXPECT_LT(frozen.fileBytes(), raw);
+    for (std::uint64_t n : {139u, 100u, 117u, 118u}) {
+        FrozenSegment::Slice s = frozen.read(n);
+        EXPECT_EQ(Bytes(s.frame->data() + s.offset, s.frame->data() + s.offset + s.length), encoded[n - 100]);
+        EXPECT_LT(s.frame->size(), 2 * opts.frameBytes);
+    }
+    EXPECT_THROW(frozen.read(99), std::out_of_range);
+    EXPECT_THROW(frozen.read(140), std::out_of_range);
+
+    // Headers come from their own frames
+    for (std::uint64_t n : {100u, 139u}) {
+        EXPECT_EQ(frozen.header(n).rlpEncode(), Block::decodeHeader(encoded[n - 100].data(), encoded[n - 100].size()).rlpEncode());
+    }
+    EXPECT_THROW(frozen.header(140), std::out_of_range);
+
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3);
+    EXPECT_THROW(FrozenSegment{path}, std::runtime_error);
+}
+
+// Closed segments below the limit are frozen and their files deleted;
+// blocks read the same before and after reopening
+TEST_F(FreezerTest, BlockStoreFreezesClosedSegments) {
+    std::vector<Block> blocks;
+    std::size_t frozen = 0;
+    {
+        BlockStore store(dir, 4096);
+        for (std::uint64_t i = 0; i < 40; ++i) {
+            blocks.push_back(makeBlock(i, 3));
+            store.append(blocks.back().rlpEncode());
+        }
+        EXPECT_EQ(store.freeze(0), 0u);
+        frozen = store.freeze(20);
+        EXPECT_GT(frozen, 0u);
+        EXPECT_EQ(store.frozenSegments(), frozen);
+        EXPECT_EQ(store.freeze(20), 0u);
+        EXPECT_FALSE(std::filesystem::exists(dir + "/seg-00000.dat"));
+        EXPECT_TRUE(std::filesystem::exists(dir + "/frz-00000.dat"));
+
+        for (std::uint64_t i = 0; i < 40; ++i) {
+            EXPECT_EQ(store.get(i).hash(), blocks[i].hash);
+        }
+        auto io = AsyncIo::create(8, AsyncIo::Backend::Pread);
+        std::optional<BlockView> got;
+        store.readAsync(*io, 1, [&](std::optional<BlockView> v) { got = v; });
+        io->drain();
+        ASSERT_TRUE(got.has_value());
+        EXPECT_EQ(got->transaction(2).hash, blocks[1].transactions[2].hash);
+    }
+
+    {
+        BlockStore store(dir, 4096);
+        ASSERT_EQ(store.size(), 40u);
+        EXPECT_EQ(store.frozenSegments(), frozen);
+        for (std::uint64_t i = 0; i < 40; ++i) {
+            EXPECT_EQ(store.get(i).hash(), blocks[i].hash);
+        }
+
+        // Truncating into a frozen segment leaves it readable; new blocks
+        // go to a fresh segment
+        store.truncate(2);
+        Block b = makeBlock(2, 1);
+        EXPECT_EQ(store.append(b.rlpEncode()), 2u);
+        EXPECT_EQ(store.get(1).hash(), blocks[1].hash);
+    }
+
+    BlockStore store(dir, 4096);
+    ASSERT_EQ(store.size(), 3u);
+    EXPECT_EQ(store.get(1).hash(), blocks[1].hash);
+    EXPECT_EQ(store.get(2).txCount(), 1u);
+}
@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+#include "gambit/hash.hpp"
+#include "gambit/kv_store.hpp"
+#include "gambit/lsm_store.hpp"
+
+#include <filesystem>
+
+using namespace gambit;
+
+class KvStoreTest : public ::testing::Test {
+protected:
+    std::string dir;
+
+    void SetUp() override {
+        dir = (std::filesystem::temp_directory_path() /
+               ("gambit_kv_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) +
+                "_" + ::testing::UnitTest::GetInstance()->current_test_info()->name())).string();
+        std::filesystem::remove_all(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    static Bytes b(const std::string& s) { return Bytes(s.begin(), s.end()); }
+
+    static Bytes hashKey(std::uint32_t i) {
+        return keccak256(Bytes{static_cast<std::uint8_t>(i), static_cast<std::uint8_t>(i >> 8),
+                               static_cast<std::uint8_t>(i >> 16), static_cast<std::uint8_t>(i >> 24)});
+    }
+
+    static std::vector<std::string> scan(const KvStore& kv, const std::string& prefix) {
+        std::vector<std::string> out;
+        for (auto it = kv.iterate(b(prefix)); it->valid(); it->next()) {
+            out.emplace_back(it->key().begin(), it->key().end());
+        }
+        return out;
+    }
+
+    // Behaviour every engine must share
+    static void checkContract(KvStore& kv) {
+        kv.put(b("acct/2"), b("two"));
+        WriteBatch batch;
+        batch.put(b("acct/1"), b("one"));
+        batch.put(b("acct/3"), b("three"));
+        batch.put(b("blk/1"), b("block"));
+        batch.del(b("acct/3"));
+        batch.put(b("acct/4"), b("x"));
+        batch.put(b("acct/4"), b("four"));
+        kv.write(batch);
+
+        EXPECT_EQ(kv.get(b("acct/1")), b("one"));
+        EXPECT_EQ(kv.get(b("acct/4")), b("four"));
+        EXPECT_FALSE(kv.get(b("acct/3")).has_value());
+        EXPECT_FALSE(kv.get(b("acct")).has_value());
+        EXPECT_EQ(scan(kv, "acct/"), (std::vector<std::string>{"acct/1", "acct/2", "acct/4"}));
+        EXPECT_EQ(scan(kv, "").size(), 4u);
+
+        auto snap = kv.snapshot();
+        kv.del(b("acct/1"));
+        kv.put(b("acct/0"), b("zero"));
+        EXPECT_FALSE(kv.get(b("acct/1")).has_value());
+        EXPECT_EQ(snap->get(b("acct/1")), b("one"));
+        EXPECT_FALSE(snap->get(b("acct/0")).has_value());
+
+        std::vector<std::string> old;
+        for (auto it = snap->iterate(b("acct/")); it->valid(); it->next()) {
+            old.emplace_back(it->key().begin(), it->key().end());
+        }
+        EXPECT_EQ(old, (std::vector<std::string>{"acct/1", "acct/2", "acct/4"}));
+        EXPECT_EQ(scan(kv, "acct/"), (std::vector<std::string>{"acct/0", "acct/2", "acct/4"}));
+    }
+};
+
+TEST_F(KvStoreTest, MemoryContract) {
+    MemoryKvStore kv;
+    checkContract(kv);
+    EXPECT_EQ(kv.size(), 4u);
+}
+
+TEST_F(KvStoreTest, LsmContract) {
+    LsmKvStore kv(dir);
+    checkContract(kv);
+
+    // Same answers once everything lives in tables
+    kv.flush();
+    EXPECT_EQ(kv.tables(), 1u);
+    EXPECT_EQ(kv.get(b("acct/0")), b("zero"));
+    EXPECT_FALSE(kv.get(b("acct/1")).has_value());
+    EXPECT_EQ(scan(kv, "acct/"), (std::vector<std::string>{"acct/0", "acct/2", "acct/4"}));
+}
+
+// Flushed tables and the unflushed log tail both survive a reopen
+TEST_F(KvStoreTest, LsmReopen) {
+    {
+        LsmKvStore kv(dir, LsmOptions{4096, 100, 10, true});
+        for (std::uint32_t i = 0; i < 500; ++i) kv.put(hashKey(i), Bytes(40, static_cast<std::uint8_t>(i)));
+        kv.del(hashKey(7));
+        EXPECT_GT(kv.tables(), 1u);
+    }
+
+    LsmKvStore kv(dir, LsmOptions{4096, 100, 10, true});
+    EXPECT_FALSE(kv.get(hashKey(7)).has_value());
+    for (std::uint32_t i = 0; i < 500; ++i) {
+        if (i == 7) continue;
+        auto v = kv.get(hashKey(i));
+        ASSERT_TRUE(v.has_value()) << i;
+        EXPECT_EQ((*v)[0], static_cast<std::uint8_t>(i));
+    }
+}
+
+// Absent keys are answered by the bloom filters without reading tables
+TEST_F(KvStoreTest, LsmBloomSkipsAbsentKeys) {
+    LsmKvStore kv(dir, LsmOptions{1 << 20, 100, 10, false});
+    for (int t = 0; t < 4; ++t) {
+        WriteBatch batch;
+        for (std::uint32_t i = 0; i < 1000; ++i) batch.put(hashKey(t * 1000 + i), Bytes(8, 1));
+        kv.write(batch);
+        kv.flush();
+    }
+    ASSERT_EQ(kv.tables(), 4u);
+
+    for (std::uint32_t i = 0; i < 1000; ++i) EXPECT_FALSE(kv.get(hashKey(100000 + i)).has_value());
+    LsmKvStore::Stats s = kv.stats();
+    EXPECT_GT(s.bloomSkips, 3800u);    // ~1% false positives over 4000 probes
+    EXPECT_LT(s.tableReads, 200u);
+}
+
+// Background compaction merges tables and drops overwritten and deleted keys
+TEST_F(KvStoreTest, LsmCompaction) {
+    LsmKvStore kv(dir, LsmOptions{2048, 3, 10, false});
+    for (int round = 0; round < 6; ++round) {
+        for (std::uint32_t i = 0; i < 200; ++i) {
+            kv.put(hashKey(i), Bytes(16, static_cast<std::uint8_t>(round)));
+        }
+        for (std::uint32_t i = 0; i < 200; i += 10) kv.del(hashKey(i));
+    }
+    kv.waitForCompaction();
+    EXPECT_GT(kv.stats().compactions, 0u);
+    EXPECT_LT(kv.tables(), kv.stats().flushes / 2);
+
+    std::size_t live = 0;
+    for (auto it = kv.iterate({}); it->valid(); it->next()) {
+        EXPECT_EQ(it->value()[0], 5);
+        ++live;
+    }
+    EXPECT_EQ(live, 180u);
+    EXPECT_FALSE(kv.get(hashKey(10)).has_value());
+    EXPECT_EQ((*kv.get(hashKey(11)))[0], 5);
+
+    std::size_t files = 0;
+    for (const auto& e : std::filesystem::directory_iterator(dir)) files += e.path().extension() == ".sst";
+    EXPECT_EQ(files, kv.tables());
+}
+
+// Merges take runs of similar-sized tables, so each table's data is
+// rewritten once per tier instead of on every merge
+TEST_F(KvStoreTest, LsmCompactionIsTiered) {
+    LsmKvStore kv(dir, LsmOptions{4096, 4, 10, false});
+    for (std::uint32_t t = 0; t < 64; ++t) {
+        WriteBatch batch;
+        for (std::uint32_t i = 0; i < 40; ++i) batch.put(hashKey(t * 40 + i), Bytes(40, static_cast<std::uint8_t>(t)));
+        kv.write(batch);
+        kv.flush();
+        kv.waitForCompaction();
+    }
+
+    // 64 tables in tiers of 4: 16 + 4 + 1 merges, three rewrites in all
+    std::uint64_t data = 64 * 40 * (8 + 32 + 40);
+    LsmKvStore::Stats s = kv.stats();
+    EXPECT_EQ(s.flushes, 64u);
+    EXPECT_EQ(s.compactions, 21u);
+    EXPECT_EQ(s.compactedBytes, 3 * data);
+    EXPECT_EQ(kv.tables(), 1u);
+    for (std::uint32_t t = 0; t < 64; ++t) {
+        auto v = kv.get(hashKey(t * 40 + 7));
+        ASSERT_TRUE(v.has_value()) << t;
+        EXPECT_EQ((*v)[0], static_cast<std::uint8_t>(t));
+    }
+}
@@ -0,0 +1,246 @@
+#include <gtest/gtest.h>
+#include "gambit/blockchain.hpp"
+#include "gambit/keys.hpp"
+#include "gambit/mempool.hpp"
+#include "gambit/zk_mining_engine.hpp"
+
+using namespace gambit;
+
+class MempoolTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        for (int i = 0; i < 4; ++i) keys.push_back(KeyPair::random());
+    }
+
+    std::vector<KeyPair> keys;
+
+    Transaction tx(std::size_t from, std::uint64_t nonce, std::uint64_t price, std::uint64_t value = 1) const {
+        Transaction t;
+        t.nonce = nonce;
+        t.gasPrice = price;
+        t.gasLimit = 21000;
+        t.to = Address::fromHex("0x1234567890123456789012345678901234567890");
+        t.value = value;
+        t.chainId = 1337;
+        t.signWith(keys[from]);
+        return t;
+    }
+
+    static std::vector<Bytes32> hashes(const std::vector<Transaction>& txs) {
+        std::vector<Bytes32> out;
+        for (const auto& t : txs) out.push_back(t.hash);
+        return out;
+    }
+};
+
+// Blocks take the best paying executable transaction first, each sender
+// in nonce order; a sender behind a nonce gap waits until it is filled
+TEST_F(MempoolTest, SelectsByPriceInNonceOrder) {
+    Mempool pool;
+    std::string err;
+    Transaction a0 = tx(0, 0, 5), a1 = tx(0, 1, 50), a2 = tx(0, 2, 1);
+    Transaction b0 = tx(1, 0, 10);
+    Transaction c0 = tx(2, 0, 1), c1 = tx(2, 1, 100);
+    for (const Transaction* t : {&a2, &a0, &b0, &c1, &a1}) ASSERT_TRUE(pool.add(*t, 0, err)) << err;
+
+    EXPECT_EQ(hashes(pool.select()), hashes({b0, a0, a1, a2}));
+    EXPECT_EQ(hashes(pool.select(2)), hashes({b0, a0}));
+    EXPECT_EQ(pool.all().size(), 5u);
+    EXPECT_EQ(pool.all().back().hash, c1.hash);
+
+    // Equal prices go first come first served
+    ASSERT_TRUE(pool.add(c0, 0, err));
+    EXPECT_EQ(hashes(pool.select()), hashes({b0, a0, a1, a2, c0, c1}));
+
+    // Committed nonces leave the pool; a reverted one leaves a gap
+    pool.setNonce(keys[0].address(), 2);
+    EXPECT_EQ(hashes(pool.select()), hashes({b0, a2, c0, c1}));
+    EXPECT_TRUE(pool.remove(c0.hash));
+    EXPECT_EQ(hashes(pool.select()), hashes({b0, a2}));
+    EXPECT_EQ(pool.size(), 3u);
+    EXPECT_EQ(pool.senders(), 3u);
+}
+
+// A transaction with a pending nonce replaces it only if it pays enough
+// more; copies and stale nonces are turned away
+TEST_F(MempoolTest, ReplacesAndRejects) {
+    Mempool pool;
+    std::string err;
+    Transaction first = tx(0, 3, 100);
+    ASSERT_TRUE(pool.add(first, 3, err));
+    EXPECT_FALSE(pool.add(first, 3, err));
+    EXPECT_EQ(err, "Already known");
+    EXPECT_FALSE(pool.add(tx(0, 2, 100), 3, err));
+    EXPECT_EQ(err, "Nonce too low");
+
+    EXPECT_FALSE(pool.add(tx(0, 3, 109), 3, err));
+    EXPECT_EQ(err, "Replacement transaction underpriced");
+    Transaction better = tx(0, 3, 110);
+    ASSERT_TRUE(pool.add(better, 3, err));
+    EXPECT_EQ(pool.size(), 1u);
+    EXPECT_FALSE(pool.find(first.hash).has_value());
+    ASSERT_TRUE(pool.find(better.hash).has_value());
+    EXPECT_EQ(pool.find(better.hash)->gasPrice, uint256(110));
+    EXPECT_EQ(hashes(pool.select()), hashes({better}));
+
+    // The head state moved past it
+    pool.setNonce(keys[0].address(), 4);
+    EXPECT_EQ(pool.size(), 0u);
+    EXPECT_EQ(pool.senders(), 0u);
+}
+
+// A full pool makes room by dropping the cheapest queue tail, and only
+// for a transaction that pays more
+TEST_F(MempoolTest, EvictsCheapestTail) {
+    Mempool pool(3);
+    std::string err;
+    Transaction a0 = tx(0, 0, 5), a1 = tx(0, 1, 1), b0 = tx(1, 0, 3);
+    for (const Transaction* t : {&a0, &a1, &b0}) ASSERT_TRUE(pool.add(*t, 0, err));
+
+    Transaction c0 = tx(2, 0, 2);
+    ASSERT_TRUE(pool.add(c0, 0, err));
+    EXPECT_FALSE(pool.contains(a1.hash));
+    EXPECT_EQ(pool.size(), 3u);
+
+    EXPECT_FALSE(pool.add(tx(3, 0, 2), 0, err));
+    EXPECT_EQ(err, "Mempool full");
+    // Nor does a sender push out its own queue
+    EXPECT_FALSE(pool.add(tx(2, 1, 4), 0, err));
+    EXPECT_EQ(hashes(pool.select()), hashes({a0, b0, c0}));
+}
+
+// Transactions behind a nonce gap are capped per sender, and a full pool
+// gives them up before any executable transaction, however well they pay
+TEST_F(MempoolTest, LimitsAndEvictsQueuedFirst) {
+    Mempool pool(4);
+    std::string err;
+    std::vector<Transaction> gapped;
+    for (std::uint64_t n = 2; n < 6; ++n) {
+        gapped.push_back(tx(0, n, 100));
+        ASSERT_TRUE(pool.add(gapped.back(), 0, err)) << err;
+    }
+    EXPECT_TRUE(pool.select().empty());
+
+    // A cheap executable transaction still gets in
+    Transaction b0 = tx(1, 0, 1);
+    ASSERT_TRUE(pool.add(b0, 0, err)) << err;
+    EXPECT_FALSE(pool.contains(gapped.back().hash));
+    EXPECT_EQ(hashes(pool.select()), hashes({b0}));
+
+    // A queued one only displaces a cheaper queued one
+    EXPECT_FALSE(pool.add(tx(2, 3, 50), 0, err));
+    EXPECT_EQ(err, "Mempool full");
+    ASSERT_TRUE(pool.add(tx(2, 3, 200), 0, err)) << err;
+    EXPECT_TRUE(pool.contains(b0.hash));
+
+    EXPECT_FALSE(pool.add(tx(3, Mempool::kMaxNonceAhead, 100), 0, err));
+    EXPECT_EQ(err, "Nonce too high");
+
+    Mempool big;
+    for (std::uint64_t n = 1; n <= Mempool::kMaxQueuedPerSender; ++n) {
+        ASSERT_TRUE(big.add(tx(3, n, 1), 0, err)) << err;
+    }
+    EXPECT_FALSE(big.add(tx(3, Mempool::kMaxQueuedPerSender + 2, 1), 0, err));
+    EXPECT_EQ(err, "Too many queued transactions");
+    // Filling the gap makes the queue executable, which frees the quota
+    ASSERT_TRUE(big.add(tx(3, 0, 1), 0, err)) << err;
+    EXPECT_EQ(big.select().size(), Mempool::kMaxQueuedPerSender + 1);
+    EXPECT_TRUE(big.add(tx(3, Mempool::kMaxQueuedPerSender + 2, 1), 0, err)) << err;
+}
+
+// The chain mines transactions that arrived out of nonce order, and a
+// transaction the sender cannot pay for waits instead of failing the
+// block
+TEST_F(MempoolTest, BlockchainMinesInNonceOrder) {
+    GenesisConfig g;
+    g.chainId = 1337;
+    g.premine.push_back({keys[0].address(), 1000000});
+    g.premine.push_back({keys[1].address(), 1000000});
+    Blockchain chain(g);
+
+    Transaction a0 = tx(0, 0, 1), a1 = tx(0, 1, 1), b0 = tx(1, 0, 2, 5000000);
+    chain.addTransaction(a1);
+    chain.addTransaction(a0);
+    chain.addTransaction(b0);
+    EXPECT_THROW(chain.addTransaction(a0), std::runtime_error);
+    std::string err;
+    EXPECT_TRUE(chain.validateTransaction(tx(0, 2, 1), err));
+    EXPECT_EQ(chain.pool().size(), 3u);
+
+    Block block = chain.mineBlock();
+    EXPECT_EQ(hashes(block.transactions), hashes({a0, a1}));
+    EXPECT_EQ(chain.state().get(keys[0].address())->nonce, 2u);
+    EXPECT_EQ(hashes(chain.mempool()), hashes({b0}));
+    EXPECT_EQ(chain.pool().size(), 1u);
+
+    EXPECT_FALSE(chain.validateTransaction(a1, err));
+    EXPECT_EQ(err, "Nonce too low");
+
+    chain.setMaxBlockTransactions(1);
+    chain.addTransaction(tx(0, 3, 1));
+    chain.addTransaction(tx(0, 2, 1));
+    EXPECT_EQ(chain.mineBlock().transactions.size(), 1u);
+    EXPECT_EQ(chain.mineBlock().transactions.size(), 1u);
+    EXPECT_EQ(chain.state().get(keys[0].address())->nonce, 4u);
+    EXPECT_TRUE(chain.pool().contains(b0.hash));
+}
+
+// The miner's engine path leaves out a queued transfer that overdraws
+// once the one before it has run, and the template it builds is accepted
+TEST_F(MempoolTest, EngineDropsOverdrawingTransfer) {
+    GenesisConfig g;
+    g.chainId = 1337;
+    g.premine.push_back({keys[0].address(), 1000000});
+    Blockchain chain(g);
+
+    // Each passes on its own against the head balance; together they overdraw
+    Transaction a0 = tx(0, 0, 1, 600000), a1 = tx(0, 1, 1, 600000);
+    std::string err;
+    for (const Transaction* t : {&a0, &a1}) {
+        ASSERT_TRUE(chain.validateTransaction(*t, err)) << err;
+        chain.addTransaction(*t);
+    }
+
+    ZkMiningEngine engine;
+    Block tmpl = engine.buildBlockTemplate(chain);
+    EXPECT_EQ(hashes(tmpl.transactions), hashes({a0}));
+    EXPECT_TRUE(chain.pool().contains(a1.hash));
+    ASSERT_TRUE(chain.addBlock(tmpl));
+    EXPECT_EQ(chain.height(), 1u);
+    EXPECT_EQ(chain.state().get(keys[0].address())->balance, 400000u);
+
+    // The next template is empty rather than stuck on the same failure
+    EXPECT_TRUE(engine.buildBlockTemplate(chain).transactions.empty());
+}
+
+// A transfer funded by another sender's transaction in the same block is
+// deferred, not dropped, and mined once the funds are in; a transaction
+// for another chain is dropped. Neither holds up the rest of the block.
+TEST_F(MempoolTest, DefersUnfundedAndDropsInvalid) {
+    GenesisConfig g;
+    g.chainId = 1337;
+    g.premine.push_back({keys[0].address(), 1000000});
+    g.premine.push_back({keys[2].address(), 1000000});
+    Blockchain chain(g);
+
+    Transaction fund = tx(0, 0, 1, 5000);
+    fund.to = keys[1].address();
+    fund.signWith(keys[0]);
+    // Pays best, so it is selected before the transfer that funds it
+    Transaction spend = tx(1, 0, 100, 3000), spendNext = tx(1, 1, 100, 1000);
+    Transaction foreign = tx(2, 0, 50);
+    foreign.chainId = 1;
+    foreign.signWith(keys[2]);
+    for (const Transaction* t : {&fund, &spend, &spendNext, &foreign}) chain.addTransaction(*t);
+
+    Block first = chain.mineBlock();
+    EXPECT_EQ(hashes(first.transactions), hashes({fund}));
+    EXPECT_TRUE(chain.pool().contains(spend.hash));
+    EXPECT_TRUE(chain.pool().contains(spendNext.hash));
+    EXPECT_FALSE(chain.pool().contains(foreign.hash));
+
+    Block second = chain.mineBlock();
+    EXPECT_EQ(hashes(second.transactions), hashes({spend, spendNext}));
+    EXPECT_EQ(chain.state().get(keys[1].address())->balance, 1000u);
+    EXPECT_EQ(chain.pool().size(), 0u);
+}
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include "gambit/merkle.hpp"
+#include "gambit/blockchain.hpp"
+#include "gambit/keys.hpp"
+
+using namespace gambit;
+
+class MerkleTest : public ::testing::Test {
+protected:
+    static std::vector<Bytes32> leaves(std::size_t n) {
+        std::vector<Bytes32> out;
+        for (std::size_t i = 0; i < n; ++i) out.push_back(keccak256_32("leaf" + std::to_string(i)));
+        return out;
+    }
+
+    static Bytes32 leafHash(const Bytes32& l) {
+        Bytes in{0x00};
+        in.insert(in.end(), l.begin(), l.end());
+        return keccak256_32(in);
+    }
+
+    static Bytes32 nodeHash(const Bytes32& l, const Bytes32& r) {
+        Bytes in{0x01};
+        in.insert(in.end(), l.begin(), l.end());
+        in.insert(in.end(), r.begin(), r.end());
+        return keccak256_32(in);
+    }
+};
+
+// Leaves and nodes are hashed with distinct tags; an unpaired node moves
+// up as is
+TEST_F(MerkleTest, RootLayout) {
+    std::vector<Bytes32> l = leaves(3);
+    EXPECT_EQ(merkle::root({}), Bytes32{});
+    EXPECT_EQ(merkle::root({l[0]}), leafHash(l[0]));
+    EXPECT_EQ(merkle::root({l[0], l[1]}), nodeHash(leafHash(l[0]), leafHash(l[1])));
+    EXPECT_EQ(merkle::root(l), nodeHash(nodeHash(leafHash(l[0]), leafHash(l[1])), leafHash(l[2])));
+
+    // Not duplicated: [a, b, c] and [a, b, c, c] differ
+    std::vector<Bytes32> dup = l;
+    dup.push_back(l[2]);
+    EXPECT_NE(merkle::root(dup), merkle::root(l));
+}
+
+// Hashing subtrees on several workers gives the serial root
+TEST_F(MerkleTest, ParallelMatchesSerial) {
+    for (std::size_t n : {merkle::kParallelLeaves, merkle::kParallelLeaves + 1, std::size_t(9001)}) {
+        std::vector<Bytes32> l = leaves(n);
+        EXPECT_EQ(merkle::root(l, 4), merkle::root(l, 1)) << n;
+    }
+}
+
+// Every leaf proves against the root; altered proofs do not
+TEST_F(MerkleTest, InclusionProofs) {
+    for (std::size_t n : {1, 2, 3, 5, 8, 13, 100}) {
+        std::vector<Bytes32> l = leaves(n);
+        Bytes32 root = merkle::root(l);
+        for (std::size_t i = 0; i < n; ++i) {
+            merkle::Proof p = merkle::prove(l, i);
+            EXPECT_TRUE(merkle::verify(root, l[i], p)) << n << " " << i;
+            EXPECT_FALSE(merkle::verify(root, keccak256_32("other"), p));
+            if (!p.siblings.empty()) {
+                merkle::Proof bad = p;
+                bad.siblings[0][0] ^= 0x01;
+                EXPECT_FALSE(merkle::verify(root, l[i], bad));
+                bad = p;
+                bad.siblings.pop_back();
+                EXPECT_FALSE(merkle::verify(root, l[i], bad));
+            }
+            if (n > 1) {
+                merkle::Proof moved = p;
+                moved.index = (i + 1) % n;
+                EXPECT_FALSE(merkle::verify(root, l[i], moved));
+            }
+        }
+        EXPECT_THROW(merkle::prove(l, n), std::out_of_range);
+    }
+}
+
+// An inner node cannot be proven as a leaf of a smaller claimed tree
+TEST_F(MerkleTest, RejectsInnerNodeAsLeaf) {
+    std::vector<Bytes32> l = leaves(4);
+    Bytes32 root = merkle::root(l);
+    Bytes32 left = nodeHash(leafHash(l[0]), leafHash(l[1]));
+    Bytes32 right = nodeHash(leafHash(l[2]), leafHash(l[3]));
+    ASSERT_EQ(root, nodeHash(left, right));
+
+    merkle::Proof forged{0, 2, {right}};
+    EXPECT_FALSE(merkle::verify(root, left, forged));
+    forged = merkle::Proof{0, 1, {}};
+    EXPECT_FALSE(merkle::verify(root, root, forged));
+}
+
+// Mined blocks commit to their transactions' Merkle root, and the chain
+// serves proofs that check against the header alone
+TEST_F(MerkleTest, ChainTransactionProofs) {
+    KeyPair kp = KeyPair::random();
+    GenesisConfig genesis;
+    genesis.chainId = 1337;
+    genesis.premine.push_back({kp.address(), 1000000});
+    Blockchain chain(genesis);
+
+    std::vector<Bytes32> hashes;
+    for (std::uint64_t i = 0; i < 5; ++i) {
+        Transaction tx;
+        tx.nonce = i;
+        tx.gasPrice = 1;
+        tx.gasLimit = 21000;
+        tx.to = Address::fromHex("0x1234567890123456789012345678901234567890");
+        tx.value = 10 + i;
+        tx.chainId = 1337;
+        tx.signWith(kp);
+        chain.addTransaction(tx);
+        hashes.push_back(tx.hash);
+    }
+    Block block = chain.mineBlock();
+    EXPECT_EQ(block.txRoot, merkle::root(hashes));
+
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+        std::optional<Blockchain::TxProof> p = chain.transactionProof(hashes[i]);
+        ASSERT_TRUE(p.has_value());
+        EXPECT_EQ(p->blockHash, block.hash);
+        EXPECT_EQ(p->header.computeHash(), block.hash);
+        EXPECT_EQ(p->proof.index, i);
+        EXPECT_TRUE(merkle::verify(p->header.txRoot, hashes[i], p->proof));
+    }
+    EXPECT_FALSE(chain.transactionProof(keccak256_32("missing")).has_value());
+}
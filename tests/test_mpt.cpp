@@ -2,6 +2,8 @@
 #include "gambit/mpt.hpp"
 #include "gambit/hash.hpp"
 
+#include <algorithm>
+
 using namespace gambit;
 
 class MptTest : public ::testing::Test {
@@ -13,10 +15,12 @@ protected:
 // Test empty trie creation
 TEST_F(MptTest, EmptyTrie) {
     MptTrie trie;
-    std::string root = trie.rootHash();
+    Bytes32 root = trie.rootHash();
     
-    // Empty trie should have a deterministic root
-    EXPECT_FALSE(root.empty());
+    // The root is always a 17-slot branch, so the empty root is
+    // keccak256(rlp([""] * 17)) rather than keccak256(rlp(""))
+    EXPECT_EQ(toHex(root),
+              "be0f4440e293a47160b9b148d49212d0616ec5b0a70c99de9bf36515d52e0901");
 }
 
 // Test put and get single value
@@ -93,14 +97,14 @@ TEST_F(MptTest, OverwriteValue) {
 TEST_F(MptTest, RootHashChanges) {
     MptTrie trie;
     
-    std::string emptyRoot = trie.rootHash();
+    Bytes32 emptyRoot = trie.rootHash();
     
     Bytes key = {0x01, 0x02, 0x03};
     Bytes value = {0xaa, 0xbb};
     
     trie.put(key, value);
     
-    std::string newRoot = trie.rootHash();
+    Bytes32 newRoot = trie.rootHash();
     
     EXPECT_NE(emptyRoot, newRoot);
 }
@@ -184,20 +188,12 @@ TEST_F(MptTest, RootHashFormat) {
     Bytes value = {0x02};
     trie.put(key, value);
     
-    std::string root = trie.rootHash();
-    
-    // Should be a hex string
-    EXPECT_FALSE(root.empty());
+    Bytes32 root = trie.rootHash();
     
-    // Check it's valid hex (only hex characters)
-    for (char c : root) {
-        if (c != 'x') {  // Skip 0x prefix if present
-            bool isHex = (c >= '0' && c <= '9') || 
-                         (c >= 'a' && c <= 'f') || 
-                         (c >= 'A' && c <= 'F');
-            EXPECT_TRUE(isHex);
-        }
-    }
+    // 32 binary bytes; hex only when shown
+    EXPECT_NE(root, Bytes32{});
+    EXPECT_EQ(toHex(root).size(), 64u);
+    EXPECT_EQ(fromHex32("0x" + toHex(root)), root);
 }
 
 // Test keys with common prefixes
@@ -221,3 +217,60 @@ TEST_F(MptTest, CommonPrefixKeys) {
     EXPECT_EQ(trie.get(key3).value(), value3);
 }
 
+
+// Bottom-up hashing of sorted entries matches the trie, serially and on
+// several threads; unsorted or duplicate keys are refused
+TEST_F(MptTest, SortedRootMatchesTrie) {
+    MptTrie::Entries entries;
+    EXPECT_EQ(MptTrie::sortedRoot(entries), MptTrie().rootHash());
+
+    std::uint64_t x = 88172645463325252ull;
+    for (int i = 0; i < 3000; ++i) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        Bytes key(1 + x % 20);
+        for (std::size_t j = 0; j < key.size(); ++j) key[j] = static_cast<std::uint8_t>(x >> (8 * (j % 8)) ^ j);
+        Bytes value(1 + x % 40, static_cast<std::uint8_t>(i));
+        entries.emplace_back(key, value);
+    }
+    entries.emplace_back(Bytes{}, Bytes{0x42});
+    std::sort(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end(),
+                              [](const auto& a, const auto& b) { return a.first == b.first; }),
+                  entries.end());
+
+    MptTrie trie;
+    for (const auto& [k, v] : entries) trie.put(k, v);
+    EXPECT_EQ(MptTrie::sortedRoot(entries, 1), trie.rootHash());
+    EXPECT_EQ(MptTrie::sortedRoot(entries, 4), trie.rootHash());
+
+    MptTrie::Entries dup = entries;
+    dup.push_back(dup.back());
+    EXPECT_THROW(MptTrie::sortedRoot(dup, 1), std::invalid_argument);
+    std::swap(dup[1], dup[2]);
+    EXPECT_THROW(MptTrie::sortedRoot(dup, 4), std::invalid_argument);
+}
+
+// Copies share nodes but not changes: each sees only its own puts
+TEST_F(MptTest, CopiesAreIndependent) {
+    MptTrie base;
+    for (std::uint8_t i = 0; i < 32; ++i) base.put(Bytes{i, 0x01}, Bytes{i});
+    Bytes32 baseRoot = base.rootHash();
+
+    MptTrie copy = base;
+    copy.put(Bytes{0x05, 0x01}, Bytes{0xee});
+    copy.put(Bytes{0x40, 0x02}, Bytes{0xef});
+    EXPECT_EQ(base.rootHash(), baseRoot);
+    EXPECT_EQ(base.get(Bytes{0x05, 0x01}), Bytes{0x05});
+    EXPECT_FALSE(base.get(Bytes{0x40, 0x02}).has_value());
+
+    base.put(Bytes{0x06, 0x01}, Bytes{0xdd});
+    EXPECT_EQ(copy.get(Bytes{0x06, 0x01}), Bytes{0x06});
+    EXPECT_EQ(copy.get(Bytes{0x05, 0x01}), Bytes{0xee});
+
+    // Same content, same root as a trie built from scratch
+    MptTrie fresh;
+    for (std::uint8_t i = 0; i < 32; ++i) fresh.put(Bytes{i, 0x01}, Bytes{i});
+    fresh.put(Bytes{0x05, 0x01}, Bytes{0xee});
+    fresh.put(Bytes{0x40, 0x02}, Bytes{0xef});
+    EXPECT_EQ(copy.rootHash(), fresh.rootHash());
+}
@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+#include "gambit/parallel_executor.hpp"
+#include "gambit/state.hpp"
+#include "gambit/genesis.hpp"
+#include "test_util.hpp"
+
+#include <atomic>
+#include <random>
+#include <thread>
+
+using namespace gambit;
+using namespace gambit::testutil;
+
+class ParallelExecutorTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+
+    // Reference: apply in block order with the original serial code path
+    static State serial(const GenesisConfig& g, const std::vector<Transaction>& txs) {
+        State s(g);
+        for (const auto& tx : txs) {
+            s.applyTransaction(tx.from, tx);
+        }
+        return s;
+    }
+
+    static State commit(const GenesisConfig& g, const ExecutionResult& r) {
+        State s(g);
+        for (const auto& [a, acc] : r.writes) {
+            s.set(a, acc);
+        }
+        return s;
+    }
+};
+
+// Small blocks take the serial path
+TEST_F(ParallelExecutorTest, SmallBlockMatchesSerial) {
+    GenesisConfig g = genesis(4, 1000);
+    std::vector<Transaction> txs = {
+        transfer(addr(0), addr(1), 100),
+        transfer(addr(1), addr(2), 1050),
+        transfer(addr(3), addr(3), 10),
+    };
+
+    ParallelExecutor exec(4);
+    ExecutionResult r = exec.execute(State(g), txs);
+
+    ASSERT_TRUE(r.ok);
+    EXPECT_EQ(commit(g, r).root(), serial(g, txs).root());
+}
+
+// Independent transfers between unrelated accounts
+TEST_F(ParallelExecutorTest, DisjointTransfersMatchSerial) {
+    GenesisConfig g = genesis(512, 1000);
+    std::vector<Transaction> txs;
+    for (std::uint32_t i = 0; i < 256; ++i) {
+        txs.push_back(transfer(addr(2 * i), addr(2 * i + 1), i + 1));
+    }
+
+    ParallelExecutor exec(8);
+    ExecutionResult r = exec.execute(State(g), txs);
+
+    ASSERT_TRUE(r.ok);
+    EXPECT_EQ(r.writes.size(), 512u);
+    EXPECT_EQ(commit(g, r).root(), serial(g, txs).root());
+}
+
+// A chain of dependent transfers: each tx spends what the previous one sent
+TEST_F(ParallelExecutorTest, DependentChainMatchesSerial) {
+    GenesisConfig g = genesis(1, 500);
+    std::vector<Transaction> txs;
+    for (std::uint32_t i = 0; i < 200; ++i) {
+        txs.push_back(transfer(addr(i), addr(i + 1), 500));
+    }
+
+    ParallelExecutor exec(8);
+    ExecutionResult r = exec.execute(State(g), txs);
+
+    ASSERT_TRUE(r.ok);
+    State s = commit(g, r);
+    EXPECT_EQ(s.root(), serial(g, txs).root());
+    ASSERT_NE(s.get(addr(200)), nullptr);
+    EXPECT_EQ(s.get(addr(200))->balance, 500u);
+}
+
+// Random traffic over a small hot set of accounts forces many conflicts
+TEST_F(ParallelExecutorTest, ContendedRandomTrafficMatchesSerial) {
+    std::mt19937 rng(42);
+    for (int round = 0; round < 20; ++round) {
+        GenesisConfig g = genesis(16, 1000000);
+        std::vector<Transaction> txs;
+        for (int i = 0; i < 300; ++i) {
+            txs.push_back(transfer(addr(rng() % 16), addr(rng() % 20), rng() % 1000));
+        }
+        numberNonces(txs);
+
+        ParallelExecutor exec(8);
+        ExecutionResult r = exec.execute(State(g), txs);
+
+        ASSERT_TRUE(r.ok);
+        EXPECT_EQ(commit(g, r).root(), serial(g, txs).root());
+    }
+}
+
+// One executor runs block after block on its pool; copies share it, and a
+// block that finds the pool busy still executes correctly
+TEST_F(ParallelExecutorTest, PoolReusedAcrossBlocksAndCallers) {
+    GenesisConfig g = genesis(16, 1000000);
+    std::vector<std::vector<Transaction>> blocks;
+    std::mt19937 rng(7);
+    for (int b = 0; b < 40; ++b) {
+        std::vector<Transaction> txs;
+        for (int i = 0; i < 64; ++i) {
+            txs.push_back(transfer(addr(rng() % 16), addr(rng() % 20), rng() % 1000));
+        }
+        numberNonces(txs);
+        blocks.push_back(std::move(txs));
+    }
+
+    ParallelExecutor exec(4);
+    ParallelExecutor copy = exec;
+    std::atomic<int> wrong{0};
+    auto run = [&](const ParallelExecutor& e) {
+        for (const auto& txs : blocks) {
+            ExecutionResult r = e.execute(State(g), txs);
+            if (!r.ok || commit(g, r).root() != serial(g, txs).root()) ++wrong;
+        }
+    };
+    std::thread other(run, std::cref(copy));
+    run(exec);
+    other.join();
+
+    EXPECT_EQ(wrong.load(), 0);
+}
+
+// An overdraft anywhere in the block is reported at its position
+TEST_F(ParallelExecutorTest, InsufficientBalanceReported) {
+    GenesisConfig g = genesis(64, 100);
+    std::vector<Transaction> txs;
+    for (std::uint32_t i = 0; i < 32; ++i) {
+        txs.push_back(transfer(addr(i), addr(i + 32), 10));
+    }
+    txs[20].value = 1000;
+
+    ParallelExecutor exec(4);
+    ExecutionResult r = exec.execute(State(g), txs);
+
+    EXPECT_FALSE(r.ok);
+    EXPECT_EQ(r.failedIndex, 20u);
+    EXPECT_TRUE(r.writes.empty());
+}
+
+// A replayed nonce or another chain's transaction fails where it sits,
+// in the serial and the parallel path alike
+TEST_F(ParallelExecutorTest, NonceAndChainIdChecked) {
+    GenesisConfig g = genesis(64, 100);
+    std::vector<Transaction> txs;
+    for (std::uint32_t i = 0; i < 32; ++i) {
+        txs.push_back(transfer(addr(i), addr(i + 32), 10));
+        txs.back().chainId = 7;
+    }
+    std::vector<Transaction> replayed = txs;
+    replayed.insert(replayed.begin() + 20, txs[5]);
+    std::vector<Transaction> foreign = txs;
+    foreign[12].chainId = 8;
+
+    for (std::size_t threads : {1u, 4u}) {
+        ParallelExecutor exec(threads, 7);
+        EXPECT_EQ(exec.chainId(), 7u);
+        ASSERT_TRUE(exec.execute(State(g), txs).ok);
+
+        ExecutionResult r = exec.execute(State(g), replayed);
+        EXPECT_FALSE(r.ok);
+        EXPECT_EQ(r.failedIndex, 20u);
+        EXPECT_EQ(r.error, "Invalid nonce");
+
+        r = exec.execute(State(g), foreign);
+        EXPECT_FALSE(r.ok);
+        EXPECT_EQ(r.failedIndex, 12u);
+        EXPECT_EQ(r.error, "Invalid chainId");
+    }
+    // Without a chain id any chain is accepted
+    EXPECT_TRUE(ParallelExecutor(4).execute(State(g), foreign).ok);
+}
+
+// Thread count defaults to the hardware concurrency
+TEST_F(ParallelExecutorTest, DefaultThreads) {
+    ParallelExecutor exec;
+    EXPECT_GE(exec.threads(), 1u);
+}
@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+#include "gambit/pre_execution.hpp"
+#include "gambit/blockchain.hpp"
+#include "gambit/zk_mining_engine.hpp"
+#include "test_util.hpp"
+
+#include <random>
+
+using namespace gambit;
+using namespace gambit::testutil;
+
+class PreExecutionTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+
+    static void expectSameWrites(const ExecutionResult& a, const ExecutionResult& b) {
+        ASSERT_EQ(a.writes.size(), b.writes.size());
+        for (std::size_t i = 0; i < a.writes.size(); ++i) {
+            EXPECT_EQ(a.writes[i].first, b.writes[i].first);
+            EXPECT_EQ(a.writes[i].second.balance, b.writes[i].second.balance);
+            EXPECT_EQ(a.writes[i].second.nonce, b.writes[i].second.nonce);
+        }
+    }
+};
+
+// Cached and fresh runs agree with the executor
+TEST_F(PreExecutionTest, MatchesExecutor) {
+    State head(genesis(20, 1000));
+    std::mt19937 rng(3);
+    std::vector<Transaction> txs;
+    for (int i = 0; i < 200; ++i) {
+        txs.push_back(transfer(addr(rng() % 24), addr(rng() % 24), rng() % 40));
+    }
+    numberNonces(txs);
+    ExecutionResult expected = ParallelExecutor(1).execute(head, txs);
+
+    PreExecutionCache cache;
+    ExecutionResult cold = cache.run(head, txs);
+    EXPECT_EQ(cold.ok, expected.ok);
+    EXPECT_EQ(cold.failedIndex, expected.failedIndex);
+    ExecutionResult warm = cache.run(head, txs);
+    EXPECT_EQ(cache.lastRun().executed, 0u);
+    if (expected.ok) {
+        expectSameWrites(cold, expected);
+        expectSameWrites(warm, expected);
+    }
+}
+
+// A committed block only invalidates the entries touching its accounts
+TEST_F(PreExecutionTest, InvalidatesOnlyChangedReads) {
+    State head(genesis(8, 1000));
+    std::vector<Transaction> txs = {
+        transfer(addr(0), addr(1), 10),
+        transfer(addr(2), addr(3), 20),
+        transfer(addr(1), addr(4), 5),    // reads addr(1) written by tx 0
+        transfer(addr(5), addr(6), 30),
+    };
+
+    PreExecutionCache cache;
+    ASSERT_TRUE(cache.run(head, txs).ok);
+    EXPECT_EQ(cache.lastRun().executed, 4u);
+
+    // New head changes addr(1): tx 0 and tx 2 read it and re-run
+    head.set(addr(1), Account{500, 0});
+    cache.invalidate({{addr(1), Account{500, 0}}});
+    EXPECT_EQ(cache.size(), 2u);
+    ExecutionResult r = cache.run(head, txs);
+    ASSERT_TRUE(r.ok);
+    EXPECT_EQ(cache.lastRun().executed, 2u);
+    EXPECT_EQ(cache.lastRun().reused, 2u);
+    expectSameWrites(r, ParallelExecutor(1).execute(head, txs));
+
+    // A replaced transaction is re-executed
+    txs[3].value = 31;
+    rehash(txs[3]);
+    cache.run(head, txs);
+    EXPECT_EQ(cache.lastRun().executed, 1u);
+
+    // A repeat of an earlier transaction fails on its spent nonce
+    txs.push_back(txs[0]);
+    r = cache.run(head, txs);
+    EXPECT_FALSE(r.ok);
+    EXPECT_EQ(r.failedIndex, 4u);
+    EXPECT_EQ(r.error, "Invalid nonce");
+}
+
+// An entry is only reused if the balances it read are still there, also
+// after a run that stopped at a failing transaction before reaching it
+TEST_F(PreExecutionTest, RechecksReadsAfterFailedRun) {
+    State head;
+    head.set(addr(0), Account{100, 0});
+    head.set(addr(1), Account{100, 0});
+    Address s = addr(0), a = addr(1), b = addr(2), c = addr(3), g = addr(4);
+    auto withNonce = [](Transaction tx, std::uint64_t nonce) {
+        tx.nonce = nonce;
+        rehash(tx);
+        return tx;
+    };
+
+    PreExecutionCache cache;
+    std::vector<Transaction> txs = {transfer(s, b, 10), transfer(a, b, 5),
+                                    withNonce(transfer(s, g, 80), 1), transfer(b, c, 15)};
+    ASSERT_TRUE(cache.run(head, txs).ok);
+
+    txs[0] = transfer(s, b, 50);
+    EXPECT_FALSE(cache.run(head, txs).ok);
+
+    txs[2] = withNonce(transfer(s, g, 10), 1);
+    ExecutionResult r = cache.run(head, txs);
+    ASSERT_TRUE(r.ok);
+    expectSameWrites(r, ParallelExecutor(1).execute(head, txs));
+}
+
+// An arrival ahead of the others only re-runs the transactions sharing an
+// account with it; those downstream whose inputs came out the same reuse
+TEST_F(PreExecutionTest, ArrivalShiftsOnlyDependents) {
+    State head(genesis(16, 1000));
+    std::vector<Transaction> txs;
+    for (std::uint32_t i = 0; i < 6; ++i) txs.push_back(transfer(addr(2 * i), addr(2 * i + 1), 10 + i));
+
+    PreExecutionCache cache;
+    ASSERT_TRUE(cache.run(head, txs).ok);
+
+    // Pays more, so it goes first; only txs[2] shares an account
+    txs.insert(txs.begin(), transfer(addr(14), addr(4), 7));
+    ExecutionResult r = cache.run(head, txs);
+    ASSERT_TRUE(r.ok);
+    EXPECT_EQ(cache.lastRun().executed, 2u);
+    EXPECT_EQ(cache.lastRun().reused, 5u);
+    expectSameWrites(r, ParallelExecutor(1).execute(head, txs));
+
+    // Gone from the pool, gone from the cache
+    txs.erase(txs.begin());
+    ASSERT_TRUE(cache.run(head, txs).ok);
+    EXPECT_EQ(cache.size(), 6u);
+    EXPECT_TRUE(cache.covers(txs));
+}
+
+// Blocks mined from pre-executed results match plain execution
+TEST_F(PreExecutionTest, BlockchainMineUsesCache) {
+    GenesisConfig g = genesis(10, 1000);
+    Blockchain plain(g);
+    Blockchain warm(g);
+
+    for (std::uint32_t i = 0; i < 30; ++i) {
+        Transaction tx = transfer(addr(i % 10), addr((i * 7) % 10), i);
+        tx.nonce = i / 10;
+        rehash(tx);
+        plain.addTransaction(tx);
+        warm.addTransaction(tx);
+        if (i % 10 == 9) warm.preExecutePending();
+    }
+
+    Block a = plain.mineBlock();
+    Block b = warm.mineBlock();
+    EXPECT_EQ(a.stateAfter, b.stateAfter);
+    EXPECT_TRUE(warm.mempool().empty());
+}
+
+// A locally built template commits with the writes it was built from;
+// one built on a head that has since moved is refused
+TEST_F(PreExecutionTest, CommitsLocalTemplate) {
+    Blockchain chain(genesis(4, 1000));
+    chain.addTransaction(transfer(addr(0), addr(1), 10));
+    chain.preExecutePending();
+
+    ZkMiningEngine engine;
+    BlockTemplate stale = engine.buildTemplate(chain);
+    BlockTemplate tmpl = engine.buildTemplate(chain);
+    ASSERT_TRUE(chain.commitVerified(tmpl.block, tmpl.writes));
+    EXPECT_EQ(chain.state().root(), tmpl.block.stateAfter);
+    EXPECT_EQ(chain.snapshot().get(addr(1))->balance, 1010u);
+    EXPECT_TRUE(chain.mempool().empty());
+
+    EXPECT_FALSE(chain.commitVerified(stale.block, stale.writes));
+    EXPECT_EQ(chain.height(), 1u);
+}
@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+#include "gambit/block_store.hpp"
+#include "gambit/blockchain.hpp"
+#include "gambit/keys.hpp"
+#include "test_util.hpp"
+
+#include <filesystem>
+
+using namespace gambit;
+using namespace gambit::testutil;
+
+class PruningTest : public ::testing::Test {
+protected:
+    std::string dir;
+
+    void SetUp() override {
+        dir = (std::filesystem::temp_directory_path() /
+               ("gambit_pruning_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) +
+                "_" + ::testing::UnitTest::GetInstance()->current_test_info()->name())).string();
+        std::filesystem::remove_all(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+};
+
+// Whole segments below the limit are deleted; block numbers keep their
+// meaning, also after reopening, and blocks above stay readable
+TEST_F(PruningTest, BlockStoreDropsWholeSegments) {
+    std::vector<Block> blocks;
+    std::uint64_t first = 0;
+    {
+        BlockStore store(dir, 4096);
+        for (std::uint64_t i = 0; i < 40; ++i) {
+            blocks.push_back(makeBlock(i, 3));
+            store.append(blocks.back().rlpEncode());
+        }
+        EXPECT_GT(store.freeze(10), 0u);
+
+        std::uint64_t end = store.segmentEnd(0);
+        EXPECT_EQ(store.prune(end - 1), 0u);
+        std::size_t dropped = store.prune(20);
+        first = store.first();
+        EXPECT_EQ(dropped, first);
+        EXPECT_GT(first, 0u);
+        EXPECT_LE(first, 20u);
+        EXPECT_GT(store.segmentEnd(first), first);
+        EXPECT_FALSE(std::filesystem::exists(dir + "/seg-00000.dat"));
+        EXPECT_FALSE(std::filesystem::exists(dir + "/frz-00000.dat"));
+
+        EXPECT_EQ(store.size(), 40u);
+        EXPECT_THROW(store.get(first - 1), std::out_of_range);
+        EXPECT_THROW(store.header(0), std::out_of_range);
+        for (std::uint64_t i = first; i < 40; ++i) {
+            EXPECT_EQ(store.get(i).hash(), blocks[i].hash);
+        }
+        blocks.push_back(makeBlock(40, 1));
+        EXPECT_EQ(store.append(blocks.back().rlpEncode()), 40u);
+
+        // Never past the newest block
+        store.prune(1000);
+        EXPECT_EQ(store.size(), 41u);
+        EXPECT_EQ(store.get(40).hash(), blocks[40].hash);
+        first = store.first();
+    }
+
+    BlockStore store(dir, 4096);
+    ASSERT_EQ(store.size(), 41u);
+    EXPECT_EQ(store.first(), first);
+    for (std::uint64_t i = first; i < 41; ++i) {
+        EXPECT_EQ(store.get(i).hash(), blocks[i].hash);
+    }
+    EXPECT_THROW(store.truncate(first - 1), std::out_of_range);
+
+    BlockStore mem;
+    for (std::uint64_t i = 0; i < 5; ++i) mem.append(makeBlock(i, 1).rlpEncode());
+    EXPECT_EQ(mem.segmentEnd(2), 3u);
+    EXPECT_EQ(mem.prune(3), 3u);
+    EXPECT_EQ(mem.first(), 3u);
+    EXPECT_EQ(mem.size(), 5u);
+    EXPECT_THROW(mem.get(2), std::out_of_range);
+    EXPECT_EQ(mem.get(3).index(), 3u);
+    EXPECT_EQ(mem.append(makeBlock(5, 1).rlpEncode()), 5u);
+}
+
+// Pruned blocks and their transactions drop out of the lookups; the kept
+// window never reaches into the reorg depth
+TEST_F(PruningTest, BlockchainKeepsRecentBlocks) {
+    KeyPair kp = KeyPair::random();
+    GenesisConfig g;
+    g.chainId = 1337;
+    g.premine.push_back({kp.address(), 1000000});
+
+    Blockchain chain(g);
+    chain.setMaxReorgDepth(2);
+    PruneConfig cfg;
+    cfg.keepBlocks = 4;
+    chain.setPruning(cfg);
+
+    std::vector<Bytes32> hashes{chain.head().hash()};
+    std::vector<Bytes32> txs;
+    for (std::uint64_t n = 0; n < 10; ++n) {
+        Transaction tx = signedTransfer(kp, n, 1000);
+        chain.addTransaction(tx);
+        txs.push_back(tx.hash);
+        hashes.push_back(chain.mineBlock().hash);
+    }
+    Bytes32 root = chain.state().root();
+
+    EXPECT_EQ(chain.pruneHistory(), 7u);
+    EXPECT_EQ(chain.firstBlock(), 7u);
+    EXPECT_EQ(chain.height(), 10u);
+    EXPECT_EQ(chain.pruneHistory(), 0u);
+    EXPECT_THROW(chain.blockView(6), std::out_of_range);
+    EXPECT_FALSE(chain.blockByHash(hashes[6]).has_value());
+    EXPECT_FALSE(chain.findTransaction(txs[5]).has_value());
+    EXPECT_EQ(chain.blockByHash(hashes[7])->index(), 7u);
+    EXPECT_EQ(chain.findTransaction(txs[6])->height, 7u);
+    EXPECT_EQ(chain.state().root(), root);
+
+    chain.addTransaction(signedTransfer(kp, 10, 1000));
+    EXPECT_EQ(chain.mineBlock().index, 11u);
+
+    ArchiveConfig archive;
+    EXPECT_THROW(chain.enableArchive(archive), std::invalid_argument);
+}
+
+// On disk, blocks go only up to a settled state checkpoint, and a
+// restart replays from it since genesis is gone
+TEST_F(PruningTest, RestartFromCheckpoint) {
+    KeyPair kp = KeyPair::random();
+    GenesisConfig g;
+    g.chainId = 1337;
+    g.premine.push_back({kp.address(), 1000000});
+
+    Bytes32 head;
+    Bytes32 root;
+    std::uint64_t first = 0;
+    {
+        Blockchain chain(g);
+        chain.setMaxReorgDepth(2);
+        chain.setDataDir(dir, 4096);
+        PruneConfig cfg;
+        cfg.keepBlocks = 4;
+        chain.setPruning(cfg);
+        for (std::uint64_t n = 0; n < 30; ++n) {
+            chain.addTransaction(signedTransfer(kp, n, 1000));
+            chain.mineBlock();
+            chain.pruneHistory();
+        }
+        first = chain.firstBlock();
+        EXPECT_GT(first, 0u);
+        EXPECT_FALSE(std::filesystem::exists(dir + "/blocks/seg-00000.dat"));
+        EXPECT_FALSE(std::filesystem::is_empty(dir + "/checkpoints"));
+        head = chain.head().hash();
+        root = chain.state().root();
+    }
+
+    Blockchain chain(g);
+    chain.setDataDir(dir, 4096);
+    EXPECT_EQ(chain.height(), 30u);
+    EXPECT_EQ(chain.firstBlock(), first);
+    EXPECT_EQ(chain.head().hash(), head);
+    EXPECT_EQ(chain.state().root(), root);
+    EXPECT_EQ(chain.snapshot().root(), root);
+    chain.addTransaction(signedTransfer(kp, 30, 1000));
+    EXPECT_EQ(chain.mineBlock().index, 31u);
+
+    GenesisConfig other = g;
+    other.premine[0].balance = 1;
+    Blockchain mismatched(other);
+    EXPECT_THROW(mismatched.setDataDir(dir, 4096), std::runtime_error);
+}
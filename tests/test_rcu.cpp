@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include "gambit/rcu.hpp"
+#include "gambit/blockchain.hpp"
+#include "test_util.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace gambit;
+using namespace gambit::testutil;
+
+class RcuTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+
+    struct Pair {
+        std::uint64_t a{0};
+        std::uint64_t b{0};
+    };
+};
+
+// A pinned version outlives newer publishes and is freed after release
+TEST_F(RcuTest, GuardPinsVersion) {
+    Rcu<Pair> cell(Pair{1, 1});
+    {
+        auto pinned = cell.read();
+        cell.publish(Pair{2, 2});
+        cell.publish(Pair{3, 3});
+        EXPECT_EQ(pinned->a, 1u);
+        EXPECT_EQ(cell.read()->a, 3u);
+        EXPECT_EQ(cell.retired(), 2u);
+    }
+    cell.publish(Pair{4, 4});
+    EXPECT_EQ(cell.retired(), 0u);
+    EXPECT_EQ(cell.read()->b, 4u);
+}
+
+// More live readers than reader slots get overflow slots instead of
+// spinning, and still hold back reclamation
+TEST_F(RcuTest, MoreReadersThanSlots) {
+    Rcu<Pair> cell(Pair{1, 1});
+    {
+        std::vector<Rcu<Pair>::Guard> guards;
+        for (int i = 0; i < 300; ++i) guards.push_back(cell.read());
+        cell.publish(Pair{2, 2});
+        EXPECT_EQ(guards.back()->a, 1u);
+        EXPECT_EQ(cell.read()->a, 2u);
+        cell.publish(Pair{3, 3});
+        EXPECT_EQ(cell.retired(), 2u);
+    }
+    cell.publish(Pair{4, 4});
+    EXPECT_EQ(cell.retired(), 0u);
+}
+
+// Readers always see a whole version while a writer keeps publishing
+TEST_F(RcuTest, ConcurrentReaders) {
+    Rcu<Pair> cell;
+    std::atomic<bool> stop{false};
+    std::atomic<std::uint64_t> torn{0};
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&] {
+            std::uint64_t last = 0;
+            while (!stop) {
+                auto v = cell.read();
+                if (v->a != v->b || v->a < last) ++torn;
+                last = v->a;
+            }
+        });
+    }
+    for (std::uint64_t i = 1; i <= 20000; ++i) cell.publish(Pair{i, i});
+    stop = true;
+    for (auto& t : readers) t.join();
+
+    EXPECT_EQ(torn.load(), 0u);
+    cell.publish(Pair{});
+    EXPECT_EQ(cell.retired(), 0u);
+}
+
+// The chain view moves with the head and keeps its own state version
+TEST_F(RcuTest, ChainViewIsConsistent) {
+    GenesisConfig g;
+    g.premine.push_back({addr(0), 1000});
+    Blockchain chain(g);
+
+    auto before = chain.view();
+    EXPECT_EQ(before->height, 0u);
+
+    Transaction tx;
+    tx.from = addr(0);
+    tx.to = addr(1);
+    tx.value = 400;
+    chain.addTransaction(tx);
+    EXPECT_EQ(chain.pool().size(), 1u);
+    EXPECT_EQ(chain.view()->height, 0u);
+
+    Block b = chain.mineBlock();
+    auto after = chain.view();
+    EXPECT_EQ(after->height, 1u);
+    EXPECT_EQ(after->headHash, b.hash);
+    EXPECT_EQ(after->stateRoot, b.stateAfter);
+    EXPECT_EQ(after->state.root(), b.stateAfter);
+    EXPECT_EQ(chain.pool().size(), 0u);
+    EXPECT_EQ(after->state.get(addr(1))->balance, 400u);
+
+    // The older view still answers from genesis state
+    EXPECT_EQ(before->state.get(addr(0))->balance, 1000u);
+    EXPECT_FALSE(before->state.get(addr(1)).has_value());
+}
+
+// Historical reads go through the view and the archive, never the chain
+// lock, and stay consistent while blocks are mined
+TEST_F(RcuTest, HistoricalReadsDuringMining) {
+    GenesisConfig g;
+    g.premine.push_back({addr(0), 1000});
+    Blockchain chain(g);
+    ArchiveConfig cfg;
+    cfg.checkpointInterval = 4;
+    chain.enableArchive(cfg);
+
+    std::atomic<bool> stop{false};
+    std::atomic<std::uint64_t> wrong{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&, t] {
+            std::uint64_t i = t;
+            while (!stop) {
+                std::uint64_t head = chain.view()->height;
+                std::uint64_t h = head ? ++i % (head + 1) : 0;
+                std::optional<Account> acc = chain.accountAt(addr(1), h);
+                // Block n moves 1 to addr(1)
+                if (h == 0 ? acc.has_value() : !acc || acc->balance != h) ++wrong;
+            }
+        });
+    }
+    for (std::uint64_t n = 0; n < 40; ++n) {
+        Transaction tx;
+        tx.nonce = n;
+        tx.from = addr(0);
+        tx.to = addr(1);
+        tx.value = 1;
+        chain.addTransaction(tx);
+        chain.mineBlock();
+    }
+    stop = true;
+    for (auto& th : readers) th.join();
+
+    EXPECT_EQ(wrong.load(), 0u);
+    EXPECT_EQ(chain.accountAt(addr(1), 17)->balance, 17u);
+}
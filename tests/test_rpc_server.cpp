@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include "gambit/blockchain.hpp"
+#include "gambit/keys.hpp"
+#include "gambit/rpc_server.hpp"
+#include "nlohmann/json.hpp"
+#include "test_util.hpp"
+
+using namespace gambit;
+using namespace gambit::testutil;
+using json = nlohmann::json;
+
+class RpcServerTest : public ::testing::Test {
+protected:
+    KeyPair kp = KeyPair::random();
+    std::unique_ptr<Blockchain> chain;
+    std::vector<Transaction> txs;
+
+    // Three transfers land in block 200 (0xc8); the server never listens
+    void SetUp() override {
+        GenesisConfig g;
+        g.chainId = 1337;
+        g.premine.push_back({kp.address(), 1000000});
+        chain = std::make_unique<Blockchain>(g);
+        for (int i = 1; i < 200; ++i) chain->mineBlock();
+        for (std::uint64_t n = 0; n < 3; ++n) {
+            txs.push_back(signedTransfer(kp, n, 10 + n));
+            chain->addTransaction(txs.back());
+        }
+        chain->mineBlock();
+    }
+
+    json call(const std::string& method, const json& params) {
+        RpcServer rpc(*chain, 0);
+        json req = {{"jsonrpc", "2.0"}, {"id", 1}, {"method", method}, {"params", params}};
+        return json::parse(rpc.handleJsonRpc(req.dump()))["result"];
+    }
+
+    static std::string hashHex(const Bytes32& h) { return "0x" + toHex(h); }
+};
+
+// Quantities are minimal hex, not RLP: 0 is "0x0", 200 is "0xc8"
+TEST_F(RpcServerTest, TransactionQuantities) {
+    json first = call("eth_getTransactionReceipt", {hashHex(txs[0].hash)});
+    EXPECT_EQ(first["transactionIndex"], "0x0");
+    EXPECT_EQ(first["blockNumber"], "0xc8");
+    EXPECT_EQ(first["gasUsed"], "0x5208");
+    EXPECT_EQ(first["cumulativeGasUsed"], "0x5208");
+
+    json last = call("eth_getTransactionReceipt", {hashHex(txs[2].hash)});
+    EXPECT_EQ(last["transactionIndex"], "0x2");
+    EXPECT_EQ(last["gasUsed"], "0x5208");
+    EXPECT_EQ(last["cumulativeGasUsed"], "0xf618");
+
+    json tx = call("eth_getTransactionByHash", {hashHex(txs[0].hash)});
+    EXPECT_EQ(tx["blockNumber"], "0xc8");
+    EXPECT_EQ(tx["transactionIndex"], "0x0");
+    EXPECT_EQ(tx["nonce"], "0x0");
+
+    EXPECT_EQ(call("eth_blockNumber", json::array()), "0xc8");
+    EXPECT_EQ(call("eth_getTransactionCount", {kp.address().toHex()}), "0x3");
+}
+
+// Block numbers echo back as requested; genesis is "0x0"
+TEST_F(RpcServerTest, HeaderQuantities) {
+    json genesis = call("eth_getBlockByNumber", {"0x0"});
+    EXPECT_EQ(genesis["number"], "0x0");
+    EXPECT_EQ(genesis["timestamp"].get<std::string>().rfind("0x", 0), 0u);
+
+    json head = call("eth_getBlockByNumber", {"0xc8"});
+    EXPECT_EQ(head["number"], "0xc8");
+    BlockView b = chain->blockView(200);
+    EXPECT_EQ(head["hash"], hashHex(b.hash()));
+    EXPECT_EQ(std::stoull(head["timestamp"].get<std::string>(), nullptr, 16), b.header().timestamp);
+}
+
+// Proof position and width parse as plain quantities
+TEST_F(RpcServerTest, ProofQuantities) {
+    json proof = call("gambit_getTransactionProof", {hashHex(txs[1].hash)});
+    EXPECT_EQ(proof["blockNumber"], "0xc8");
+    EXPECT_EQ(proof["index"], "0x1");
+    EXPECT_EQ(proof["leaves"], "0x3");
+}
+
+// Address history postings and totals are plain quantities
+TEST_F(RpcServerTest, AddressHistoryQuantities) {
+    json page = call("gambit_getAddressTransactions", {kp.address().toHex(), {{"order", "asc"}}});
+    EXPECT_EQ(page["total"], "0x3");
+    ASSERT_EQ(page["transactions"].size(), 3u);
+    EXPECT_EQ(page["transactions"][0]["blockNumber"], "0xc8");
+    EXPECT_EQ(page["transactions"][0]["transactionIndex"], "0x0");
+    EXPECT_EQ(page["transactions"][2]["transactionIndex"], "0x2");
+}
@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include "gambit/sharded_executor.hpp"
+#include "gambit/blockchain.hpp"
+#include "test_util.hpp"
+
+#include <random>
+
+using namespace gambit;
+using namespace gambit::testutil;
+
+class ShardedExecutorTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+
+    static Bytes32 root(const GenesisConfig& g, const ExecutionResult& r) {
+        State s(g);
+        for (const auto& [a, acc] : r.writes) s.set(a, acc);
+        return s.root();
+    }
+};
+
+// Prefix partitioning covers every shard and is stable
+TEST_F(ShardedExecutorTest, ShardOfPrefix) {
+    ShardedExecutor ex(4);
+    EXPECT_EQ(ex.shards(), 4u);
+    std::vector<bool> hit(4);
+    for (std::uint32_t i = 0; i < 64; ++i) {
+        std::size_t s = ex.shardOf(addr(i));
+        ASSERT_LT(s, 4u);
+        EXPECT_EQ(s, ex.shardOf(addr(i)));
+        hit[s] = true;
+    }
+    for (bool h : hit) EXPECT_TRUE(h);
+}
+
+// Random transfer blocks end in the same state as serial execution
+TEST_F(ShardedExecutorTest, MatchesSerial) {
+    GenesisConfig g = genesis(64, 1000000);
+    ShardedExecutor ex(4);
+    ParallelExecutor serial(1);
+    std::mt19937 rng(11);
+
+    for (int block = 0; block < 10; ++block) {
+        std::vector<Transaction> txs;
+        for (int i = 0; i < 500; ++i) {
+            txs.push_back(transfer(addr(rng() % 64), addr(rng() % 80), rng() % 1000));
+        }
+        numberNonces(txs);
+        ExecutionResult a = ex.execute(State(g), txs);
+        ExecutionResult b = serial.execute(State(g), txs);
+        ASSERT_TRUE(a.ok);
+        EXPECT_FALSE(ex.lastRun().fallback);
+        EXPECT_GT(ex.lastRun().crossShard, 0u);
+        EXPECT_EQ(root(g, a), root(g, b));
+        EXPECT_EQ(a.writes.size(), b.writes.size());
+    }
+}
+
+// A debit funded by an earlier cross-shard credit falls back to serial order
+TEST_F(ShardedExecutorTest, CrossShardFundingFallsBack) {
+    ShardedExecutor ex(4);
+    Address rich = addr(0);
+    std::uint32_t n = 1;
+    while (ex.shardOf(addr(n)) == ex.shardOf(rich)) ++n;
+    Address poor = addr(n);
+
+    GenesisConfig g;
+    g.premine.push_back({rich, 100});
+    State base(g);
+
+    std::vector<Transaction> txs = {transfer(rich, poor, 50), transfer(poor, rich, 30)};
+    ExecutionResult r = ex.execute(base, txs);
+    ASSERT_TRUE(r.ok);
+    EXPECT_TRUE(ex.lastRun().fallback);
+    EXPECT_EQ(root(g, r), root(g, ParallelExecutor(1).execute(base, txs)));
+
+    // Genuinely unfunded transfers still fail at the right index
+    txs.push_back(transfer(poor, rich, 500));
+    numberNonces(txs);
+    r = ex.execute(base, txs);
+    EXPECT_FALSE(r.ok);
+    EXPECT_EQ(r.failedIndex, 2u);
+
+    // So does a transaction replayed within the block
+    txs.back() = txs[0];
+    r = ex.execute(base, txs);
+    EXPECT_FALSE(r.ok);
+    EXPECT_EQ(r.failedIndex, 2u);
+    EXPECT_EQ(r.error, "Invalid nonce");
+}
+
+// Partitions stay resident across blocks: accounts are read from the
+// base once, and only committed writes reach them
+TEST_F(ShardedExecutorTest, PartitionsStayResident) {
+    GenesisConfig g = genesis(32, 1000000);
+    ShardedExecutor ex(4);
+    State state(g);
+    std::mt19937 rng(5);
+
+    auto block = [&] {
+        std::vector<Transaction> txs;
+        for (int i = 0; i < 200; ++i) txs.push_back(transfer(addr(rng() % 32), addr(rng() % 32), rng() % 100));
+        numberNonces(txs, &state);
+        return txs;
+    };
+
+    std::vector<Transaction> txs = block();
+    ExecutionResult r = ex.execute(state, txs);
+    ASSERT_TRUE(r.ok);
+    EXPECT_EQ(ex.lastRun().loaded, r.writes.size());
+
+    // Executed but never committed: the next run starts from the base again
+    ExecutionResult again = ex.execute(state, txs);
+    ASSERT_TRUE(again.ok);
+    EXPECT_EQ(ex.lastRun().loaded, 0u);
+    EXPECT_EQ(root(g, again), root(g, r));
+
+    for (const auto& [a, acc] : r.writes) state.set(a, acc);
+    ex.commit(r.writes);
+    for (int n = 0; n < 3; ++n) {
+        txs = block();
+        r = ex.execute(state, txs);
+        ASSERT_TRUE(r.ok);
+        EXPECT_EQ(ex.lastRun().loaded, 0u);
+        ExecutionResult expected = ParallelExecutor(1).execute(state, txs);
+        ASSERT_EQ(r.writes.size(), expected.writes.size());
+        for (std::size_t i = 0; i < r.writes.size(); ++i) {
+            EXPECT_EQ(r.writes[i].second.balance, expected.writes[i].second.balance);
+            EXPECT_EQ(r.writes[i].second.nonce, expected.writes[i].second.nonce);
+        }
+        for (const auto& [a, acc] : r.writes) state.set(a, acc);
+        ex.commit(r.writes);
+    }
+
+    ex.invalidate();
+    ASSERT_TRUE(ex.execute(state, block()).ok);
+    EXPECT_GT(ex.lastRun().loaded, 0u);
+}
+
+// Blockchain mines identical state with sharded execution
+TEST_F(ShardedExecutorTest, BlockchainShardedMining) {
+    GenesisConfig g = genesis(32, 1000);
+    Blockchain plain(g);
+    Blockchain sharded(g);
+    sharded.setShardCount(3);
+    EXPECT_EQ(sharded.shardCount(), 3u);
+
+    // The second block runs on the partitions the first one committed
+    for (std::uint32_t i = 0; i < 200; ++i) {
+        Transaction tx = transfer(addr(i % 32), addr((i * 5 + 1) % 40), i % 17);
+        tx.nonce = i / 32;
+        tx.hash = tx.computeHash();
+        plain.addTransaction(tx);
+        sharded.addTransaction(tx);
+        if (i == 99) {
+            EXPECT_EQ(plain.mineBlock().stateAfter, sharded.mineBlock().stateAfter);
+        }
+    }
+    EXPECT_EQ(plain.mineBlock().stateAfter, sharded.mineBlock().stateAfter);
+}
@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+#include "gambit/snapshot.hpp"
+#include "gambit/hash.hpp"
+#include "test_util.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+using namespace gambit;
+using namespace gambit::testutil;
+
+class SnapshotTest : public ::testing::Test {
+protected:
+    std::string dir;
+
+    void SetUp() override {
+        dir = (std::filesystem::temp_directory_path() /
+               ("gambit_snapshot_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) +
+                "_" + ::testing::UnitTest::GetInstance()->current_test_info()->name())).string();
+        std::filesystem::remove_all(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    static Bytes32 root(std::uint8_t n) {
+        return keccak256_32(std::string(1, static_cast<char>(n)));
+    }
+};
+
+// Lookups on an in-memory base table
+TEST_F(SnapshotTest, BaseGet) {
+    SnapshotBase::Entries entries;
+    for (std::uint32_t i = 0; i < 1000; ++i) {
+        entries.emplace_back(addr(i), Account{i * 10, i});
+    }
+    auto base = SnapshotBase::build(root(1), entries);
+
+    EXPECT_EQ(base->size(), 1000u);
+    EXPECT_EQ(base->root(), root(1));
+    for (std::uint32_t i = 0; i < 1000; ++i) {
+        auto acc = base->get(addr(i));
+        ASSERT_TRUE(acc.has_value());
+        EXPECT_EQ(acc->balance, i * 10);
+        EXPECT_EQ(acc->nonce, i);
+    }
+    EXPECT_FALSE(base->get(addr(5000)).has_value());
+}
+
+// A base table written to disk reads back identically through mmap
+TEST_F(SnapshotTest, BaseFileRoundTrip) {
+    std::filesystem::create_directories(dir);
+    std::string path = dir + "/base.bin";
+
+    SnapshotBase::Entries entries = {
+        {addr(1), Account{100, 1}},
+        {addr(2), Account{200, 2}},
+    };
+    SnapshotBase::create(path, root(2), entries);
+
+    auto loaded = SnapshotBase::load(path);
+    EXPECT_EQ(loaded->root(), root(2));
+    EXPECT_EQ(loaded->size(), 2u);
+    ASSERT_TRUE(loaded->get(addr(2)).has_value());
+    EXPECT_EQ(loaded->get(addr(2))->balance, 200u);
+    EXPECT_FALSE(loaded->get(addr(3)).has_value());
+}
+
+// Loading garbage fails loudly
+TEST_F(SnapshotTest, BadFileRejected) {
+    std::filesystem::create_directories(dir);
+    std::string path = dir + "/junk.bin";
+    {
+        std::FILE* f = std::fopen(path.c_str(), "wb");
+        std::fputs("not a snapshot", f);
+        std::fclose(f);
+    }
+    EXPECT_THROW(SnapshotBase::load(path), std::runtime_error);
+}
+
+// Newer diff layers shadow older ones and the base
+TEST_F(SnapshotTest, DiffLayersShadowBase) {
+    SnapshotTree tree(16);
+    tree.reset(root(0), {{addr(1), Account{100, 0}}, {addr(2), Account{50, 0}}});
+
+    tree.update(root(1), {{addr(1), Account{90, 1}}, {addr(3), Account{10, 0}}});
+    tree.update(root(2), {{addr(1), Account{80, 2}}});
+
+    EXPECT_EQ(tree.root(), root(2));
+    EXPECT_EQ(tree.diffLayers(), 2u);
+    EXPECT_EQ(tree.get(addr(1))->balance, 80u);
+    EXPECT_EQ(tree.get(addr(1))->nonce, 2u);
+    EXPECT_EQ(tree.get(addr(2))->balance, 50u);
+    EXPECT_EQ(tree.get(addr(3))->balance, 10u);
+    EXPECT_FALSE(tree.get(addr(4)).has_value());
+}
+
+// Exceeding the layer limit flattens the oldest layers into the base in
+// the background; reads see the latest values throughout
+TEST_F(SnapshotTest, FlattenKeepsLatestValues) {
+    SnapshotTree tree(4);
+    tree.reset(root(0), {{addr(0), Account{1000, 0}}});
+
+    for (std::uint8_t b = 1; b <= 10; ++b) {
+        tree.update(root(b), {{addr(0), Account{1000u - b, b}}, {addr(b), Account{b, 0}}});
+        EXPECT_EQ(tree.get(addr(0))->nonce, b);
+        tree.waitForMerge();
+        EXPECT_LE(tree.diffLayers(), 4u);
+    }
+
+    EXPECT_EQ(tree.root(), root(10));
+    EXPECT_EQ(tree.get(addr(0))->balance, 990u);
+    EXPECT_EQ(tree.get(addr(0))->nonce, 10u);
+    for (std::uint32_t b = 1; b <= 10; ++b) {
+        EXPECT_EQ(tree.get(addr(b))->balance, b);
+    }
+}
+
+// With a directory configured, bases live in mmap'd files
+TEST_F(SnapshotTest, PersistedTreeFlattensToDisk) {
+    SnapshotTree tree(2);
+    tree.reset(root(0), {{addr(0), Account{7, 0}}});
+    tree.persistTo(dir);
+
+    for (std::uint8_t b = 1; b <= 5; ++b) {
+        tree.update(root(b), {{addr(b), Account{b, b}}});
+    }
+    tree.waitForMerge();
+
+    std::size_t files = 0;
+    for (const auto& e : std::filesystem::directory_iterator(dir)) {
+        if (e.path().extension() == ".bin") ++files;
+    }
+    EXPECT_EQ(files, 1u);
+    EXPECT_EQ(tree.get(addr(0))->balance, 7u);
+    EXPECT_EQ(tree.get(addr(5))->nonce, 5u);
+}
+
+// Bases left by an earlier run are cleared, and a reset does not leave
+// the base it replaces behind
+TEST_F(SnapshotTest, PersistedTreeKeepsOneBaseFile) {
+    auto listDir = [&] {
+        std::vector<std::string> names;
+        for (const auto& e : std::filesystem::directory_iterator(dir)) {
+            names.push_back(e.path().filename().string());
+        }
+        return names;
+    };
+    std::filesystem::create_directories(dir);
+    for (const char* stale : {"snapshot-0.bin", "snapshot-9.bin", "snapshot-3.bin.tmp"}) {
+        std::ofstream(dir + "/" + stale) << "stale";
+    }
+    std::ofstream(dir + "/other.dat") << "kept";
+
+    SnapshotTree tree(2);
+    tree.reset(root(0), {{addr(0), Account{7, 0}}});
+    tree.persistTo(dir);
+    EXPECT_EQ(listDir().size(), 2u);
+    EXPECT_EQ(tree.get(addr(0))->balance, 7u);
+
+    tree.reset(root(1), {{addr(1), Account{8, 0}}});
+    auto names = listDir();
+    ASSERT_EQ(names.size(), 2u);
+    EXPECT_TRUE(std::find(names.begin(), names.end(), "other.dat") != names.end());
+    EXPECT_EQ(tree.get(addr(1))->balance, 8u);
+    EXPECT_FALSE(tree.get(addr(0)).has_value());
+}
+
+// Layers stacked while a merge runs stay on top of its result, and a
+// reset during a merge wins over it
+TEST_F(SnapshotTest, UpdatesDuringMergeSurvive) {
+    // A base with some bulk to merge
+    SnapshotTree tree(2);
+    SnapshotBase::Entries big;
+    for (std::uint32_t i = 1; i <= 5000; ++i) big.emplace_back(addr(i), Account{i, 0});
+    tree.reset(root(0), big);
+
+    for (std::uint8_t b = 1; b <= 40; ++b) {
+        tree.update(root(b), {{addr(0), Account{b, b}}});
+    }
+    EXPECT_EQ(tree.get(addr(0))->nonce, 40u);
+    tree.waitForMerge();
+    EXPECT_LE(tree.diffLayers(), 2u);
+    EXPECT_EQ(tree.root(), root(40));
+    EXPECT_EQ(tree.get(addr(0))->nonce, 40u);
+    EXPECT_EQ(tree.get(addr(999))->balance, 999u);
+
+    for (std::uint8_t b = 41; b <= 44; ++b) {
+        tree.update(root(b), {{addr(0), Account{b, b}}});
+    }
+    tree.reset(root(0), {{addr(0), Account{1, 0}}});
+    tree.waitForMerge();
+    EXPECT_EQ(tree.diffLayers(), 0u);
+    EXPECT_EQ(tree.root(), root(0));
+    EXPECT_EQ(tree.get(addr(0))->balance, 1u);
+    EXPECT_FALSE(tree.get(addr(999)).has_value());
+}
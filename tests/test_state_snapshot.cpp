@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include "gambit/state_snapshot.hpp"
+#include "test_util.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace gambit;
+using namespace gambit::testutil;
+
+class StateSnapshotTest : public ::testing::Test {
+protected:
+    static State makeState(std::uint32_t accounts) {
+        State s;
+        for (std::uint32_t i = 0; i < accounts; ++i) {
+            uint256 balance = uint256(1000 + i) << (i % 200);
+            s.set(addr(i), Account{balance, i % 7});
+        }
+        return s;
+    }
+};
+
+// A written snapshot loads back to the same accounts and root, whatever
+// the chunk size and number of loader threads
+TEST_F(StateSnapshotTest, RoundTrip) {
+    State state = makeState(1000);
+    EXPECT_EQ(state.root(), state.trie().rootHash());
+
+    std::stringstream buf;
+    Bytes32 root = writeStateSnapshot(state, buf, 64);
+    EXPECT_EQ(root, state.root());
+
+    for (std::size_t threads : {1u, 3u}) {
+        std::stringstream in(buf.str());
+        State loaded = loadStateSnapshot(in, threads);
+        EXPECT_EQ(loaded.root(), root);
+        for (std::uint32_t i : {0u, 1u, 457u, 999u}) {
+            const Account* acc = loaded.get(addr(i));
+            ASSERT_NE(acc, nullptr);
+            EXPECT_EQ(acc->balance, state.get(addr(i))->balance);
+            EXPECT_EQ(acc->nonce, state.get(addr(i))->nonce);
+        }
+    }
+
+    std::stringstream empty;
+    writeStateSnapshot(State(), empty);
+    EXPECT_EQ(loadStateSnapshot(empty).root(), State().root());
+}
+
+// A bulk load on several threads holds the same accounts as set() one by
+// one, and a repeated address keeps its last account
+TEST_F(StateSnapshotTest, BulkLoad) {
+    std::vector<std::pair<Address, Account>> accounts;
+    for (std::uint32_t i = 0; i < 6000; ++i) accounts.emplace_back(addr(i), Account{uint256(i), i % 5});
+    accounts.emplace_back(addr(17), Account{uint256(1), 99});
+
+    State bulk = State::fromAccounts(accounts, 4);
+    State serial;
+    for (const auto& [a, acc] : accounts) serial.set(a, acc);
+
+    std::size_t n = 0;
+    serial.forEach([&](const Address& a, const Account& acc) {
+        const Account* got = bulk.get(a);
+        ASSERT_NE(got, nullptr);
+        EXPECT_EQ(got->balance, acc.balance);
+        EXPECT_EQ(got->nonce, acc.nonce);
+        ++n;
+    });
+    EXPECT_EQ(n, 6000u);
+    EXPECT_EQ(bulk.get(addr(17))->nonce, 99u);
+}
+
+// Damaged payloads, headers, roots and truncation are all refused
+TEST_F(StateSnapshotTest, DetectsCorruption) {
+    State state = makeState(2000);
+    std::stringstream buf;
+    writeStateSnapshot(state, buf, 256);
+    const std::string good = buf.str();
+
+    auto load = [](std::string bytes) {
+        std::stringstream in(bytes);
+        return loadStateSnapshot(in, 2);
+    };
+    EXPECT_NO_THROW(load(good));
+
+    std::string payload = good;
+    payload[52 + 76 + 30] ^= 0x01;                 // balance byte of the first account
+    EXPECT_THROW(load(payload), std::runtime_error);
+
+    std::string range = good;
+    range[52 + 4] ^= 0x80;                         // first address of chunk 0
+    EXPECT_THROW(load(range), std::runtime_error);
+
+    std::string root = good;
+    root[20] ^= 0x01;
+    EXPECT_THROW(load(root), std::runtime_error);
+
+    std::string magic = good;
+    magic[0] = 'X';
+    EXPECT_THROW(load(magic), std::runtime_error);
+
+    EXPECT_THROW(load(good.substr(0, good.size() - 1)), std::runtime_error);
+}
+
+// Genesis loads the snapshot, then applies the premine on top
+TEST_F(StateSnapshotTest, GenesisStateFile) {
+    std::string path = (std::filesystem::temp_directory_path() /
+                        ("gambit_state_snapshot_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) +
+                         ".bin")).string();
+    State base = makeState(500);
+    {
+        std::ofstream out(path, std::ios::binary);
+        writeStateSnapshot(base, out);
+    }
+
+    GenesisConfig genesis;
+    genesis.stateFile = path;
+    genesis.premine.push_back({addr(1), uint256(77)});
+    genesis.premine.push_back({addr(100000), uint256(5)});
+    State state(genesis);
+    std::filesystem::remove(path);
+
+    EXPECT_EQ(state.get(addr(0))->balance, base.get(addr(0))->balance);
+    EXPECT_EQ(state.get(addr(1))->balance, uint256(77));
+    EXPECT_EQ(state.get(addr(100000))->balance, uint256(5));
+
+    genesis.stateFile = path;
+    EXPECT_THROW(State{genesis}, std::runtime_error);
+}
@@ -232,11 +232,8 @@ TEST_F(TransactionTest, HashComputed) {
     
     tx.signWith(senderKey);
     
-    // Hash should be populated
-    EXPECT_FALSE(tx.hash.empty());
-    
-    // Hash should be hex string of 66 chars (0x + 64 hex digits)
-    EXPECT_EQ(tx.hash.length(), 66u);
-    EXPECT_EQ(tx.hash.substr(0, 2), "0x");
+    // Hash should be populated: keccak256 of the signed encoding
+    EXPECT_NE(tx.hash, Bytes32{});
+    EXPECT_EQ(tx.hash, keccak256_32(tx.rlpEncodeSigned()));
 }
 
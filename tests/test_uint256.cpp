@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include "gambit/uint256.hpp"
+#include "gambit/rlp.hpp"
+#include "gambit/state.hpp"
+
+#include <random>
+
+using namespace gambit;
+
+class Uint256Test : public ::testing::Test {
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+
+    // Random value with a random number of significant limbs
+    static uint256 random(std::mt19937_64& rng) {
+        std::uint64_t w[4] = {rng(), rng(), rng(), rng()};
+        int limbs = 1 + rng() % 4;
+        for (int i = limbs; i < 4; ++i) w[i] = 0;
+        if (rng() % 4 == 0) w[limbs - 1] >>= rng() % 64;   // short top limb
+        return uint256::fromWords(w[3], w[2], w[1], w[0]);
+    }
+};
+
+// Usable in constant expressions
+TEST_F(Uint256Test, Constexpr) {
+    constexpr uint256 a = uint256(1) << 200;
+    constexpr uint256 b = a / 3 * 3 + a % 3;
+    static_assert(a == b, "divmod identity");
+    static_assert(uint256::max() + 1 == 0, "wraps");
+    static_assert((uint256(0) - 1) == uint256::max(), "wraps");
+    static_assert(a.bitLength() == 201, "bit length");
+    EXPECT_TRUE(a == b);
+}
+
+// 128-bit results match the compiler's native arithmetic
+TEST_F(Uint256Test, MatchesNative128) {
+#ifdef __SIZEOF_INT128__
+    __extension__ using u128 = unsigned __int128;
+    auto from = [](u128 v) {
+        return uint256::fromWords(0, 0, static_cast<std::uint64_t>(v >> 64), static_cast<std::uint64_t>(v));
+    };
+    std::mt19937_64 rng(5);
+    for (int i = 0; i < 10000; ++i) {
+        u128 x = (static_cast<u128>(rng()) << 64) | rng();
+        u128 y = (static_cast<u128>(rng() >> (rng() % 64)) << 64) | rng();
+        EXPECT_EQ(from(x) + from(y), from(x + y) + (x + y < x ? uint256(1) << 128 : uint256()));
+        if (x >= y) {
+            EXPECT_EQ(from(x) - from(y), from(x - y));
+        }
+        EXPECT_EQ(from(x) / from(y), from(x / y));
+        EXPECT_EQ(from(x) % from(y), from(x % y));
+        std::uint64_t s = rng(), t = rng();
+        EXPECT_EQ(uint256(s) * uint256(t), from(static_cast<u128>(s) * t));
+    }
+#else
+    GTEST_SKIP() << "no native 128-bit integer";
+#endif
+}
+
+// q * b + r == a and r < b over all limb counts
+TEST_F(Uint256Test, DivmodIdentity) {
+    std::mt19937_64 rng(9);
+    for (int i = 0; i < 20000; ++i) {
+        uint256 a = random(rng);
+        uint256 b = random(rng);
+        if (b.isZero()) continue;
+        uint256 q, r;
+        uint256::divmod(a, b, q, r);
+        EXPECT_TRUE(r < b);
+        EXPECT_EQ(q * b + r, a);
+    }
+    EXPECT_THROW(uint256(1) / uint256(0), std::domain_error);
+}
+
+// Checked arithmetic reports overflow exactly
+TEST_F(Uint256Test, OverflowChecks) {
+    uint256 out;
+    EXPECT_TRUE(uint256::addOverflow(uint256::max(), 1, out));
+    EXPECT_FALSE(uint256::addOverflow(uint256::max() - 1, 1, out));
+    EXPECT_TRUE(uint256::subUnderflow(1, 2, out));
+    EXPECT_FALSE(uint256::mulOverflow(uint256(1) << 128, (uint256(1) << 127) * 2 - 1, out));
+    EXPECT_TRUE(uint256::mulOverflow(uint256(1) << 128, uint256(1) << 128, out));
+    EXPECT_TRUE(uint256::mulOverflow(uint256::max(), 2, out));
+    EXPECT_FALSE(uint256::mulOverflow(uint256::max(), 1, out));
+}
+
+// Hex, decimal and big-endian conversions round trip
+TEST_F(Uint256Test, Conversions) {
+    EXPECT_EQ(uint256().toHex(), "0x0");
+    EXPECT_EQ(uint256(255).toHex(), "0xff");
+    EXPECT_EQ(uint256::fromHex("0x0100").low64(), 256u);
+    EXPECT_EQ(uint256::max().toString(),
+              "115792089237316195423570985008687907853269984665640564039457584007913129639935");
+    EXPECT_EQ(uint256::fromString("10000000000000000000000"), uint256(10000000000000000000ull) * 1000);
+    EXPECT_THROW(uint256::fromHex("0x" + std::string(65, 'f')), std::out_of_range);
+    EXPECT_THROW(uint256::fromString("115792089237316195423570985008687907853269984665640564039457584007913129639936"),
+                 std::out_of_range);
+
+    std::mt19937_64 rng(2);
+    for (int i = 0; i < 1000; ++i) {
+        uint256 v = random(rng);
+        EXPECT_EQ(uint256::fromHex(v.toHex()), v);
+        EXPECT_EQ(uint256::fromString(v.toString()), v);
+        std::uint8_t buf[32];
+        std::size_t len = v.toBigEndian(buf);
+        EXPECT_EQ(uint256::fromBigEndian(buf, len), v);
+    }
+}
+
+// RLP encoding is minimal big-endian and matches the 64-bit encoder
+TEST_F(Uint256Test, RlpEncoding) {
+    for (std::uint64_t v : {0ull, 1ull, 127ull, 128ull, 65535ull, ~0ull}) {
+        EXPECT_EQ(rlp::encodeUint(uint256(v)), rlp::encodeUint(v));
+    }
+    Bytes enc = rlp::encodeUint(uint256(1) << 255);
+    ASSERT_EQ(enc.size(), 33u);
+    EXPECT_EQ(enc[0], 0x80 + 32);
+    EXPECT_EQ(enc[1], 0x80);
+}
+
+// Balances beyond 64 bits survive state transitions and the trie encoding
+TEST_F(Uint256Test, LargeBalances) {
+    std::array<std::uint8_t, Address::kSize> raw{};
+    raw[0] = 1;
+    Address a(raw);
+    raw[0] = 2;
+    Address b(raw);
+
+    uint256 big = uint256::fromString("1000000000000000000000000");   // 1M ether in wei
+    GenesisConfig g;
+    g.premine.push_back({a, big});
+    State s(g);
+
+    Transaction tx;
+    tx.from = a;
+    tx.to = b;
+    tx.value = big / 4;
+    s.applyTransaction(a, tx);
+
+    EXPECT_EQ(s.get(a)->balance, big - big / 4);
+    EXPECT_EQ(s.get(b)->balance, big / 4);
+    Account round = State::decodeAccount(State::encodeAccount(*s.get(a)));
+    EXPECT_EQ(round.balance, big - big / 4);
+}
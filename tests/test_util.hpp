@@ -0,0 +1,96 @@
+#pragma once
+#include "gambit/block.hpp"
+#include "gambit/keys.hpp"
+#include "gambit/state.hpp"
+#include "gambit/transaction.hpp"
+#include "gambit/zk.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Fixtures shared by the storage, index, execution and RPC tests
+namespace gambit::testutil {
+
+// The i-th test account: distinct for every i, with the leading bytes
+// spread over the key space so prefixes and hash buckets all get used
+inline Address addr(std::uint32_t i) {
+    std::array<std::uint8_t, Address::kSize> raw{};
+    std::uint32_t h = i * 2654435761u;
+    raw[0] = static_cast<std::uint8_t>(h >> 24);
+    raw[1] = static_cast<std::uint8_t>(h >> 16);
+    raw[15] = 0x7e;
+    raw[16] = static_cast<std::uint8_t>(i >> 24);
+    raw[17] = static_cast<std::uint8_t>(i >> 16);
+    raw[18] = static_cast<std::uint8_t>(i >> 8);
+    raw[19] = static_cast<std::uint8_t>(i);
+    return Address(raw);
+}
+
+// Unsigned transfers hash the same whoever sends them, so the sender is
+// mixed in to keep equal transfers from two senders apart
+inline void rehash(Transaction& tx) {
+    tx.hash = keccak256_32(toHex(tx.computeHash()) + tx.from.toHex());
+}
+
+// An unsigned transfer, as executors see it after sender recovery
+inline Transaction transfer(const Address& from, const Address& to, std::uint64_t value) {
+    Transaction tx;
+    tx.from = from;
+    tx.to = to;
+    tx.value = value;
+    rehash(tx);
+    return tx;
+}
+
+// Each sender's transfers in block order take its next nonce, counting
+// from its nonce on `base` if given
+inline void numberNonces(std::vector<Transaction>& txs, const State* base = nullptr) {
+    std::unordered_map<Address, std::uint64_t, AddressHash> next;
+    for (auto& tx : txs) {
+        auto it = next.find(tx.from);
+        if (it == next.end()) {
+            const Account* acc = base ? base->get(tx.from) : nullptr;
+            it = next.emplace(tx.from, acc ? acc->nonce : 0).first;
+        }
+        tx.nonce = it->second++;
+        rehash(tx);
+    }
+}
+
+// Accounts addr(0) .. addr(accounts - 1), each holding `balance`
+inline GenesisConfig genesis(std::uint32_t accounts, std::uint64_t balance) {
+    GenesisConfig g;
+    for (std::uint32_t i = 0; i < accounts; ++i) g.premine.push_back({addr(i), balance});
+    return g;
+}
+
+// A signed 21000-gas transfer on chain 1337 to a fixed recipient
+inline Transaction signedTransfer(const KeyPair& kp, std::uint64_t nonce, std::uint64_t value) {
+    Transaction tx;
+    tx.nonce = nonce;
+    tx.gasPrice = 1;
+    tx.gasLimit = 21000;
+    tx.to = Address::fromHex("0x1234567890123456789012345678901234567890");
+    tx.value = value;
+    tx.chainId = 1337;
+    tx.signWith(kp);
+    return tx;
+}
+
+// A block at `index` with made-up roots and `txs` transfers from one
+// fresh key; not executable against any state
+inline Block makeBlock(std::uint64_t index, std::size_t txs) {
+    Block b(index, keccak256_32("prev" + std::to_string(index)), keccak256_32("before"),
+            keccak256_32("after" + std::to_string(index)), keccak256_32("txroot"),
+            ZkProver::generate(keccak256_32("before"), keccak256_32("after"), keccak256_32("txroot")));
+    KeyPair kp = KeyPair::random();
+    for (std::size_t i = 0; i < txs; ++i) {
+        b.transactions.push_back(signedTransfer(kp, i, 100 + i));
+    }
+    return b;
+}
+
+} // namespace gambit::testutil
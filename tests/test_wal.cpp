@@ -0,0 +1,241 @@
+#include <gtest/gtest.h>
+#include "gambit/blockchain.hpp"
+#include "gambit/keys.hpp"
+#include "gambit/wal.hpp"
+#include "test_util.hpp"
+
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#ifndef _WIN32
+    #include <sys/resource.h>
+#endif
+
+using namespace gambit;
+using namespace gambit::testutil;
+
+class WalTest : public ::testing::Test {
+protected:
+    std::string dir;
+
+    void SetUp() override {
+        dir = (std::filesystem::temp_directory_path() /
+               ("gambit_wal_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) +
+                "_" + ::testing::UnitTest::GetInstance()->current_test_info()->name())).string();
+        std::filesystem::remove_all(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    // Record types for the log-level tests; the log only frames them
+    static constexpr std::uint8_t kTx = 1;
+    static constexpr std::uint8_t kBlock = 2;
+    static constexpr std::uint8_t kRewind = 3;
+
+    static std::vector<std::pair<std::uint8_t, Bytes>> readAll(const WriteAheadLog& wal) {
+        std::vector<std::pair<std::uint8_t, Bytes>> out;
+        wal.replay([&](std::uint8_t t, const Bytes& p) { out.emplace_back(t, p); });
+        return out;
+    }
+};
+
+// Synced records are replayed in order; a torn tail is cut off
+TEST_F(WalTest, ReplaysAndDropsTornTail) {
+    std::string path = dir + "/wal.log";
+    {
+        WriteAheadLog wal(path);
+        wal.append(kTx, Bytes{1, 2, 3});
+        wal.append(kBlock, Bytes(1000, 7));
+        wal.commit(kRewind, Bytes{9});
+        EXPECT_EQ(wal.syncs(), 1u);
+    }
+    std::uintmax_t intact = std::filesystem::file_size(path);
+    {
+        // Header of a record whose payload never made it
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        out << std::string("\x20\x00\x00\x00\x01\x02", 6);
+    }
+
+    WriteAheadLog wal(path);
+    EXPECT_EQ(std::filesystem::file_size(path), intact);
+    auto records = readAll(wal);
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(records[0].first, kTx);
+    EXPECT_EQ(records[0].second, (Bytes{1, 2, 3}));
+    EXPECT_EQ(records[1].second.size(), 1000u);
+    EXPECT_EQ(records[2].first, kRewind);
+
+    wal.reset();
+    EXPECT_EQ(wal.bytes(), 0u);
+    EXPECT_TRUE(readAll(WriteAheadLog(path)).empty());
+}
+
+// A flipped byte ends replay at the damaged record
+TEST_F(WalTest, StopsAtCorruptRecord) {
+    std::string path = dir + "/wal.log";
+    {
+        WriteAheadLog wal(path);
+        for (std::uint8_t i = 0; i < 4; ++i) wal.append(kTx, Bytes(16, i));
+        wal.sync(4);
+    }
+    {
+        std::fstream f(path, std::ios::binary | std::ios::in | std::ios::out);
+        f.seekp(2 * (9 + 16) + 12);
+        f.put('\xff');
+    }
+    WriteAheadLog wal(path);
+    EXPECT_EQ(readAll(wal).size(), 2u);
+}
+
+// A failed write leaves no torn record behind and reports nothing durable;
+// the records go out with the next successful sync
+TEST_F(WalTest, FailedWriteStaysBuffered) {
+#ifdef _WIN32
+    GTEST_SKIP() << "needs RLIMIT_FSIZE to inject a short write";
+#else
+    std::string path = dir + "/wal.log";
+    WriteAheadLog wal(path);
+    wal.commit(kTx, Bytes(16, 1));
+    std::uintmax_t intact = std::filesystem::file_size(path);
+
+    // Let only part of the next record reach the file
+    auto oldHandler = std::signal(SIGXFSZ, SIG_IGN);
+    rlimit saved{};
+    ::getrlimit(RLIMIT_FSIZE, &saved);
+    rlimit capped = saved;
+    capped.rlim_cur = intact + 20;
+    ::setrlimit(RLIMIT_FSIZE, &capped);
+
+    std::uint64_t lost = wal.append(kBlock, Bytes(100, 2));
+    EXPECT_THROW(wal.sync(lost), std::runtime_error);
+    // Retrying must fail again rather than claim the batch is durable
+    EXPECT_THROW(wal.sync(lost), std::runtime_error);
+
+    ::setrlimit(RLIMIT_FSIZE, &saved);
+    std::signal(SIGXFSZ, oldHandler);
+
+    EXPECT_EQ(std::filesystem::file_size(path), intact);
+    EXPECT_EQ(readAll(wal).size(), 1u);
+
+    wal.commit(kTx, Bytes(8, 3));
+    auto records = readAll(WriteAheadLog(path));
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(records[1].first, kBlock);
+    EXPECT_EQ(records[1].second, Bytes(100, 2));
+    EXPECT_EQ(records[2].second, Bytes(8, 3));
+#endif
+}
+
+// Concurrent committers share fsyncs and every record lands
+TEST_F(WalTest, GroupCommit) {
+    std::string path = dir + "/wal.log";
+    constexpr int kThreads = 8;
+    constexpr int kPerThread = 40;
+    {
+        WriteAheadLog wal(path);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; ++t) {
+            threads.emplace_back([&wal, t] {
+                for (int i = 0; i < kPerThread; ++i) {
+                    wal.commit(kTx,
+                               Bytes{static_cast<std::uint8_t>(t), static_cast<std::uint8_t>(i)});
+                }
+            });
+        }
+        for (auto& th : threads) th.join();
+        EXPECT_LT(wal.syncs(), std::uint64_t(kThreads * kPerThread));
+    }
+
+    WriteAheadLog wal(path);
+    auto records = readAll(wal);
+    ASSERT_EQ(records.size(), std::size_t(kThreads * kPerThread));
+    // Each thread's records keep their order
+    std::vector<int> next(kThreads, 0);
+    for (const auto& [type, p] : records) {
+        EXPECT_EQ(p[1], next[p[0]]++);
+    }
+}
+
+// Blocks the store lost and pending transactions come back from the log
+TEST_F(WalTest, BlockchainRecovery) {
+    KeyPair kp = KeyPair::random();
+    GenesisConfig g;
+    g.chainId = 1337;
+    g.premine.push_back({kp.address(), 1000000});
+
+    Bytes32 head;
+    Bytes32 root;
+    Bytes32 pending;
+    {
+        Blockchain chain(g);
+        chain.setDataDir(dir);
+        for (std::uint64_t n = 0; n < 3; ++n) {
+            chain.addTransaction(signedTransfer(kp, n, 1000 * (n + 1)));
+            chain.mineBlock();
+        }
+        Transaction tx = signedTransfer(kp, 3, 5);
+        chain.addTransaction(tx);
+        pending = tx.hash;
+        head = chain.head().hash();
+        root = chain.state().root();
+        EXPECT_GT(chain.wal()->bytes(), 0u);
+    }
+    {
+        // Crash before the last two blocks reached the store
+        BlockStore store(dir + "/blocks");
+        store.truncate(2);
+    }
+
+    Blockchain chain(g);
+    chain.setDataDir(dir);
+    EXPECT_EQ(chain.height(), 3u);
+    EXPECT_EQ(chain.head().hash(), head);
+    EXPECT_EQ(chain.state().root(), root);
+    EXPECT_EQ(chain.snapshot().root(), root);
+    EXPECT_TRUE(chain.findTransaction(chain.blockAt(3).transactions[0].hash).has_value());
+    ASSERT_EQ(chain.mempool().size(), 1u);
+    EXPECT_EQ(chain.mempool()[0].hash, pending);
+}
+
+// A logged block whose writes do not reach its state root is refused
+// before any of it is applied
+TEST_F(WalTest, RecoveryChecksRootFirst) {
+    KeyPair kp = KeyPair::random();
+    GenesisConfig g;
+    g.chainId = 1337;
+    g.premine.push_back({kp.address(), 1000000});
+
+    Block block;
+    Bytes32 genesisRoot;
+    {
+        Blockchain chain(g);
+        chain.setDataDir(dir);
+        genesisRoot = chain.state().root();
+        chain.addTransaction(signedTransfer(kp, 0, 1000));
+        block = chain.mineBlock();
+    }
+    {
+        BlockStore store(dir + "/blocks");
+        store.truncate(0);
+
+        // The block with a sender balance that does not match it
+        Bytes addr(kp.address().bytes().begin(), kp.address().bytes().end());
+        Bytes account = State::encodeAccount(Account{uint256(7), 1});
+        Bytes record = rlp::encodeList({rlp::encodeBytes(block.rlpEncode()),
+                                        rlp::encodeList({rlp::encodeList({rlp::encodeBytes(addr),
+                                                                          rlp::encodeBytes(account)})})});
+        WriteAheadLog wal(dir + "/wal.log");
+        wal.reset();
+        wal.commit(static_cast<std::uint8_t>(Blockchain::WalRecord::Block), record);
+    }
+
+    Blockchain chain(g);
+    EXPECT_THROW(chain.setDataDir(dir), std::runtime_error);
+    EXPECT_EQ(chain.height(), 0u);
+    EXPECT_EQ(chain.state().root(), genesisRoot);
+    EXPECT_FALSE(chain.findTransaction(block.transactions[0].hash).has_value());
+}
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include "gambit/witness.hpp"
+#include "gambit/blockchain.hpp"
+#include "gambit/zk_mining_engine.hpp"
+#include "test_util.hpp"
+
+using namespace gambit;
+using namespace gambit::testutil;
+
+class WitnessTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+
+    static Bytes key(const Address& a) {
+        return Bytes(a.bytes().begin(), a.bytes().end());
+    }
+
+    static State makeState(std::uint32_t accounts) {
+        GenesisConfig g;
+        for (std::uint32_t i = 0; i < accounts; ++i) g.premine.push_back({addr(i), 1000 + i});
+        return State(g);
+    }
+
+};
+
+// A partial trie has the full root, serves witnessed keys and tracks updates
+TEST_F(WitnessTest, PartialTrieMatchesFullTrie) {
+    State state = makeState(200);
+    MptTrie full = state.trie();
+    Bytes32 root = full.rootHash();
+
+    BlockWitness w = BlockWitness::build(full, {addr(3), addr(150), addr(999)});
+    MptTrie partial = w.toTrie(root);
+    EXPECT_EQ(partial.rootHash(), root);
+
+    auto raw = partial.get(key(addr(150)));
+    ASSERT_TRUE(raw.has_value());
+    EXPECT_EQ(State::decodeAccount(*raw).balance, 1150u);
+    EXPECT_FALSE(partial.get(key(addr(999))).has_value());
+    EXPECT_THROW(partial.get(key(addr(42))), std::runtime_error);
+
+    for (MptTrie* t : {&full, &partial}) {
+        t->put(key(addr(3)), State::encodeAccount(Account{7, 1}));
+        t->put(key(addr(999)), State::encodeAccount(Account{5, 0}));
+    }
+    EXPECT_EQ(partial.rootHash(), full.rootHash());
+}
+
+// Nodes are matched by their own hash; a tampered node does not attach
+TEST_F(WitnessTest, TamperedNodeRejected) {
+    MptTrie full = makeState(50).trie();
+    BlockWitness w = BlockWitness::build(full, {addr(1)});
+    ASSERT_FALSE(w.empty());
+
+    for (auto& n : w.nodes) n.back() ^= 0x01;
+    EXPECT_THROW(w.toTrie(full.rootHash()), std::runtime_error);
+}
+
+// Witness survives the block RLP round trip
+TEST_F(WitnessTest, BlockRlpRoundTrip) {
+    GenesisConfig g;
+    g.premine.push_back({addr(0), 1000});
+    Blockchain chain(g);
+    Block b = chain.mineBlock();
+    ASSERT_FALSE(b.witness.empty());
+
+    Block decoded = Block::rlpDecode(b.rlpEncode());
+    EXPECT_EQ(decoded.witness.nodes, b.witness.nodes);
+}
+
+// Stateless validation accepts honest blocks and rejects bad roots
+TEST_F(WitnessTest, StatelessValidation) {
+    GenesisConfig g;
+    for (std::uint32_t i = 0; i < 64; ++i) g.premine.push_back({addr(i), 1000});
+    Blockchain chain(g);
+    chain.setStatelessValidation(true);
+
+    for (Transaction tx : {transfer(addr(1), addr(2), 100), transfer(addr(2), addr(500), 50)}) {
+        tx.hash = tx.computeHash();
+        chain.addTransaction(tx);
+    }
+    ZkMiningEngine engine;
+    Block tmpl = engine.buildBlockTemplate(chain);
+
+    Block badRoot = tmpl;
+    badRoot.stateAfter = chain.head().stateAfter();
+    EXPECT_FALSE(chain.addBlock(badRoot));
+
+    Block badTx = tmpl;
+    badTx.transactions[0].value = 101;
+    EXPECT_FALSE(chain.addBlock(badTx));
+
+    Block noWitness = tmpl;
+    noWitness.witness.nodes.resize(1);   // root only
+    EXPECT_FALSE(chain.addBlock(noWitness));
+
+    EXPECT_TRUE(chain.addBlock(tmpl));
+}